@@ -1,30 +1,51 @@
 #include "1802.h"
-#include "mbed.h"
+#include "Hal.h"
+#include <cstring>
 
 // modified from https://os.mbed.com/users/Yar/code/CSE321_LCD_for_Nucleo/
 // modified from:
 // https://os.mbed.com/users/cmatz3/code/Grove_LCD_RGB_Backlight_HelloWorld/
 
 // constructor
-CSE321_LCD::CSE321_LCD(unsigned char lcd_cols, unsigned char lcd_rows,
-                       unsigned char charsize, PinName sda, PinName scl)
-    : i2c(sda, scl) {
+CSE321_LCDController::CSE321_LCDController(I2CBus *bus, unsigned char lines,
+                                           unsigned char charsize,
+                                           int frequency, bool backlight) {
+  _bus = bus;
+  _textClient = _bus->addClient("LCD text", I2CBus::DisplayPriority);
+  _backlightClient = _bus->addClient("LCD backlight", I2CBus::ControlPriority);
   _addr = LCD_ADDRESS_1802;
-  _cols = lcd_cols;
-  _rows = lcd_rows;
+  _lines = lines;
+  _displayfunction = 0;
+  _displaycontrol = 0;
+  _displaymode = 0;
   _charsize = charsize;
   _backlightval = LCD_BACKLIGHT;
+  _backlight = backlight;
+  _cursorCol = 0;
+  _cursorRow = 0;
+  _cursorKnown = false;
+  _glyphsLoaded = 0; // CGRAM content is unknown at power up
+  _regsKnown = 0;    // so are the backlight registers
+  _regWrites = 0;
+  _regWritesElided = 0;
+  _requestedFrequency = frequency;
+  _frequency = 0;
+  _transactions = 0;
+  _busBytes = 0;
 }
 
-void CSE321_LCD::begin() {
+void CSE321_LCDController::begin() {
 
   // Initialize displayfunction parameter for setting up LCD display
-  _displayfunction |= LCD_2LINE;
+  _displayfunction |= _lines > 1 ? LCD_2LINE : LCD_1LINE;
   _displayfunction |= LCD_5x10DOTS;
 
   // Wait for more than 30 ms after power rises above 4.5V per the data sheet
   thread_sleep_for(50);
 
+  // Raise the bus to the requested frequency if both devices keep up
+  setFrequency(_requestedFrequency);
+
   // Send first function set command. Wait longer that 39 us per the data
   // sheet
   sendCommand(LCD_FUNCTIONSET | _displayfunction);
@@ -34,67 +55,192 @@ void CSE321_LCD::begin() {
   displayON();
 
   // clear the display
-  clear();
+  clearDisplay();
 
   // Initialize backlight
-  setReg(0, 0);
-  setReg(1, 0);
-  setReg(0x08, 0xAA);
+  setReg(RGB_REG_MODE1, 0);
+  setReg(RGB_REG_MODE2, 0);
+  setReg(RGB_REG_LEDOUT, RGB_LEDOUT_PWM);
 
   //   }
 }
 
-void CSE321_LCD::clear() {
+int CSE321_LCDController::setFrequency(int frequency) {
+  static const int frequencies[] = {LCD_I2C_FAST_PLUS, LCD_I2C_FAST,
+                                    LCD_I2C_STANDARD};
+  _frequency = 0;
+  for (int hz : frequencies) {
+    if (hz > frequency) {
+      continue;
+    }
+    _bus->setFrequency(_textClient, hz);
+
+    // both probes are harmless: a function set, and MODE1 = normal mode
+    char lcdProbe[2] = {(char)0x80, (char)(LCD_FUNCTIONSET | _displayfunction)};
+    char rgbProbe[2] = {RGB_REG_MODE1, 0};
+    if (busWrite(_addr, lcdProbe, 2) == 0 &&
+        (!_backlight || busWrite(RGB_ADDRESS, rgbProbe, 2) == 0)) {
+      _frequency = hz;
+      _regValues[RGB_REG_MODE1] = 0;
+      _regsKnown |= 1 << RGB_REG_MODE1;
+      break;
+    }
+  }
+  return _frequency;
+}
+
+int CSE321_LCDController::busWrite(int address, const char *data, int length,
+                         bool wait) {
+  _transactions++;
+  _busBytes += LCD_I2C_ADDRESS_BYTES + length;
+  int client = address == RGB_ADDRESS ? _backlightClient : _textClient;
+  if (wait) {
+    return _bus->write(client, address, data, length);
+  }
+  // data writes share the control byte 0x40, which is sent once per batch
+  _bus->post(client, address, data, length, data[0] == 0x40 ? 1 : 0);
+  return 0;
+}
+
+void CSE321_LCDController::flush() {
+  _bus->flush(_textClient);
+  _bus->flush(_backlightClient);
+}
+
+void CSE321_LCDController::notifyWhenShown(void (*handler)(uint32_t value),
+                                           uint32_t value) {
+  _bus->notify(_textClient, handler, value);
+}
+
+void CSE321_LCDController::clearDisplay() {
   sendCommand(LCD_CLEARDISPLAY);
   wait_us(2000);
+  _cursorCol = 0;
+  _cursorRow = 0;
+  _cursorKnown = true;
+}
+
+void CSE321_LCDController::returnHome() {
+  sendCommand(LCD_RETURNHOME);
+  wait_us(2000);
+  _cursorCol = 0;
+  _cursorRow = 0;
+  _cursorKnown = true;
 }
 
-void CSE321_LCD::sendCommand(char value) {
+void CSE321_LCDController::shiftDisplay(int columns, unsigned char direction) {
+  char data[I2CBusMaxPayload];
+  while (columns > 0) {
+    int count = 0;
+    while (columns > 0 && count + 2 <= I2CBusMaxPayload) {
+      data[count++] = 0x80; // Co = 1: another control byte follows
+      data[count++] = LCD_CURSORSHIFT | LCD_DISPLAYMOVE | direction;
+      columns--;
+    }
+    busWrite(_addr, data, count, false);
+  }
+}
+
+void CSE321_LCDController::sendCommand(char value) {
   char data[2] = {0x80, value};
-  i2c.write(_addr, data, 2);
+  busWrite(_addr, data, 2);
 }
 
 // set color thing for seeed
-void CSE321_LCD::setRGB(char r, char g, char b) {
+void CSE321_LCDController::setRGB(char r, char g, char b) {
 
   this->setReg(RED_REG, r);
   this->setReg(GREEN_REG, g);
   this->setReg(BLUE_REG, b);
 }
 
-void CSE321_LCD::displayON() {
+void CSE321_LCDController::displayON() {
   _displaycontrol |= LCD_DISPLAYON;
   this->sendCommand(LCD_DISPLAYCONTROL | _displaycontrol);
 }
 
-void CSE321_LCD::setReg(char addr, char val) {
+void CSE321_LCDController::setReg(char addr, char val) {
+  if (!_backlight) {
+    return;
+  }
+  unsigned char reg = addr;
+  if (reg < RGB_REG_COUNT) {
+    if ((_regsKnown & (1 << reg)) && _regValues[reg] == val) {
+      _regWritesElided++;
+      return;
+    }
+    _regValues[reg] = val;
+    _regsKnown |= 1 << reg;
+  }
+  _regWrites++;
+
   char data[2];
   data[0] = addr;
   data[1] = val;
-  i2c.write(RGB_ADDRESS, data, 2);
+  busWrite(RGB_ADDRESS, data, 2, false);
 }
 
-void CSE321_LCD::setCursor(unsigned char col, unsigned char row) {
-//change the cordinate of where the next charecter will be put
-  if (row == 0) {
-    col = col | 0x80;
-  } else {
-    col = col | 0xc0;
-  }
-
+void CSE321_LCDController::setAddress(unsigned char address) {
+  //change the cordinate of where the next charecter will be put
   char data[2];
   data[0] = 0x80;
-  data[1] = col;
-  i2c.write(_addr, data, 2);
+  data[1] = LCD_SETDDRAMADDR | address;
+  busWrite(_addr, data, 2, false);
 }
 
-int CSE321_LCD::print(const char *text) { //output a string to the LCD
-  char data[2];
+void CSE321_LCDController::sendData(const char *values, int count) {
+  // one control byte (Co = 0, RS = 1) followed by every data byte
+  char data[LCD_DDRAM_LINE + 1];
   data[0] = 0x40;
-  while (*text) {
-    data[1] = *text;
-    i2c.write(_addr, data, 2);
-    text++;
+  memcpy(data + 1, values, count);
+  busWrite(_addr, data, count + 1, false);
+}
+
+bool CSE321_LCDController::createChar(unsigned char slot, const char glyph[LCD_GLYPH_ROWS]) {
+  if (slot >= LCD_GLYPH_SLOTS) {
+    return false;
+  }
+  if ((_glyphsLoaded & (1 << slot)) &&
+      memcmp(_glyphs[slot], glyph, LCD_GLYPH_ROWS) == 0) {
+    return false; // already in CGRAM
+  }
+
+  sendCommand(LCD_SETCGRAMADDR | (slot << 3));
+  char data[LCD_GLYPH_ROWS + 1];
+  data[0] = 0x40;
+  memcpy(data + 1, glyph, LCD_GLYPH_ROWS);
+  busWrite(_addr, data, LCD_GLYPH_ROWS + 1, false);
+
+  memcpy(_glyphs[slot], glyph, LCD_GLYPH_ROWS);
+  _glyphsLoaded |= 1 << slot;
+  _cursorKnown = false; // the address counter now points into CGRAM
+  return true;
+}
+
+void CSE321_LCDController::loadBarGlyphs() {
+  for (int dots = 1; dots < LCD_BAR_STEPS; dots++) {
+    char glyph[LCD_GLYPH_ROWS];
+    memset(glyph, (0x1F << (LCD_BAR_STEPS - dots)) & 0x1F, LCD_GLYPH_ROWS);
+    createChar(LCD_BAR_FIRST_SLOT + dots - 1, glyph);
+  }
+}
+
+void CSE321_LCDController::renderBar(char *text, int cells, int value, int maxValue) {
+  if (value < 0 || maxValue <= 0) {
+    value = 0;
+  } else if (value > maxValue) {
+    value = maxValue;
+  }
+  int steps = maxValue > 0 ? value * cells * LCD_BAR_STEPS / maxValue : 0;
+
+  for (int i = 0; i < cells; i++) {
+    int dots = steps - i * LCD_BAR_STEPS;
+    if (dots <= 0) {
+      text[i] = ' ';
+    } else if (dots >= LCD_BAR_STEPS) {
+      text[i] = LCD_FULL_BLOCK;
+    } else {
+      text[i] = LCD_GLYPH_CHAR(LCD_BAR_FIRST_SLOT + dots - 1);
+    }
   }
-  return 0;
 }
\ No newline at end of file
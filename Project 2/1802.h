@@ -2,7 +2,9 @@
 // modified from
 // https://os.mbed.com/users/cmatz3/code/Grove_LCD_RGB_Backlight_HelloWorld/
 
-#include "mbed.h"
+#include "Hal.h"
+#include "I2CBus.h"
+#include <cstring>
 
 // commands
 #define LCD_CLEARDISPLAY 0x01
@@ -58,33 +60,51 @@
 #define GREEN_REG 0x03
 #define BLUE_REG 0x02
 
-// model flag
+// backlight controller registers
+#define RGB_REG_MODE1 0x00
+#define RGB_REG_MODE2 0x01
+#define RGB_REG_LEDOUT 0x08
+#define RGB_REG_COUNT 9       // registers 0x00-0x08, whose values are cached by setReg()
+#define RGB_LEDOUT_PWM 0xAA   // every LED driven by its own PWM register
+#define RGB_WRITE_BYTES 3     // I2C bytes of one register write: address, register, value
+
+// I2C bus frequencies (Hz). The display controller is specified up to fast
+// mode; fast mode plus also needs Fm+ capable pins on the target
+#define LCD_I2C_STANDARD 100000
+#define LCD_I2C_FAST 400000
+#define LCD_I2C_FAST_PLUS 1000000
+#define LCD_I2C_ADDRESS_BYTES 1 // bytes of the address phase of every transaction
+
+// model flag. The LCD1802 carries the RGB backlight controller at
+// RGB_ADDRESS; the LCD1602 is the same display without it
 #define LCD1602 0x00
 #define LCD1802 0x02
 
+// DDRAM of the controller: two lines of 40 characters, the second at 0x40.
+// Panels of 4 rows show the third and fourth row further along the first and
+// second line
+#define LCD_DDRAM_LINE 40
+#define LCD_LINE2_ADDRESS 0x40
+#define LCD_MAX_ROWS 4
+
+// custom glyphs
+#define LCD_GLYPH_SLOTS 8 // CGRAM holds 8 glyphs of 5x8 dots
+#define LCD_GLYPH_ROWS 8
+#define LCD_GLYPH_CHAR(slot) (char)(0x08 | (slot)) // CGRAM glyphs repeat at 0x08-0x0F, so they can be placed in strings
+#define LCD_FULL_BLOCK (char)0xFF                   // ROM character with every dot on
+
+// horizontal bar graphs
+#define LCD_BAR_STEPS 5      // sub-steps per cell, one per dot column
+#define LCD_BAR_FIRST_SLOT 0 // glyph slots 0-3 hold the bars of 1 to 4 dot columns
+
 /**
- * This is the driver for the Liquid Crystal LCD displays that use the I2C bus.
- *
- * After creating an instance of this class, first call begin() before anything
- * else. The backlight is on by default, since that is the most likely operating
- * mode in most cases.
+ * This is the part of the driver for the Liquid Crystal LCD displays that use
+ * the I2C bus which does not depend on the panel geometry: the bus, commands,
+ * custom glyphs and the backlight. Displays are created as CSE321_LCD<Cols,
+ * Rows>, below.
  */
-class CSE321_LCD {
+class CSE321_LCDController {
 public:
-  /**
-   * Constructor
-   *
-   * @param lcd_cols  Number of columns your LCD display has.
-   * @param lcd_rows  Number of rows your LCD display has.
-   * @param charsize  The size in dots that the display has, use LCD_5x10DOTS or
-   * LCD_5x8DOTS.
-   * @param sda       Pin to use for SDA connection of I2C for LCD
-   * @param scl       Pin to use for the SCL connection of I2C for LCD
-   */
-  CSE321_LCD(unsigned char lcd_cols, unsigned char lcd_rows,
-             unsigned char charsize = LCD_5x8DOTS, PinName sda = PB_9,
-             PinName scl = PB_8);
-
   /**
    * Set the LCD display in the correct begin state, must be called before
    * anything else is done.
@@ -92,17 +112,74 @@ public:
   void begin();
 
   /**
-   * Remove all the characters currently shown. Next print/write operation will
-   * start from the first position on LCD display.
+   * Set the I2C bus frequency and probe the display, and the backlight
+   * controller if the model has one, at it. If a device does not acknowledge,
+   * the next slower frequency is tried, down to LCD_I2C_STANDARD.
+   *   @param frequency  Requested frequency (Hz).
+   *   @return The frequency in use, or 0 if no device acknowledged even at
+   * LCD_I2C_STANDARD.
+   */
+  int setFrequency(int frequency);
+
+  /** The I2C bus frequency in use (Hz), or 0 if the probe failed. */
+  int frequency() const { return _frequency; }
+
+  /**
+   * Number of I2C writes queued for the display and backlight, and the bytes
+   * they would put on the bus including the address byte. Adjacent character
+   * writes are merged by the bus manager, so the bus may carry fewer
+   * transactions; see I2CBus::printStatistics().
+   */
+  unsigned int transactions() const { return _transactions; }
+  unsigned int busBytes() const { return _busBytes; }
+
+  /**
+   * Wait until every queued write of the display and backlight is on the bus.
+   * Character writes, cursor moves and backlight writes are queued and return
+   * at once; commands wait.
    */
-  void clear();
+  void flush();
+
+  /**
+   * Call handler(value) on the bus thread once every write of the display
+   * text queued so far is on the bus, without waiting. Used to time a frame
+   * from its start until the display shows it.
+   */
+  void notifyWhenShown(void (*handler)(uint32_t value), uint32_t value);
 
   void displayON();
-  void setCursor(unsigned char, unsigned char);
-  int print(const char *text);
+
+  /**
+   * Upload a custom glyph into a CGRAM slot. The glyphs already uploaded are
+   * cached, so uploading the glyph a slot already holds costs no I2C
+   * transfer. Print the glyph with LCD_GLYPH_CHAR(slot). The cursor must be
+   * set again before printing after an upload.
+   *   @param slot   CGRAM slot (0 to 7).
+   *   @param glyph  8 rows of 5 dots, the leftmost dot in bit 4.
+   *   @return true if the glyph was uploaded, false if the slot already held
+   * it or does not exist.
+   */
+  bool createChar(unsigned char slot, const char glyph[LCD_GLYPH_ROWS]);
+
+  /**
+   * Upload the partial cell glyphs used by renderBar() into slots 0-3.
+   */
+  void loadBarGlyphs();
+
+  /**
+   * Render a horizontal bar graph of value out of maxValue into a text
+   * buffer, with LCD_BAR_STEPS sub-steps per cell. loadBarGlyphs() must have
+   * been called.
+   *   @param text      Buffer to write cells characters into. No null
+   * terminator is written.
+   *   @param cells     Number of cells of the bar.
+   *   @param value     Value shown by the bar, limited to 0 to maxValue.
+   *   @param maxValue  Value of a full bar.
+   */
+  static void renderBar(char *text, int cells, int value, int maxValue);
 
 
-  /** Set RGB color of backlight
+  /** Set RGB color of backlight. Does nothing on a model without one.
    *   @param r Value for the red component of the RGB backlight (Between 0 and
    * 255).
    *   @param g Value for the green component of the RGB backlight (Between 0
@@ -114,19 +191,341 @@ public:
   // Send command to display
   void sendCommand(char value);
 
-  // Set register value
+  /**
+   * Set a backlight controller register. The values written to registers
+   * 0x00-0x08 are cached, and a write of the value a register already holds
+   * is dropped. Does nothing on a model without a backlight controller.
+   */
   void setReg(char addr, char val);
 
+  /**
+   * Number of backlight register writes sent over I2C, and dropped because
+   * the register already held the value. Each write sent is RGB_WRITE_BYTES
+   * bytes on the bus.
+   */
+  unsigned int backlightWrites() const { return _regWrites; }
+  unsigned int backlightWritesElided() const { return _regWritesElided; }
+
+protected:
+  /**
+   * @param bus        Bus manager of the I2C pins the display is on.
+   * @param lines      Number of rows of the panel.
+   * @param charsize   The size in dots that the display has.
+   * @param frequency  I2C bus frequency requested by begin().
+   * @param backlight  Whether the model has the RGB backlight controller.
+   */
+  CSE321_LCDController(I2CBus *bus, unsigned char lines,
+                       unsigned char charsize, int frequency, bool backlight);
+
+  // clear the display and move the cursor to DDRAM address 0. Also undoes
+  // any display shift
+  void clearDisplay();
+
+  // undo any display shift and move the cursor to DDRAM address 0, without
+  // clearing the display
+  void returnHome();
+
+  // queue a shift of the display by a number of columns, in as few I2C
+  // transfers as the bus payload allows. The controller shifts one column
+  // per command, so every command is a control byte with Co = 1 and a shift
+  // command. direction is LCD_MOVELEFT or LCD_MOVERIGHT
+  void shiftDisplay(int columns, unsigned char direction);
+
+  // queue a move of the cursor to a DDRAM address
+  void setAddress(unsigned char address);
+
+  // queue characters to write at the cursor, in one I2C transfer
+  void sendData(const char *values, int count);
+
+  // cursor position, and whether it is known (it is not after a CGRAM write)
+  unsigned char _cursorCol;
+  unsigned char _cursorRow;
+  bool _cursorKnown;
+
 private:
   unsigned char _addr;
   unsigned char _displayfunction;
   unsigned char _displaycontrol;
   unsigned char _displaymode;
-  unsigned char _cols;
-  unsigned char _rows;
+  unsigned char _lines;
   unsigned char _charsize;
   unsigned char _backlightval;
+  bool _backlight;
+
+  // requested and probed I2C bus frequency, and bus traffic counters
+  int _requestedFrequency;
+  int _frequency;
+  unsigned int _transactions;
+  unsigned int _busBytes;
+
+  // every transaction goes through here to be counted. A write that does not
+  // wait is queued on the bus, and merged with the data writes queued after
+  // it when it is a data write itself
+  int busWrite(int address, const char *data, int length, bool wait = true);
+
+  // backlight register cache: the value of each register, and a bit per
+  // register written
+  char _regValues[RGB_REG_COUNT];
+  unsigned short _regsKnown;
+  unsigned int _regWrites;
+  unsigned int _regWritesElided;
+
+  // glyph cache: the glyph of each CGRAM slot, and a bit per slot uploaded
+  char _glyphs[LCD_GLYPH_SLOTS][LCD_GLYPH_ROWS];
+  unsigned char _glyphsLoaded;
+
+  // bus manager that owns the I2C peripheral, and the clients of the text
+  // and backlight on it
+  I2CBus *_bus;
+  int _textClient;
+  int _backlightClient;
+};
+
+/**
+ * This is the driver for the Liquid Crystal LCD displays that use the I2C bus.
+ *
+ * The geometry and model of the panel are template parameters, so the row
+ * addresses and bounds checks are constants, and the text shown is kept in an
+ * array of exactly the size of the panel. 16x2, 20x4 and 40x2 panels are
+ * driven as CSE321_LCD<16, 2>, CSE321_LCD<20, 4> and CSE321_LCD<40, 2>.
+ *
+ * Panels of 1 or 2 rows only show Cols of the 40 characters of each DDRAM
+ * line. The rest of the line holds further pages of Cols columns, which are
+ * written while hidden and brought into view by shifting the display. A
+ * 16x2 panel has two pages: DDRAM columns 0-15 and 16-31.
+ *
+ * After creating an instance of this class, first call begin() before anything
+ * else. The backlight is on by default, since that is the most likely operating
+ * mode in most cases.
+ */
+template <unsigned char Cols, unsigned char Rows, unsigned char Model = LCD1802>
+class CSE321_LCD : public CSE321_LCDController {
+  static_assert(Cols > 0 && Rows > 0 && Rows <= LCD_MAX_ROWS,
+                "the controller drives 1 to 4 rows");
+  static_assert(Rows <= 2 ? Cols <= LCD_DDRAM_LINE
+                          : 2 * Cols <= LCD_DDRAM_LINE,
+                "the rows of the panel do not fit in the DDRAM lines");
+  static_assert(Model == LCD1602 || Model == LCD1802,
+                "the model is LCD1602 or LCD1802");
+
+  static constexpr unsigned char Pages = Rows <= 2 ? LCD_DDRAM_LINE / Cols : 1;
+
+public:
+  static constexpr unsigned char cols() { return Cols; }
+  static constexpr unsigned char rows() { return Rows; }
+  static constexpr unsigned char model() { return Model; }
+
+  /**
+   * Number of pages of Cols columns side by side in a DDRAM line. Panels of
+   * 4 rows show both DDRAM lines already, so they have one page.
+   */
+  static constexpr unsigned char pages() { return Pages; }
+
+  /** DDRAM address of the first cell of a row. */
+  static constexpr unsigned char rowAddress(unsigned char row) {
+    return ((row & 1) ? LCD_LINE2_ADDRESS : 0) + (row >= 2 ? Cols : 0);
+  }
+
+  /**
+   * Constructor
+   *
+   * @param charsize  The size in dots that the display has, use LCD_5x10DOTS or
+   * LCD_5x8DOTS.
+   * @param sda       Pin to use for SDA connection of I2C for LCD
+   * @param scl       Pin to use for the SCL connection of I2C for LCD
+   * @param frequency I2C bus frequency requested by begin(), use
+   * LCD_I2C_STANDARD, LCD_I2C_FAST or LCD_I2C_FAST_PLUS.
+   */
+  explicit CSE321_LCD(unsigned char charsize = LCD_5x8DOTS, PinName sda = PB_9,
+                      PinName scl = PB_8, int frequency = LCD_I2C_STANDARD)
+      // a bus of its own, for the lifetime of the program
+      : CSE321_LCDController(new I2CBus(sda, scl), Rows, charsize, frequency,
+                             Model == LCD1802) {
+    forgetShown();
+  }
+
+  /**
+   * Constructor for a display on a shared I2C bus. The display text and the
+   * backlight are added to the bus as two clients: text at DisplayPriority,
+   * so that sensor transactions go first, and the backlight at
+   * ControlPriority. The constructor above creates a bus of its own.
+   *
+   * @param bus       Bus manager of the I2C pins the display is on.
+   * @param charsize  The size in dots that the display has.
+   * @param frequency I2C bus frequency requested by begin().
+   */
+  explicit CSE321_LCD(I2CBus &bus, unsigned char charsize = LCD_5x8DOTS,
+                      int frequency = LCD_I2C_STANDARD)
+      : CSE321_LCDController(&bus, Rows, charsize, frequency,
+                             Model == LCD1802) {
+    forgetShown();
+  }
+
+  /**
+   * Set the LCD display in the correct begin state, must be called before
+   * anything else is done.
+   */
+  void begin() {
+    CSE321_LCDController::begin();
+    forgetShown();
+  }
+
+  /**
+   * Remove all the characters currently shown. Next print/write operation will
+   * start from the first position on LCD display.
+   */
+  void clear() {
+    clearDisplay();
+    forgetShown();
+  }
+
+  /**
+   * Move the cursor. A column or row outside the panel is limited to the last
+   * column or row. Columns are those of page 0.
+   */
+  void setCursor(unsigned char col, unsigned char row) {
+    if (row >= Rows) {
+      row = Rows - 1;
+    }
+    if (col >= Cols) {
+      col = Cols - 1;
+    }
+    moveCursor(col, row);
+  }
+
+  /**
+   * Move the cursor to a position known at compile time. A position outside
+   * the panel does not compile.
+   */
+  template <unsigned char Col, unsigned char Row> void setCursor() {
+    static_assert(Col < Cols && Row < Rows, "the cursor is outside the panel");
+    moveCursor(Col, Row);
+  }
+
+  int print(const char *text) { //output a string to the LCD
+    while (*text) {
+      write(*text++);
+    }
+    return 0;
+  }
+
+  /**
+   * Write a single character at the cursor. Unlike print(), this can write
+   * the glyph of CGRAM slot 0.
+   */
+  void write(char value) { writeData(&value, 1); }
+
+  /**
+   * Rewrite only the cells of a row that differ from what the display
+   * currently shows. Each run of changed cells costs one cursor move and one
+   * I2C transfer; unchanged cells cost nothing.
+   *   @param row   Row to update.
+   *   @param text  New text of the row. Cells past the end of text or past
+   * the last column are left as they are.
+   *   @return Number of cells written.
+   */
+  int updateRow(unsigned char row, const char *text) {
+    return updatePage(0, row, text);
+  }
+
+  /**
+   * updateRow() for a row of any page, whether or not the page is in view.
+   *   @param page  Page to update, from 0 to pages() - 1.
+   *   @param row   Row to update.
+   *   @param text  New text of the row of the page.
+   *   @return Number of cells written.
+   */
+  int updatePage(unsigned char page, unsigned char row, const char *text) {
+    if (page >= pages() || row >= Rows) {
+      return 0;
+    }
+
+    int first = page * Cols; // DDRAM column of the first cell of the page
+    int written = 0;
+    int col = 0;
+    while (col < Cols && text[col]) {
+      if (_shown[row][first + col] == text[col]) {
+        col++;
+        continue;
+      }
+
+      // find the end of the run of changed cells
+      int end = col + 1;
+      while (end < Cols && text[end] &&
+             _shown[row][first + end] != text[end]) {
+        end++;
+      }
+
+      if (!_cursorKnown || _cursorRow != row || _cursorCol != first + col) {
+        moveCursor(first + col, row);
+      }
+      writeData(text + col, end - col);
+      written += end - col;
+      col = end;
+    }
+    return written;
+  }
+
+  /**
+   * Bring a page into view by shifting the display. The text of every page
+   * stays in DDRAM, so no character is sent: page 0 costs one return home
+   * command, and any other page one I2C transfer of shift commands, in the
+   * direction that needs fewer.
+   *   @param page  Page to show, from 0 to pages() - 1.
+   */
+  void showPage(unsigned char page) {
+    if (page >= pages() || page == _page) {
+      return;
+    }
+    if (page == 0) {
+      returnHome();
+    } else {
+      // columns to shift left, around the 40 column DDRAM line
+      int left = ((page - _page) * Cols + LCD_DDRAM_LINE) % LCD_DDRAM_LINE;
+      if (left <= LCD_DDRAM_LINE / 2) {
+        shiftDisplay(left, LCD_MOVELEFT);
+      } else {
+        shiftDisplay(LCD_DDRAM_LINE - left, LCD_MOVERIGHT);
+      }
+    }
+    _page = page;
+  }
+
+  /** The page in view. */
+  unsigned char page() const { return _page; }
+
+private:
+  // characters currently in the DDRAM of every page, for updatePage()
+  char _shown[Rows][Pages * Cols];
+
+  // the page in view
+  unsigned char _page;
+
+  // after a clear, every cell is blank and the display is not shifted
+  void forgetShown() {
+    memset(_shown, ' ', sizeof(_shown));
+    _page = 0;
+  }
+
+  void moveCursor(unsigned char col, unsigned char row) {
+    setAddress(rowAddress(row) + col);
+    _cursorCol = col;
+    _cursorRow = row;
+    _cursorKnown = true;
+  }
 
-  // MBED I2C object used to transfer data to LCD
-  I2C i2c;
-};
\ No newline at end of file
+  // write characters at the cursor in one I2C transfer. Past the last column
+  // of the last page the controller carries on into DDRAM that is not
+  // tracked, or that is shown on another row of a 4 row panel, so the cursor
+  // is no longer known
+  void writeData(const char *values, int count) {
+    sendData(values, count);
+    for (int i = 0; i < count && _cursorKnown; i++) {
+      if (_cursorCol < pages() * Cols) {
+        _shown[_cursorRow][_cursorCol++] = values[i];
+      } else {
+        _cursorKnown = false;
+      }
+    }
+  }
+};
@@ -0,0 +1,166 @@
+/******************************************************************************
+ *   File Name:      GpioPin.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This library replaces hand-written GPIO register masks with pins that
+ *         are described by template parameters.  Every MODER, BSRR and IDR
+ *         mask is computed at compile time, and every output change is a
+ *         single store to the BSRR register of the port.  It is shared by
+ *         Project 2 and Project 3.
+ *
+ *       A read-modify-write of ODR (GPIOC->ODR |= 0x200) can be interrupted
+ *         between its read and its write by an ISR that changes another pin
+ *         of the same port, and the ISR's change is then overwritten.  A BSRR
+ *         store sets and clears only the pins of its mask, in one access, so
+ *         it cannot lose a concurrent change.
+ *
+ *       Every mask is a constant expression.  The main programs check the
+ *         masks of their pins against the hand-written masks they replaced
+ *         with static_assert.  The code size has not been compared with the
+ *         hand-written masks: to compare it, build the program both ways and
+ *         compare the text size that arm-none-eabi-size reports.
+ ******************************************************************************
+ *   Usage:
+ *       typedef Pin<PortC, 9> RangeTrigger;
+ *       RangeTrigger::configureOutput();       enable the port clock, set MODER
+ *       RangeTrigger::set();                   drive high
+ *       RangeTrigger::clear();                 drive low
+ *
+ *       typedef PinGroup<Pin<PortE, 2>, Pin<PortE, 4>> Rows;
+ *       Rows::configureOutputs();
+ *       Rows::set();                           drive every pin of the group high
+ *       Rows::select(1);                       drive pin 1 of the group high and every other pin low
+ *       Rows::write(levels);                   drive the pins in levels high and every other pin of the group low
+ *
+ *   Constraints:
+ *       The pins of a PinGroup must share one GPIO port.
+ *       PinName values follow the STM32 layout: a PinName is (port << 4) | pin.
+ *       On a host build, the registers are the register models of the POSIX
+ *         backend of Hal.h, and a BSRR store updates the modelled ODR.
+ *
+ *   References:
+ *       NUCLEO datasheet:          https://www.st.com/resource/en/reference_manual/dm00310109-stm32l4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+ *
+ ******************************************************************************/
+
+#ifndef GPIO_PIN_H
+#define GPIO_PIN_H
+
+#include "Hal.h"
+
+//GPIO port aliases.  The value is the index of the port from port A
+enum GpioPort : uint32_t {PortA, PortB, PortC, PortD, PortE, PortF, PortG, PortH, PortI};
+
+//the registers of a port, from the HAL
+inline GPIO_TypeDef* gpioPort(GpioPort port){return halGpioPort(port);}
+
+
+/**
+ * Pin<GpioPort Port, int Number>
+ *
+ * A single GPIO pin.  All members are static, so a pin is used through its type and takes no memory.
+ */
+template<GpioPort Port, int Number>
+struct Pin {
+    static_assert(Number >= 0 && Number < 16, "GPIO pin numbers are 0 to 15");
+
+    static constexpr GpioPort port(){return Port;}
+    static constexpr uint32_t mask(){return 1u << Number;}                          //the BSRR set bit and IDR bit of the pin
+    static constexpr uint32_t modeMask(){return 0x3u << (2 * Number);}              //the MODER bits of the pin
+    static constexpr uint32_t outputModeMask(){return 0x1u << (2 * Number);}        //the MODER value of the pin as a general purpose output
+    static constexpr PinName name(){return static_cast<PinName>((Port << 4) | Number);}    //the Mbed name of the pin, for InterruptIn and DigitalOut
+
+    static GPIO_TypeDef* gpio(){return gpioPort(Port);}
+
+    //enables the clock of the port and configures the pin as an output.  Setup only: MODER is read-modify-written
+    static void configureOutput(){
+        RCC->AHB2ENR |= 1u << Port;
+        gpio()->MODER = (gpio()->MODER & ~modeMask()) | outputModeMask();
+    }
+
+    static void set()  {gpio()->BSRR = mask();}                 //drive the pin high
+    static void clear(){gpio()->BSRR = mask() << 16;}           //drive the pin low
+    static void write(bool high){gpio()->BSRR = high ? mask() : mask() << 16;}
+    static bool read() {return gpio()->IDR & mask();}
+};
+
+
+/**
+ * PinGroup<typename... Pins>
+ *
+ * A group of Pins on one GPIO port.  The position of a pin in the group is its index, which the keypad driver
+ *   uses as the row or column.  Writes to the group change every pin of the group with one BSRR store.
+ */
+template<typename... Pins>
+struct PinGroup {
+    static constexpr int count = sizeof...(Pins);
+    static_assert(sizeof...(Pins) > 0, "a PinGroup needs at least one pin");
+
+    static constexpr uint32_t bits[sizeof...(Pins)] = {Pins::mask()...};     //the BSRR set bit and IDR bit of each pin
+    static constexpr PinName names[sizeof...(Pins)] = {Pins::name()...};     //the Mbed name of each pin
+    static const uint32_t selections[sizeof...(Pins)];                       //the BSRR value that drives only one pin of the group high, for each pin
+
+    static constexpr uint32_t bit(int index){return bits[index];}
+    static constexpr PinName name(int index){return names[index];}
+
+    //the BSRR set bits and IDR bits of every pin in the group
+    static constexpr uint32_t mask(){
+        uint32_t pinBits = 0;
+        for(int i = 0; i < count; i++) pinBits |= bits[i];
+        return pinBits;
+    }
+
+    //the MODER bits of every pin in the group, and their value as general purpose outputs
+    static constexpr uint32_t modeMask(){
+        uint32_t modeBits = 0;
+        for(uint32_t pin = 0; pin < 16; pin++){
+            if(mask() & (1u << pin)) modeBits |= 0x3u << (2 * pin);
+        }
+        return modeBits;
+    }
+    static constexpr uint32_t outputModeMask(){return modeMask() & 0x55555555u;}
+
+    //the port of the first pin, and whether every pin shares it
+    static constexpr GpioPort port(){return portOf<Pins...>();}
+    static constexpr bool onePort(){return samePort<Pins...>();}
+
+    static GPIO_TypeDef* gpio(){
+        static_assert(onePort(), "the pins of a PinGroup must share one GPIO port");
+        return gpioPort(port());
+    }
+
+    //the BSRR value that drives the pins in levels high and every other pin of the group low
+    static constexpr uint32_t bsrr(uint32_t levels){return ((mask() & ~levels) << 16) | (levels & mask());}
+
+    //enables the clock of the port and configures every pin as an output.  Setup only: MODER is read-modify-written
+    static void configureOutputs(){
+        RCC->AHB2ENR |= 1u << port();
+        gpio()->MODER = (gpio()->MODER & ~modeMask()) | outputModeMask();
+    }
+
+    static void set()  {gpio()->BSRR = mask();}                 //drive every pin of the group high
+    static void clear(){gpio()->BSRR = mask() << 16;}           //drive every pin of the group low
+    static void write(uint32_t levels){gpio()->BSRR = bsrr(levels);}
+    static void select(int index){gpio()->BSRR = selections[index];}  //drive only the pin at index high.  One table load, no mask arithmetic at run time
+    static uint32_t read(){return gpio()->IDR & mask();}
+
+private:
+    template<typename First, typename... Rest>
+    static constexpr GpioPort portOf(){return First::port();}
+
+    template<typename First>
+    static constexpr bool samePort(){return true;}
+    template<typename First, typename Second, typename... Rest>
+    static constexpr bool samePort(){return First::port() == Second::port() && samePort<Second, Rest...>();}
+};
+template<typename... Pins>
+constexpr uint32_t PinGroup<Pins...>::bits[sizeof...(Pins)];
+template<typename... Pins>
+constexpr PinName PinGroup<Pins...>::names[sizeof...(Pins)];
+template<typename... Pins>
+const uint32_t PinGroup<Pins...>::selections[sizeof...(Pins)] = {PinGroup<Pins...>::bsrr(Pins::mask())...};
+
+#endif
@@ -0,0 +1,83 @@
+/******************************************************************************
+ *   File Name:      Hal.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       The hardware abstraction layer of the shared libraries and of
+ *         Project 3.  Code includes Hal.h instead of mbed.h, and uses only the
+ *         part of the Mbed OS API listed below, so that it builds both for the
+ *         NUCLEO and on a Linux host.
+ *
+ *       On the NUCLEO (the mbed backend), Hal.h is mbed.h and the functions
+ *         below are inline wrappers of the registers and the RTC.  On a host,
+ *         CSE321_HOST is defined and Hal.h is the POSIX backend in
+ *         "Project 3/host/posix", which implements the same API with POSIX
+ *         threads and register models.
+ ******************************************************************************
+ *   The HAL:
+ *       GPIO          DigitalOut, DigitalIn, and the GPIO port, RCC and EXTI registers
+ *                       through halGpioPort(index), RCC and EXTI
+ *       Interrupts    InterruptIn, core_util_critical_section_enter/exit,
+ *                       core_util_atomic_load/store/incr_u32
+ *       Time          Timer, Ticker, Timeout, LowPowerTicker, LowPowerTimeout, wait_us,
+ *                       wait_ns, thread_sleep_for, Kernel::Clock, ThisThread::sleep_for,
+ *                       the RTC through halRtcRead, halRtcSubsecondUs and halRtcWrite, and the core cycle
+ *                       counter through halCycleCounterStart and halCycles, which count
+ *                       SystemCoreClock cycles per second
+ *       Threads       Thread, Mutex, Semaphore, EventQueue (call, call_in, call_every,
+ *                       cancel, dispatch_forever)
+ *       Buses         I2C
+ *       System        Watchdog, ResetReason
+ *
+ *   Constraints:
+ *       Code that uses a part of the Mbed OS API outside this list builds for
+ *         the NUCLEO only, until the POSIX backend implements it.
+ *
+ *   References:
+ *       MBED OS API:    https://os.mbed.com/docs/mbed-os/v6.15/apis/index.html
+ *
+ ******************************************************************************/
+
+#ifndef HAL_H
+#define HAL_H
+
+#ifdef CSE321_HOST
+
+#include "HalPosix.h"
+
+#else
+
+#include "mbed.h"
+#include <ctime>
+
+//the registers of a GPIO port, by index from port A.  GPIO ports are spaced evenly from port A
+inline GPIO_TypeDef* halGpioPort(uint32_t index){return reinterpret_cast<GPIO_TypeDef*>(GPIOA_BASE + index * (GPIOB_BASE - GPIOA_BASE));}
+
+//the on-chip RTC, in seconds since the epoch
+inline time_t halRtcRead(){return time(NULL);}
+inline void halRtcWrite(time_t seconds){set_time(seconds);}
+
+//the time into the current RTC second, in microseconds, to the resolution of the synchronous prescaler (1/256 s
+//with the LSE).  The subsecond register counts down from PREDIV_S to 0 through each second.  Reading it freezes
+//the calendar shadow registers until the date register is read
+inline uint32_t halRtcSubsecondUs(){
+    uint32_t predivS = RTC->PRER & RTC_PRER_PREDIV_S;
+    uint32_t subseconds = RTC->SSR;
+    (void)RTC->DR;
+    if(subseconds > predivS) return 0;          //a shift of the second is in progress
+    return (uint32_t)((unsigned long long)(predivS - subseconds) * 1000000 / (predivS + 1));
+}
+
+//the DWT cycle counter of the core.  It counts core clock cycles and wraps every 2^32 cycles
+inline void halCycleCounterStart(){
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;     //enable the trace units, of which the DWT is one
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+inline uint32_t halCycles(){return DWT->CYCCNT;}
+
+#endif
+
+#endif
@@ -0,0 +1,316 @@
+/******************************************************************************
+ *   File Name:      I2CBus.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       Implementation of the I2CBus transaction queue.  See I2CBus.h.
+ ******************************************************************************/
+
+#include "I2CBus.h"
+#include <cstring>
+
+I2CBus::I2CBus(PinName sda, PinName scl)
+    : i2c(sda, scl), busThread(osPriorityAboveNormal, 1536),
+      slotsFree(I2CBusQueueDepth, I2CBusQueueDepth), requestsQueued(0, I2CBusQueueDepth) {}
+
+
+/**
+ * int addClient(const char* name, Priority priority)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function adds a client of the bus.  Every transaction of the client is queued with its priority.
+ *
+ * Parameters:
+ *    - name     - the name of the client in the statistics printout
+ *    - priority - the priority of the transactions of the client
+ *
+ * Return value:
+ *    The client id, or -1 if the bus already has I2CBusMaxClients clients
+ */
+int I2CBus::addClient(const char* name, Priority priority){
+    queueLock.lock();
+    int client = clientCount < I2CBusMaxClients ? clientCount++ : -1;
+    if(client >= 0){
+        clients[client] = {name, priority, 0, 0, 0, 0};
+    }
+    queueLock.unlock();
+    return client;
+}
+
+
+//queue a write and wait for it.  Returns 0 if the transaction was acknowledged
+int I2CBus::write(int client, int address, const char* data, int length){
+    return submit(WriteRequest, client, address, data, length, 0, nullptr, true);
+}
+
+//queue a read and wait for it.  Returns 0 if the transaction was acknowledged
+int I2CBus::read(int client, int address, char* data, int length){
+    return submit(ReadRequest, client, address, nullptr, length, 0, data, true);
+}
+
+//queue a write and return at once.  The write may be merged with the writes queued right after it with the same prefix
+void I2CBus::post(int client, int address, const char* data, int length, int mergePrefix){
+    submit(WriteRequest, client, address, data, length, mergePrefix, nullptr, false);
+}
+
+//wait for every transaction the client queued before this call
+void I2CBus::flush(int client){
+    submit(FlushRequest, client, 0, nullptr, 0, 0, nullptr, true);
+}
+
+//call handler(value) on the bus thread once every transaction the client queued before this call is complete, without waiting
+void I2CBus::notify(int client, void (*handler)(uint32_t value), uint32_t value){
+    submit(NotifyRequest, client, 0, nullptr, (int)value, 0, nullptr, false, handler);
+}
+
+int I2CBus::setFrequency(int client, int hz){
+    return submit(FrequencyRequest, client, 0, nullptr, hz, 0, nullptr, true);
+}
+
+
+/**
+ * int submit(RequestKind kind, int client, int address, const char* data, int length, int mergePrefix, char* readBuffer, bool wait,
+ *            void (*notifyHandler)(uint32_t value))
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function copies a transaction into a free request entry and wakes the bus thread.  If wait is set, it
+ *      blocks until the transaction is complete.
+ *    The bus thread is started by the first transaction.
+ *
+ * Parameters:
+ *    - kind        - the kind of the transaction
+ *    - client      - the client id
+ *    - address     - the 8-bit I2C address
+ *    - data        - the payload of a write, copied into the entry
+ *    - length      - the payload or read length, the frequency of a FrequencyRequest, or the value of a NotifyRequest
+ *    - mergePrefix - leading payload bytes shared by writes that may be merged, or 0
+ *    - readBuffer  - the destination of a read
+ *    - wait        - true to block until the transaction is complete
+ *    - notifyHandler - the function a NotifyRequest calls on the bus thread
+ *
+ * Return value:
+ *    The result of a waited transaction: 0 if it was acknowledged.  0 for a posted write
+ */
+int I2CBus::submit(RequestKind kind, int client, int address, const char* data, int length, int mergePrefix, char* readBuffer, bool wait,
+                   void (*notifyHandler)(uint32_t value)){
+    if(kind == WriteRequest && (length > I2CBusMaxPayload || length < 0)) return -1;
+
+    Semaphore done(0, 1);
+    int result = 0;
+    slotsFree.acquire();            //wait for a free request entry
+    queueLock.lock();
+    if(!started){
+        started = true;
+        busClock.start();
+        busThread.start(callback(this, &I2CBus::run));
+    }
+
+    int slot = 0;
+    while(requests[slot].inUse) slot++;     //a free entry exists, as one was acquired from slotsFree
+    Request& request = requests[slot];
+    request.inUse = true;
+    request.taken = false;
+    request.kind = kind;
+    request.client = client;
+    request.mergePrefix = mergePrefix;
+    request.address = address;
+    request.length = length;
+    request.sequence = nextSequence++;
+    request.queuedUs = busClock.elapsed_time().count();
+    if(kind == WriteRequest) memcpy(request.payload, data, length);
+    request.readBuffer = readBuffer;
+    request.notifyHandler = notifyHandler;
+    request.done = wait ? &done : nullptr;
+    request.result = &result;
+    clients[client].transactions++;
+    requestsQueued.release();       //before the queue is unlocked, so that a merge of the request always finds its token
+    queueLock.unlock();
+
+    if(!wait) return 0;
+
+    done.acquire();                 //the entry may be reused once done is released, so the result is kept on this stack
+    return result;
+}
+
+
+/**
+ * int selectNext()
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function finds the queued request to run next: the highest client priority, and of those the first queued.
+ *    queueLock must be held.
+ *
+ * Return value:
+ *    The index of the request, or -1 if none is queued
+ */
+int I2CBus::selectNext(){
+    int next = -1;
+    for(int i = 0; i < I2CBusQueueDepth; i++){
+        if(!requests[i].inUse || requests[i].taken) continue;
+        if(next < 0){
+            next = i;
+            continue;
+        }
+        Priority priority = clients[requests[i].client].priority;
+        Priority nextPriority = clients[requests[next].client].priority;
+        if(priority < nextPriority || (priority == nextPriority && requests[i].sequence - requests[next].sequence > 0x80000000u)){
+            next = i;
+        }
+    }
+    return next;
+}
+
+
+/**
+ * int nextInQueueOrder(uint32_t afterSequence)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function finds the queued request that was queued right after a sequence number, of any client.
+ *    queueLock must be held.
+ *
+ * Return value:
+ *    The index of the request, or -1 if none was queued after it
+ */
+int I2CBus::nextInQueueOrder(uint32_t afterSequence){
+    int next = -1;
+    uint32_t nextDistance = 0;
+    for(int i = 0; i < I2CBusQueueDepth; i++){
+        if(!requests[i].inUse || requests[i].taken) continue;
+        uint32_t distance = requests[i].sequence - afterSequence;
+        if(distance == 0 || distance > 0x80000000u) continue;          //queued before or at afterSequence
+        if(next < 0 || distance < nextDistance){
+            next = i;
+            nextDistance = distance;
+        }
+    }
+    return next;
+}
+
+
+/**
+ * void run()
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function runs on the bus thread.  For each queued request, it selects the next request, merges the posted
+ *      writes queued right after a mergeable write, runs the transaction, records the queueing delay of every merged
+ *      request and completes them.
+ *
+ * Parameters:
+ *    None
+ *
+ * Return value:
+ *    None
+ */
+void I2CBus::run(){
+    char batch[I2CBusMaxPayload];
+    int batched[I2CBusQueueDepth];
+
+    while(true){
+        requestsQueued.acquire();
+        queueLock.lock();
+        int head = selectNext();
+        if(head < 0){                   //the token of a request that was merged into an earlier batch
+            queueLock.unlock();
+            continue;
+        }
+        Request& request = requests[head];
+        int batchCount = 0;
+        batched[batchCount++] = head;
+
+        int batchLength = 0;
+        if(request.kind == WriteRequest){
+            memcpy(batch, request.payload, request.length);
+            batchLength = request.length;
+        }
+
+        //merge the posted writes queued right after a mergeable write, to the same address with the same prefix
+        int prefix = request.mergePrefix;
+        uint32_t last = request.sequence;
+        while(request.kind == WriteRequest && prefix > 0 && !request.done){
+            int next = nextInQueueOrder(last);
+            if(next < 0) break;
+            Request& candidate = requests[next];
+            if(candidate.kind != WriteRequest || candidate.done || candidate.client != request.client ||
+               candidate.address != request.address || candidate.mergePrefix != prefix ||
+               memcmp(candidate.payload, request.payload, prefix) != 0 ||
+               batchLength + candidate.length - prefix > I2CBusMaxPayload){
+                break;
+            }
+            memcpy(batch + batchLength, candidate.payload + prefix, candidate.length - prefix);
+            batchLength += candidate.length - prefix;
+            last = candidate.sequence;
+            batched[batchCount++] = next;
+            clients[request.client].batched++;
+            requestsQueued.try_acquire();       //the merged request will not be run on its own
+        }
+
+        //mark the batch as taken so that it is not selected again while the transaction runs, and record its queueing delay
+        long long startUs = busClock.elapsed_time().count();
+        for(int i = 0; i < batchCount; i++){
+            requests[batched[i]].taken = true;
+            ClientStatistics& client = clients[requests[batched[i]].client];
+            unsigned int delayUs = startUs - requests[batched[i]].queuedUs;
+            client.totalQueueDelayUs += delayUs;
+            if(delayUs > client.maxQueueDelayUs) client.maxQueueDelayUs = delayUs;
+        }
+        queueLock.unlock();
+
+        //run the transaction without holding the queue, so that clients can keep queueing
+        int result = 0;
+        switch(request.kind){
+            case WriteRequest:     result = i2c.write(request.address, batch, batchLength); break;
+            case ReadRequest:      result = i2c.read(request.address, request.readBuffer, request.length); break;
+            case FrequencyRequest: i2c.frequency(request.length); break;
+            case FlushRequest:     break;
+            case NotifyRequest:    request.notifyHandler((uint32_t)request.length); break;
+        }
+
+        queueLock.lock();
+        for(int i = 0; i < batchCount; i++){
+            Request& completed = requests[batched[i]];
+            completed.inUse = false;
+            if(completed.done){
+                *completed.result = result;
+                completed.done->release();
+            }
+            slotsFree.release();
+        }
+        queueLock.unlock();
+    }
+}
+
+
+//returns a copy of the statistics of a client
+I2CBus::ClientStatistics I2CBus::statistics(int client){
+    queueLock.lock();
+    ClientStatistics copy = clients[client];
+    queueLock.unlock();
+    return copy;
+}
+
+
+/**
+ * void printStatistics()
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function prints the transactions, batched writes, and average and longest queueing delay of every client.
+ *
+ * Outputs:
+ *    Serial printout
+ */
+void I2CBus::printStatistics(){
+    printf("I2C client\tpriority\ttransactions\tbatched\tavg wait us\tmax wait us\n");
+    for(int i = 0; i < clientCount; i++){
+        ClientStatistics client = statistics(i);
+        unsigned long long averageUs = client.transactions ? client.totalQueueDelayUs / client.transactions : 0;
+        printf("%-14s\t%d\t\t%u\t\t%u\t%llu\t\t%u\n", client.name, client.priority, client.transactions, client.batched, averageUs, client.maxQueueDelayUs);
+    }
+}
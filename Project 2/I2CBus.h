@@ -0,0 +1,132 @@
+/******************************************************************************
+ *   File Name:      I2CBus.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This library owns an I2C peripheral and serializes the transactions
+ *         of several clients on a dedicated bus thread.  It is shared by
+ *         Project 2 and Project 3, where the LCD text and the LCD backlight
+ *         are clients, and an I2C sensor on the same pins would be another.
+ *
+ *       Every transaction is queued with the priority of its client.  When
+ *         the bus is free, the highest priority transaction that has waited
+ *         the longest goes next, so a sensor read never waits behind a queue
+ *         of display text.  Transactions of one client run in the order
+ *         they were queued.
+ *
+ *       Posted writes return at once.  A posted write that declares a merge
+ *         prefix is batched with the writes queued right after it that go to
+ *         the same address with the same prefix: the payloads after the
+ *         prefix are sent as one transaction.  For the LCD, the prefix is the
+ *         data control byte 0x40, after which every byte is a character.
+ ******************************************************************************
+ *   Usage:
+ *       I2CBus bus(PB_9, PB_8);
+ *       int sensor = bus.addClient("ToF sensor", I2CBus::SensorPriority);
+ *       bus.write(sensor, address, data, length)     wait for the transaction, returns 0 on acknowledge
+ *       bus.read(sensor, address, data, length)      wait for the transaction, returns 0 on acknowledge
+ *       bus.post(client, address, data, length, 1)   queue a write with a one byte merge prefix and return
+ *       bus.flush(client)                            wait for the posted writes of a client
+ *       bus.notify(client, handler, value)           call handler(value) on the bus thread once the
+ *                                                      posted writes of a client are on the bus
+ *       bus.printStatistics()                        transactions and queueing delay of every client
+ *
+ *   Constraints:
+ *       Writes are copied into the queue, up to I2CBusMaxPayload bytes each.
+ *       A caller blocks in post while all I2CBusQueueDepth entries are queued.
+ *       The bus thread is started by the first transaction, not at construction.
+ *
+ *   References:
+ *       MBED OS API: I2C           https://os.mbed.com/docs/mbed-os/v6.15/apis/i2c.html
+ *       MBED OS API: Semaphore     https://os.mbed.com/docs/mbed-os/v6.15/apis/semaphore.html
+ *
+ ******************************************************************************/
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include "Hal.h"
+
+#define I2CBusQueueDepth  16    /* transactions that can wait for the bus */
+#define I2CBusMaxPayload  48    /* bytes of one queued write, and of a batch of merged writes */
+#define I2CBusMaxClients  6     /* clients that can be added to a bus */
+
+
+/**
+ * I2CBus
+ *
+ * A priority-ordered, batching I2C transaction queue with per-client queueing delay statistics.
+ */
+class I2CBus {
+public:
+    //client priorities, highest first
+    enum Priority : uint8_t {SensorPriority, ControlPriority, DisplayPriority};
+
+    //transaction counts and queueing delay of a client
+    struct ClientStatistics {
+        const char* name;
+        Priority priority;
+        unsigned int transactions;          //transactions queued by the client
+        unsigned int batched;               //posted writes merged into the transaction of an earlier write
+        unsigned long long totalQueueDelayUs;   //time from queueing to the start of the transaction, summed
+        unsigned int maxQueueDelayUs;       //the longest queueing delay
+    };
+
+    I2CBus(PinName sda, PinName scl);
+
+    int  addClient(const char* name, Priority priority);   //returns the client id, or -1 if there are I2CBusMaxClients
+    int  write(int client, int address, const char* data, int length);
+    int  read(int client, int address, char* data, int length);
+    void post(int client, int address, const char* data, int length, int mergePrefix = 0);
+    void flush(int client);
+    void notify(int client, void (*handler)(uint32_t value), uint32_t value);
+    int  setFrequency(int client, int hz);                  //changes the bus frequency between transactions.  Returns 0
+
+    ClientStatistics statistics(int client);
+    void printStatistics();
+
+private:
+    enum RequestKind : uint8_t {WriteRequest, ReadRequest, FrequencyRequest, FlushRequest, NotifyRequest};
+
+    //a queued transaction
+    struct Request {
+        bool inUse;
+        bool taken;                     //the bus thread is running the request
+        RequestKind kind;
+        uint8_t client;
+        uint8_t mergePrefix;            //leading payload bytes shared by writes that may be merged, or 0
+        int address;
+        int length;                     //payload or read length, the frequency of a FrequencyRequest, or the value of a NotifyRequest
+        uint32_t sequence;              //queueing order
+        long long queuedUs;             //bus clock time at which the request was queued
+        char payload[I2CBusMaxPayload];
+        char* readBuffer;               //destination of a ReadRequest
+        void (*notifyHandler)(uint32_t value);  //called by the bus thread when it reaches a NotifyRequest
+        Semaphore* done;                //released when a waiting request completes, or nullptr for a posted write
+        int* result;                    //set to 0 if a waiting request was acknowledged
+    };
+
+    int  submit(RequestKind kind, int client, int address, const char* data, int length, int mergePrefix, char* readBuffer, bool wait,
+                void (*notifyHandler)(uint32_t value) = nullptr);
+    int  selectNext();
+    int  nextInQueueOrder(uint32_t afterSequence);
+    void run();
+
+    I2C i2c;
+    Thread busThread;
+    bool started = false;
+    Timer busClock;                             //time base of the queueing delays
+
+    Mutex queueLock;                            //protects the requests, the sequence counter and the statistics
+    Semaphore slotsFree;                        //free request entries
+    Semaphore requestsQueued;                   //requests waiting for the bus thread
+    Request requests[I2CBusQueueDepth] = {};
+    uint32_t nextSequence = 0;
+
+    int clientCount = 0;
+    ClientStatistics clients[I2CBusMaxClients] = {};
+};
+
+#endif
@@ -0,0 +1,609 @@
+/******************************************************************************
+ *   File Name:      KeypadMatrix.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This library drives a matrix keypad with row outputs on a single GPIO
+ *         port and one interrupt input per column.  It is shared by Project 2
+ *         and Project 3.
+ *
+ *       While no key is pressed, every row is driven high so that any press
+ *         raises a rising edge on its column.  The row of the key is resolved
+ *         with a single scan in the interrupt.  Contact bounce is absorbed by
+ *         masking the EXTI line of a column for a short time after an edge and
+ *         by a per key bounce window.  Accepted presses, releases, long presses
+ *         and repeats of a held key are delivered as timestamped key events,
+ *         either to a callback or into a KeyEventRing.  With latency probes
+ *         built in (LatencyProbe.h), an event also carries the cycle counter
+ *         of its edge, so the time from the edge to its handling can be
+ *         recorded.
+ ******************************************************************************
+ *   Usage:
+ *       PinGroup<Pin<PortC, 8>, ...>           row outputs, first row first
+ *       PinGroup<Pin<PortC, 0>, ...>           column inputs, first column first
+ *
+ *       KeypadMatrix<RowPins, ColPins> keypad(keyValues, driverQueue, timing);
+ *         keyValues    - the character of each key, indexed [column][row]
+ *         driverQueue  - event queue on which debounce and event delivery run.
+ *                          It must be dispatched by a thread.
+ *         timing       - KeypadTiming with scan, mask, bounce and hold times
+ *
+ *       keypad.attach(handler)                          deliver to a callback
+ *       keypad.attach(ring, consumerQueue, consumer)    deliver into a ring
+ *       keypad.start()
+ *
+ *   Constraints:
+ *       All rows must be on the same GPIO port, so that rows are switched
+ *         with single atomic writes to its BSRR register.
+ *       Column inputs must be on distinct pin numbers, as each pin number
+ *         shares one EXTI line across ports.
+ *       No more than one key should be pressed at a time.
+ *
+ *   References:
+ *       NUCLEO datasheet:          https://www.st.com/resource/en/reference_manual/dm00310109-stm32l4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+ *       MBED OS API: InterruptIn   https://os.mbed.com/docs/mbed-os/v6.15/apis/interruptin.html
+ *
+ ******************************************************************************/
+
+#ifndef KEYPAD_MATRIX_H
+#define KEYPAD_MATRIX_H
+
+#include "Hal.h"
+#include "GpioPin.h"
+#include "LatencyProbe.h"
+#include <chrono>
+#include <utility>
+
+//key event aliases
+enum KeyEventType {KeyPress, KeyRelease, KeyLongPress, KeyRepeat};
+
+//a key event delivered by the keypad driver
+struct KeyEvent {
+    KeyEventType type;                  //what happened to the key
+    char key;                           //the character of the key
+    Kernel::Clock::time_point time;     //the Kernel clock time of the edge or hold that caused the event
+    uint32_t cycles;                    //the latencyStamp() of the edge or hold that caused the event.  0 unless CSE321_LATENCY_PROBES is set
+};
+
+//keypad timing configuration
+struct KeypadTiming {
+    std::chrono::microseconds scanSettleTime;   //time for a column input to follow a row output through a closed key
+    std::chrono::microseconds edgeMaskTime;     //time that a column EXTI line stays masked after an edge, absorbing the rest of a bounce burst
+    std::chrono::milliseconds debounceWindow;   //default bounce window of each key.  Edges closer than this to the last accepted edge of the key are ignored
+    std::chrono::milliseconds longPressTime;    //time that a key must be held before a long press event is delivered
+    std::chrono::milliseconds repeatPeriod;     //time between repeat events while a key remains held after a long press
+};
+
+
+/**
+ * KeyEventRing<int Size>
+ *
+ * A lock-free single producer, single consumer ring of key events.  The head is only written by the producer
+ *   and the tail only by the consumer, each with atomic accesses, so no mutex is required.
+ */
+template<int Size>
+class KeyEventRing {
+    static_assert(Size > 0 && (Size & (Size - 1)) == 0, "KeyEventRing size must be a power of two");
+public:
+    //adds an event to the ring.  Called only by the producer.  The event is dropped and counted if the ring is full
+    void publish(KeyEvent event){
+        uint32_t currentHead = head;                //only written by the producer
+        if(currentHead - core_util_atomic_load_u32(&tail) == Size){
+            droppedEvents++;                        //the consumer has fallen a full ring behind
+            return;
+        }
+        entries[currentHead % Size] = event;
+        core_util_atomic_store_u32(&head, currentHead + 1);    //make the entry visible to the consumer only after it is written
+    }
+
+    //removes the oldest event from the ring.  Called only by the consumer.  Returns false if the ring was empty
+    bool consume(KeyEvent* event){
+        uint32_t currentTail = tail;                //only written by the consumer
+        if(currentTail == core_util_atomic_load_u32(&head)) return false;
+        *event = entries[currentTail % Size];
+        core_util_atomic_store_u32(&tail, currentTail + 1);    //release the entry to the producer only after it is copied
+        return true;
+    }
+
+    //the number of events that did not fit in the ring
+    unsigned int dropped() const {return droppedEvents;}
+
+private:
+    KeyEvent entries[Size];
+    volatile uint32_t head = 0;         //the number of events published
+    volatile uint32_t tail = 0;         //the number of events consumed
+    unsigned int droppedEvents = 0;     //accessed solely by the producer
+};
+
+
+/**
+ * KeypadMatrix<typename RowPins, typename ColPins>
+ *
+ * A matrix keypad driver.  RowPins and ColPins are PinGroups.  The interrupt handlers of every column are
+ *   generated at compile time from the column index.
+ */
+template<typename RowPins, typename ColPins>
+class KeypadMatrix {
+public:
+    static constexpr int Rows = RowPins::count;
+    static constexpr int Cols = ColPins::count;
+    static constexpr int AllRows = -1;      //vccRow value while every row is driven high, waiting for any key press
+
+    static_assert(RowPins::onePort(), "keypad rows must share one GPIO port for atomic BSRR row switching");
+
+    //edge and event counters of a column
+    struct EdgeCounters {
+        unsigned int edgesReceived;     //edge interrupts taken on the column
+        unsigned int edgesRecovered;    //edges that were missed while the column was masked and reported when it was re-enabled
+        unsigned int eventsEnqueued;    //edges enqueued on the driver queue
+        unsigned int eventsDropped;     //edges that did not fit in the driver queue
+    };
+
+    KeypadMatrix(const char (&keyValues)[Cols][Rows + 1], EventQueue& driverQueue, const KeypadTiming& timing, PinMode columnMode = PullDown)
+        : KeypadMatrix(keyValues, driverQueue, timing, columnMode, std::make_index_sequence<Cols>()) {}
+
+    //delivers key events by calling handler on the driver queue thread
+    void attach(Callback<void(KeyEvent)> handler){
+        eventHandler = handler;
+        notifyQueue = nullptr;
+    }
+
+    //delivers key events into ring and enqueues a call of consumer on consumerQueue after each
+    template<int Size>
+    void attach(KeyEventRing<Size>& ring, EventQueue& consumerQueue, void (*consumer)()){
+        eventHandler = callback(&ring, &KeyEventRing<Size>::publish);
+        notifyQueue = &consumerQueue;
+        notifyHandler = consumer;
+    }
+
+    void start();
+    void setDebounceWindow(int column, int row, std::chrono::milliseconds window){debounceWindow[column][row] = window;}
+    char pressedKey() const {return pressed;}      //the character of the key that is currently pressed, or '\0'
+    EdgeCounters edgeCounters(int column) const;
+
+private:
+    template<size_t... Columns>
+    KeypadMatrix(const char (&keyValues)[Cols][Rows + 1], EventQueue& driverQueue, const KeypadTiming& timing, PinMode columnMode, std::index_sequence<Columns...>)
+        : keyValues(keyValues), driverQueue(driverQueue), timing(timing),
+          columns{{ColPins::name(Columns), columnMode}...},
+          unmaskCallbacks{callback(this, &KeypadMatrix::unmaskIsr<Columns>)...} {
+        for(int column = 0; column < Cols; column++){
+            for(int row = 0; row < Rows; row++) debounceWindow[column][row] = timing.debounceWindow;
+        }
+        int attached[] = {0, (columns[Columns].rise(callback(this, &KeypadMatrix::riseIsr<Columns>)),
+                              columns[Columns].fall(callback(this, &KeypadMatrix::fallIsr<Columns>)), 0)...};
+        (void)attached;
+    }
+
+    //compile-time generated interrupt handlers of each column
+    template<int Column> void riseIsr()  {filterColumnEdge(Column, true);}
+    template<int Column> void fallIsr()  {filterColumnEdge(Column, false);}
+    template<int Column> void unmaskIsr(){unmaskColumnEdges(Column);}
+
+    static uint32_t extiLine(int column){return ColPins::bit(column);}     //EXTI line n serves pin n of every port
+
+    int  resolvePressedRow(int column);
+    void enterIdle();
+    void filterColumnEdge(int column, bool isRisingEdge);
+    void reportColumnEdge(int column, bool isRisingEdge);
+    void unmaskColumnEdges(int column);
+    void handleColumnRise(int column);
+    void handleColumnFall(int column);
+    void enqueueEdge(bool isRisingEdge, int column, int row, Kernel::Clock::time_point edgeTime, uint32_t edgeCycles);
+
+    void handleEdge(bool isRisingEdge, int column, int row, Kernel::Clock::time_point edgeTime, uint32_t edgeCycles);
+    void confirmRelease(int column, int row);
+    void releaseKey(int column, int row, Kernel::Clock::time_point releaseTime, uint32_t releaseCycles);
+    void signalHeld(int column, int row, KeyEventType heldEventType);
+    void deliver(KeyEventType type, char key, Kernel::Clock::time_point time, uint32_t cycles);
+
+    const char (&keyValues)[Cols][Rows + 1];    //the character of each key, indexed [column][row]
+    EventQueue& driverQueue;                    //queue on which edges are debounced and events are delivered
+    KeypadTiming timing;
+
+    InterruptIn columns[Cols];                  //column inputs, indexed by column
+    Timeout columnMaskTimeouts[Cols];           //one-shot timers that re-enable the EXTI line of each column
+    Callback<void()> unmaskCallbacks[Cols];     //unmaskIsr of each column
+    int columnReportedLevel[Cols] = {0};        //the level of each column after the last reported edge.  Accessed solely in ISR context
+
+    volatile unsigned int edgesReceived[Cols] = {0};
+    volatile unsigned int edgesRecovered[Cols] = {0};
+    volatile unsigned int eventsEnqueued[Cols] = {0};
+    volatile unsigned int eventsDropped[Cols] = {0};
+
+    volatile int vccRow = AllRows;              //the row currently driven, or AllRows.  Shared with the column ISRs, modified by enterIdle within a critical section
+
+    //accessed solely on the driver queue thread
+    char pressed = '\0';
+    int pressedColumn = 0;
+    int pressedRow = 0;
+    Kernel::Clock::time_point lastKeyEdgeTime[Cols][Rows];
+    std::chrono::milliseconds debounceWindow[Cols][Rows];
+    int holdEventId = 0;
+
+    Callback<void(KeyEvent)> eventHandler;
+    EventQueue* notifyQueue = nullptr;
+    void (*notifyHandler)() = nullptr;
+};
+
+
+/**
+ * void start()
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function enables the clock of the row port, configures the rows as outputs and drives every row high
+ *      so that the first key press raises an interrupt.
+ *
+ * Parameters:
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    Digital high DC output signal on every row
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::start(){
+    RowPins::configureOutputs();     //enable the clock of the row port and configure the rows as outputs
+    enterIdle();
+}
+
+
+/**
+ * EdgeCounters edgeCounters(int column)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function returns the edge and event counters of a column.  The difference between edges received and
+ *      events enqueued is the number of bounce edges suppressed in ISR context.
+ *
+ * Parameters:
+ *    - column - the column index
+ *
+ * Return value:
+ *    A copy of the counters.  They are written in ISR context and may advance while being copied.
+ */
+template<typename RowPins, typename ColPins>
+typename KeypadMatrix<RowPins, ColPins>::EdgeCounters KeypadMatrix<RowPins, ColPins>::edgeCounters(int column) const {
+    return {edgesReceived[column], edgesRecovered[column], eventsEnqueued[column], eventsDropped[column]};
+}
+
+
+/**
+ * int resolvePressedRow(int column)
+ * ISR function
+ *
+ * Summary of the function:
+ *    This function finds the row of a key that was pressed while every row was driven high.
+ *    Each row is driven high on its own in turn until the column input follows it.  The row that was found is left
+ *      driven so that the release of the key is seen as a falling edge on the column.
+ *    Edges raised on the column inputs by the scan itself are cleared from the EXTI pending register.
+ *
+ * Parameters:
+ *    - column - the column that raised the interrupt
+ *
+ * Return value:
+ *    The row of the pressed key, or AllRows if the column did not follow any row (the key was already released).
+ *    In that case every row is driven high again.
+ */
+template<typename RowPins, typename ColPins>
+int KeypadMatrix<RowPins, ColPins>::resolvePressedRow(int column){
+    int row = 0;
+    for(; row < Rows; row++){
+        RowPins::select(row);                       //drive only this row high
+        wait_us(timing.scanSettleTime.count());     //give the column input time to follow the row
+        if(columns[column].read()) break;
+    }
+    if(row == Rows){
+        row = AllRows;
+        RowPins::set();                         //no row found.  Go back to waiting for any key press
+    }
+
+    EXTI->PR1 = ColPins::mask();                //discard edges caused by switching the rows during the scan
+    return row;
+}
+
+
+/**
+ * void enterIdle()
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function drives every row high so that a press of any key raises a rising edge interrupt on its column.
+ *    If a column still reads high through the currently driven row (a key is held or bouncing), the row is kept.
+ *      The next edge on that column calls this function again.
+ *
+ * Parameters:
+ *    None
+ *
+ * Return value:
+ *    None
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::enterIdle(){
+    core_util_critical_section_enter();
+    bool columnHigh = false;
+    for(int column = 0; column < Cols; column++){
+        if(columns[column].read()) columnHigh = true;
+    }
+    if(!columnHigh){
+        vccRow = AllRows;
+        RowPins::set();                             //supply voltage to every row
+    }
+    core_util_critical_section_exit();
+}
+
+
+/**
+ * void filterColumnEdge(int column, bool isRisingEdge)
+ * ISR function
+ *
+ * Summary of the function:
+ *    This function is the first handler of every edge interrupt on a column.  The edge is counted and passed on
+ *      to reportColumnEdge.
+ *
+ * Parameters:
+ *    - column       - the column that raised the interrupt
+ *    - isRisingEdge - true for a rising edge
+ *
+ * Return value:
+ *    None
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::filterColumnEdge(int column, bool isRisingEdge){
+    edgesReceived[column]++;
+    reportColumnEdge(column, isRisingEdge);
+}
+
+
+/**
+ * void reportColumnEdge(int column, bool isRisingEdge)
+ * ISR function
+ *
+ * Summary of the function:
+ *    This function masks the EXTI line of a column and passes an edge on to the column edge handlers.
+ *    The line is re-enabled by a hardware timer after edgeMaskTime, so the remaining edges of a contact bounce
+ *      burst never raise an interrupt or take space in the driver queue.
+ *    The level that the edge leaves the column at is recorded so that unmaskColumnEdges can detect a missed final edge.
+ *
+ * Parameters:
+ *    - column       - the column of the edge
+ *    - isRisingEdge - true for a rising edge
+ *
+ * Return value:
+ *    None
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::reportColumnEdge(int column, bool isRisingEdge){
+    core_util_critical_section_enter();
+    EXTI->IMR1 &= ~extiLine(column);            //ignore further edges on this column until the bounce burst is over
+    core_util_critical_section_exit();
+    columnMaskTimeouts[column].attach(unmaskCallbacks[column], timing.edgeMaskTime);
+
+    columnReportedLevel[column] = isRisingEdge;
+    if(isRisingEdge) handleColumnRise(column);
+    else handleColumnFall(column);
+}
+
+
+/**
+ * void unmaskColumnEdges(int column)
+ * ISR function
+ *
+ * Summary of the function:
+ *    This function re-enables the EXTI line of a column once its mask time has passed.
+ *    Edges are not latched while the line is masked, so if the column now reads a different level than the last
+ *      reported edge left it at, the final edge of the burst was missed and is reported now.
+ *
+ * Parameters:
+ *    - column - the column to re-enable
+ *
+ * Return value:
+ *    None
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::unmaskColumnEdges(int column){
+    core_util_critical_section_enter();
+    EXTI->PR1 = extiLine(column);               //discard anything latched for this line before re-enabling it
+    EXTI->IMR1 |= extiLine(column);
+    core_util_critical_section_exit();
+
+    int level = columns[column].read();
+    if(level != columnReportedLevel[column]){
+        edgesRecovered[column]++;
+        reportColumnEdge(column, level);
+    }
+}
+
+
+/**
+ * void handleColumnRise(int column)
+ * ISR function
+ *
+ * Summary of the function:
+ *    This function enqueues a key press edge of a column.  While every row is driven, the row of the key is first
+ *      resolved with a single scan.  The Kernel clock time of the edge is taken here so that debounce is not
+ *      affected by queueing delay.
+ *
+ * Parameters:
+ *    - column - the column of the edge
+ *
+ * Return value:
+ *    None
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::handleColumnRise(int column){
+    Kernel::Clock::time_point edgeTime = Kernel::Clock::now();
+    uint32_t edgeCycles = latencyStamp();
+    if(vccRow == AllRows){
+        int row = resolvePressedRow(column);
+        if(row == AllRows) return;              //the key was released before it could be resolved
+        vccRow = row;
+    }
+    enqueueEdge(true, column, vccRow, edgeTime, edgeCycles);
+}
+
+
+/**
+ * void handleColumnFall(int column)
+ * ISR function
+ *
+ * Summary of the function:
+ *    This function enqueues a key release edge of a column.
+ *
+ * Parameters:
+ *    - column - the column of the edge
+ *
+ * Return value:
+ *    None
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::handleColumnFall(int column){
+    enqueueEdge(false, column, AllRows, Kernel::Clock::now(), latencyStamp());
+}
+
+
+//enqueues an edge on the driver queue, counting edges that do not fit
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::enqueueEdge(bool isRisingEdge, int column, int row, Kernel::Clock::time_point edgeTime, uint32_t edgeCycles){
+    if(driverQueue.call(this, &KeypadMatrix::handleEdge, isRisingEdge, column, row, edgeTime, edgeCycles)) eventsEnqueued[column]++;
+    else eventsDropped[column]++;
+}
+
+
+/**
+ * void handleEdge(bool isRisingEdge, int column, int row, Kernel::Clock::time_point edgeTime, uint32_t edgeCycles)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function converts a column edge into a key, handles duplicate edges due to bounce, and delivers press
+ *      and release events of filtered results.
+ *    An edge is treated as bounce if it arrives within the bounce window of that key after its last accepted press or release.
+ *    A release that is ignored as bounce is confirmed by reading the column again once the bounce window has passed.
+ *    A key held for longPressTime delivers a long press event followed by a repeat event every repeatPeriod.
+ *    Once no key is pressed, every row is driven again.
+ *
+ * Parameters:
+ *    - isRisingEdge - true for a press edge
+ *    - column       - the column of the edge
+ *    - row          - the row driven at the time of a press edge.  Not used for a release edge
+ *    - edgeTime     - the Kernel clock time at which the interrupt occured
+ *    - edgeCycles   - the latencyStamp() of the interrupt
+ *
+ * Return value:
+ *    None
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::handleEdge(bool isRisingEdge, int column, int row, Kernel::Clock::time_point edgeTime, uint32_t edgeCycles){
+    if(!isRisingEdge) row = pressedRow;         //a release belongs to the pressed key, whichever row is driven at the time of the edge
+    bool withinBounceWindow = edgeTime - lastKeyEdgeTime[column][row] < debounceWindow[column][row];
+
+    if(isRisingEdge){
+        if(!pressed && !withinBounceWindow){    //fail immediately if another key is pressed or this key was pressed or released recently
+            lastKeyEdgeTime[column][row] = edgeTime;
+            pressedColumn = column;
+            pressedRow = row;
+            pressed = keyValues[column][row];
+            deliver(KeyPress, pressed, edgeTime, edgeCycles);
+            holdEventId = driverQueue.call_in(timing.longPressTime, this, &KeypadMatrix::signalHeld, column, row, KeyLongPress);
+        }
+    }else if(pressed && column == pressedColumn){
+        if(!withinBounceWindow){
+            releaseKey(column, row, edgeTime, edgeCycles);
+        }else{
+            //the release may be bounce of the press or a very short press.  Check the column again once the bounce window has passed
+            std::chrono::milliseconds recheckDelay = debounceWindow[column][row] - (Kernel::Clock::now() - lastKeyEdgeTime[column][row]);
+            if(recheckDelay < std::chrono::milliseconds(0)) recheckDelay = std::chrono::milliseconds(0);   //the window may already have passed while the edge was queued
+            driverQueue.call_in(recheckDelay, this, &KeypadMatrix::confirmRelease, column, row);
+        }
+    }
+    if(!pressed) enterIdle();                   //wait for the next key press on every row
+}
+
+
+/**
+ * void confirmRelease(int column, int row)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function releases the pressed key if its column input no longer reads high.  It is called once the bounce
+ *      window of a press has passed if a release edge arrived within that window.
+ *
+ * Parameters:
+ *    - column - the column of the key
+ *    - row    - the row of the key
+ *
+ * Return value:
+ *    None
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::confirmRelease(int column, int row){
+    if(pressed == keyValues[column][row] && columns[column].read() == 0){
+        releaseKey(column, row, Kernel::Clock::now(), latencyStamp());
+    }
+    if(!pressed) enterIdle();                   //wait for the next key press on every row
+}
+
+
+/**
+ * void releaseKey(int column, int row, Kernel::Clock::time_point releaseTime, uint32_t releaseCycles)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function ends the press of the pressed key.  Its pending long press or repeat is cancelled and a release
+ *      event is delivered.
+ *
+ * Parameters:
+ *    - column        - the column of the key
+ *    - row           - the row of the key
+ *    - releaseTime   - the Kernel clock time of the accepted release
+ *    - releaseCycles - the latencyStamp() of the accepted release
+ *
+ * Return value:
+ *    None
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::releaseKey(int column, int row, Kernel::Clock::time_point releaseTime, uint32_t releaseCycles){
+    lastKeyEdgeTime[column][row] = releaseTime; //ignore bounce of the release as a new press
+    driverQueue.cancel(holdEventId);            //the key is no longer held.  Cancelling is safe as the hold event runs on this same thread
+    deliver(KeyRelease, pressed, releaseTime, releaseCycles);
+    pressed = '\0';
+}
+
+
+/**
+ * void signalHeld(int column, int row, KeyEventType heldEventType)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function delivers a long press or repeat event of a key that is still held, and schedules the next
+ *      repeat event repeatPeriod later.
+ *
+ * Parameters:
+ *    - column        - the column of the key
+ *    - row           - the row of the key
+ *    - heldEventType - KeyLongPress for the first event of a hold, KeyRepeat for every one after
+ *
+ * Return value:
+ *    None
+ */
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::signalHeld(int column, int row, KeyEventType heldEventType){
+    if(pressed != keyValues[column][row]) return;
+    deliver(heldEventType, pressed, Kernel::Clock::now(), latencyStamp());
+    holdEventId = driverQueue.call_in(timing.repeatPeriod, this, &KeypadMatrix::signalHeld, column, row, KeyRepeat);
+}
+
+
+//passes a key event to the attached callback or ring, and requests processing of a ring on its consumer queue
+template<typename RowPins, typename ColPins>
+void KeypadMatrix<RowPins, ColPins>::deliver(KeyEventType type, char key, Kernel::Clock::time_point time, uint32_t cycles){
+    if(eventHandler) eventHandler({type, key, time, cycles});
+    if(notifyQueue) notifyQueue->call(notifyHandler);   //may fail if the consumer queue is full.  The event stays in the ring and is processed with the events before it
+}
+
+#endif
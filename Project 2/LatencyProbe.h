@@ -0,0 +1,221 @@
+/******************************************************************************
+ *   File Name:      LatencyProbe.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This library measures the latency of a path through the program, such
+ *         as from an interrupt to the thread that handles it, with the cycle
+ *         counter of the core.  It is shared by Project 2 and Project 3.
+ *
+ *       A probe is stamped with the cycle counter where the path starts,
+ *         usually in an ISR, and records the cycles since the stamp where the
+ *         path ends.  Each probe keeps a log-bucketed histogram in RAM, in the
+ *         manner of an HDR histogram: values below 2^latencyPrecisionBits
+ *         cycles have a bucket each, and every power of two above is split
+ *         into 2^latencyPrecisionBits buckets, so a bucket is never wider than
+ *         1/8 of its values and every 32-bit value fits in 240 counters.
+ *         Recording a value is a count leading zeros, a shift and an add.
+ ******************************************************************************
+ *   Usage:
+ *       #define CSE321_LATENCY_PROBES 1        before the first include, or as a build macro
+ *
+ *       #if CSE321_LATENCY_PROBES
+ *       LatencyProbe echoProbe("echo fall -> process");
+ *       #endif
+ *
+ *       latencyCounterStart();                 once, at startup
+ *       LATENCY_START(echoProbe);              where the path starts, in an ISR or a thread
+ *       LATENCY_STOP(echoProbe);               where it ends: records the cycles since the start
+ *       LATENCY_RECORD(echoProbe, cycles);     where it ends, for a start stamped with latencyStamp()
+ *                                                and carried along the path, such as in an event
+ *       LatencyProbe::printAll();              the histogram of every probe, in microseconds
+ *
+ *   Constraints:
+ *       With CSE321_LATENCY_PROBES 0, the default, the LATENCY_ macros
+ *         compile to nothing, latencyStamp() is the constant 0 and no probe
+ *         should be declared, so the probes cost no code, time or RAM.
+ *       A probe has one start stamp.  A start that is not followed by a
+ *         stop, such as an enqueue that failed, is replaced by the next start.
+ *       The end of a path must be recorded by one thread at a time.  The
+ *         histograms may advance while they are printed.
+ *       The cycle counter wraps every 2^32 cycles, 35 seconds at 120 MHz, so
+ *         longer latencies are not measured.
+ *
+ *   References:
+ *       ARMv7-M Architecture Reference Manual, C1.8 The Data Watchpoint and Trace unit
+ *       HdrHistogram:              http://hdrhistogram.org
+ *
+ ******************************************************************************/
+
+#ifndef LATENCY_PROBE_H
+#define LATENCY_PROBE_H
+
+#include "Hal.h"
+#include <cstdint>
+#include <cstdio>
+
+#ifndef CSE321_LATENCY_PROBES
+#define CSE321_LATENCY_PROBES 0
+#endif
+
+#define latencyPrecisionBits 3      /* 8 buckets per power of two: each bucket is within 12.5% of its values */
+#define latencyBucketCount   ((32 - latencyPrecisionBits + 1) << latencyPrecisionBits)
+
+
+#if CSE321_LATENCY_PROBES
+inline void latencyCounterStart(){halCycleCounterStart();}
+inline uint32_t latencyStamp(){return halCycles();}
+
+#define LATENCY_START(probe)                 (probe).start()
+#define LATENCY_STOP(probe)                  (probe).stop()
+#define LATENCY_RECORD(probe, startCycles)   (probe).record(startCycles)
+#else
+inline void latencyCounterStart(){}
+inline uint32_t latencyStamp(){return 0;}
+
+#define LATENCY_START(probe)                 ((void)0)
+#define LATENCY_STOP(probe)                  ((void)0)
+#define LATENCY_RECORD(probe, startCycles)   ((void)0)
+#endif
+
+
+/**
+ * LatencyHistogram
+ *
+ * A log-bucketed histogram of 32-bit cycle counts, with the count, sum, smallest and largest value recorded.
+ */
+class LatencyHistogram {
+public:
+    //the bucket of a value: the value itself below 2^latencyPrecisionBits, then latencyPrecisionBits bits of
+    //the value below its leading one, after the index of the power of two
+    static int bucketOf(uint32_t cycles){
+        if(cycles < (1u << latencyPrecisionBits)) return cycles;
+        int magnitude = 31 - __builtin_clz(cycles);
+        int shift = magnitude - latencyPrecisionBits;
+        return ((shift + 1) << latencyPrecisionBits) + ((cycles >> shift) & ((1u << latencyPrecisionBits) - 1));
+    }
+
+    //the smallest and largest value of a bucket
+    static uint32_t bucketLow(int bucket){
+        if(bucket < (1 << latencyPrecisionBits)) return bucket;
+        int shift = (bucket >> latencyPrecisionBits) - 1;
+        return (uint32_t)((1u << latencyPrecisionBits) + (bucket & ((1 << latencyPrecisionBits) - 1))) << shift;
+    }
+    static uint32_t bucketHigh(int bucket){
+        int shift = bucket < (1 << latencyPrecisionBits) ? 0 : (bucket >> latencyPrecisionBits) - 1;
+        return bucketLow(bucket) + ((1u << shift) - 1);
+    }
+
+    void record(uint32_t cycles){
+        counts[bucketOf(cycles)]++;
+        if(total == 0 || cycles < smallest) smallest = cycles;
+        if(cycles > largest) largest = cycles;
+        sum += cycles;
+        total++;
+    }
+
+    //forgets every recorded value.  Not to be called while a value may be recorded
+    void reset(){
+        for(int bucket = 0; bucket < latencyBucketCount; bucket++) counts[bucket] = 0;
+        total = 0;
+        smallest = 0;
+        largest = 0;
+        sum = 0;
+    }
+
+    //the value that perMille of the recorded values do not exceed, to the largest value of its bucket
+    uint32_t percentile(unsigned int perMille) const {
+        unsigned long long rank = ((unsigned long long)total * perMille + 999) / 1000;     //ceiling
+        if(rank == 0) rank = 1;
+        unsigned long long seen = 0;
+        for(int bucket = 0; bucket < latencyBucketCount; bucket++){
+            seen += counts[bucket];
+            if(seen >= rank) return bucketHigh(bucket) < largest ? bucketHigh(bucket) : largest;
+        }
+        return largest;
+    }
+
+    uint32_t count() const {return total;}
+    uint32_t minimum() const {return smallest;}
+    uint32_t maximum() const {return largest;}
+    uint32_t mean() const {return total ? sum / total : 0;}
+
+private:
+    volatile uint32_t counts[latencyBucketCount] = {0};
+    volatile uint32_t total = 0;
+    volatile uint32_t smallest = 0;
+    volatile uint32_t largest = 0;
+    unsigned long long sum = 0;
+};
+
+
+/**
+ * LatencyProbe
+ *
+ * A named latency histogram with a start stamp.  Every probe adds itself to a list at construction, from which
+ *   printAll prints them in the reverse order of construction.
+ */
+class LatencyProbe {
+public:
+    explicit LatencyProbe(const char* name) : probeName(name), next(first()) {first() = this;}
+
+    //stamps the start of the path.  ISR safe
+    void start(){
+        startCycles = latencyStamp();
+        started = true;
+    }
+
+    //records the cycles since the start stamp, if there is one
+    void stop(){
+        if(!started) return;
+        started = false;
+        histogram.record(latencyStamp() - startCycles);
+    }
+
+    //records the cycles since a start stamped with latencyStamp()
+    void record(uint32_t startStamp){histogram.record(latencyStamp() - startStamp);}
+
+    const char* name() const {return probeName;}
+    const LatencyHistogram& values() const {return histogram;}
+
+    /**
+     * void printAll()
+     * non-ISR function
+     *
+     * Summary of the function:
+     *    This function prints the count and the smallest, mean, median, 90th, 99th, 99.9th percentile and largest
+     *      latency of every probe, in microseconds to two decimals.  The percentiles are the largest values of
+     *      their buckets, so they may read up to 1/8 high.
+     */
+    static void printAll(){
+        uint32_t cyclesPerUs = SystemCoreClock / 1000000;
+        printf("latency (us at %lu MHz)\t\tcount\tmin\tmean\tp50\tp90\tp99\tp99.9\tmax\n", (unsigned long)cyclesPerUs);
+        for(const LatencyProbe* probe = first(); probe; probe = probe->next){
+            const LatencyHistogram& values = probe->histogram;
+            uint32_t shown[] = {values.minimum(), values.mean(), values.percentile(500), values.percentile(900),
+                                values.percentile(990), values.percentile(999), values.maximum()};
+            printf("%-32s\t%lu", probe->probeName, (unsigned long)values.count());
+            for(uint32_t cycles : shown){
+                unsigned long long hundredths = (unsigned long long)cycles * 100 / cyclesPerUs;
+                printf("\t%lu.%02lu", (unsigned long)(hundredths / 100), (unsigned long)(hundredths % 100));
+            }
+            printf("\n");
+        }
+    }
+
+private:
+    static LatencyProbe*& first(){
+        static LatencyProbe* head = nullptr;
+        return head;
+    }
+
+    const char* probeName;
+    LatencyProbe* next;
+    volatile uint32_t startCycles = 0;
+    volatile bool started = false;
+    LatencyHistogram histogram;
+};
+
+#endif
@@ -2,39 +2,25 @@
 *   File Name:      cse321_project2_mnelyubo_main.cpp
 *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
 *   Date Created:   10/10/2021
-*   Last Modified:  10/27/2021
+*   Last Modified:  10/19/2026
 *   Purpose:        
 *               This program takes inputs from a 4x4 matrix keypad to control a timer.
 *               Timer mode-based text and input/remaining time are output to a connected LCD.
 *               
-*               The main function of the program initializes the system by configuring a set of four GPIO pins as
-*                 outputs to supply voltage to the keypad, assigning event handlers to the rising and falling edges 
-*                 of input interrupts that are connected to the keypad, and setting the initial timer mode to input.
-
-*               After the initialization is complete, the main function cycles through the four output channels, 
-*                 providing power to one channel at a time and proceeding to the next input after a short time interval 
-*                 in which no input keystroke is detected.  This allows a fast response time to any of the 16 keys and 
-*                 eliminates the opportunity for duplicate inputs to be detected due to a single key press.
+*               The main function of the program initializes the system by starting the shared KeypadMatrix driver,
+*                 which supplies voltage to the keypad rows and debounces the column interrupts on its own thread, 
+*                 and setting the initial timer mode to input.
+
+*               After the initialization is complete, the main function refreshes the LCD output at a short interval.
+*                 Key events are delivered by the keypad driver to handleKeyEvent as they occur.
 *               
 *   Functions:      
 *               populateLcdOutput
-*               handleMatrixButtonEvent
+*               handleKeyEvent
 *               handleInputKey
 *               tickCountdownTimer
-*               tickBounceHandler
 *               switchToCountdownMode
 *               
-*               The following set of functions are used as handlers for the 
-*                 rising and falling edge behaviors of keypad buttons:
-*                 * rising_isr_abc
-*                 * rising_isr_369
-*                 * rising_isr_258
-*                 * rising_isr_147
-*                 * falling_isr_abc
-*                 * falling_isr_369
-*                 * falling_isr_258
-*                 * falling_isr_147
-*               
 *   Assignment:     CSE321 Project 2
 *
 *   Inputs:         4x4 matrix array input buttons
@@ -51,6 +37,8 @@
 ******************************************************************************/
 #include "mbed.h"
 #include "1802.h"
+#include "KeypadMatrix.h"
+#include "GpioPin.h"
 #include <cstdio>
 #include <ctime>
 #include <string>
@@ -58,15 +46,6 @@
 #define COL 16
 #define ROW 2
 
-#define RisingEdgeInterrupt 1
-#define FallingEdgeInterrupt 0
-
-//Associated column values with their respective character key value index in the matrix
-#define ColABC 0
-#define Col369 1
-#define Col258 2
-#define Col147 3
-
 //dimension (row and column) of the Matrix keypad
 #define MatrixDim 4
 
@@ -89,32 +68,24 @@
 #define CountdownSecondsIndex 9
 
 //System Time Rates
-#define KeyPadHighInputCycleTime 5
-#define KeyPadFallingEdgeBufferTime 1
-#define bounceTimeoutWindow 100
+#define LcdRefreshCycleTime 5
+
+//Keypad timing
+#define keypadScanSettleTime 5us
+#define columnEdgeMaskTime 2ms
+#define bounceTimeoutWindow 100ms
+#define keyLongPressTime 600ms
+#define keyRepeatPeriod 200ms
 
 /****************************
   *  Function Declarations  *
   ***************************/
 
-////declare individual interrupt handler events for each column
-//declare rising edge interrupt handler events
-void rising_isr_abc(void);
-void rising_isr_369(void);
-void rising_isr_258(void);
-void rising_isr_147(void);
-
-//declare falling edge interrupt handler events
-void falling_isr_abc(void);
-void falling_isr_369(void);
-void falling_isr_258(void);
-void falling_isr_147(void);
-
 //output to LCD and configure LED states based on the mode
 void populateLcdOutput();
 
 //declare general handler for Matrix keypad input events
-void handleMatrixButtonEvent(int isRisingEdgeInterrupt, int column, int row);
+void handleKeyEvent(KeyEvent event);
 
 //injection point for the controller to handle the input with respect to the system state
 void handleInputKey(char inputKey);
@@ -122,9 +93,6 @@ void handleInputKey(char inputKey);
 //use a 1 Hz ticker to count down the remaining seconds
 void tickCountdownTimer();
 
-//tick down bounce handler
-void tickBounceHandler();
-
 //switch the system to Countdown Mode
 void switchToCountdownMode();
 
@@ -139,32 +107,13 @@ void switchToInputMode();
 //This value is used to determine which behaviors to perform when a key is pressed.
 int timerMode = InputMode;
 
-// This value is set to a defined (bounceTimeoutWindow) quantity of milliseconds when a button is pressed down.
-// This value is ticked down every millisecond by the function tickBounceHandler.
-// If the variable is accessed by handleMatrixButtonEvent while the value is positive, this indicates that a button press is most likely a duplicate.
-int bounceLockout = 0;
-
-//This value indicates the only row that is to be supplied power.
-//This value is used to determine which keypad input was pressed in the function handleMatrixButtonEvent().
-int keypadVccRow = 0;
-
 //Boolean flag to indicate if the output to the LCD needs to be refreshed.
 //The initial value is 1 to populate the display during startup.
 int outputChangesMade = true;
 
-//This (boolean) variable indicates if any button is currently pressed.
-//A value of 1 means some button is pressed and 0 means no button is pressed.
-//The polling of rows will be halted as long as this value is true.
-int buttonPressed = false;
-
-//The character on the input matrix keypad which is currently pressed down.  
-//The variable defaults to '\0' when no key is pressed.
-//system behavior is UNDEFINED when more than one key is pressed at the same time.
-char charPressed = '\0';    
-
-//The matrix of characters maps keypad rows/columns to their associated character
+//The matrix of characters maps keypad columns/rows to their associated character
 // MatrixDim + 1 used as second dimension because of null terminator in each string
-char keyValues[][MatrixDim + 1] = {"dcba","#963","0852","*741"};
+const char keyValues[][MatrixDim + 1] = {"dcba","#963","0852","*741"};
 
 //The LCD output matrix. Access strings as modeLCDvalues[definedMode + LcdLineIndex]
 //Each string must be exactly COL characters in length so that populateLcdOutput() 
@@ -180,138 +129,72 @@ char modeLCDvalues[ROW * ModeCount][COL] = {
   *   Global API Objects    *
   ***************************/
 
-CSE321_LCD lcdObject(COL,ROW);  //create interface to control the output LCD
+CSE321_LCD<COL, ROW> lcdObject;  //create interface to control the output LCD
 
-InterruptIn colLL(PC_0);    //declare the connection to pin PC_0 as a source of input interrupts, connected to the far left column of the matrix keypad
-InterruptIn colCL(PC_3);    //declare the connection to pin PC_3 as a source of input interrupts, connected to the center left column of the matrix keypad
-InterruptIn colCR(PC_1);    //declare the connection to pin PC_1 as a source of input interrupts, connected to the center right column of the matrix keypad
-InterruptIn colRR(PC_4);    //declare the connection to pin PC_4 as a source of input interrupts, connected to the far right column of the matrix keypad
+typedef Pin<PortB, 10> InputLed;                    //indicator LED that is on while a key is pressed
+typedef Pin<PortB, 11> AlarmLed;                    //indicator LEDs that are on while the timer is in Alarm Mode
+typedef PinGroup<InputLed, AlarmLed> IndicatorLeds;
+static_assert(IndicatorLeds::outputModeMask() == 0x500000 && IndicatorLeds::modeMask() == 0xF00000, "LED masks differ from the hand-written PB10, PB11 masks");
 
-Ticker countdownTicker;     //create a ticker that counts down the timer once per second
-Ticker bounceHandlerTicker; //create a ticker that handles input lockout to mitigate bounce
+Thread keypadThread;        //thread on which the keypad driver debounces key presses and delivers key events
+EventQueue keypadEventQueue(32 * EVENTS_EVENT_SIZE);    //queue of keypad driver events for the keypad thread to execute
 
-int main() {
-    RCC->AHB2ENR |= 0x6;    //enable RCC for GPIO ports B and C
+//keypad rows with labels *0#D (PC_8), 789C (PC_9), 456B (PC_10), 123A (PC_11)
+//keypad columns containing buttons a,b,c,d (PC_0), 3,6,9,# (PC_3), 2,5,8,0 (PC_1), 1,4,7,* (PC_4)
+typedef PinGroup<Pin<PortC, 8>, Pin<PortC, 9>, Pin<PortC, 10>, Pin<PortC, 11>> KeypadRows;
+typedef PinGroup<Pin<PortC, 0>, Pin<PortC, 3>, Pin<PortC, 1>, Pin<PortC, 4>> KeypadColumns;
+static_assert(KeypadRows::mask() == 0xF00 && KeypadRows::outputModeMask() == 0x550000, "keypad row masks differ from the hand-written PC8 - PC11 masks");
+KeypadMatrix<KeypadRows, KeypadColumns> keypad(keyValues, keypadEventQueue,
+    {keypadScanSettleTime, columnEdgeMaskTime, bounceTimeoutWindow, keyLongPressTime, keyRepeatPeriod});
 
-    GPIOC->MODER |= 0x550000;       //configugure GPIO pins PC8,PC9,PC10,PC11
-    GPIOC->MODER &= ~(0xAA0000);    //  as outputs
-
-    GPIOB->MODER |= 0x500000;       //configure GPIO pins PB10,PB11 as outputs
-    GPIOB->MODER &= ~(0xA00000);    //these will be used to control input/alarm indicator LEDs
-
-    colLL.rise(&rising_isr_abc);   //assign interrupt handler for a rising edge event from the column containing buttons a,b,c,d
-    colCL.rise(&rising_isr_369);   //assign interrupt handler for a rising edge event from the column containing buttons 3,6,9,#
-    colCR.rise(&rising_isr_258);   //assign interrupt handler for a rising edge event from the column containing buttons 2,5,8,0
-    colRR.rise(&rising_isr_147);   //assign interrupt handler for a rising edge event from the column containing buttons 1,4,7,*
+Ticker countdownTicker;     //create a ticker that counts down the timer once per second
 
-    colLL.fall(&falling_isr_abc);   //assign interrupt handler for a falling edge event from the column containing buttons a,b,c,d
-    colCL.fall(&falling_isr_369);   //assign interrupt handler for a falling edge event from the column containing buttons 3,6,9,#
-    colCR.fall(&falling_isr_258);   //assign interrupt handler for a falling edge event from the column containing buttons 2,5,8,0
-    colRR.fall(&falling_isr_147);   //assign interrupt handler for a falling edge event from the column containing buttons 1,4,7,*
+int main() {
+    IndicatorLeds::configureOutputs();  //enable RCC for GPIO port B and configure pins PB10,PB11 as outputs to control input/alarm indicator LEDs.  The keypad driver enables the port of its rows
 
     lcdObject.begin();              //initialize LCD
     populateLcdOutput();            //populate initial LCD text
-    
-    bounceHandlerTicker.attach(&tickBounceHandler, 1ms);    //Attach the function that ticks down milliseconds for the bounce lockout to eliminate duplicate events
-
-    while (1) {
-
-        //supply voltage to one output row at a time
-        switch (keypadVccRow){
-            case 0:
-                GPIOC->ODR |= 0x100;        //supply voltage to the row of keypad buttons with labels *0#D
-                break;
-            case 1:
-                GPIOC->ODR |= 0x200;        //supply voltage to the row of keypad buttons with labels 789C
-                break;
-            case 2:
-                GPIOC->ODR |= 0x400;        //supply voltage to the row of keypad buttons with labels 456B
-                break;
-            case 3:
-                GPIOC->ODR |= 0x800;        //supply voltage to the row of keypad buttons with labels 123A
-                break;
-        }
-
-        thread_sleep_for(KeyPadHighInputCycleTime);   //maintain power to the row for a brief period of time to account for bounce
 
-        //proceed to scanning the next input if and only if there is 
-        //  no closed loop in the current scan set
-        if(!buttonPressed){
-            GPIOC->ODR &= ~(0xF00);         //reset voltage to output 0 on all pins
+    keypad.attach(&handleKeyEvent);                                                 //deliver key events to handleKeyEvent on the keypad thread
+    keypadThread.start(callback(&keypadEventQueue, &EventQueue::dispatch_forever));  //run the keypad driver
+    keypad.start();                                                                 //supply voltage to every keypad row so that any key press raises an interrupt
 
-            thread_sleep_for(KeyPadFallingEdgeBufferTime);   //wait to give any falling edge triggers a chance to resolve before proceeding
-
-            keypadVccRow++;                          //update the row target to poll the next row
-            keypadVccRow%=MatrixDim;
-        }
-
-        populateLcdOutput();                //refresh the LCD output at the same rate as inputs are polled
+    while (1) {
+        thread_sleep_for(LcdRefreshCycleTime);  //refresh the LCD output at a short interval
+        populateLcdOutput();
     }
 
     return 0;
 }
 
 
-//The following set of functions are used as handlers for the rising and falling edge behaviors of keypad buttons.
-//All of the following eight functions serve to configure the inputs for handleMatrixButtonevent().
-void rising_isr_abc(void) {handleMatrixButtonEvent(RisingEdgeInterrupt,  ColABC, keypadVccRow);}
-void falling_isr_abc(void){handleMatrixButtonEvent(FallingEdgeInterrupt, ColABC, keypadVccRow);}
-void rising_isr_369(void) {handleMatrixButtonEvent(RisingEdgeInterrupt,  Col369, keypadVccRow);}
-void falling_isr_369(void){handleMatrixButtonEvent(FallingEdgeInterrupt, Col369, keypadVccRow);}
-void rising_isr_258(void) {handleMatrixButtonEvent(RisingEdgeInterrupt,  Col258, keypadVccRow);}
-void falling_isr_258(void){handleMatrixButtonEvent(FallingEdgeInterrupt, Col258, keypadVccRow);}
-void rising_isr_147(void) {handleMatrixButtonEvent(RisingEdgeInterrupt,  Col147, keypadVccRow);}
-void falling_isr_147(void){handleMatrixButtonEvent(FallingEdgeInterrupt, Col147, keypadVccRow);}
-
-
-
 /**
-* void handleMatrixButtonEvent
+* void handleKeyEvent
 * 
 * Summary of the function:
-*    This function converts an input event type, row, and column received 
-*    from an ISR handler into the character that is represented by that 
-*    button press, filters for duplicate inputs, and calls to handle the key press if appropriate.
+*    This function receives the debounced key events of the keypad driver, shows whether a key is pressed on the 
+*    input detection LED, and calls to handle the key press.
 *
 * Parameters:   
-*   - int isRisingEdgeInterrupt - 1 indicates that the button that triggered the event was pressed down, 0 indicates that the button was released
-*   - int column - 0-3 value indicating which column the event was detected on 
-*   - int row    - 0-3 value indicating which row the event occured in, based on which row is currently being supplied a voltage
+*   - KeyEvent event - the key event delivered by the keypad driver on the keypad thread
 *
 * Return value: None
 *
-* Outputs:      The input detection LED is turned on and off based on whether the incoming interrupt is riding or falling edge, displaying whether or not there is currently an input detected.
+* Outputs:      The input detection LED is turned on and off based on whether the key was pressed or released, displaying whether or not there is currently an input detected.
 *
 * Description:  
-*   This function will only update the state of the key press if there is no other key press currently detected.
-*   Two key presses of the same key in short sequence will be ignored to prevent duplicate event handlers from being launched.
-*   If a single non-conflicting key press or release is detected, the global variables charPressed and buttonPressed are set appropriately, and handleInputKey is called if the button was pressed.
+*   The keypad driver only delivers the press of a key while no other key is pressed, and ignores bounce within the bounce window.
+*   handleInputKey is called within a critical section, as it shares the timer mode and LCD strings with the countdown ticker interrupt.
+*   Long press and repeat events are not used by the timer.
 */
-void handleMatrixButtonEvent(int isRisingEdgeInterrupt, int column, int row){
-    char detectedKey = keyValues[column][row];      //fetch the char value associated with the index that was detected
-    if(isRisingEdgeInterrupt){
-
-        //prevent duplicate event creation if another button press was just detected
-        if(bounceLockout > 0){
-            return;
-        }
-
-        //enforce only one key being pressed down at a time
-        if(charPressed != '\0'){
-            return;
-        }
-        
-        buttonPressed = isRisingEdgeInterrupt;     //a rising edge interrupt occurs when a button is pressed.  Set to 1 to prevent further polling until key is released
-        bounceLockout = bounceTimeoutWindow;       //lock bounce timeout window after event is triggered to ignore duplicate events
-
-        GPIOB->ODR |= 0x400;                       //send signal High to pin PB10 to indicate that a button press is detected
-        charPressed = detectedKey;                 //set the global variable for the currently pressed character to the detected character
-        handleInputKey(charPressed);
-    }else{
-        if(detectedKey != charPressed) return;        //Ignore any key release inputs that are not the pressed key
-        GPIOB->ODR &= ~(0x400);                       //send signal Low to pin PB10 to indicate that a button release is detected
-        charPressed = '\0';                           //reset the char value to '\0' as the key has been released
-        buttonPressed = isRisingEdgeInterrupt;        //once the appropriate key has been verified, update button pressed state to resume polling
+void handleKeyEvent(KeyEvent event){
+    if(event.type == KeyPress){
+        InputLed::set();                           //send signal High to pin PB10 to indicate that a button press is detected
+        core_util_critical_section_enter();
+        handleInputKey(event.key);
+        core_util_critical_section_exit();
+    }else if(event.type == KeyRelease){
+        InputLed::clear();                         //send signal Low to pin PB10 to indicate that a button release is detected
     }
 }
 
@@ -507,9 +390,9 @@ void populateLcdOutput(){
 
     //update output LED state for alarm mode condition:
     if(timerMode == AlarmMode){
-        GPIOB->ODR |= 0x800;                       //send signal High to pin PB11 to indicate that the alarm is going off
+        AlarmLed::set();                           //send signal High to pin PB11 to indicate that the alarm is going off
     }else{
-        GPIOB->ODR &= ~(0x800);                       //send signal Low  to pin PB11 to indicate that the alarm is off
+        AlarmLed::clear();                         //send signal Low  to pin PB11 to indicate that the alarm is off
     }
 
     //refresh each line of the LCD display
@@ -575,24 +458,3 @@ void tickCountdownTimer(){
     //switch the timer to the Alarm Mode
     timerMode = AlarmMode;
 }
-
-/**
-* void tickBounceHandler
-* 
-* Summary of the function:
-*  This function counts down the bounce lockout in order to prevent duplicate events from being generated due to a single button press.
-*
-* Parameters:   None
-*
-* Return value: None
-*
-* Outputs:      None
-*
-* Description:  
-*   The global variable bounceLockout will cause button presses to be ignored when it is set to a value greater than 0
-*   bounceLockout will not be decremented for values less than zero to avoid an accidental lockout caused by an integer underflow 
-*/
-void tickBounceHandler(){
-    if(bounceLockout > 0)
-        bounceLockout--;
-}
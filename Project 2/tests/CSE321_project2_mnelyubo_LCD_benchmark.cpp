@@ -0,0 +1,132 @@
+/******************************************************************************
+*   File Name:      CSE321_project2_mnelyubo_LCD_benchmark.cpp
+*   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+*   Date Created:   10/19/2026
+*   Last Modified:  10/19/2026
+*   Purpose:        Measure the I2C throughput of the external LCD at each bus
+*                     frequency.  Built from the LCD test.
+*
+*   Functions:
+*               runBenchmark
+*
+*   Assignment:     CSE321 Project 2
+*
+*   Inputs:         None
+*
+*   Outputs:        LCD display, Serial printout
+*
+*   Constraints:    LCD must be connected to system
+*                   For each of 100 kHz, 400 kHz and 1 MHz, the bus frequency
+*                     is probed and the frequency in use is printed.  A lower
+*                     frequency than requested means the display or its
+*                     backlight controller did not acknowledge at the higher one.
+*                   Transactions/s and bytes/s are measured with single
+*                     character writes, each flushed before the next so that
+*                     the bus manager cannot merge them.  Writes are queued on
+*                     the I2C bus thread, so every timing waits for the queue
+*                     with flush().  Full-frame latency is measured for a
+*                     frame of both rows written one character per transaction
+*                     (as populateLcdOutput did) and written by updateRow.
+*
+*   References:
+*               https://www.st.com/resource/en/reference_manual/dm00310109-stm32l4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+*               MBED OS API: I2C   https://os.mbed.com/docs/mbed-os/v6.15/apis/i2c.html
+*
+******************************************************************************/
+#include "mbed.h"
+#include "I2CBus.h"
+#include "1802.h"
+#include <chrono>
+#include <cstdio>
+
+// #define COL 16
+// #define ROW 2
+
+// #define characterWrites 320         /* single character transactions timed at each frequency */
+// #define frameRepeats    20          /* full frames timed at each frequency, of each kind */
+
+// //create interface to output LCD, on a bus whose statistics are printed at the end
+// I2CBus i2cBus(PB_9, PB_8);
+// CSE321_LCD<COL, ROW> lcdObject(i2cBus);
+
+// Timer benchmarkTimer;
+
+// //two frames that differ in every cell, so that updateRow rewrites the whole display
+// const char frames[2][ROW][COL + 1] = {
+//     {"0123456789ABCDEF","FEDCBA9876543210"},
+//     {"abcdefghijklmnop","ponmlkjihgfedcba"}
+// };
+
+// void runBenchmark(int frequency);
+
+// int main() {
+//     lcdObject.begin();       //initialize LCD
+
+//     printf("\n\n== LCD I2C Benchmark ==\n");
+//     printf("requested\tin use\ttransactions/s\tbytes/s\tframe (print) us\tframe (updateRow) us\n");
+
+//     const int frequencies[] = {LCD_I2C_STANDARD, LCD_I2C_FAST, LCD_I2C_FAST_PLUS};
+//     for(int frequency : frequencies){
+//         runBenchmark(frequency);
+//     }
+//     lcdObject.setFrequency(LCD_I2C_STANDARD);
+//     i2cBus.printStatistics();
+
+//     while (1) {
+//         thread_sleep_for(1000);
+//     }
+
+//     return 0;
+// }
+
+// //probes a bus frequency and prints the throughput and frame latency at the frequency in use
+// void runBenchmark(int frequency){
+//     int inUse = lcdObject.setFrequency(frequency);
+//     if(!inUse){
+//         printf("%d\tno acknowledge\n", frequency);
+//         return;
+//     }
+
+//     //single character transactions
+//     lcdObject.setCursor(0, 0);
+//     unsigned int transactionsBefore = lcdObject.transactions();
+//     unsigned int bytesBefore = lcdObject.busBytes();
+//     benchmarkTimer.reset();
+//     benchmarkTimer.start();
+//     for(int i = 0; i < characterWrites; i++){
+//         if(i % COL == 0) lcdObject.setCursor(0, (i / COL) % ROW);
+//         lcdObject.write('0' + i % 10);
+//         lcdObject.flush();
+//     }
+//     benchmarkTimer.stop();
+//     long long elapsedUs = benchmarkTimer.elapsed_time().count();
+//     unsigned long long transactionsPerSecond = (lcdObject.transactions() - transactionsBefore) * 1000000ULL / elapsedUs;
+//     unsigned long long bytesPerSecond = (lcdObject.busBytes() - bytesBefore) * 1000000ULL / elapsedUs;
+
+//     //full frames, one character per queued write.  Adjacent writes may be merged by the bus manager
+//     benchmarkTimer.reset();
+//     benchmarkTimer.start();
+//     for(int i = 0; i < frameRepeats; i++){
+//         for(int line = 0; line < ROW; line++){
+//             lcdObject.setCursor(0, line);
+//             lcdObject.print(frames[i % 2][line]);
+//         }
+//     }
+//     lcdObject.flush();
+//     benchmarkTimer.stop();
+//     long long printFrameUs = benchmarkTimer.elapsed_time().count() / frameRepeats;
+
+//     //full frames through updateRow, one transaction per run of changed cells
+//     benchmarkTimer.reset();
+//     benchmarkTimer.start();
+//     for(int i = 0; i < frameRepeats; i++){
+//         for(int line = 0; line < ROW; line++){
+//             lcdObject.updateRow(line, frames[i % 2][line]);
+//         }
+//     }
+//     lcdObject.flush();
+//     benchmarkTimer.stop();
+//     long long updateFrameUs = benchmarkTimer.elapsed_time().count() / frameRepeats;
+
+//     printf("%d\t\t%d\t%llu\t\t%llu\t%lld\t\t\t%lld\n", frequency, inUse, transactionsPerSecond, bytesPerSecond, printFrameUs, updateFrameUs);
+// }
@@ -31,7 +31,7 @@
 
 
 // //create interface to output LCD
-// CSE321_LCD lcdObject(COL,ROW);
+// CSE321_LCD<COL, ROW> lcdObject;
 
 // int main() {
 //     lcdObject.begin();       //initialize LCD
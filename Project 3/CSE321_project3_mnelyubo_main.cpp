@@ -2,7 +2,7 @@
  *   File Name:      CSE321_project3_mnelyubo_main.cpp
  *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
  *   Date Created:   11/20/2021
- *   Last Modified:  12/03/2021
+ *   Last Modified:  10/19/2026
  ******************************************************************************
  *   Purpose:
  *       This program operates a distance sensor, buzzer, LCD, and matrix 
@@ -10,20 +10,29 @@
  *         container that can be taken home at closing time.
  ******************************************************************************
  *   Functions:      
- *      void alternateMatrixInput()
- *      void enqueueMatrixAlternation() (ISR)
- *
- *      void handleMatrixButtonEvent(bool isRisingEdgeInterrupt, int column, int row)
- *      void rising_isr_abc()  (ISR)
- *      void falling_isr_abc() (ISR)
- *      void rising_isr_369()  (ISR)
- *      void falling_isr_369() (ISR)
- *      void rising_isr_258()  (ISR)
- *      void falling_isr_258() (ISR)
- *      void rising_isr_147()  (ISR)
- *      void falling_isr_147() (ISR)
+ *      void configureSystem()
+ *      void startThreads()
+ *
+ *      void processKeyEvents()
+ *      void printKeypadEdgeCounters()
  *
  *      void handleInputKey(char charPressed)
+ *      void handleHeldKey(char keyHeld)
+ *      void applyUiTransition(char key, int keyClass)
+ *      void confirmRealTime(int entryState, char key)
+ *      void advanceRealTimeDay(int entryState, char key)
+ *      void confirmClosingTime(int entryState, char key)
+ *      void storeClosingDay(int entryState, char key)
+ *      void clearTimeInput(int entryState, char key)
+ *      void enterTimeDigit(int entryState, char key)
+ *      void scrollTimeDigit(int entryState, char key)
+ *      void confirmMaxDistance(int entryState, char key)
+ *      void confirmMinDistance(int entryState, char key)
+ *      void toggleAlarmArmed(int entryState, char key)
+ *      void returnToSetup(int entryState, char key)
+ *      void reportDiagnostics(int entryState, char key)
+ *      void fillUnsetTimeDigits(char* timeLine)
+ *      void storeClosingTimeInput(char* timeLine)
  *
  *      void pollDistanceSensor()
  *      void enqueuePoll() (ISR)
@@ -35,16 +44,40 @@
  *
  *      int updateStableDistance()
  *
- *      void tickRealTimeClock()
- *      void enqueueRTClockTick() (ISR)
+ *      int  readRealTimeOfWeek()
+ *      int  readRealTimeClock()
+ *      void setRealTimeClock(int weekday, int secondsOfDay)
+ *      int  parseTimeOfDay(const char* timeLine)
+ *      void renderTimeOfDay(char* timeLine, int secondsOfDay)
+ *      void renderWeekday(char* dayLine, int weekday)
  *
  *      void populateLcdOutput()
- *      void enqueueOutputRefresh() (ISR) 
- *      bool closingTimeCrossed()
+ *      void requestOutputRefresh(bool userInput)
+ *      void enqueueOutputRefresh(bool userInput) (ISR)
+ *      void drawCoalescedFrame()
+ *      void drawOnNewSecond()
+ *      void printDisplayRefreshStatistics()
+ *      void renderObserverDetails(int spaceValue, int timeOfWeek)
+ *      void rotateObserverPage()
+ *      int  computeSpaceValue()
+ *
+ *      void setBacklightStatus(int spaceValue, bool alarmActive)
+ *      void stepBacklightFade()
+ *
+ *      void scheduleClosingAlarm()
+ *      void enqueueAlarmScheduling() (ISR)
+ *      void updateAlarmOutput()
+ *      void enqueueAlarmUpdate() (ISR)
  *
  *      void alternateBuzzer()
  *      void runBuzzer()
  *
+ *      int compensatedBuzzerWait(int partNs, int overheadNs)
+ *
+ *      void kickWatchdog() (ISR)
+ *
+ *      void recordFrameShown(uint32_t frameStartCycles)
+ *
  ******************************************************************************
  *   Assignment:     Project 3
  *
@@ -89,6 +122,25 @@
  *   Additional Notes:
  *       A hardware watchdog timer reset is implemented in this function 
  *          to prevent a system reset if the input button is not stuck.
+ *          The watchdog is kicked from a low power ticker so that the main
+ *          thread can block indefinitely and the MCU can reach deep sleep.
+ *       Keypad bounce is filtered by comparing the Kernel clock time of each
+ *          edge, taken in the ISR, to the last accepted edge of the same key.
+ *       The keypad is not scanned periodically.  While no key is pressed all
+ *          four rows are driven high so that any key press raises a column
+ *          interrupt, which scans the rows once to find the key.
+ *       The real-world time of day is kept by the on-chip RTC, which is not
+ *          cleared by a watchdog reset.  After a watchdog reset the SetRealTime
+ *          input is pre-filled with the time still held by the RTC.
+ *       The closing time may differ for each day of the week.  The alarm is not
+ *          polled: a single low power timeout is armed for the next closing
+ *          time or midnight, and the alarm output is only re-evaluated when that
+ *          timeout fires or the clock, schedule, arming or fill level changes.
+ *       With CSE321_LATENCY_PROBES set to 1, the cycle counter of the core times
+ *          the echo fall to processDistanceData, a key press edge to handleInputKey,
+ *          the poll ticker to pollDistanceSensor, and the start of a frame to the
+ *          last of its text on the I2C bus.  The latency histograms are printed
+ *          with the diagnostics of the [*] key.  Set to 0, the probes are not built.
  *       Code to operate the watchdog in the main function is from
  *          https://os.mbed.com/docs/mbed-os/v6.15/apis/watchdog.html
  *
@@ -99,29 +151,27 @@
  *       Buzzer datasheet:                     https://www.mouser.com/datasheet/2/400/ef532_ps-13444.pdf
  *       MBED OS API: Timer                    https://os.mbed.com/docs/mbed-os/v6.15/apis/timer.html
  *       MBED OS API: Watchdog                 https://os.mbed.com/docs/mbed-os/v6.15/apis/watchdog.html
+ *       MBED OS API: Time (RTC)               https://os.mbed.com/docs/mbed-os/v6.15/apis/time.html
+ *       MBED OS API: ResetReason              https://os.mbed.com/docs/mbed-os/v6.15/apis/resetreason.html
  *
  ******************************************************************************/
 
+//Build option: set to 1 to build the latency probes and their histograms into the program (see LatencyProbe.h)
+#ifndef CSE321_LATENCY_PROBES
+#define CSE321_LATENCY_PROBES 0
+#endif
+
 //library imports
-#include "mbed.h"
-#include "1802.h"
+#include "Hal.h"
+#include "I2CBus.h"
+#include "CSE321_project3_mnelyubo_main.h"    //LCD size, time factors, states, and the globals and functions shared with the host programs
+#include "KeypadMatrix.h"
+#include "GpioPin.h"
+#include "LatencyProbe.h"
 #include <chrono>
+#include <cstring>
 
 //Definitions
-    //LCD properties
-    #define COL 16
-    #define ROW 2
-
-    //Reused from Project 2: Matrix event aliases
-    #define RisingEdgeInterrupt true
-    #define FallingEdgeInterrupt false
-
-    //Reused from Project 2: Associated column values with their respective character key value index in the matrix
-    #define ColABC 0
-    #define Col369 1
-    #define Col258 2
-    #define Col147 3
-
     //LCD character positions
     #define distancePosition100  11
     #define distancePosition10   12
@@ -132,6 +182,10 @@
     #define percentPosition10  1
     #define percentPosition1   2
 
+    //string index and width of the fill level bar graph in the first line of the Observer mode
+    #define fillBarPosition 6
+    #define fillBarCells    5   /* 5 cells of LCD_BAR_STEPS sub-steps each show the fill level in steps of 4% */
+
     //string indexes of the SetRealTIme, SetClosingTime, and Observer modes indicating where the time string is stored
     #define timeInputHours01 9
     #define timeInputHours10 8
@@ -140,19 +194,45 @@
     #define timeInputSecs01 15
     #define timeInputSecs10 14
 
+    //string index of the SetRealTime and SetClosingTime modes indicating where the day of the week is stored
+    #define weekdayPosition 13
+
+    //fill level reported by computeSpaceValue when the min and max distances are equal
+    #define spaceValueUndefined -1
+
     //string index and representation of the alarm indicator in the LCD output Observer state
     #define alarmIndicatorPosition 7
     #define alarmIndicatorArmed '#'
     #define alarmIndicatorOff ' '
 
+    //Observer pages.  Both pages are kept in the 40 column DDRAM lines of the LCD, and the page in view is switched
+    //  by shifting the display, so rotating pages sends no text
+    #define observerPageCount    2      /* page 0: fill level and time of day.  page 1: sample rate, fill trend and closing time */
+    #define observerPagePeriod   4s     /* time each Observer page stays in view */
+
+    //string indexes of the second Observer page
+    #define sampleRatePosition10 5      /* valid distance samples in the last second */
+    #define sampleRatePosition1  6
+    #define fillTrendPosition    15     /* '+' filling, '-' emptying, '=' steady, '?' no fill level */
+    #define fillTrendWindow      10s    /* time over which the fill trend is measured */
+
     //how long the watchdog will wait in an unexpected state before resetting the system
     #define WATCHDOG_TIMEOUT_DURATION_MS 30000 /*30 seconds*/
+    #define WATCHDOG_KICK_PERIOD 10s           /*must be shorter than the watchdog timeout*/
 
     //Reused from Project 2: dimension (row and column) of the Matrix keypad
     #define MatrixDim 4
 
-    //Reused from Project 2: keypad bounce timeout window (ms)
-    #define bounceTimeoutWindow 100
+    //keypad timing
+    #define keypadScanSettleTime 5us    /* time for a column input to follow a row output through a closed key */
+    #define columnEdgeMaskTime 2ms      /* time that a column EXTI line stays masked after an edge, absorbing the rest of a bounce burst */
+    #define bounceTimeoutWindow 30ms    /* default keypad bounce window.  Edges of a key closer than its window to the last accepted edge of that key are ignored */
+    #define keyLongPressTime 600ms      /* time that a key must be held before a long press event is published */
+    #define keyRepeatPeriod 200ms       /* time between repeat events while a key remains held after a long press */
+
+    //key event ring buffer between the keypad driver and the user interface
+    #define keyEventRingSize 16         /* number of key events that can wait for the user interface.  Must be a power of two */
+    #define autoRepeatKeys "b"          /* keys whose long press and repeat events are handled as further presses.  Held digits scroll the digit they entered */
 
     //Distance Sensor data
     #define POLLING_HIGH_TIME     10us
@@ -163,19 +243,47 @@
     //data type alias
     #define ull unsigned long long
 
-    //output stabilization buffer data
-    #define stabilizerArrayLen 4
-
-    //system state configuration
-    #define SetRealTime    0x0
-    #define SetClosingTime 0x2
-    #define SetMax         0x4
-    #define SetMin         0x6
-    #define Observer       0x8
+    //LCD backlight status colours and fade engine
+    #define backlightFadePeriod  40ms   /* time between fade steps */
+    #define backlightFadeStep    24     /* largest change of a colour channel in one fade step */
+    #define backlightAmberGreen  160    /* green level of amber, the colour of a half full container */
+    #define backlightPulseLow    40     /* red level at the dim end of the alarm pulse */
+    #define backlightWriteBudget 60     /* backlight register writes allowed per second, RGB_WRITE_BYTES I2C bytes each */
+    #define backlightChannels    3      /* red, green, blue */
+
+    //display refresh modes of the refresh policy of each state
+    #define RefreshPeriodic  0  /* a frame is drawn every interval, whether or not the output has changed */
+    #define RefreshOnChange  1  /* a frame is drawn as soon as the output changes */
+    #define RefreshCoalesced 2  /* a change is drawn no sooner than interval after the previous frame.  Changes within the interval share one frame */
+    #define RefreshEachSecond 3 /* a frame is drawn at each edge of the RTC second, by one event per second aimed at the edge */
+    #define secondEdgeDelay   2ms   /* time after an RTC second edge at which a RefreshEachSecond frame is drawn: covers the drift of the kernel clock against the RTC */
+    #define usPerSecond       1000000
+
+    //key classes: the columns of the user interface transition table
+    #define KeyClassA      0
+    #define KeyClassB      1
+    #define KeyClassC      2
+    #define KeyClassD      3
+    #define KeyClassHash   4
+    #define KeyClassStar   5
+    #define KeyClassDigit  6
+    #define KeyClassHeldDigit 7     /* long press and repeat events of a digit key */
+    #define KeyClassOther  8
+    #define KeyClassCount  9
+
+    //time input digit rule value of a position whose maximum digit does not depend on another position
+    #define noLimitingPosition -1
 
     //buzzer configuration
     #define nanosecondsPerSecond 1000*1000*1000
 
+    //compensation of the software oscillator of runBuzzer.  Until it is measured on the board, wait_ns is taken as
+    //exact and the loop as free.  To measure it, run the buzzer test with SELF_MEASURE set to 1 and replace these three
+    //lines with the ones it prints, as described in "Calibrating the Buzzer" of the README
+    #define buzzerWaitScalePpm    1000000   /* ns that wait_ns takes per requested ns, in parts per million */
+    #define buzzerHighOverheadNs  0         /* ns of each period with the buzzer on beyond its wait_ns */
+    #define buzzerLowOverheadNs   0         /* ns of each period with the buzzer off beyond its wait_ns: the loop, locks and division */
+
     //buzzer frequency table 
     #define frequencyTableLength 64
     #define frequencyTableFields 3
@@ -183,6 +291,10 @@
     #define tableOffsetDutyCycle 1
     #define tableOffsetDuration  2
 
+//Startup, split so that a host simulator can configure the system and serve the event queues itself
+    void configureSystem();     //configures the peripherals, interrupts, tickers and watchdog, and queues the first frame
+    void startThreads();        //starts the threads that serve the event queues, and the buzzer threads
+
 //Internal variables shared by more than on thread
     /**************************************************************************
     * Competitive resource usage conflict avoidance synchronization technique * 
@@ -201,14 +313,10 @@
     *  included on every lock and unlock mutex call to ensure that operations *
     *  proceed without unrecoverable conflicts.                               *
     **************************************************************************/
-    //Reused from Project 2:
-    int bounceLockout = 0;              //set to a value greater than zero whenever a button press is detected in order to lock out duplicate button presses for a brief period
-    Mutex bounceHandlerMutex;           //mutex order: (0)
-
     int currentState = SetRealTime;     //the current state of the system
     Mutex currentStateRW;               //mutex order: (1)
 
-    int outputChangesMade = false;      //indicates if there have been any changes made that would require a change to the output display
+    int outputChangesMade = true;       //indicates if there have been any changes made that would require a change to the output display.  Initially true to populate the display during startup
     Mutex outputChangesMadeRW;          //mutex order: (2)
 
     int stableDistance = 0;             //the stabilized distance from an average of multiple polls by the distance sensor
@@ -216,13 +324,17 @@
 
     //a table of output values to display on the LCD matrix during any given state
     char lcdOutputTextTable[][COL + 1] = {        //COL + 1 due to '\0' string suffix
-        "Set current time","(24hr)  hh:mm:ss",    //output configuration for the State:  SetRealTime
-        "Set closing time","(24hr)  hh:mm:ss",    //output configuration for the State:  SetClosingTime
+        "Set current: Mon","(24hr)  hh:mm:ss",    //output configuration for the State:  SetRealTime
+        "Set closing: Mon","(24hr)  hh:mm:ss",    //output configuration for the State:  SetClosingTime
         "[A] confirm     ","Set empty: 000cm",    //output configuration for the State:  SetMax
         "[A] confirm     ","Set full:  000cm",    //output configuration for the State:  SetMin
         "Space       Time","nnn%    hh:mm:ss"     //output configuration for the State:  Observer
     };
-    Mutex lcdOutputTableRW;             //mutex order: (4)
+    char observerDetailTextTable[][COL + 1] = {    //second Observer page, shown in turn with the Observer lines of the table above
+        "Poll --/s Fill ?",
+        "Closes  --:--:--"
+    };
+    Mutex lcdOutputTableRW;             //mutex order: (4).  Protects both tables
 
     int maxDistance = DISTANCE_MAXIMUM; //The maximum distance detected by the distance sensor.  
                                         //Once configured, the stable distance value equaling this value indicates that the container is currently emptied.
@@ -243,21 +355,94 @@
     int oscillationFrequency;           //frequency of digital signal oscillation in Hertz
     Mutex oscillationFrequencyRW;       //mutex order: (9)
 
+    int closingTimeSchedule[daysPerWeek] = {0};     //closing time of each day of the week (Monday first) in seconds since midnight
+    bool closingScheduleSet = false;                //indicates if a closing time has been confirmed since startup
+    Mutex closingScheduleRW;                        //mutex order: (10)
+
 //Internal variables exclusive to output data path: LCD (Integration of a previously used output peripheral)
     Thread outputRefreshThread;                                    //thread to execute output modification functions that cannot be handled in an ISR context
     EventQueue outputModificationEventQueue(32 * EVENTS_EVENT_SIZE);    //queue of events that must be handled by the LCD Refresh Thread
 
-    Ticker outputRefreshTicker;             //periodically enqueues an event into the lcdRefresh queue to update the contents of the LCD output
-
-    CSE321_LCD lcdObject(COL,ROW);          //create interface to control the output LCD.  Reused from Project 2
-    void populateLcdOutput();               //non-ISR function that will update the contents of the LCD output and toggle the state of the buzzer as appropriate
-    void enqueueOutputRefresh();            //helper function to enqueue a refresh of the LCD for the lcdRefreshThread to execute
-    bool closingTimeCrossed();              //checks if the current time is later than the closing time.  returns true if this is the case
-    
+    I2CBus i2cBus(PB_9, PB_8);              //owns the I2C peripheral of the LCD.  An I2C sensor on PB_9/PB_8 is added as a client with SensorPriority, so its reads go before queued LCD text
+    CSE321_LCD<COL, ROW> lcdObject(i2cBus, LCD_5x8DOTS, LCD_I2C_FAST);    //create interface to control the output LCD.  Reused from Project 2.  begin() falls back to 100 kHz if the display does not keep up at 400 kHz
+    void populateLcdOutput();               //non-ISR function that will update the contents of the LCD output
+    void requestOutputRefresh(bool userInput);  //non-ISR function that schedules LCD frames according to the refresh policy of the current state
+    void enqueueOutputRefresh(bool userInput);  //helper function to enqueue a refresh request for the output refresh thread to execute
+    void drawCoalescedFrame();              //draws the frame that a coalesced refresh was deferred to
+    void drawOnNewSecond();                 //draws a frame if the RTC second has changed since the last one it drew, and aims its next run at the next second edge
+    void printDisplayRefreshStatistics();   //prints the LCD frames per minute drawn in each state to the serial console
+
+    //the display refresh policy of a state: how the LCD frames of the state are scheduled
+    struct RefreshPolicy {
+        uint8_t mode;                       //RefreshPeriodic, RefreshOnChange, RefreshCoalesced or RefreshEachSecond
+        std::chrono::milliseconds interval; //frame period, or minimum time between coalesced frames.  Unused by RefreshOnChange and RefreshEachSecond
+    };
 
-    Ticker rtClockHandler;                  //ticker that will periodically enqueue an event increment real-time clock once it is input every second
-    void enqueueRTClockTick();              //helper event that enqueues an incrementation of the real-time clock
-    void tickRealTimeClock();               //non-ISR function that will increment the real-time clock and handle numeric roll-over
+    //refresh policy of each state, indexed by [state / 2].  A key press draws a frame at once in every state
+    constexpr RefreshPolicy refreshPolicies[StateCount] = {
+        {RefreshOnChange,  0ms},       //SetRealTime:    only key presses change the output
+        {RefreshOnChange,  0ms},       //SetClosingTime: only key presses change the output
+        {RefreshCoalesced, 20ms},      //SetMax:         the distance is drawn as soon as it changes, while the sensor is being positioned
+        {RefreshCoalesced, 20ms},      //SetMin:         the distance is drawn as soon as it changes, while the sensor is being positioned
+        {RefreshEachSecond, 0ms}       //Observer:       only the seconds change between key presses, so a frame follows each RTC second edge by secondEdgeDelay.  Fill level changes wait for the next second
+    };
+    const char* const stateNames[StateCount] = {"SetRealTime", "SetClosingTime", "SetMax", "SetMin", "Observer"};
+
+    //display refresh scheduler state.  Accessed solely by functions on the output refresh thread
+    int refreshPolicyState = -1;                    //the state whose refresh policy is applied, or -1 before the first frame
+    int periodicRefreshEventId = 0;                 //the id of the periodic frame or next RTC second event, or 0 if the policy has neither
+    int lastDrawnSecond = -1;                       //the RTC time of week drawn by the last RefreshEachSecond frame
+    int coalescedRefreshEventId = 0;                //the id of the deferred coalesced frame event, or 0 if none is pending
+    Kernel::Clock::time_point lastFrameTime;        //the time at which the last frame was drawn
+    Kernel::Clock::time_point policyStartTime;      //the time at which the refresh policy of the state was applied
+    unsigned int lcdFrames[StateCount] = {0};       //the number of frames drawn in each state
+    Kernel::Clock::duration stateDisplayTime[StateCount] = {};  //the time spent displaying each state, excluding the state currently displayed
+
+    //backlight status: green to amber to red with the fill level, pulsing red while the alarm is active
+    void setBacklightStatus(int spaceValue, bool alarmActive);  //non-ISR function that sets the colour the backlight fades to
+    void stepBacklightFade();                                   //non-ISR function that moves the backlight one fade step toward its target colour
+
+    //backlight fade engine state.  Accessed solely by functions on the output refresh thread
+    int backlightColor[backlightChannels] = {0, 0, 0};      //the colour last written to the backlight
+    int backlightTarget[backlightChannels] = {0, 0, 0};     //the colour the backlight is fading to
+    bool backlightPulsing = false;                          //indicates if the alarm pulse is running
+    int backlightFadeEventId = 0;                           //the id of the periodic fade step event, or 0 while the backlight is at its target
+    Kernel::Clock::time_point backlightBudgetWindowStart;   //the start of the current one second budget window
+    unsigned int backlightBudgetWindowWrites = 0;           //backlight register writes sent in the current budget window
+    unsigned int backlightPeakWritesPerSecond = 0;          //the most backlight register writes sent in one budget window
+    unsigned int backlightStepsDeferred = 0;                //fade steps postponed because the budget window was spent
+
+    //Observer page rotation and second page data.  Accessed solely by functions on the output refresh thread
+    void renderObserverDetails(int spaceValue, int timeOfWeek); //non-ISR function that renders the second Observer page
+    void rotateObserverPage();                                  //non-ISR function that brings the next Observer page into view
+    int observerPage = 0;                                   //the Observer page in view
+    int observerPageEventId = 0;                            //the id of the periodic page rotation event, or 0 outside the Observer state
+    unsigned int observerPageSwitches = 0;                  //pages brought into view by a display shift
+    uint32_t lastSampleCount = 0;                           //distanceSampleCount at the last sample rate measurement
+    Kernel::Clock::time_point lastSampleRateTime;           //the time of the last sample rate measurement
+    int fillTrendReference = spaceValueUndefined;           //the fill level at the start of the fill trend window
+    Kernel::Clock::time_point fillTrendTime;                //the start of the fill trend window
+    char fillTrend = '?';                                   //the fill trend shown on the second Observer page
+    int  computeSpaceValue();               //calculates the percent of the container that is used, or spaceValueUndefined if the min and max distances are equal
+
+    LowPowerTimeout closingAlarmTimeout;    //fires once at the next closing time or midnight, whichever comes first, to re-evaluate the alarm
+    bool closingTimePassed = false;         //indicates if the current time is past the closing time of the current day.  Accessed solely by functions on the output refresh thread
+    void scheduleClosingAlarm();            //non-ISR function that determines if closing time has passed and arms the closing alarm timeout for the next change
+    void enqueueAlarmScheduling();          //helper function to enqueue a scheduling of the closing alarm for the output refresh thread to execute
+    void updateAlarmOutput();               //non-ISR function that turns the alarm on or off based on closing time, arming and fill level
+    void enqueueAlarmUpdate();              //helper function to enqueue an update of the alarm output for the output refresh thread to execute
+
+
+    int lastRenderedSecond = -1;            //the RTC time of day (s) last rendered into the Observer output.  Accessed solely by populateLcdOutput on the output refresh thread
+
+    int  readRealTimeOfWeek();                                  //returns the current real-world time in seconds since Monday 00:00:00, as kept by the on-chip RTC
+    int  readRealTimeClock();                                   //returns the current real-world time of day in seconds since midnight, as kept by the on-chip RTC
+    void setRealTimeClock(int weekday, int secondsOfDay);       //sets the on-chip RTC to the given day of the week and time of day in seconds since midnight
+    int  parseTimeOfDay(const char* timeLine);                  //converts the hh:mm:ss digits of an LCD output line into seconds since midnight
+    void renderTimeOfDay(char* timeLine, int secondsOfDay);     //writes seconds since midnight into the hh:mm:ss digits of an LCD output line
+    void renderWeekday(char* dayLine, int weekday);             //writes the abbreviated name of a day of the week into an LCD output line
+
+    const char weekdayNames[daysPerWeek][4] = {"Mon","Tue","Wed","Thu","Fri","Sat","Sun"};     //abbreviated day names, Monday first to match the weekday index
 
     DigitalOut alarm_Enable(PB_10);    //starts off with 0V. power to alarm disabled until the alarm needs to be turned on.  Used as enable for audio output from always-runing buzzer.
 
@@ -266,6 +451,7 @@
     Thread buzzerDataThread;    //the thread that will send data to the buzzer's I/O channel to produce audio
 
     void runBuzzer();           //sends square wave signal to the buzzer
+    int compensatedBuzzerWait(int partNs, int overheadNs);  //the wait_ns of a part of a buzzer period, after the oscillator compensation
     void alternateBuzzer();     //modifies frequency, duty cycle, and duration of the next buzzer tone
 
     DigitalOut alarm_data_L(PB_11);     //starts off with 0V. active low component that produces a noise when active.  Frequency and duty cycle variation allow for notes to be played.
@@ -352,47 +538,109 @@
 //Internal variables exclusive to input data path: 4x4 matrix keypad (Integration of a previously used input peripheral)
     Thread matrixThread;                                    //thread to execute handler functions triggered by user interaction with the matrix keypad
     EventQueue matrixOpsEventQueue(32 * EVENTS_EVENT_SIZE); //queue of events for the matrix thread to execute
-    Ticker matrixAlternationTicker;                         //ticker that will create periodic matrix events to alternate the channel being polled
-
-    void enqueueMatrixAlternation();                        //helper function to enqueue alternator function alternateMatrixInput
-    void alternateMatrixInput();                            //alternates matrix poll channel when no button is pressed
 
     //Reused from Project 2
-    char charPressed = '\0';            //the character on the matrix that is currently pressed
-    int keypadVccRow = 0;               //the output into the keypad that is currently being supplied a voltage
-    char keyValues[][MatrixDim + 1] = {"dcba","#963","0852","*741"};       //a 2D character array mapping keypad row/column indexes to their representative characters
+    const char keyValues[][MatrixDim + 1] = {"dcba","#963","0852","*741"};     //a 2D character array mapping keypad column/row indexes to their representative characters
+
+    //rows with labels *0#D (PE_2), 789C (PE_4), 456B (PE_5), 123A (PE_6)
+    //columns containing buttons a,b,c,d (PC_0), 3,6,9,# (PC_3), 2,5,8,0 (PC_1), 1,4,7,* (PC_4)
+    typedef PinGroup<Pin<PortE, 2>, Pin<PortE, 4>, Pin<PortE, 5>, Pin<PortE, 6>> KeypadRows;
+    typedef PinGroup<Pin<PortC, 0>, Pin<PortC, 3>, Pin<PortC, 1>, Pin<PortC, 4>> KeypadColumns;
+    static_assert(KeypadRows::mask() == 0x74 && KeypadRows::outputModeMask() == 0x1510, "keypad row masks differ from the hand-written PE2, PE4, PE5, PE6 masks");
+    typedef KeypadMatrix<KeypadRows, KeypadColumns> Keypad;
+    Keypad keypad(keyValues, matrixOpsEventQueue,
+                  {keypadScanSettleTime, columnEdgeMaskTime, bounceTimeoutWindow, keyLongPressTime, keyRepeatPeriod});  //debounce and key events run on the matrix thread
+
+    LowPowerTicker watchdogKickTicker;  //periodically kicks the watchdog while no key is pressed
+    void kickWatchdog();                //ISR function that kicks the watchdog unless a key is held down
 
-    //Reused from Project 2
-    InterruptIn colLL(PC_0,PullDown);    //declare the connection to pin PC_0 as a source of input interrupts, connected to the far left column of the matrix keypad
-    InterruptIn colCL(PC_3,PullDown);    //declare the connection to pin PC_3 as a source of input interrupts, connected to the center left column of the matrix keypad
-    InterruptIn colCR(PC_1,PullDown);    //declare the connection to pin PC_1 as a source of input interrupts, connected to the center right column of the matrix keypad
-    InterruptIn colRR(PC_4,PullDown);    //declare the connection to pin PC_4 as a source of input interrupts, connected to the far right column of the matrix keypad
-
-    //Reused from Project 2: declare rising edge interrupt handler events
-    void rising_isr_abc();
-    void rising_isr_369();
-    void rising_isr_258();
-    void rising_isr_147();
-
-    //Reused from Project 2: declare falling edge interrupt handler events
-    void falling_isr_abc();
-    void falling_isr_369();
-    void falling_isr_258();
-    void falling_isr_147();
-
-    //Reused from Project 2: 
-    void handleMatrixButtonEvent(bool isRisingEdgeInterrupt, int column, int row);   //filter duplicates and parse matrix button events into input key events
     void handleInputKey(char charPressed);                                          //handle input keys based on the current state of the system
+    void handleHeldKey(char keyHeld);                                               //handle the long press and repeat events of a held key
+    void applyUiTransition(char key, int keyClass);                                 //take the action and enter the state of the transition of a key class
+
+    //key events published by the keypad driver on the matrix thread and consumed by the user interface on the key input thread
+    KeyEventRing<keyEventRingSize> keyEventRing;
+    Thread keyInputThread;                                      //thread to execute the user interface state machine on key events
+    EventQueue keyInputEventQueue(32 * EVENTS_EVENT_SIZE);      //queue of key event processing requests for the key input thread
+
+    void processKeyEvents();                                    //passes every key event in the ring to the user interface
+    void printKeypadEdgeCounters();                             //prints the keypad column edge and event counters to the serial console
+
+    //Time input digit rules.  A digit is accepted at a position if it does not exceed the maximum digit of that position.
+    //The maximum is lowered to limitedMaxDigit while the limiting position holds limitingDigit (hours cannot exceed 23).
+    struct TimeDigitRule {
+        int8_t position;            //string index of the digit in the time input line
+        char maxDigit;              //largest digit accepted at this position
+        int8_t limitingPosition;    //string index of a digit that may lower the maximum, or noLimitingPosition
+        char limitingDigit;         //value of the limiting digit at which the maximum is lowered
+        char limitedMaxDigit;       //largest digit accepted while the limiting digit holds limitingDigit
+    };
+    constexpr TimeDigitRule timeDigitRules[] = {    //the time input positions in the order that digits are entered
+        {timeInputHours10, '2', noLimitingPosition, '\0', '\0'},    //tens of hours cannot exceed 2
+        {timeInputHours01, '9', timeInputHours10,   '2',  '3'},     //hours can reach 19 and 09, but cannot exceed 23 (23:59:59 is followed by 00:00:00)
+        {timeInputMins10,  '5', noLimitingPosition, '\0', '\0'},    //minutes cannot exceed 59
+        {timeInputMins01,  '9', noLimitingPosition, '\0', '\0'},    //the entire range of 0-9 is valid for single minutes
+        {timeInputSecs10,  '5', noLimitingPosition, '\0', '\0'},    //seconds cannot exceed 59
+        {timeInputSecs01,  '9', noLimitingPosition, '\0', '\0'}     //the entire range of 0-9 is valid for single seconds
+    };
+    int timeInputIndex = 0;         //the current index through the timeDigitRules array.  Accessed solely by the user interface state machine
+    int scrollInputIndex = -1;      //the index through timeDigitRules of the digit that the last digit key entered, which holding the key scrolls, or -1.  Accessed solely by the user interface state machine
+    int realTimeInputDay = 0;       //the day of the week shown in the SetRealTime input.  Accessed solely by the user interface state machine
+    int closingInputDay = 0;        //the day of the week whose closing time is shown in the SetClosingTime input.  Accessed solely by the user interface state machine
+    bool closingInputPerDay = false;//indicates if [B] has been used since entering SetClosingTime, switching the input from a daily closing time to one day at a time.  Accessed solely by the user interface state machine
+
+    //User interface state machine actions.  Each is called by applyUiTransition with currentStateRW (1) locked, with the state and key that selected it
+    void confirmRealTime(int entryState, char key);         //loads the time input into the RTC and starts the closing time input
+    void advanceRealTimeDay(int entryState, char key);      //advances the day of the week of the current time input
+    void confirmClosingTime(int entryState, char key);      //stores the time input as the closing time of the displayed day, or of every day
+    void storeClosingDay(int entryState, char key);         //stores the time input as the closing time of the displayed day and shows the next day
+    void clearTimeInput(int entryState, char key);          //resets the time input of the state to hh:mm:ss
+    void enterTimeDigit(int entryState, char key);          //enters a digit at the time input position if it is valid there
+    void scrollTimeDigit(int entryState, char key);         //advances the digit that the held key entered, wrapping to 0 past the largest valid digit
+    void confirmMaxDistance(int entryState, char key);      //sets the empty container distance to the stable distance
+    void confirmMinDistance(int entryState, char key);      //sets the full container distance to the stable distance and arms the alarm
+    void toggleAlarmArmed(int entryState, char key);        //arms or disarms the alarm
+    void returnToSetup(int entryState, char key);           //disarms the alarm and shows the time held by the RTC as the current time input
+    void reportDiagnostics(int entryState, char key);       //prints the keypad edge counters, the I2C bus statistics and the LCD frame rates
+    void fillUnsetTimeDigits(char* timeLine);               //replaces the h, m and s placeholders of a time input with 0
+    void storeClosingTimeInput(char* timeLine);       //stores a time input into the closing time schedule
+
+    //the actions of the user interface state machine, indexing uiActionHandlers
+    enum UiAction : uint8_t {
+        NoAction, ConfirmRealTime, AdvanceRealTimeDay, ConfirmClosingTime, StoreClosingDay, ClearTimeInput, EnterTimeDigit,
+        ScrollTimeDigit, ConfirmMaxDistance, ConfirmMinDistance, ToggleAlarmArmed, ReturnToSetup, ReportDiagnostics, UiActionCount
+    };
+    constexpr void (*uiActionHandlers[UiActionCount])(int entryState, char key) = {
+        nullptr, confirmRealTime, advanceRealTimeDay, confirmClosingTime, storeClosingDay, clearTimeInput, enterTimeDigit,
+        scrollTimeDigit, confirmMaxDistance, confirmMinDistance, toggleAlarmArmed, returnToSetup, reportDiagnostics
+    };
 
-    int timeInputPositions[] = {    //an array of the defined time value positions for use by iteration during user input 
-        timeInputHours10,
-        timeInputHours01,
-        timeInputMins10,
-        timeInputMins01,
-        timeInputSecs10,
-        timeInputSecs01
+    //an entry of the user interface transition table: the action taken and the state entered on a key.  Two bytes per entry
+    struct UiTransition {
+        UiAction action;            //action to take
+        uint8_t  nextState;         //state of the system after the action
+    };
+
+    //the key class of each key press, selecting the column of the user interface transition table.  Held digits are classed by handleHeldKey
+    constexpr int keyClassOf(char key){
+        return key >= '0' && key <= '9' ? KeyClassDigit :
+               key == 'a' ? KeyClassA :
+               key == 'b' ? KeyClassB :
+               key == 'c' ? KeyClassC :
+               key == 'd' ? KeyClassD :
+               key == '#' ? KeyClassHash :
+               key == '*' ? KeyClassStar : KeyClassOther;
+    }
+
+    //user interface transition table, indexed by [state / 2][key class].  Being constexpr, it is placed in flash
+    constexpr UiTransition uiTransitionTable[StateCount][KeyClassCount] = {
+      /*                 [A]                                  [B]                                  [C]                                [D]                           [#]                           [*]                                  [0-9]                             [0-9] held                         other                   */
+      /*SetRealTime*/    {{ConfirmRealTime, SetClosingTime},  {AdvanceRealTimeDay, SetRealTime},   {ClearTimeInput, SetRealTime},     {ReturnToSetup, SetRealTime}, {NoAction, SetRealTime},      {ReportDiagnostics, SetRealTime},    {EnterTimeDigit, SetRealTime},    {ScrollTimeDigit, SetRealTime},    {NoAction, SetRealTime}},
+      /*SetClosingTime*/ {{ConfirmClosingTime, SetMax},       {StoreClosingDay, SetClosingTime},   {ClearTimeInput, SetClosingTime},  {ReturnToSetup, SetRealTime}, {NoAction, SetClosingTime},   {ReportDiagnostics, SetClosingTime}, {EnterTimeDigit, SetClosingTime}, {ScrollTimeDigit, SetClosingTime}, {NoAction, SetClosingTime}},
+      /*SetMax*/         {{ConfirmMaxDistance, SetMin},       {NoAction, SetMax},                  {NoAction, SetMax},                {ReturnToSetup, SetRealTime}, {NoAction, SetMax},           {ReportDiagnostics, SetMax},         {NoAction, SetMax},               {NoAction, SetMax},                {NoAction, SetMax}},
+      /*SetMin*/         {{ConfirmMinDistance, Observer},     {NoAction, SetMin},                  {NoAction, SetMin},                {ReturnToSetup, SetRealTime}, {NoAction, SetMin},           {ReportDiagnostics, SetMin},         {NoAction, SetMin},               {NoAction, SetMin},                {NoAction, SetMin}},
+      /*Observer*/       {{NoAction, Observer},               {NoAction, Observer},                {NoAction, Observer},              {ReturnToSetup, SetRealTime}, {ToggleAlarmArmed, Observer}, {ReportDiagnostics, Observer},       {NoAction, Observer},             {NoAction, Observer},              {NoAction, Observer}}
     };
-    int timeInputIndex = 0;         //the current index through the timeInputPositions array.  Accessed solely by the function handleInputKey
 
 
 //Internal variables exclusive to input data path: Distance Sensor (Integration of a new input peripheral)
@@ -411,6 +659,7 @@
 
     int distanceBuffer[stabilizerArrayLen]; //circular array for stabilizing distance inputs.  Only accessed by functions running on the distance sensor thread to ensure mutual exclusion.
     int distanceBuffIdx = 0;                //the index of the distance buffer that should receive the next polled value
+    volatile uint32_t distanceSampleCount = 0;  //valid distance samples since startup.  Incremented atomically on the distance sensor thread, read atomically by the output refresh thread
 
     Timer distanceEchoTimer;                //measures the time between the trigger signal, rise, and fall of distance sensor events
     Ticker distanceSensorPollStarter;       //periodically executes the enqueuePoll function to call for a new distance sensor poll
@@ -419,92 +668,140 @@
     ull fallEchoTimestamp = 0;              //the time between when the poll was started and the time that the falling edge of the echo was detected
 
     InterruptIn echo(PC_8);                 //interrupt that listens for the rising and falling edges of the distance sensor echo channel
+    typedef Pin<PortC, 9> RangeTrigger;     //output that starts a distance measurement with a 10 us high pulse
+
+
+//Latency probes of the paths from an interrupt or tick to the thread that handles it.  Each probe is recorded by one thread.
+//The histograms are printed in the reverse order of declaration
+#if CSE321_LATENCY_PROBES
+    LatencyProbe frameShownProbe("frame start -> LCD text sent");         //output refresh thread to the I2C bus thread
+    LatencyProbe pollTickProbe("poll tick -> pollDistanceSensor");        //poll ticker ISR to the distance sensor thread
+    LatencyProbe keyEdgeProbe("key edge -> handleInputKey");              //column ISR to the key input thread, through the keypad driver
+    LatencyProbe echoFallProbe("echo fall -> processDistanceData");       //echo ISR to the distance sensor thread
+
+    void recordFrameShown(uint32_t frameStartCycles);   //called on the I2C bus thread once the text of a frame is on the bus
+#endif
 
 
 //main sequence execution/initialization
 int main(){
     printf("\n\n=== System Startup ===\n");
 
+    configureSystem();      //peripherals, interrupts, tickers and the watchdog
+    startThreads();         //the threads that serve the event queues, and the buzzer threads
+
+    while(true){ //Idle on main thread to prevent program from exiting
+        ThisThread::sleep_for(Kernel::wait_for_u32_forever);        //block with no mutexes locked.  All work is done by tickers, interrupts and the event queue threads
+    }
+    return 0;
+}
+
+
+/**
+ * void configureSystem()
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function attaches the interrupt handlers, configures the GPIO registers and the LCD, arms the distance
+ *      sensor poll ticker and the watchdog, and queues the first LCD frame and closing alarm scheduling.
+ *    No thread is started, so the queued work waits until startThreads, or until a host simulator serves the
+ *      event queues in virtual time.
+ *
+ * Parameters:
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    The LCD is initialized, every keypad row is driven high and the watchdog is running
+ *
+ * Shared variables accessed:
+ *    The SetRealTime lines of the LCD output table are written before any thread that reads them is started
+ */
+void configureSystem(){
+    latencyCounterStart();      //start the cycle counter of the latency probes, if they are built in
+
     //create rise and fall timers for input port
     echo.rise(distanceEchoRiseHandler);
     echo.fall(distanceEchoFallHandler);
 
-    //reused from Project 2
-    colLL.rise(&rising_isr_abc);   //assign interrupt handler for a rising edge event from the column containing buttons a,b,c,d
-    colCL.rise(&rising_isr_369);   //assign interrupt handler for a rising edge event from the column containing buttons 3,6,9,#
-    colCR.rise(&rising_isr_258);   //assign interrupt handler for a rising edge event from the column containing buttons 2,5,8,0
-    colRR.rise(&rising_isr_147);   //assign interrupt handler for a rising edge event from the column containing buttons 1,4,7,*
-
-    //reused from Project 2
-    colLL.fall(&falling_isr_abc);   //assign interrupt handler for a falling edge event from the column containing buttons a,b,c,d
-    colCL.fall(&falling_isr_369);   //assign interrupt handler for a falling edge event from the column containing buttons 3,6,9,#
-    colCR.fall(&falling_isr_258);   //assign interrupt handler for a falling edge event from the column containing buttons 2,5,8,0
-    colRR.fall(&falling_isr_147);   //assign interrupt handler for a falling edge event from the column containing buttons 1,4,7,*
+    keypad.attach(keyEventRing, keyInputEventQueue, &processKeyEvents);    //deliver key events into the ring for the key input thread
 
     /*******************************
     * Bitwise Driver Configuration *
     *******************************/
 
-    //enable ports B,C,E
-    RCC->AHB2ENR |= 0x16;
-
-    //configure pin C9 as an output (Distance Sensor)
-    GPIOC->MODER &= ~(0x80000);
-    GPIOC->MODER |= 0x40000;
+    //enable port B.  The keypad driver enables the port of its rows
+    RCC->AHB2ENR |= 0x02;
 
-    //configugure GPIO pins PE2, PE4, PE5, PE6 as outputs (4x4 matrix)
-    GPIOE->MODER |= 0x01510;       
-    GPIOE->MODER &= ~(0x02A20);
+    //enable port C and configure pin C9 as an output (Distance Sensor)
+    RangeTrigger::configureOutput();
 
 
     /*******************************
     *   Peripheral Configuration   *
     *******************************/
     lcdObject.begin();              //initialize LCD, reused from Project 2
+    lcdObject.loadBarGlyphs();      //upload the partial cell glyphs of the fill level bar graph into CGRAM
+    printf("LCD I2C bus: %d Hz\n", lcdObject.frequency());
+
+    //the RTC keeps counting through a watchdog reset.  Offer the time it still holds as the SetRealTime input so that only a confirmation is needed
+    if(ResetReason::get() == RESET_REASON_WATCHDOG){
+        realTimeInputDay = readRealTimeOfWeek() / secondsPerDay;
+        renderWeekday(lcdOutputTextTable[SetRealTime], realTimeInputDay);
+        renderTimeOfDay(lcdOutputTextTable[SetRealTime + 1], readRealTimeClock());
+    }
 
 
     /*******************************
-    *     Thread Configuration     *
+    *  Tickers and Queued Startup  *
     *******************************/
-    distanceSensorThread.start(callback(&distanceSensorEventQueue, &EventQueue::dispatch_forever));    //set the distance sensor thread to continuously execute anything in the distance sensor event queue
     distanceSensorPollStarter.attach(&enqueuePoll, 100ms);                  //set the distance sensor poll starting ticker to enqueue a poll of the distance every 100ms
+    enqueueOutputRefresh(true);                                             //draw the first frame and apply the refresh policy of the initial state
+    enqueueAlarmScheduling();                                               //find the first closing time state change and arm the closing alarm timeout for it
+    keypad.start();                                                         //configure the keypad rows and drive every row so that the first key press raises an interrupt
 
-    outputRefreshThread.start(callback(&outputModificationEventQueue, &EventQueue::dispatch_forever)); //set the LCD and alarm refresh thread to continously execute anything in the output modification event queue
-    outputRefreshTicker.attach(&enqueueOutputRefresh, 100ms);               //set the output refresh starting ticker to enqueue an output refresh every 100 ms
-    rtClockHandler.attach(&enqueueRTClockTick, 1s);                         //set the real-world clock time ticker to enqueue an increment ever second (executed in the output modifications event queue)
+    //the following used code is based on the sample code provided at the MBED OS API https://os.mbed.com/docs/mbed-os/v6.15/apis/watchdog.html
+    Watchdog::get_instance().start(WATCHDOG_TIMEOUT_DURATION_MS);   //Set the watchdog timer to reset the system if button is not released for 30 seconds
+    watchdogKickTicker.attach(&kickWatchdog, WATCHDOG_KICK_PERIOD); //keep the watchdog from resetting the system while no key is held down
+}
 
+
+/**
+ * void startThreads()
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function starts a thread to dispatch each event queue, and the two buzzer threads.
+ *
+ * Parameters:
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    None directly.  The work queued by configureSystem starts to run
+ */
+void startThreads(){
+    distanceSensorThread.start(callback(&distanceSensorEventQueue, &EventQueue::dispatch_forever));    //set the distance sensor thread to continuously execute anything in the distance sensor event queue
+    outputRefreshThread.start(callback(&outputModificationEventQueue, &EventQueue::dispatch_forever)); //set the LCD and alarm refresh thread to continously execute anything in the output modification event queue
+    keyInputThread.start(callback(&keyInputEventQueue, &EventQueue::dispatch_forever)); //set the key input thread to continously process key events published by the keypad driver
     matrixThread.start(callback(&matrixOpsEventQueue, &EventQueue::dispatch_forever));  //set the matrix I/O thread to continously execute anything in the matrix operations event queue
-    matrixAlternationTicker.attach(&enqueueMatrixAlternation, 10ms);        //set the output to matrix alternation ticker to enqueue an alternation every 10ms
 
     buzzerAlternatorThread.start(&alternateBuzzer);  //set the buzzer alternation thread to run the alternate buzzer function continously
     buzzerDataThread.start(&runBuzzer);              //set the buzzer execution thread to oscillate I/O at the variable oscillation frequency and duty cycle
-    
-
-    while(true){ //Idle on main thread to prevent program from exiting
-        thread_sleep_for(1);                    //timeout thread for 1ms every cycle with no mutexes locked.
-        bounceHandlerMutex.lock();              //(0) lock the bounce handler mutex to avoid concurrent R/W operations from another thread
-        if(bounceLockout > 0) bounceLockout--;  //decrement the bounce lockout if it is still greater than 0 after a recent rising edge button press
-        bounceHandlerMutex.unlock();            //(0) unlock the bounce handler immediately after the critical section is exited
-
-        //the following used code is based on the sample code provided at the MBED OS API https://os.mbed.com/docs/mbed-os/v6.15/apis/watchdog.html
-        if(!charPressed){                       //if there is no input to the system, keep the watchdog armed but prevent it from reseting the system
-            Watchdog &watchdog = Watchdog::get_instance();          //access the watchdog instance
-            if(watchdog.is_running()) watchdog.kick();              //if the watchdog is already running, ask it nicely to not reset the system
-            else watchdog.start(WATCHDOG_TIMEOUT_DURATION_MS);      //Set the watchdog timer to reset the system if button is not released for 30 seconds
-        }
-    }
-    return 0;
 }
 
 
 /**
- * void alternateMatrixInput()
- * non-ISR Function
- * Reused from Project 2
+ * void kickWatchdog()
+ * ISR function
  *
  * Summary of the function:
- *    This function alternates which column of the matrix receives voltage to bounce back a signal on the input pins that are expecting interrupt events.
- *    This function only switches matrix columns if no character is currently pressed.
+ *    This function kicks the watchdog if no key is pressed.  A key held down for longer than the watchdog timeout 
+ *      therefore resets the system.
  *
  * Parameters:   
  *    None
@@ -513,105 +810,78 @@ int main(){
  *    None
  *
  * Outputs:
- *    Exactly one digital high DC output signal between pins PE_2, PE_4, PE_5, and PE_6 will be sent at the end of the execution of this function
- *    During the execution of the function, a brief period (~1ms) may exist where none of the four channels are given a non-zero voltage.
+ *    The watchdog timer is reloaded
  *
  * Shared variables accessed:
- *    None.  Global variable charPressed is exclusive to operations executing on the matrix operations thread, which can only be one function at any point in time, so a mutex is not required.
- *
- * Helper ISR Function:
- *    enqueueMatrixAlternation
+ *    The pressed key of the keypad driver is read.  It is a single byte written only on the matrix operations thread.
  */
-void alternateMatrixInput(){
-    if(charPressed) return;     //secondary safety to prevent repetition if the Mutex fails
-
-    GPIOE->ODR &= ~(0x74);      //reset voltage to output 0 on all four alternating pins
-
-    thread_sleep_for(1);        //provide a 1ms window between one input going low and the next going high
-
-    keypadVccRow = (1 + keypadVccRow) % MatrixDim;    //update the row target to poll the next row
-
-    //Reused from Project 2
-    switch (keypadVccRow){
-        case 0:
-            GPIOE->ODR |= 0x04;        //supply voltage to the row of keypad buttons with labels *0#D (PE_2)
-            break;
-        case 1:
-            GPIOE->ODR |= 0x10;        //supply voltage to the row of keypad buttons with labels 789C (PE_4)
-            break;
-        case 2:
-            GPIOE->ODR |= 0x20;        //supply voltage to the row of keypad buttons with labels 456B (PE_5)
-            break;
-        case 3:
-            GPIOE->ODR |= 0x40;        //supply voltage to the row of keypad buttons with labels 123A (PE_6)
-            break;
-    }
+void kickWatchdog(){
+    if(!keypad.pressedKey()) Watchdog::get_instance().kick();   //if there is no input to the system, ask the watchdog nicely to not reset the system
 }
-//helper function
-void enqueueMatrixAlternation(){matrixOpsEventQueue.call(alternateMatrixInput);}
 
 
 /**
- * void handleMatrixButtonEvent
- * Reused from Project 2
+ * void processKeyEvents()
  * non-ISR function
  *
  * Summary of the function:
- *    This function converts any event triggered by a matrix button input into a character, handles duplicate events due to bounce, and calls handleInputKey on the rising edge of filtered results.
+ *    This function passes every key event waiting in the key event ring to the user interface, in the order the 
+ *      events were published.  Presses are handled as input keys, and long press and repeat events as a held key.
  *
  * Parameters:   
- *    - isRisingEdgeInterrupt - boolean indicating whether the trigger event is a rising or falling edge of a button press
- *    - column                - integer 0-3 indicating the matrix column of the input button press, used to map to the proper key value
- *    - row                   - integer 0-3 indicating the matrix row of the input button press, used to map to the proper key value
+ *    None
  *
  * Return value:
  *    None
  *
  * Outputs:
- *    handleInputKey called to modify system state based on button press.
+ *    handleInputKey or handleHeldKey called to modify system state based on button press.
  *    
  * Shared variables accessed:
- *    bounce lockout  -  mutex (8)
- *
- * Helper ISR Functions:
- *    rising_isr_abc
- *    falling_isr_abc
- *    rising_isr_369
- *    falling_isr_369
- *    rising_isr_258
- *    falling_isr_258
- *    rising_isr_147
- *    falling_isr_147
- *
+ *    keyEventRing is consumed.  It is lock-free, with this thread as its only consumer.  See also handleInputKey
  */
-void handleMatrixButtonEvent(bool isRisingEdgeInterrupt, int column, int row){
-    char detectedKey = keyValues[column][row];      //fetch the char value associated with the index that was detected
-    if(isRisingEdgeInterrupt){
-        bounceHandlerMutex.lock();                //(0) lock bounce handler mutex to avoid concurrent access
-        if(!charPressed && bounceLockout == 0){   //fail immediately if another key is pressed or was pressed recently
-            bounceLockout = bounceTimeoutWindow;  //ensure no additional events are acted upon
-            charPressed = detectedKey;            //set the global variable charPressed to the detected key press
-            handleInputKey(charPressed);          //(0) call the function to handle the input key without unlocking the mutex
-        }
-        bounceHandlerMutex.unlock();              //unlock the bounce handler mutex only after all updates to system state have been completed
-    }else{
-        if(charPressed == detectedKey){
-            charPressed = '\0';                 //reset the char value to '\0' to indicate that no key is pressed
+void processKeyEvents(){
+    KeyEvent event;
+    while(keyEventRing.consume(&event)){
+        if(event.type == KeyPress){
+            LATENCY_RECORD(keyEdgeProbe, event.cycles);
+            handleInputKey(event.key);
+        }else if(event.type == KeyLongPress || event.type == KeyRepeat){
+            handleHeldKey(event.key);
         }
     }
 }
 
-//Helper Functions:
-//Reused from Project 2
-// Handle interrupts by enqueueing matrix operation queue events to address the cause of the interrupt in a non-ISR context
-void rising_isr_abc() {matrixOpsEventQueue.call(handleMatrixButtonEvent, RisingEdgeInterrupt,  ColABC, keypadVccRow);}
-void falling_isr_abc(){matrixOpsEventQueue.call(handleMatrixButtonEvent, FallingEdgeInterrupt, ColABC, keypadVccRow);}
-void rising_isr_369() {matrixOpsEventQueue.call(handleMatrixButtonEvent, RisingEdgeInterrupt,  Col369, keypadVccRow);}
-void falling_isr_369(){matrixOpsEventQueue.call(handleMatrixButtonEvent, FallingEdgeInterrupt, Col369, keypadVccRow);}
-void rising_isr_258() {matrixOpsEventQueue.call(handleMatrixButtonEvent, RisingEdgeInterrupt,  Col258, keypadVccRow);}
-void falling_isr_258(){matrixOpsEventQueue.call(handleMatrixButtonEvent, FallingEdgeInterrupt, Col258, keypadVccRow);}
-void rising_isr_147() {matrixOpsEventQueue.call(handleMatrixButtonEvent, RisingEdgeInterrupt,  Col147, keypadVccRow);}
-void falling_isr_147(){matrixOpsEventQueue.call(handleMatrixButtonEvent, FallingEdgeInterrupt, Col147, keypadVccRow);}
+
+/**
+ * void printKeypadEdgeCounters()
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function prints, for each keypad column, the edge interrupts received, the missed edges recovered when 
+ *      the column was re-enabled, and the key events enqueued and dropped.
+ *    The difference between edges received and events enqueued is the number of bounce edges suppressed in ISR context.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    Serial printout
+ *
+ * Shared variables accessed:
+ *    The keypad driver column counters are read.  They are written only in ISR context and may advance while being printed.
+ */
+void printKeypadEdgeCounters(){
+    printf("column\tedges\trecovered\tenqueued\tdropped\n");
+    for(int column = 0; column < Keypad::Cols; column++){
+        Keypad::EdgeCounters counters = keypad.edgeCounters(column);
+        printf("%d\t%u\t%u\t\t%u\t\t%u\n", column, counters.edgesReceived, counters.edgesRecovered, counters.eventsEnqueued, counters.eventsDropped);
+    }
+    printf("key events dropped by the ring: %u\n", keyEventRing.dropped());
+}
 
 
 /**
@@ -621,10 +891,15 @@ void falling_isr_147(){matrixOpsEventQueue.call(handleMatrixButtonEvent, Falling
  *
  * Summary of the function:
  *    This function modifies the system state and internal variables based on the user input to the system.
+ *    The action and next state of every state and key class are held in the constexpr uiTransitionTable, so 
+ *      dispatch is a single table lookup.  Adding a state means adding a row of the table.
  *    While in the SetRealTime and SetClosingTime states,
- *      Numeric inputs are used to configure the two respective times.
+ *      Numeric inputs are used to configure the two respective times.  Holding a digit scrolls the digit it entered.
  *      A is used to confirm the current input, defaulting all unentered positions to 0.
  *      C is used to clear the current input time and begin again from the tens of hours.
+ *      B is used in SetRealTime to advance the current day of the week.  Holding B scrolls through the days.
+ *      B is used in SetClosingTime to keep the input as the closing time of the displayed day and advance to the next day.
+ *        Confirming with A without having used B sets the same closing time for every day of the week.
  *
  *    While in the SetMax and SetMin states,
  *      A is used to lock in the current distance measured by the distance sensor for that particular mode.
@@ -634,6 +909,7 @@ void falling_isr_147(){matrixOpsEventQueue.call(handleMatrixButtonEvent, Falling
  *
  *    While in any state,
  *      D is used to reset the system to the SetRealTime state to reconfigure the system.
+ *      * is used to print the keypad edge counters and the LCD frame rates to the serial console.
  *
  * Parameters:   
  *    - charPressed - an ASCII character value indicating the user input, based on which to modify the system state or variables
@@ -645,399 +921,725 @@ void falling_isr_147(){matrixOpsEventQueue.call(handleMatrixButtonEvent, Falling
  *    None directly.  The configuration of the alarm and LCD outputs may be modified due to calling this function.
  *
  * Shared variables accessed:
- *    currentState       - mutex (1)
- *    outputChangesMade  - mutex (2)
- *    stableDistance     - mutex (3)
- *    lcdOutputTextTable - mutex (4)
- *    maxDistance        - mutex (5)
- *    minDistance        - mutex (6)
- *    alarmArmed         - mutex (7)
+ *    currentState        - mutex (1)
+ *    outputChangesMade   - mutex (2)
+ *    stableDistance      - mutex (3)
+ *    lcdOutputTextTable  - mutex (4)
+ *    maxDistance         - mutex (5)
+ *    minDistance         - mutex (6)
+ *    alarmArmed          - mutex (7)
+ *    closingTimeSchedule - mutex (10)
+ *    Mutexes (3) through (10) are locked by the state machine actions
  *
  * Helper ISR Function:
- *    no direct helper.  Dependent on handleMatrixButtonEvent
+ *    no direct helper.  Called on the key input thread by processKeyEvents
  */
-
-//MACRO to update an input number that will work as a timestamp.
-//Due to the variable scope of incrementInputIndex, this set of frequently called lines cannot effectively be a function.
-#define updateTimeData  lcdOutputTableRW.lock();    /*(4) lock the LCD output table mutex before modifying values in the table*/      \
-                        lcdOutputTextTable[entryState + 1][timeInputPositions[timeInputIndex]] = charPressed; /*modify table values*/ \
-                        lcdOutputTableRW.unlock();  /*(4) unlock the table mutex as soon as the operation is completed*/              \
-                        incrementInputIndex=true;   /*indicate that the input index must be updated*/
-
 void handleInputKey(char charPressed){
-    currentStateRW.lock();              //(1)
-    int entryState = currentState;      //act based on the system state preceeding the button press to avoid rollover
-    if(entryState == SetRealTime){
-        lcdOutputTableRW.lock();            //(4)
-        switch(charPressed){
-            case 'a':               //switch to next state and filter input of the current state
-                timeInputIndex = 0; //reset the index of the next button to be updated to 0
-                currentState = SetClosingTime;  //set the system state to setting the closing time
-
-                //iterate over the time input and replace any remaining 'h','m', and 's' characters with '0'
-                for(int i = timeInputHours10; i <= timeInputSecs01; i++){   //iterate over the confirmed input time of the SetRealTime state output string
-                    if(lcdOutputTextTable[entryState + 1][i] > ':'){        //fix any unset characters (where the value is still h,m,s (all ASCII values greater than ':'))
-                        lcdOutputTextTable[entryState + 1][i] = '0';        //by setting those unset characters to 0
-                    }
-                }
-                
-                break;
-            
-            case 'c':               //reset time input when the button C is pressed
-                timeInputIndex = 0; //reset the index of the next button to be updated to 0
-                lcdOutputTextTable[entryState + 1][timeInputHours10] = 'h'; //reset the value of tens of hours to h
-                lcdOutputTextTable[entryState + 1][timeInputHours01] = 'h'; //reset the value of hours to h
-                lcdOutputTextTable[entryState + 1][timeInputMins10] = 'm';  //reset the value of tens of minutes to m
-                lcdOutputTextTable[entryState + 1][timeInputMins01] = 'm';  //reset the value of minutes to m
-                lcdOutputTextTable[entryState + 1][timeInputSecs10] = 's';  //reset the value of tens of seconds to s
-                lcdOutputTextTable[entryState + 1][timeInputSecs01] = 's';  //reset the value of seconds to s
-                break;
-
-            case '1': //Handle all number inputs in the same manner:
-            case '2': //Update the time input of the state
-            case '3': //if the input number is valid for the current time index
-            case '4': //otherwise take no action
-            case '5': 
-            case '6': 
-            case '7':
-            case '8':
-            case '9':
-            case '0':
-                bool incrementInputIndex = false;    //indicate if a valid button press was detected and the next time index should be switched to
-                int timeInputPosition = timeInputPositions[timeInputIndex]; //the current index of the time input position to update
-
-                //repeat for each time input position.  This cannot be a single for loop due to the variance of rollover conditions for each digit
-                //if the current time input position matches the time input position of this time unit, make sure that the
-                // input number does not break the conditions required for the time to remain valid on a 24 hour clock
-
-                if(timeInputPosition == timeInputHours10){
-                    if(charPressed < '3'){  //tens of hours cannot exceed 2
-                        updateTimeData;
-                    }
-                }
-
-                if(timeInputPosition == timeInputHours01){
-                    if(lcdOutputTextTable[entryState + 1][timeInputHours10] < '3' && charPressed < '4'  ||   //hours cannot exceed 23 (23:59:59 is followed by 00:00:00)
-                       lcdOutputTextTable[entryState + 1][timeInputHours10] < '2'){                            //hours can reach 19:00:00 and 09:00:00
-                        updateTimeData;
-                    }
-                }
-
-                if(timeInputPosition == timeInputMins10){
-                    if(charPressed < '6'){  //minutes cannot exceed 59
-                        updateTimeData;
-                    }
-                }
-
-                if(timeInputPosition == timeInputMins01){
-                    updateTimeData;         //the entire range of 0-9 is valid for single minutes
-                }
-
-                if(timeInputPosition == timeInputSecs10){
-                    if(charPressed < '6'){  //seconds cannot exceed 59
-                        updateTimeData;
-                    }
-
-                }
-
-                if(timeInputPosition == timeInputSecs01){
-                    updateTimeData;         //the entire range of 0-9 is valid for single seconds
-                }
-
-                if(incrementInputIndex) timeInputIndex++;   //this is done at the end to prevent a cascade of multiple time indexes being updated due to a number input that is valid for all of them
-
-                break;
-        }
-        lcdOutputTableRW.unlock();          //(4)
-    }
-    
-    if(entryState == SetClosingTime){
-        lcdOutputTableRW.lock();            //(4)
-        switch(charPressed){
-            case 'a':               //switch to next state and filter input of the current state
-                timeInputIndex = 0; //reset the index of the next button to be updated to 0
-                currentState = SetMax; //set the system state to configuring the maximum distance within the sensor range
-
-                //iterate over the time input and replace any remaining 'h','m', and 's' characters with '0'
-                for(int i = timeInputHours10; i <= timeInputSecs01; i++){   //iterate over the confirmed input time of the SetRealTime state output string
-                    if(lcdOutputTextTable[entryState + 1][i] > ':'){        //fix any unset characters (where the value is still h,m,s (all ASCII values greater than ':'))
-                        lcdOutputTextTable[entryState + 1][i] = '0';        //by setting those unset characters to 0
-                    }
-                }
-                
-                break;
-            case 'c':               //reset time input when the button C is pressed
-                timeInputIndex = 0; //reset the index of the next button to be updated to 0
-                lcdOutputTextTable[entryState + 1][timeInputHours10] = 'h'; //reset the value of tens of hours to h
-                lcdOutputTextTable[entryState + 1][timeInputHours01] = 'h'; //reset the value of hours to h
-                lcdOutputTextTable[entryState + 1][timeInputMins10] = 'm';  //reset the value of tens of minutes to m
-                lcdOutputTextTable[entryState + 1][timeInputMins01] = 'm';  //reset the value of minutes to m
-                lcdOutputTextTable[entryState + 1][timeInputSecs10] = 's';  //reset the value of tens of seconds to s
-                lcdOutputTextTable[entryState + 1][timeInputSecs01] = 's';  //reset the value of seconds to s
-                break;
-
-            case '1': //Handle all number inputs in the same manner:
-            case '2': //Update the time input of the state
-            case '3': //if the input number is valid for the current time index
-            case '4': //otherwise take no action
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '0':
-                bool incrementInputIndex = false;    //indicate if a valid button press was detected and the next time index should be switched to
-                int timeInputPosition = timeInputPositions[timeInputIndex]; //the current index of the time input position to update
- 
-                //repeat for each time input position.  This cannot be a single for loop due to the variance of rollover conditions for each digit
-                //if the current time input position matches the time input position of this time unit, make sure that the
-                // input number does not break the conditions required for the time to remain valid on a 24 hour clock
-
-                if(timeInputPosition == timeInputHours10){
-                    if(charPressed < '3'){  //tens of hours cannot exceed 2
-                        updateTimeData;
-                    }
-                }
-
-                if(timeInputPosition == timeInputHours01){
-                    if(lcdOutputTextTable[entryState + 1][timeInputHours10] < '3' && charPressed < '4'  ||   //hours cannot exceed 23 (23:59:59 is followed by 00:00:00)
-                       lcdOutputTextTable[entryState + 1][timeInputHours10] < '2'){                            //hours can reach 19:00:00 and 09:00:00
-                        updateTimeData;
-                    }
-                }
-
-                if(timeInputPosition == timeInputMins10){
-                    if(charPressed < '6'){  //minutes cannot exceed 59
-                        updateTimeData;
-                    }
-                }
-
-                if(timeInputPosition == timeInputMins01){
-                    updateTimeData;         //the entire range of 0-9 is valid for single minutes
-                }
-
-                if(timeInputPosition == timeInputSecs10){
-                    if(charPressed < '6'){  //seconds cannot exceed 59
-                        updateTimeData;
-                    }
-
-                }
-
-                if(timeInputPosition == timeInputSecs01){
-                    updateTimeData;         //the entire range of 0-9 is valid for single seconds
-                }
-
-                if(incrementInputIndex) timeInputIndex++;   //this is done at the end to prevent a cascade of multiple time indexes being updated due to a number input that is valid for all of them
-
-                break;
-        }
-        lcdOutputTableRW.unlock();          //(4)
-    }
-
-    if(entryState == SetMax){
-        switch(charPressed){
-            case 'a':   //set the maximum distance from the sensor (empty container) equal to the stabilized distance at the time that the button was pressed
-                stableDistanceRWMutex.lock();   //(3)
-                maxDistanceRW.lock();           //(5)
-                maxDistance = stableDistance;   //critical section: set maximum distance equal to stable distance
-                maxDistanceRW.unlock();         //(5)
-                stableDistanceRWMutex.unlock(); //(3)
-                currentState = SetMin;          //with the maximum distance set, switch to the next state for setting the minimum distance (full container)
-                break;
-        }
-    }
-
-    if(entryState == SetMin){
-        switch(charPressed){
-            case 'a':       //lock in the minimum distance and switch to the observing state
-                stableDistanceRWMutex.lock();    //(3)
-                maxDistanceRW.lock();            //(5)
-                minDistanceRW.lock();            //(6)
-                alarmArmedRW.lock();             //(7)
-                
-                minDistance = stableDistance;    //set the minimum distance (full container) to the current stabilized distance measurement
-                currentState = Observer;         //switch to the observer mode to monitor for the conditions required to trigger the alarm
-                
-                if(minDistance != maxDistance){   //only start off with the alarm armed if the min and max distances aren't equal.  If the alarm is turned on while they are equal, the alarm will always sound.
-                    alarmArmed = true;               //arm the alarm to be activated when the necessary trigger conditions are met
-                }
-
-                alarmArmedRW.unlock();           //(7)
-                minDistanceRW.unlock();          //(6)
-                maxDistanceRW.unlock();          //(5)
-                stableDistanceRWMutex.unlock();  //(3)
-                break;
-        }
-    }
-
-    if(entryState == Observer){
-        switch (charPressed) {
-        case '#':       //toggle state of alarm between armed and off
-            alarmArmedRW.lock();       //(7)
-            alarmArmed = !alarmArmed;
-            alarmArmedRW.unlock();     //(7)
-            break;
-        }
-    }
-
-    //Inputs Independent of State:
-    switch(charPressed){
-        case 'd':       //return to setup, deactivate the alarm until setup completes
-            currentState = SetRealTime;     //return to state SetRealTime
-            timeInputIndex = 0;             //reset edit cursor to 10's of hours, but do not clear stored data
-            alarmArmedRW.lock();       //(7)
-            alarmArmed = false;        //disable the alarm while not in Observer mode
-            alarmArmedRW.unlock();     //(7)
-            break;
-    }
-
-    outputChangesMadeRW.lock();     //(2)
-    outputChangesMade = true;       //after any button press, raise the mutex-protected flag indicating that changes to the output have been made and require an output refresh
-    outputChangesMadeRW.unlock();   //(2)
-    currentStateRW.unlock();        //(1) end of critical section where the current state of the system may be modified and lower-level mutexes
+    applyUiTransition(charPressed, keyClassOf(charPressed));
 }
 
 
 /**
- * void pollDistanceSensor()
- * non-ISR function
- * 
+ * void handleHeldKey(char keyHeld)
+ * non-ISR Function
+ *
  * Summary of the function:
- *    This function starts the distance echo timer and sends a digital high signal to the trigger pin for 10 us
+ *    This function handles the long press and repeat events of a key that is held down.  The keys in autoRepeatKeys 
+ *      are handled as further presses, so holding B scrolls through the days.  A held digit takes the [0-9] held 
+ *      transition of the state, which scrolls the digit that its press entered in the SetRealTime and SetClosingTime 
+ *      states.  Other held keys are ignored.
  *
- * Parameters:
- *    None
+ * Parameters:   
+ *    - keyHeld - the ASCII character of the key that is held down
  *
  * Return value:
  *    None
  *
  * Outputs:
- *    GPIO pin PC_9 is sent a digital high signal for 10 us and then reset to 0
+ *    None directly.  See handleInputKey
  *
  * Shared variables accessed:
- *    distanceEchoTimer is started
+ *    See handleInputKey
  *
  * Helper ISR Function:
- *    enqueuePoll
+ *    no direct helper.  Called on the key input thread by processKeyEvents
  */
-void pollDistanceSensor(){
-    distanceEchoTimer.start();  //start the timer to measure response time
-
-    //send trigger signal high for 10 us
-    GPIOC->ODR |= 0x200;    //set signal high on pin PC_9
-    wait_us(10);            //wait 10 us
-    GPIOC->ODR &= ~(0x200); //set signal low on pin PC_9
+void handleHeldKey(char keyHeld){
+    if(strchr(autoRepeatKeys, keyHeld)){
+        handleInputKey(keyHeld);
+    }else if(keyClassOf(keyHeld) == KeyClassDigit){
+        applyUiTransition(keyHeld, KeyClassHeldDigit);
+    }
 }
-//helper ISR Function
-void enqueuePoll(){distanceSensorEventQueue.call(pollDistanceSensor);}
 
 
 /**
- * void processDistanceData()
- * non-ISR function
- * 
+ * void applyUiTransition(char key, int keyClass)
+ * non-ISR Function
+ *
  * Summary of the function:
- *    This function converts the duration of the echo response from the distance sensor into a duration that is then added to the stabilizer distance array.
- *    Once the new distance is added to the circular stabilizer array, a function to update the stabilized distance value is called.
+ *    This function takes the action of the uiTransitionTable entry of the current state and the key class, enters 
+ *      the next state of the entry, and draws the result at once.
  *
  * Parameters:   
- *    None
+ *    - key      - the ASCII character of the key, passed to the action
+ *    - keyClass - the column of the transition table
  *
  * Return value:
  *    None
  *
  * Outputs:
- *    None
+ *    None directly.  See handleInputKey
  *
  * Shared variables accessed:
- *    riseEchoTimestamp and fallEchoTimestamp are accessed and cleared by this function
- *    a value of the distanceBuffer is overwritten by this function
- *
- * Helper ISR Function:
- *    distanceEchoFallHandler
- *    distanceEchoRiseHandler
- *
+ *    See handleInputKey
  */
-void processDistanceData(){
-    ull deltaTime = fallEchoTimestamp - riseEchoTimestamp;      //the time between the rising and falling edge events in microseconds
-    int distance = deltaTime / 58;                              //distance sensor documentation states divide the time delta by (58 us/cm) to calculate distance in cm
-    if(DISTANCE_MINIMUM < distance && distance < DISTANCE_MAXIMUM){          //if the detected distance is within the range of values that the sensor can accurately measure
-        distanceBuffer[distanceBuffIdx++ % stabilizerArrayLen] = distance;   //add it to the stabilizer array by overwriting the oldest value in the array
-    }
-
-    int updatedStableDistance = updateStableDistance();     //call updateStableDistance to recalculate the stable distance
-    // printf("Threaded sample measured: %d cm \tStabilized estimate: %d cm \tChar Pressed: %c\n", distance, updatedStableDistance, charPressed);
-
-    //clear timestamp data after distance has been recorded
-    riseEchoTimestamp = 0;
-    fallEchoTimestamp = 0;
-
-    distanceEchoTimer.stop();   //stop the timer to prevent it from counting up after the reset
-    distanceEchoTimer.reset();  //reset the timer to be ready for the next run
-}
-//Helper ISR Functions:
-
-//ISR function to immediately handle falling edge of distance scan and enqueue a processing of the recorded data
-void distanceEchoFallHandler(){
-    fallEchoTimestamp=getTimeSinceStart();
-    distanceSensorEventQueue.call(processDistanceData);
-}
+void applyUiTransition(char key, int keyClass){
+    currentStateRW.lock();              //(1)
+    int entryState = currentState;      //act based on the system state preceeding the button press to avoid rollover
+    const UiTransition& transition = uiTransitionTable[entryState / 2][keyClass];     //states are spaced by two LCD output table lines
+    if(transition.action != NoAction) uiActionHandlers[transition.action](entryState, key);
+    currentState = transition.nextState;
 
-//ISR function to immediately handle rising edge of distance scan
-void distanceEchoRiseHandler(){
-    riseEchoTimestamp=getTimeSinceStart();
+    outputChangesMadeRW.lock();     //(2)
+    outputChangesMade = true;       //after any button press, raise the mutex-protected flag indicating that changes to the output have been made and require an output refresh
+    outputChangesMadeRW.unlock();   //(2)
+    enqueueOutputRefresh(true);     //draw the key press at once.  A change of state also switches the refresh policy
+    currentStateRW.unlock();        //(1) end of critical section where the current state of the system may be modified and lower-level mutexes
 }
 
 
 /**
- * unsigned long long getTimeSinceStart()
- * ISR-friendly helper function
- * 
+ * void confirmRealTime(int entryState, char key)
+ * non-ISR function
+ *
  * Summary of the function:
- *    This function returns the elapsed time in milliseconds since the distance echo timer was started.
+ *    This function confirms the current time input of the SetRealTime state, defaulting all unentered positions to 0, 
+ *      and loads it into the RTC.  The closing time input is started on the same day, showing the closing time 
+ *      already confirmed for it.
  *
  * Parameters:   
- *    None
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the key that was pressed
  *
  * Return value:
- *    The elapsed time in milliseconds since the distance echo timer was started.
+ *    None
  *
  * Outputs:
- *    None
+ *    The RTC is set and the closing alarm is rescheduled
  *
  * Shared variables accessed:
- *    The Timer distanceEchoTimer, exclusive to the distance sensor thread, is accessed.
- *
+ *    lcdOutputTextTable  - mutex (4)
+ *    closingTimeSchedule - mutex (10)
  */
-//Access global object timer to get the time since the process began in microseconds
-//code in this function is from https://os.mbed.com/docs/mbed-os/v6.15/apis/timer.html
-ull getTimeSinceStart() {
-    using namespace std::chrono;
-    return duration_cast<microseconds>(distanceEchoTimer.elapsed_time()).count();
+void confirmRealTime(int entryState, char key){
+    lcdOutputTableRW.lock();            //(4)
+    timeInputIndex = 0;                 //reset the index of the next button to be updated to 0
+    fillUnsetTimeDigits(lcdOutputTextTable[entryState + 1]);
+    setRealTimeClock(realTimeInputDay, parseTimeOfDay(lcdOutputTextTable[entryState + 1]));   //load the confirmed time into the RTC, which keeps the time of day from here on
+    enqueueAlarmScheduling();           //the clock has changed, so the next closing time must be found again
+
+    //start the closing time input on the current day, showing the closing time already confirmed for it
+    closingInputDay = realTimeInputDay;
+    closingInputPerDay = false;
+    renderWeekday(lcdOutputTextTable[SetClosingTime], closingInputDay);
+    closingScheduleRW.lock();           //(10)
+    if(closingScheduleSet){
+        renderTimeOfDay(lcdOutputTextTable[SetClosingTime + 1], closingTimeSchedule[closingInputDay]);
+    }
+    closingScheduleRW.unlock();         //(10)
+    lcdOutputTableRW.unlock();          //(4)
 }
 
 
 /**
- * int updateStableDistance()
+ * void advanceRealTimeDay(int entryState, char key)
  * non-ISR function
- * 
+ *
  * Summary of the function:
- *    This function recalculates the stable distance detected by the distance sensor as an average of the sampled array of distances.
- *    If the stable distance mutex is unlocked, the function will update the value of the stable distance to match the newly calculated value.
+ *    This function advances the day of the week of the SetRealTime input.
  *
  * Parameters:   
- *    None
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the key that was pressed
  *
  * Return value:
- *    A copy of the updated value of the sum, not needing mutex protection
+ *    None
  *
  * Outputs:
- *    The changes made flag is raised to update outputs with new stable distance value
+ *    None
  *
  * Shared variables accessed:
- *    outputChangesMade  - mutex (2)
- *    stableDistance     - mutex (3)
- *
+ *    lcdOutputTextTable  - mutex (4)
+ */
+void advanceRealTimeDay(int entryState, char key){
+    realTimeInputDay = (realTimeInputDay + 1) % daysPerWeek;
+    lcdOutputTableRW.lock();            //(4)
+    renderWeekday(lcdOutputTextTable[entryState], realTimeInputDay);
+    lcdOutputTableRW.unlock();          //(4)
+}
+
+
+/**
+ * void confirmClosingTime(int entryState, char key)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function confirms the current time input of the SetClosingTime state, defaulting all unentered positions to 0.
+ *    It is stored as the closing time of every day, or of the displayed day only if [B] has been used.
+ *
+ * Parameters:   
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the key that was pressed
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    The closing alarm is rescheduled
+ *
+ * Shared variables accessed:
+ *    lcdOutputTextTable  - mutex (4)
+ *    closingTimeSchedule - mutex (10)
+ */
+void confirmClosingTime(int entryState, char key){
+    lcdOutputTableRW.lock();            //(4)
+    timeInputIndex = 0;                 //reset the index of the next button to be updated to 0
+    storeClosingTimeInput(lcdOutputTextTable[entryState + 1]);
+    lcdOutputTableRW.unlock();          //(4)
+}
+
+
+/**
+ * void storeClosingDay(int entryState, char key)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function keeps the current time input as the closing time of the displayed day and advances the input 
+ *      to the next day, showing the closing time stored for it.
+ *    The first use seeds every day with the input so that only differing days need to be edited.
+ *
+ * Parameters:   
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the key that was pressed
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    The closing alarm is rescheduled
+ *
+ * Shared variables accessed:
+ *    lcdOutputTextTable  - mutex (4)
+ *    closingTimeSchedule - mutex (10)
+ */
+void storeClosingDay(int entryState, char key){
+    lcdOutputTableRW.lock();            //(4)
+    timeInputIndex = 0;                 //reset the index of the next button to be updated to 0
+    storeClosingTimeInput(lcdOutputTextTable[entryState + 1]);
+    closingInputPerDay = true;
+    closingInputDay = (closingInputDay + 1) % daysPerWeek;
+    closingScheduleRW.lock();           //(10)
+    renderTimeOfDay(lcdOutputTextTable[entryState + 1], closingTimeSchedule[closingInputDay]);
+    closingScheduleRW.unlock();         //(10)
+    renderWeekday(lcdOutputTextTable[entryState], closingInputDay);
+    lcdOutputTableRW.unlock();          //(4)
+}
+
+
+/**
+ * void clearTimeInput(int entryState, char key)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function resets the time input of the state to hh:mm:ss and begins the input again from the tens of hours.
+ *
+ * Parameters:   
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the key that was pressed
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    lcdOutputTextTable  - mutex (4)
+ */
+void clearTimeInput(int entryState, char key){
+    timeInputIndex = 0;                 //reset the index of the next button to be updated to 0
+    lcdOutputTableRW.lock();            //(4)
+    memcpy(&lcdOutputTextTable[entryState + 1][timeInputHours10], "hh:mm:ss", timeInputSecs01 - timeInputHours10 + 1);
+    lcdOutputTableRW.unlock();          //(4)
+}
+
+
+/**
+ * void enterTimeDigit(int entryState, char key)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function enters a digit at the current time input position if the digit rule of that position accepts it, 
+ *      keeping the time valid on a 24 hour clock, and keeps the position for scrollTimeDigit.  Otherwise no digit 
+ *      is entered, and holding the key scrolls nothing.
+ *
+ * Parameters:   
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the digit that was pressed
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    lcdOutputTextTable  - mutex (4)
+ */
+void enterTimeDigit(int entryState, char key){
+    if(timeInputIndex >= (int)(sizeof(timeDigitRules) / sizeof(timeDigitRules[0]))) return;  //every digit has been entered
+    const TimeDigitRule& rule = timeDigitRules[timeInputIndex];
+
+    lcdOutputTableRW.lock();            //(4)
+    char* timeLine = lcdOutputTextTable[entryState + 1];
+    char maxDigit = rule.maxDigit;
+    if(rule.limitingPosition != noLimitingPosition && timeLine[rule.limitingPosition] == rule.limitingDigit){
+        maxDigit = rule.limitedMaxDigit;
+    }
+    if(key <= maxDigit){
+        timeLine[rule.position] = key;
+        scrollInputIndex = timeInputIndex++;
+    }else{
+        scrollInputIndex = -1;          //a held rejected digit scrolls nothing
+    }
+    lcdOutputTableRW.unlock();          //(4)
+}
+
+
+/**
+ * void scrollTimeDigit(int entryState, char key)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function advances the digit that the held digit key entered to the next digit accepted by the digit rule 
+ *      of its position, wrapping to 0 past the largest, so that holding a digit key scrolls the digit from the one 
+ *      pressed.  The input position is not moved.  If the press was rejected, or the input has been confirmed or 
+ *      cleared since, no action is taken.
+ *
+ * Parameters:   
+ *    - entryState - the state of the system when the key was held
+ *    - key        - the digit that is held
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    lcdOutputTextTable  - mutex (4)
+ */
+void scrollTimeDigit(int entryState, char key){
+    if(scrollInputIndex < 0 || scrollInputIndex != timeInputIndex - 1) return;     //the held key did not enter the last digit
+    const TimeDigitRule& rule = timeDigitRules[scrollInputIndex];
+
+    lcdOutputTableRW.lock();            //(4)
+    char* timeLine = lcdOutputTextTable[entryState + 1];
+    char maxDigit = rule.maxDigit;
+    if(rule.limitingPosition != noLimitingPosition && timeLine[rule.limitingPosition] == rule.limitingDigit){
+        maxDigit = rule.limitedMaxDigit;
+    }
+    timeLine[rule.position] = timeLine[rule.position] < maxDigit ? timeLine[rule.position] + 1 : '0';
+    lcdOutputTableRW.unlock();          //(4)
+}
+
+
+/**
+ * void confirmMaxDistance(int entryState, char key)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function sets the maximum distance from the sensor (empty container) equal to the stabilized distance 
+ *      at the time that the button was pressed.
+ *
+ * Parameters:   
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the key that was pressed
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    stableDistance - mutex (3)
+ *    maxDistance    - mutex (5)
+ */
+void confirmMaxDistance(int entryState, char key){
+    stableDistanceRWMutex.lock();   //(3)
+    maxDistanceRW.lock();           //(5)
+    maxDistance = stableDistance;   //critical section: set maximum distance equal to stable distance
+    maxDistanceRW.unlock();         //(5)
+    stableDistanceRWMutex.unlock(); //(3)
+}
+
+
+/**
+ * void confirmMinDistance(int entryState, char key)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function sets the minimum distance from the sensor (full container) equal to the stabilized distance 
+ *      at the time that the button was pressed, and arms the alarm for the Observer state.
+ *
+ * Parameters:   
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the key that was pressed
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    The alarm output is updated
+ *
+ * Shared variables accessed:
+ *    stableDistance - mutex (3)
+ *    maxDistance    - mutex (5)
+ *    minDistance    - mutex (6)
+ *    alarmArmed     - mutex (7)
+ */
+void confirmMinDistance(int entryState, char key){
+    stableDistanceRWMutex.lock();    //(3)
+    maxDistanceRW.lock();            //(5)
+    minDistanceRW.lock();            //(6)
+    alarmArmedRW.lock();             //(7)
+    
+    minDistance = stableDistance;    //set the minimum distance (full container) to the current stabilized distance measurement
+    if(minDistance != maxDistance){   //only start off with the alarm armed if the min and max distances aren't equal.  If the alarm is turned on while they are equal, the alarm will always sound.
+        alarmArmed = true;               //arm the alarm to be activated when the necessary trigger conditions are met
+    }
+    enqueueAlarmUpdate();            //arming and the fill level range have changed
+
+    alarmArmedRW.unlock();           //(7)
+    minDistanceRW.unlock();          //(6)
+    maxDistanceRW.unlock();          //(5)
+    stableDistanceRWMutex.unlock();  //(3)
+}
+
+
+/**
+ * void toggleAlarmArmed(int entryState, char key)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function toggles the state of the alarm between armed and off.
+ *
+ * Parameters:   
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the key that was pressed
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    The alarm output is updated
+ *
+ * Shared variables accessed:
+ *    alarmArmed - mutex (7)
+ */
+void toggleAlarmArmed(int entryState, char key){
+    alarmArmedRW.lock();       //(7)
+    alarmArmed = !alarmArmed;
+    alarmArmedRW.unlock();     //(7)
+    enqueueAlarmUpdate();      //arming has changed
+}
+
+
+/**
+ * void returnToSetup(int entryState, char key)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function deactivates the alarm until setup completes again.  When leaving a running state, the time 
+ *      currently held by the RTC is shown as the current time input to edit.  Stored data is not cleared.
+ *
+ * Parameters:   
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the key that was pressed
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    The alarm output is updated
+ *
+ * Shared variables accessed:
+ *    lcdOutputTextTable - mutex (4)
+ *    alarmArmed         - mutex (7)
+ */
+void returnToSetup(int entryState, char key){
+    if(entryState != SetRealTime){      //leaving a running state: show the time currently held by the RTC as the input to edit
+        realTimeInputDay = readRealTimeOfWeek() / secondsPerDay;
+        lcdOutputTableRW.lock();        //(4)
+        renderWeekday(lcdOutputTextTable[SetRealTime], realTimeInputDay);
+        renderTimeOfDay(lcdOutputTextTable[SetRealTime + 1], readRealTimeClock());
+        lcdOutputTableRW.unlock();      //(4)
+    }
+    timeInputIndex = 0;             //reset edit cursor to 10's of hours, but do not clear stored data
+    alarmArmedRW.lock();       //(7)
+    alarmArmed = false;        //disable the alarm while not in Observer mode
+    alarmArmedRW.unlock();     //(7)
+    enqueueAlarmUpdate();      //arming has changed
+}
+
+
+/**
+ * void reportDiagnostics(int entryState, char key)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function prints the keypad edge counters and the I2C transactions and queueing delay of each bus client
+ *      to the serial console in any state, and enqueues a printout of the LCD frame rates on the output refresh
+ *      thread, which owns the refresh statistics.
+ *
+ * Parameters:   
+ *    - entryState - the state of the system when the key was pressed
+ *    - key        - the key that was pressed
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    Serial printout
+ *
+ * Shared variables accessed:
+ *    See printKeypadEdgeCounters
+ *    I2C bus statistics, protected by the bus
+ */
+void reportDiagnostics(int entryState, char key){
+    printKeypadEdgeCounters();
+    i2cBus.printStatistics();
+    outputModificationEventQueue.call(printDisplayRefreshStatistics);
+#if CSE321_LATENCY_PROBES
+    LatencyProbe::printAll();
+#endif
+}
+
+
+/**
+ * void fillUnsetTimeDigits(char* timeLine)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function replaces any remaining 'h', 'm' and 's' placeholders of a time input with '0'.
+ *    The caller must hold lcdOutputTableRW (4) if the line is in the LCD output table.
+ *
+ * Parameters:   
+ *    - timeLine - the LCD output line holding the time input
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    None directly
+ */
+void fillUnsetTimeDigits(char* timeLine){
+    for(int i = timeInputHours10; i <= timeInputSecs01; i++){
+        if(timeLine[i] > ':') timeLine[i] = '0';    //unset characters h, m and s all have ASCII values greater than ':'
+    }
+}
+
+
+/**
+ * void storeClosingTimeInput(char* timeLine)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function defaults all unentered positions of a closing time input to 0 and stores it as the closing time 
+ *      of every day, or of the displayed day only once [B] has been used.  The closing alarm is rescheduled.
+ *    The caller must hold lcdOutputTableRW (4).
+ *
+ * Parameters:   
+ *    - timeLine - the LCD output line holding the closing time input
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    The closing alarm is rescheduled
+ *
+ * Shared variables accessed:
+ *    closingTimeSchedule - mutex (10)
+ */
+void storeClosingTimeInput(char* timeLine){
+    fillUnsetTimeDigits(timeLine);
+    int closingTime = parseTimeOfDay(timeLine);
+    closingScheduleRW.lock();       //(10)
+    for(int day = 0; day < daysPerWeek; day++){
+        if(!closingInputPerDay || day == closingInputDay){      //a daily closing time applies to every day, otherwise only the displayed day is updated
+            closingTimeSchedule[day] = closingTime;
+        }
+    }
+    closingScheduleSet = true;
+    closingScheduleRW.unlock();     //(10)
+    enqueueAlarmScheduling();       //the schedule has changed, so the next closing time must be found again
+}
+
+
+/**
+ * void pollDistanceSensor()
+ * non-ISR function
+ * 
+ * Summary of the function:
+ *    This function starts the distance echo timer and sends a digital high signal to the trigger pin for 10 us
+ *
+ * Parameters:
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    GPIO pin PC_9 is sent a digital high signal for 10 us and then reset to 0
+ *
+ * Shared variables accessed:
+ *    distanceEchoTimer is started
+ *
+ * Helper ISR Function:
+ *    enqueuePoll
+ */
+void pollDistanceSensor(){
+    LATENCY_STOP(pollTickProbe);
+    distanceEchoTimer.start();  //start the timer to measure response time
+
+    //send trigger signal high for 10 us
+    RangeTrigger::set();    //set signal high on pin PC_9
+    wait_us(10);            //wait 10 us
+    RangeTrigger::clear();  //set signal low on pin PC_9
+}
+//helper ISR Function
+void enqueuePoll(){
+    LATENCY_START(pollTickProbe);
+    distanceSensorEventQueue.call(pollDistanceSensor);
+}
+
+
+/**
+ * void processDistanceData()
+ * non-ISR function
+ * 
+ * Summary of the function:
+ *    This function converts the duration of the echo response from the distance sensor into a duration that is then added to the stabilizer distance array.
+ *    Once the new distance is added to the circular stabilizer array, a function to update the stabilized distance value is called.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    riseEchoTimestamp and fallEchoTimestamp are accessed and cleared by this function
+ *    a value of the distanceBuffer is overwritten by this function
+ *
+ * Helper ISR Function:
+ *    distanceEchoFallHandler
+ *    distanceEchoRiseHandler
+ *
+ */
+void processDistanceData(){
+    LATENCY_STOP(echoFallProbe);
+    ull deltaTime = fallEchoTimestamp - riseEchoTimestamp;      //the time between the rising and falling edge events in microseconds
+    int distance = deltaTime / 58;                              //distance sensor documentation states divide the time delta by (58 us/cm) to calculate distance in cm
+    if(DISTANCE_MINIMUM < distance && distance < DISTANCE_MAXIMUM){          //if the detected distance is within the range of values that the sensor can accurately measure
+        distanceBuffer[distanceBuffIdx++ % stabilizerArrayLen] = distance;   //add it to the stabilizer array by overwriting the oldest value in the array
+        core_util_atomic_incr_u32(&distanceSampleCount, 1);                  //counted for the sample rate of the second Observer page
+    }
+
+    int updatedStableDistance = updateStableDistance();     //call updateStableDistance to recalculate the stable distance
+    // printf("Threaded sample measured: %d cm \tStabilized estimate: %d cm \tChar Pressed: %c\n", distance, updatedStableDistance, charPressed);
+    (void)updatedStableDistance;                            //only read by the trace above
+
+    //clear timestamp data after distance has been recorded
+    riseEchoTimestamp = 0;
+    fallEchoTimestamp = 0;
+
+    distanceEchoTimer.stop();   //stop the timer to prevent it from counting up after the reset
+    distanceEchoTimer.reset();  //reset the timer to be ready for the next run
+}
+//Helper ISR Functions:
+
+//ISR function to immediately handle falling edge of distance scan and enqueue a processing of the recorded data
+void distanceEchoFallHandler(){
+    LATENCY_START(echoFallProbe);
+    fallEchoTimestamp=getTimeSinceStart();
+    distanceSensorEventQueue.call(processDistanceData);
+}
+
+//ISR function to immediately handle rising edge of distance scan
+void distanceEchoRiseHandler(){
+    riseEchoTimestamp=getTimeSinceStart();
+}
+
+
+/**
+ * unsigned long long getTimeSinceStart()
+ * ISR-friendly helper function
+ * 
+ * Summary of the function:
+ *    This function returns the elapsed time in milliseconds since the distance echo timer was started.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    The elapsed time in milliseconds since the distance echo timer was started.
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    The Timer distanceEchoTimer, exclusive to the distance sensor thread, is accessed.
+ *
+ */
+//Access global object timer to get the time since the process began in microseconds
+//code in this function is from https://os.mbed.com/docs/mbed-os/v6.15/apis/timer.html
+ull getTimeSinceStart() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(distanceEchoTimer.elapsed_time()).count();
+}
+
+
+/**
+ * int updateStableDistance()
+ * non-ISR function
+ * 
+ * Summary of the function:
+ *    This function recalculates the stable distance detected by the distance sensor as an average of the sampled array of distances.
+ *    If the stable distance mutex is unlocked, the function will update the value of the stable distance to match the newly calculated value.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    A copy of the updated value of the sum, not needing mutex protection
+ *
+ * Outputs:
+ *    The changes made flag is raised to update outputs with new stable distance value
+ *    An update of the alarm output and an output refresh request are enqueued when the stable distance changes
+ *
+ * Shared variables accessed:
+ *    outputChangesMade  - mutex (2)
+ *    stableDistance     - mutex (3)
+ *
  * Helper ISR Function:
  *    no direct helper.  Dependent on processDistanceData
  */
@@ -1054,24 +1656,411 @@ int updateStableDistance(){
     if(acquiredLock){                                       //if the mutex was successfully acquired, update the stable distance with the new average value
         if(stableDistance != averageDistance){              //if the previous stable distance is different from the new average
             outputChangesMade = true;                       //raise the flag indicating that the output must be refreshed to account for this new value
+            enqueueOutputRefresh(false);                    //schedule a frame according to the refresh policy of the current state
             stableDistance = averageDistance;               //update the stable distance with the new average value
+            enqueueAlarmUpdate();                           //the fill level has changed, so the alarm output must be re-evaluated
+        }
+        stableDistanceRWMutex.unlock();       //(3)
+    }
+    outputChangesMadeRW.unlock();        //(2)
+
+    return averageDistance;     //returns the new stable distance as a non-mutex-protected value regardless of whether or not it was successfully locked in
+}
+
+
+/**
+ * int readRealTimeOfWeek()
+ * ISR-compatible function
+ * 
+ * Summary of the function:
+ *    This function reads the real-world time of the week from the on-chip RTC.
+ *    The RTC counts whole seconds in hardware, so no periodic tick is required to keep the time and no drift
+ *      accumulates from ticker latency.  Day and week rollover are handled by the modulo of the epoch seconds.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    The current time in seconds since Monday 00:00:00 (0 - 604799)
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    None.  The RTC peripheral is read through the HAL (the MBED time API on the NUCLEO).
+ *
+ */
+int readRealTimeOfWeek(){
+    return (halRtcRead() + rtcEpochWeekdayOffset * secondsPerDay) % secondsPerWeek;
+}
+
+
+/**
+ * int readRealTimeClock()
+ * ISR-compatible function
+ * 
+ * Summary of the function:
+ *    This function reads the real-world time of day from the on-chip RTC.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    The current time of day in seconds since midnight (0 - 86399)
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    None.  The RTC peripheral is read through the HAL (the MBED time API on the NUCLEO).
+ *
+ */
+int readRealTimeClock(){
+    return readRealTimeOfWeek() % secondsPerDay;
+}
+
+
+/**
+ * void setRealTimeClock(int weekday, int secondsOfDay)
+ * non-ISR function
+ * 
+ * Summary of the function:
+ *    This function loads a day of the week and time of day into the on-chip RTC.  The RTC is counted in seconds since 
+ *      the epoch, so the time is stored within the first week after the epoch that falls on the given day.
+ *
+ * Parameters:   
+ *    - weekday      - the day of the week, 0 (Monday) through 6 (Sunday)
+ *    - secondsOfDay - the time of day in seconds since midnight (0 - 86399)
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    The on-chip RTC is set
+ *
+ * Shared variables accessed:
+ *    None
+ *
+ */
+void setRealTimeClock(int weekday, int secondsOfDay){
+    int epochDay = (weekday + daysPerWeek - rtcEpochWeekdayOffset) % daysPerWeek;  //the first day after the epoch that falls on the given weekday
+    halRtcWrite(epochDay * secondsPerDay + secondsOfDay);
+}
+
+
+/**
+ * int parseTimeOfDay(const char* timeLine)
+ * ISR-compatible function
+ * 
+ * Summary of the function:
+ *    This function converts the hh:mm:ss digits of an LCD output line into seconds since midnight.
+ *    All six time positions must contain digits.
+ *
+ * Parameters:   
+ *    - timeLine - an LCD output line holding a time at the positions timeInputHours10 through timeInputSecs01
+ *
+ * Return value:
+ *    The time of day in seconds since midnight
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    lcdOutputTextTable - mutex (4) when timeLine is a line of the table.  It is assumed that the calling function has locked the mutex.
+ *
+ */
+int parseTimeOfDay(const char* timeLine){
+    int hours   = 10 * (timeLine[timeInputHours10] - '0') + (timeLine[timeInputHours01] - '0');
+    int minutes = 10 * (timeLine[timeInputMins10]  - '0') + (timeLine[timeInputMins01]  - '0');
+    int seconds = 10 * (timeLine[timeInputSecs10]  - '0') + (timeLine[timeInputSecs01]  - '0');
+    return hours * secondsPerHour + minutes * secondsPerMinute + seconds;
+}
+
+
+/**
+ * void renderTimeOfDay(char* timeLine, int secondsOfDay)
+ * ISR-compatible function
+ * 
+ * Summary of the function:
+ *    This function writes a time of day as hh:mm:ss digits into an LCD output line.
+ *    Digits are only rendered when a line is about to be displayed, not every time the clock advances.
+ *
+ * Parameters:   
+ *    - timeLine     - an LCD output line with time positions timeInputHours10 through timeInputSecs01
+ *    - secondsOfDay - the time of day in seconds since midnight (0 - 86399)
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    The six time digits of timeLine are overwritten
+ *
+ * Shared variables accessed:
+ *    lcdOutputTextTable - mutex (4) when timeLine is a line of the table.  It is assumed that the calling function has locked the mutex.
+ *
+ */
+void renderTimeOfDay(char* timeLine, int secondsOfDay){
+    int hours   = secondsOfDay / secondsPerHour;
+    int minutes = (secondsOfDay / secondsPerMinute) % 60;
+    int seconds = secondsOfDay % 60;
+    timeLine[timeInputHours10] = '0' + hours / 10;
+    timeLine[timeInputHours01] = '0' + hours % 10;
+    timeLine[timeInputMins10]  = '0' + minutes / 10;
+    timeLine[timeInputMins01]  = '0' + minutes % 10;
+    timeLine[timeInputSecs10]  = '0' + seconds / 10;
+    timeLine[timeInputSecs01]  = '0' + seconds % 10;
+}
+
+
+/**
+ * void renderWeekday(char* dayLine, int weekday)
+ * ISR-compatible function
+ * 
+ * Summary of the function:
+ *    This function writes the three letter name of a day of the week into an LCD output line.
+ *
+ * Parameters:   
+ *    - dayLine - an LCD output line with a day name at the position weekdayPosition
+ *    - weekday - the day of the week, 0 (Monday) through 6 (Sunday)
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    Three characters of dayLine are overwritten
+ *
+ * Shared variables accessed:
+ *    lcdOutputTextTable - mutex (4) when dayLine is a line of the table.  It is assumed that the calling function has locked the mutex.
+ *
+ */
+void renderWeekday(char* dayLine, int weekday){
+    for(int i = 0; i < 3; i++){
+        dayLine[weekdayPosition + i] = weekdayNames[weekday][i];
+    }
+}
+
+
+/**
+ * void populateLcdOutput()
+ * Reused from Project 2
+ * non-ISR function
+ * 
+ * Summary of the function:
+ *    This function performs the following operations:
+ *     1. Updates the LCD output string to match the latest distance data from the stabilized distance data, 
+ *          including the fill level bar graph of the Observer state.
+ *     2. Renders the RTC time of day into the Observer output string.
+ *     3. Updates the alarm armed indicator of the Observer output string.
+ *     4. Renders the second Observer page: sample rate, fill trend and closing time of today.
+ *     5. Updates the text of each line of the LCD based on the present state.  Only changed cells are sent, so a 
+ *          new second in the Observer state costs one cell.  In the Observer state both pages are updated, whichever 
+ *          is in view.
+ *    The alarm output itself is not evaluated here.  See scheduleClosingAlarm and updateAlarmOutput.
+ *    It is called when a frame is due under the refresh policy of the state.  See requestOutputRefresh.
+ *    With latency probes built in, the time from the start of a frame until its text is on the bus is recorded.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    LCD text is updated
+ *
+ * Shared variables accessed:
+ *    currentState       - mutex (1)
+ *    outputChangesMade  - mutex (2)
+ *    stableDistance     - mutex (3)
+ *    lcdOutputTextTable - mutex (4)
+ *    maxDistance        - mutex (5)
+ *    minDistance        - mutex (6)
+ *    alarmArmed         - mutex (7)
+ *    closingTimeSchedule, closingScheduleSet - mutex (10), see renderObserverDetails
+ *
+ * Helper ISR Function:
+ *    no direct helper.  Called on the output refresh thread by requestOutputRefresh, its periodic frame event, drawCoalescedFrame and drawOnNewSecond
+ *
+ */
+void populateLcdOutput(){
+#if CSE321_LATENCY_PROBES
+    uint32_t frameStartCycles = latencyStamp();     //the refresh tick, whether or not the frame has changes to send
+#endif
+    currentStateRW.lock();          //(1)
+    outputChangesMadeRW.lock();     //(2)
+
+    //the Observer output shows the seconds of the RTC, so a new second counts as an output change
+    int secondsOfDay = readRealTimeClock();
+    if(currentState == Observer && secondsOfDay != lastRenderedSecond){
+        outputChangesMade = true;
+    }
+
+    //only execute if output changes have been made
+    if(!outputChangesMade){
+        outputChangesMadeRW.unlock();    //(2)
+        currentStateRW.unlock();         //(1)
+        return;
+    }
+
+    //now that it has been confirmed that output changes are necessary, lock the remaining required mutexes
+    stableDistanceRWMutex.lock();   //(3)
+    lcdOutputTableRW.lock();        //(4)
+    maxDistanceRW.lock();           //(5)
+    minDistanceRW.lock();           //(6)
+
+    outputChangesMade = false;
+
+    //update capacity distance in min/max states
+    if(currentState == SetMax || currentState == SetMin){
+        lcdOutputTextTable[currentState + 1][distancePosition100] = '0' + (stableDistance/100) % 10;    //update 100's digit of displayed distance
+        lcdOutputTextTable[currentState + 1][distancePosition10]  = '0' + (stableDistance/10)  % 10;    //update 10's digit of displayed distance
+        lcdOutputTextTable[currentState + 1][distancePosition1]   = '0' + (stableDistance/1)   % 10;    //update 1's digit of displayed distance
+    }
+
+
+    int spaceValue = computeSpaceValue();  //the percentage number to be displayed in the Observer state
+    //update the value of the percent of space used in the Observer State
+    if(spaceValue != spaceValueUndefined){
+        lcdOutputTextTable[Observer + 1][percentPosition100] = '0' + (spaceValue/100) % 10;    //update 100's digit of displayed distance
+        lcdOutputTextTable[Observer + 1][percentPosition10]  = '0' + (spaceValue/10)  % 10;    //update 10's digit of displayed distance
+        lcdOutputTextTable[Observer + 1][percentPosition1]   = '0' + (spaceValue/1)   % 10;    //update 1's digit of displayed distance
+        CSE321_LCDController::renderBar(&lcdOutputTextTable[Observer][fillBarPosition], fillBarCells, spaceValue, 100);     //show the fill level at a glance
+    }else{  //in the case that the min and max distances are equal, there is no range to have a percentage out of.  Display "N/0" instead of a number
+        lcdOutputTextTable[Observer + 1][percentPosition100] = 'N';
+        lcdOutputTextTable[Observer + 1][percentPosition10]  = '/';
+        lcdOutputTextTable[Observer + 1][percentPosition1]   = '0';
+        CSE321_LCDController::renderBar(&lcdOutputTextTable[Observer][fillBarPosition], fillBarCells, 0, 100);
+    }
+
+    //render the time of day and the second page only when the Observer output is displayed
+    if(currentState == Observer){
+        renderTimeOfDay(lcdOutputTextTable[Observer + 1], secondsOfDay);
+        lastRenderedSecond = secondsOfDay;
+        renderObserverDetails(spaceValue, readRealTimeOfWeek());
+    }
+
+    //update the display flag of whether or not the alarm is armed
+    alarmArmedRW.lock();     //(7)
+    lcdOutputTextTable[Observer + 1][alarmIndicatorPosition] = alarmArmed ? alarmIndicatorArmed : alarmIndicatorOff;
+    alarmArmedRW.unlock();   //(7)
+
+    //refresh each line of the LCD display.  Only the cells that differ from the displayed text are sent
+    for(char line = 0; line < ROW; line++){
+        char* printVal = lcdOutputTextTable[currentState + line];   //retrieve the string associated with the current line of the LCD
+        lcdObject.updateRow(line, printVal);                //send the changed cells of the line
+        if(currentState == Observer){
+            lcdObject.updatePage(1, line, observerDetailTextTable[(int)line]);   //the second page is kept current while hidden
+        }
+    }
+    lcdFrames[currentState / 2]++;
+    lastFrameTime = Kernel::Clock::now();
+#if CSE321_LATENCY_PROBES
+    lcdObject.notifyWhenShown(recordFrameShown, frameStartCycles);     //recorded on the bus thread once the changed cells are sent
+#endif
+
+    minDistanceRW.unlock();           //(6)
+    maxDistanceRW.unlock();           //(5)
+    lcdOutputTableRW.unlock();        //(4)
+    stableDistanceRWMutex.unlock();   //(3)
+    outputChangesMadeRW.unlock();     //(2)
+    currentStateRW.unlock();          //(1)
+}
+
+
+/**
+ * void requestOutputRefresh(bool userInput)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function schedules LCD frames according to the refresh policy of the current state.  It is requested 
+ *      whenever the output changes.
+ *    When the state differs from the state whose policy is applied, the periodic and deferred frame events of the 
+ *      previous policy are cancelled, the first page is brought into view, a frame is drawn at once, and the policy 
+ *      of the new state is applied.  The Observer state also rotates its pages every observerPagePeriod.
+ *    Otherwise, a request from a key press draws a frame at once.  Any other request is handled by the policy:
+ *      RefreshPeriodic  - the change is drawn by the next periodic frame
+ *      RefreshOnChange  - a frame is drawn at once
+ *      RefreshCoalesced - a frame is drawn at once if the minimum interval has passed since the last frame.
+ *                           Otherwise one frame is deferred to the end of the interval, and further requests 
+ *                           within the interval are absorbed by it.
+ *      RefreshEachSecond - the change is drawn by the frame of the next RTC second.  The frames follow the RTC
+ *                           rather than a timer of their own, whose phase against the RTC second is arbitrary
+ *                           and drifts, so that the seconds shown never skip or repeat.
+ *
+ * Parameters:   
+ *    - userInput - true if the request follows a key press
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    LCD text may be updated
+ *
+ * Shared variables accessed:
+ *    currentState       - mutex (1)
+ *    Refresh scheduler state, accessed solely on the output refresh thread
+ *
+ * Helper ISR Function:
+ *    enqueueOutputRefresh
+ */
+void requestOutputRefresh(bool userInput){
+    currentStateRW.lock();          //(1)
+    int state = currentState;
+    currentStateRW.unlock();        //(1)
+    const RefreshPolicy& policy = refreshPolicies[state / 2];
+    Kernel::Clock::time_point now = Kernel::Clock::now();
+
+    if(state != refreshPolicyState){
+        //switch to the policy of the new state
+        if(refreshPolicyState >= 0) stateDisplayTime[refreshPolicyState / 2] += now - policyStartTime;
+        if(periodicRefreshEventId) outputModificationEventQueue.cancel(periodicRefreshEventId);
+        if(coalescedRefreshEventId) outputModificationEventQueue.cancel(coalescedRefreshEventId);
+        if(observerPageEventId) outputModificationEventQueue.cancel(observerPageEventId);
+        periodicRefreshEventId = 0;
+        coalescedRefreshEventId = 0;
+        observerPageEventId = 0;
+        refreshPolicyState = state;
+        policyStartTime = now;
+
+        //every state is drawn on the first page
+        observerPage = 0;
+        lcdObject.showPage(0);
+
+        lastDrawnSecond = readRealTimeOfWeek();
+        populateLcdOutput();        //draw the new state at once
+        if(policy.mode == RefreshPeriodic){
+            periodicRefreshEventId = outputModificationEventQueue.call_every(policy.interval, populateLcdOutput);
+        }else if(policy.mode == RefreshEachSecond){
+            drawOnNewSecond();      //the second is already drawn: aims the first event at the next second edge
         }
-        stableDistanceRWMutex.unlock();       //(3)
+        if(state == Observer){
+            observerPageEventId = outputModificationEventQueue.call_every(observerPagePeriod, rotateObserverPage);
+        }
+        return;
     }
-    outputChangesMadeRW.unlock();        //(2)
 
-    return averageDistance;     //returns the new stable distance as a non-mutex-protected value regardless of whether or not it was successfully locked in
+    if(userInput || policy.mode == RefreshOnChange){
+        populateLcdOutput();
+    }else if(policy.mode == RefreshCoalesced && !coalescedRefreshEventId){
+        Kernel::Clock::duration untilAllowed = lastFrameTime + policy.interval - now;
+        if(untilAllowed <= Kernel::Clock::duration::zero()){
+            populateLcdOutput();
+        }else{
+            coalescedRefreshEventId = outputModificationEventQueue.call_in(untilAllowed, drawCoalescedFrame);
+        }
+    }
 }
+//helper ISR Function
+void enqueueOutputRefresh(bool userInput){outputModificationEventQueue.call(requestOutputRefresh, userInput);}
 
 
 /**
- * void tickRealTimeClock()
- * non-ISR Function
- * 
+ * void drawCoalescedFrame()
+ * non-ISR function
+ *
  * Summary of the function:
- *    This funciton increments the real-world clock time by one second every time that it is 
- *      called (once per second) and handles the rollover into higher-signficance positions of the timestamp.
- *    The stabilized value after the rollover has been handled is then also cloned into the Observer state output.
+ *    This function draws the frame that a coalesced refresh request was deferred to, and allows the next 
+ *      request to defer another frame.
  *
  * Parameters:   
  *    None
@@ -1080,77 +2069,92 @@ int updateStableDistance(){
  *    None
  *
  * Outputs:
- *    The changes made flag is raised to update outputs with new stable distance value
+ *    LCD text is updated
  *
  * Shared variables accessed:
- *    currentState       - mutex (1)
- *    outputChangesMade  - mutex (2)
- *    lcdOutputTextTable - mutex (4)
+ *    Refresh scheduler state, accessed solely on the output refresh thread
+ */
+void drawCoalescedFrame(){
+    coalescedRefreshEventId = 0;
+    populateLcdOutput();
+}
+
+
+/**
+ * void drawOnNewSecond()
+ * non-ISR function
  *
- * Helper ISR Function:
- *   enqueueRTClockTick 
+ * Summary of the function:
+ *    This function runs once per second under a RefreshEachSecond policy, and draws a frame when the RTC second
+ *      has changed since the last frame it drew.  It then posts itself to run secondEdgeDelay after the next edge
+ *      of the RTC second, from the time into the current second.  That time is read between two reads of the
+ *      second that agree, so an edge that passes during the read or the frame is seen, and drawn at once.
+ *    The subsecond time is rounded down, so an event never aims early by the RTC resolution.  An event that
+ *      still runs before the edge, from the drift of the kernel clock, draws nothing and aims again.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    LCD text may be updated
  *
+ * Shared variables accessed:
+ *    Refresh scheduler state, accessed solely on the output refresh thread
  */
-void tickRealTimeClock(){
-    currentStateRW.lock();          //(1)
-    outputChangesMadeRW.lock();     //(2)
-    lcdOutputTableRW.lock();        //(4)
-    outputChangesMade = true;
-
-    if(currentState != SetRealTime){    //only update the clock when not setting the clock
-        if(lcdOutputTextTable[SetRealTime + 1][timeInputSecs01]++ >= '9'){      //increment seconds up to the limit of 9
-            lcdOutputTextTable[SetRealTime + 1][timeInputSecs01] = '0';
-
-            if(lcdOutputTextTable[SetRealTime + 1][timeInputSecs10]++ >= '5'){  //only occurs when seconds were previously :59
-                lcdOutputTextTable[SetRealTime + 1][timeInputSecs10] = '0';
-                //handle minutes
-                if(lcdOutputTextTable[SetRealTime + 1][timeInputMins01]++ >= '9'){  //increment minutes up to the limit of 9
-                    lcdOutputTextTable[SetRealTime + 1][timeInputMins01] = '0';
-
-                    if(lcdOutputTextTable[SetRealTime + 1][timeInputMins10]++ >= '5'){  //only occurs when minutes were previously :59
-                        lcdOutputTextTable[SetRealTime + 1][timeInputMins10] = '0';
-
-                        //handle hours
-                        if(lcdOutputTextTable[SetRealTime + 1][timeInputHours01]++ >= '9'){ //increment hours up to the generic limit of 9
-                            lcdOutputTextTable[SetRealTime + 1][timeInputHours01]='0';
-                            lcdOutputTextTable[SetRealTime + 1][timeInputHours10]++;
-
-                            //handle day rollover when hours = "24" by reseting to "00"
-                            if(lcdOutputTextTable[SetRealTime + 1][timeInputHours01] == '4' && lcdOutputTextTable[SetRealTime + 1][timeInputHours01] == '2'){
-                               lcdOutputTextTable[SetRealTime + 1][timeInputHours01] = '0';
-                               lcdOutputTextTable[SetRealTime + 1][timeInputHours10] = '0'; 
-                            }
-                        }
-                    }
-                }
-            }
-        }
+void drawOnNewSecond(){
+    int second = readRealTimeOfWeek();
+    if(second != lastDrawnSecond){
+        lastDrawnSecond = second;
+        populateLcdOutput();
     }
 
-    //put new value of SetRealTime into the Observer state as well
-    for(int i = timeInputHours10; i <= timeInputSecs01; i++){
-        lcdOutputTextTable[Observer + 1][i] = lcdOutputTextTable[SetRealTime + 1][i];
+    uint32_t subsecondUs;
+    do{
+        second = readRealTimeOfWeek();
+        subsecondUs = halRtcSubsecondUs();
+    }while(second != readRealTimeOfWeek());
+
+    std::chrono::milliseconds untilNextSecond = 0ms;        //an undrawn second is drawn at once
+    if(second == lastDrawnSecond){
+        untilNextSecond = std::chrono::milliseconds((usPerSecond - subsecondUs + 999) / 1000) + secondEdgeDelay;
     }
+    periodicRefreshEventId = outputModificationEventQueue.call_in(untilNextSecond, drawOnNewSecond);
+}
+
 
-    lcdOutputTableRW.unlock();     //(4)
-    outputChangesMadeRW.unlock();  //(2)
-    currentStateRW.unlock();       //(1)
+#if CSE321_LATENCY_PROBES
+/**
+ * void recordFrameShown(uint32_t frameStartCycles)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function records the latency of a frame, from the start of populateLcdOutput to the completion of the
+ *      last I2C transfer of its text.  It is called on the I2C bus thread, which is the only thread to record
+ *      frameShownProbe.
+ *
+ * Parameters:
+ *    - frameStartCycles - the latencyStamp() taken at the start of the frame
+ *
+ * Return value:
+ *    None
+ */
+void recordFrameShown(uint32_t frameStartCycles){
+    LATENCY_RECORD(frameShownProbe, frameStartCycles);
 }
-//helper ISR Function
-void enqueueRTClockTick(){outputModificationEventQueue.call(tickRealTimeClock);}
+#endif
 
 
 /**
- * void populateLcdOutput()
- * Reused from Project 2
+ * void printDisplayRefreshStatistics()
  * non-ISR function
- * 
+ *
  * Summary of the function:
- *    This function performs the following operations:
- *     1. Updates the LCD output string to match the latest distance data from the stabilized distance data.
- *     2. Checks if the alarm should be activated or deactivated.
- *     3. Sets the state of the alarm accordingly.
- *     4. Updates the text of each line of the LCD based on the present state.
+ *    This function prints, for each state, the LCD frames drawn, the time the state has been displayed, and the 
+ *      resulting frames per minute.  The time of the state currently displayed includes the time up to now.
+ *    The backlight register writes sent and elided, and the peak write rate against its budget, are printed after.
  *
  * Parameters:   
  *    None
@@ -1159,136 +2163,385 @@ void enqueueRTClockTick(){outputModificationEventQueue.call(tickRealTimeClock);}
  *    None
  *
  * Outputs:
- *    LCD text is updated
- *    Alarm may be turned on/off
+ *    Serial printout
  *
  * Shared variables accessed:
- *    currentState       - mutex (1)
- *    outputChangesMade  - mutex (2)
- *    stableDistance     - mutex (3)
- *    lcdOutputTextTable - mutex (4)
- *    maxDistance        - mutex (5)
- *    minDistance        - mutex (6)
- *    alarmArmed         - mutex (7)
+ *    Refresh scheduler state, accessed solely on the output refresh thread
+ */
+void printDisplayRefreshStatistics(){
+    printf("state\t\tframes\tseconds\tframes/min\n");
+    for(int i = 0; i < StateCount; i++){
+        Kernel::Clock::duration displayTime = stateDisplayTime[i];
+        if(refreshPolicyState == 2 * i) displayTime += Kernel::Clock::now() - policyStartTime;
+        unsigned long long displayMs = std::chrono::duration_cast<std::chrono::milliseconds>(displayTime).count();
+        unsigned long long framesPerMinute = displayMs ? lcdFrames[i] * 60000ULL / displayMs : 0;
+        printf("%-14s\t%u\t%llu\t%llu\n", stateNames[i], lcdFrames[i], displayMs / 1000, framesPerMinute);
+    }
+    printf("backlight register writes: %u sent, %u elided, peak %u/s (%u bytes/s), budget %u/s, %u fade steps deferred\n",
+           lcdObject.backlightWrites(), lcdObject.backlightWritesElided(), backlightPeakWritesPerSecond,
+           backlightPeakWritesPerSecond * RGB_WRITE_BYTES, backlightWriteBudget, backlightStepsDeferred);
+    printf("Observer page switches: %u, each one display shift transfer\n", observerPageSwitches);
+}
+
+
+/**
+ * void renderObserverDetails(int spaceValue, int timeOfWeek)
+ * non-ISR function
  *
- * Helper ISR Function:
- *    enqueueOutputRefresh
+ * Summary of the function:
+ *    This function renders the second Observer page:
+ *     1. The valid distance samples per second since the last measurement, at most twice per second.
+ *     2. The fill trend: the fill level against the level at the start of the trend window, once per window.
+ *     3. The closing time of today, or dashes before a closing time has been confirmed.
+ *    The caller must hold lcdOutputTableRW (4).
+ *
+ * Parameters:   
+ *    - spaceValue - the fill level in percent, or spaceValueUndefined
+ *    - timeOfWeek - the RTC time in seconds since Monday 00:00:00
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    observerDetailTextTable is updated
  *
+ * Shared variables accessed:
+ *    observerDetailTextTable - mutex (4), held by the caller
+ *    closingTimeSchedule, closingScheduleSet - mutex (10)
+ *    distanceSampleCount - atomic read
+ *    Page data, accessed solely on the output refresh thread
  */
-void populateLcdOutput(){
-    currentStateRW.lock();          //(1)
-    outputChangesMadeRW.lock();     //(2)
+void renderObserverDetails(int spaceValue, int timeOfWeek){
+    Kernel::Clock::time_point now = Kernel::Clock::now();
+
+    //sample rate, over the time since the last measurement: about one Observer frame period
+    long long rateMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastSampleRateTime).count();
+    if(rateMs >= 500){
+        uint32_t sampleCount = core_util_atomic_load_u32(&distanceSampleCount);
+        int samplesPerSecond = (sampleCount - lastSampleCount) * 1000 / rateMs;
+        if(samplesPerSecond > 99) samplesPerSecond = 99;
+        observerDetailTextTable[0][sampleRatePosition10] = '0' + samplesPerSecond / 10;
+        observerDetailTextTable[0][sampleRatePosition1]  = '0' + samplesPerSecond % 10;
+        lastSampleCount = sampleCount;
+        lastSampleRateTime = now;
+    }
 
-    //only execute if output changes have been made
-    if(!outputChangesMade){
-        outputChangesMadeRW.unlock();    //(2)
-        currentStateRW.unlock();         //(1)
-        return;
+    //fill trend
+    if(spaceValue == spaceValueUndefined){
+        fillTrend = '?';
+        fillTrendReference = spaceValueUndefined;
+    }else if(fillTrendReference == spaceValueUndefined){
+        fillTrendReference = spaceValue;        //start a trend window
+        fillTrendTime = now;
+    }else if(now - fillTrendTime >= fillTrendWindow){
+        fillTrend = spaceValue > fillTrendReference ? '+' : spaceValue < fillTrendReference ? '-' : '=';
+        fillTrendReference = spaceValue;
+        fillTrendTime = now;
     }
+    observerDetailTextTable[0][fillTrendPosition] = fillTrend;
 
-    //now that it has been confirmed that output changes are necessary, lock the remaining required mutexes
-    stableDistanceRWMutex.lock();   //(3)
-    lcdOutputTableRW.lock();        //(4)
-    maxDistanceRW.lock();           //(5)
-    minDistanceRW.lock();           //(6)
+    //closing time of today
+    closingScheduleRW.lock();       //(10)
+    if(closingScheduleSet){
+        renderTimeOfDay(observerDetailTextTable[1], closingTimeSchedule[timeOfWeek / secondsPerDay]);
+    }else{
+        memcpy(&observerDetailTextTable[1][timeInputHours10], "--:--:--", timeInputSecs01 - timeInputHours10 + 1);
+    }
+    closingScheduleRW.unlock();     //(10)
+}
 
-    outputChangesMade = false;
 
-    //update capacity distance in min/max states
-    if(currentState == SetMax || currentState == SetMin){
-        lcdOutputTextTable[currentState + 1][distancePosition100] = '0' + (stableDistance/100) % 10;    //update 100's digit of displayed distance
-        lcdOutputTextTable[currentState + 1][distancePosition10]  = '0' + (stableDistance/10)  % 10;    //update 10's digit of displayed distance
-        lcdOutputTextTable[currentState + 1][distancePosition1]   = '0' + (stableDistance/1)   % 10;    //update 1's digit of displayed distance
-    }
+/**
+ * void rotateObserverPage()
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function brings the next Observer page into view.  Both pages are already in the DDRAM of the LCD, so
+ *      the switch is one display shift transfer, or one return home command for the first page.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    LCD display is shifted
+ *
+ * Shared variables accessed:
+ *    Page data, accessed solely on the output refresh thread
+ *
+ * Helper ISR Function:
+ *    no direct helper.  Called every observerPagePeriod on the output refresh thread while in the Observer state
+ */
+void rotateObserverPage(){
+    observerPage = (observerPage + 1) % observerPageCount;
+    lcdObject.showPage(observerPage);
+    observerPageSwitches++;
+}
 
 
-    int spaceValue;  //the percentage number to be displayed in the Observer state
-    //update the value of the percent of space used in the Observer State
-    if(maxDistance != minDistance){ //ensure that values aren't equal to ensure no divide by zero error
-        spaceValue = 100 * (maxDistance - stableDistance);      //calculate numerator terms
-        spaceValue = spaceValue / (maxDistance - minDistance);  //factor in denominator
+/**
+ * int computeSpaceValue()
+ * non-ISR function
+ * 
+ * Summary of the function:
+ *    This function calculates the percent of the container that is used from the stable distance and the configured
+ *      minimum (full) and maximum (empty) distances.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    The percent of the container that is used, no less than 0.
+ *    spaceValueUndefined if the minimum and maximum distances are equal and there is no range to have a percentage out of.
+ *
+ * Outputs:
+ *    None
+ *
+ * Shared variables accessed:
+ *    stableDistance - mutex (3)
+ *    maxDistance    - mutex (5)
+ *    minDistance    - mutex (6)
+ *    These mutexes are not locked within the function because it is assumed that the calling function has locked them.
+ *
+ */
+int computeSpaceValue(){
+    if(maxDistance == minDistance) return spaceValueUndefined;     //ensure that values aren't equal to ensure no divide by zero error
 
-        if(spaceValue < 0) spaceValue = 0;  //set a hard limit of 0% full in case the container moves backwards
+    int spaceValue = 100 * (maxDistance - stableDistance);      //calculate numerator terms
+    spaceValue = spaceValue / (maxDistance - minDistance);      //factor in denominator
 
-        lcdOutputTextTable[Observer + 1][percentPosition100] = '0' + (spaceValue/100) % 10;    //update 100's digit of displayed distance
-        lcdOutputTextTable[Observer + 1][percentPosition10]  = '0' + (spaceValue/10)  % 10;    //update 10's digit of displayed distance
-        lcdOutputTextTable[Observer + 1][percentPosition1]   = '0' + (spaceValue/1)   % 10;    //update 1's digit of displayed distance
-    }else{  //in the case that the min and max distances are equal, there is no range to have a percentage out of.  Display "N/0" instead of a number
-        spaceValue = 1;   //set to an arbitrary positive value to prevent the alarm from sounding when distance is undefined
-        lcdOutputTextTable[Observer + 1][percentPosition100] = 'N';
-        lcdOutputTextTable[Observer + 1][percentPosition10]  = '/';
-        lcdOutputTextTable[Observer + 1][percentPosition1]   = '0';
-    }
+    if(spaceValue < 0) spaceValue = 0;  //set a hard limit of 0% full in case the container moves backwards
+    return spaceValue;
+}
 
-    //update the state of the alarm
-    bool activateAlarm = false;     //initialize to false and look for an exception true case
-    alarmArmedRW.lock();     //(7)
-    if(alarmArmed){          //only proceed with activation of alarm if it is armed
-        lcdOutputTextTable[Observer + 1][alarmIndicatorPosition] = alarmIndicatorArmed; //set the display flag that the alarm is armed to true
-        if(closingTimeCrossed() && spaceValue > 0){                                     //only play the alarm if it is past closing time and the container is not empty
-            activateAlarm = true;                                                       //if both of these conditions are met, raise the flag to activate the alarm
-        }
+
+/**
+ * void scheduleClosingAlarm()
+ * non-ISR function
+ * 
+ * Summary of the function:
+ *    This function determines if the current time is past the closing time of the current day and arms the closing 
+ *      alarm timeout to call it again at the next instant where that changes: one second after today's closing time
+ *      if it has not yet passed, or midnight if it has.
+ *    The alarm output is then updated with the new closing time state.
+ *    This replaces a comparison of the current and closing times on every LCD refresh.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    closingAlarmTimeout is re-armed
+ *    Alarm may be turned on/off
+ *
+ * Shared variables accessed:
+ *    closingTimeSchedule - mutex (10)
+ *
+ * Helper ISR Functions:
+ *    enqueueAlarmScheduling
+ *
+ */
+void scheduleClosingAlarm(){
+    int timeOfWeek = readRealTimeOfWeek();
+    int weekday = timeOfWeek / secondsPerDay;
+    int secondsOfDay = timeOfWeek % secondsPerDay;
+
+    closingScheduleRW.lock();      //(10)
+    bool scheduleSet = closingScheduleSet;
+    int closingTime = closingTimeSchedule[weekday];
+    closingScheduleRW.unlock();    //(10)
+
+    int secondsUntilChange;         //seconds from now until the closing time state next changes
+    if(!scheduleSet){
+        closingTimePassed = false;                                  //no closing time has been confirmed yet.  Look again at midnight or when the schedule is set
+        secondsUntilChange = secondsPerDay - secondsOfDay;
+    }else if(secondsOfDay > closingTime){
+        closingTimePassed = true;                                   //past closing time until midnight
+        secondsUntilChange = secondsPerDay - secondsOfDay;
     }else{
-        lcdOutputTextTable[Observer + 1][alarmIndicatorPosition] = alarmIndicatorOff;   //set the display flag that the alarm is armed to false
+        closingTimePassed = false;                                  //the time is crossed once it is greater than closing time
+        secondsUntilChange = closingTime + 1 - secondsOfDay;
     }
-    alarmArmedRW.unlock();   //(7)
+
+    closingAlarmTimeout.attach(&enqueueAlarmScheduling, std::chrono::seconds(secondsUntilChange));
+    updateAlarmOutput();
+}
+//helper ISR Function
+void enqueueAlarmScheduling(){outputModificationEventQueue.call(scheduleClosingAlarm);}
+
+
+/**
+ * void updateAlarmOutput()
+ * non-ISR function
+ * 
+ * Summary of the function:
+ *    This function turns the alarm on if it is armed, closing time has passed and the container is not empty, and 
+ *      turns the alarm off otherwise.
+ *    It runs only when one of those conditions may have changed.
+ *
+ * Parameters:   
+ *    None
+ *
+ * Return value:
+ *    None
+ *
+ * Outputs:
+ *    Alarm may be turned on/off
+ *    The backlight starts fading to the colour of the fill level and alarm state
+ *
+ * Shared variables accessed:
+ *    stableDistance - mutex (3)
+ *    maxDistance    - mutex (5)
+ *    minDistance    - mutex (6)
+ *    alarmArmed     - mutex (7)
+ *
+ * Helper ISR Functions:
+ *    enqueueAlarmUpdate
+ *
+ */
+void updateAlarmOutput(){
+    stableDistanceRWMutex.lock();   //(3)
+    maxDistanceRW.lock();           //(5)
+    minDistanceRW.lock();           //(6)
+    alarmArmedRW.lock();            //(7)
+
+    int spaceValue = computeSpaceValue();
+    bool containerUsed = spaceValue > 0 || spaceValue == spaceValueUndefined;   //an undefined fill level is treated as not empty
+    bool activateAlarm = alarmArmed && closingTimePassed && containerUsed;     //only play the alarm if it is past closing time and the container is not empty
+
+    alarmArmedRW.unlock();          //(7)
+    minDistanceRW.unlock();         //(6)
+    maxDistanceRW.unlock();         //(5)
+    stableDistanceRWMutex.unlock(); //(3)
 
     if(activateAlarm){
         alarm_Enable.write(1);        //activate Vcc to alarm pin (PB_10), enabling the alarm audio
     }else{
         alarm_Enable.write(0);        //zero out Vcc to alarm pin (PB_10), disabling the alarm audio
     }
+    setBacklightStatus(spaceValue, activateAlarm);     //show the fill level and alarm on the backlight
+}
+//helper ISR Function
+void enqueueAlarmUpdate(){outputModificationEventQueue.call(updateAlarmOutput);}
 
-    //refresh each line of the LCD display
-    //Reused from Project 2
-    for(char line = 0; line < ROW; line++){
-        char* printVal = lcdOutputTextTable[currentState + line];   //retrieve the string associated with the current line of the LCD
-        lcdObject.setCursor(0, line);                       //reset cursor to position 0 of the line to be written to
-        lcdObject.print(printVal);                          //send a print request to configure the text of the line
+
+/**
+ * void setBacklightStatus(int spaceValue, bool alarmActive)
+ * non-ISR function
+ * 
+ * Summary of the function:
+ *    This function sets the colour that the LCD backlight fades to.  The colour runs from green for an empty 
+ *      container through amber at half full to red when full.  While the alarm is active the backlight pulses red 
+ *      instead, and while the fill level is undefined it is white.
+ *    The fade engine is started if the backlight is not already at the new colour.
+ *
+ * Parameters:   
+ *    - spaceValue  - the fill level in percent, or spaceValueUndefined
+ *    - alarmActive - true if the alarm is sounding
+ *
+ * Return value:
+ *    None
+ *
+ * Shared variables accessed:
+ *    Backlight fade engine state, accessed solely on the output refresh thread
+ *
+ * Helper ISR Function:
+ *    no direct helper.  Called on the output refresh thread by updateAlarmOutput
+ */
+void setBacklightStatus(int spaceValue, bool alarmActive){
+    int target[backlightChannels];
+    if(alarmActive){
+        target[0] = backlightPulsing ? backlightTarget[0] : 255;    //keep the phase of a pulse already running
+        target[1] = 0;
+        target[2] = 0;
+    }else if(spaceValue == spaceValueUndefined){
+        target[0] = 255;
+        target[1] = 255;
+        target[2] = 255;
+    }else{
+        int fill = spaceValue > 100 ? 100 : spaceValue;
+        if(fill <= 50){
+            target[0] = 255 * fill / 50;                                        //green to amber: red rises
+            target[1] = 255 - (255 - backlightAmberGreen) * fill / 50;
+        }else{
+            target[0] = 255;                                                    //amber to red: green falls
+            target[1] = backlightAmberGreen - backlightAmberGreen * (fill - 50) / 50;
+        }
+        target[2] = 0;
     }
+    backlightPulsing = alarmActive;
+    memcpy(backlightTarget, target, sizeof(backlightTarget));
 
-    minDistanceRW.unlock();           //(6)
-    maxDistanceRW.unlock();           //(5)
-    lcdOutputTableRW.unlock();        //(4)
-    stableDistanceRWMutex.unlock();   //(3)
-    outputChangesMadeRW.unlock();     //(2)
-    currentStateRW.unlock();          //(1)
+    if(!backlightFadeEventId && memcmp(backlightColor, backlightTarget, sizeof(backlightColor)) != 0){
+        backlightFadeEventId = outputModificationEventQueue.call_every(backlightFadePeriod, stepBacklightFade);
+    }
 }
-//helper ISR Function
-void enqueueOutputRefresh(){outputModificationEventQueue.call(populateLcdOutput);}
 
 
 /**
- * bool closingTimeCrossed()
+ * void stepBacklightFade()
  * non-ISR function
  * 
  * Summary of the function:
- *    This function checks if the current time is later than closing time.
+ *    This function moves each colour channel of the backlight up to backlightFadeStep toward its target and writes 
+ *      the colour.  The LCD driver drops the write of any channel that has not changed.
+ *    Backlight register writes are counted in one second windows.  A step that could exceed backlightWriteBudget 
+ *      in the current window is postponed to the next period, so the fade slows down rather than exceeding the budget.
+ *    When the target is reached, the pulse reverses between full and backlightPulseLow red while the alarm is 
+ *      active.  Otherwise the periodic step event is cancelled.
  *
  * Parameters:   
  *    None
  *
  * Return value:
- *    Returns true if the current time is greater than closing time and false otherwise.
+ *    None
  *
  * Outputs:
- *    None
+ *    LCD backlight colour
  *
  * Shared variables accessed:
- *    lcdOutputTextTable - mutex (4).  This mutex is not locked within the function because it is assumed that the calling function has locked the mutex.
+ *    Backlight fade engine state, accessed solely on the output refresh thread
  *
+ * Helper ISR Function:
+ *    no direct helper.  Called periodically on the output refresh thread while fading
  */
-bool closingTimeCrossed(){
-    //iterate over the time indexes from most to least significant position
-    for(int i = timeInputHours10; i<=timeInputSecs01; i++){
-        //compare for a greater quantity of unit time
-        if(lcdOutputTextTable[SetRealTime + 1][i] > lcdOutputTextTable[SetClosingTime + 1][i]) return true;       //current unit time is greater than closing unit time
-        if(lcdOutputTextTable[SetRealTime + 1][i] < lcdOutputTextTable[SetClosingTime + 1][i]) return false;      //current unit time is less than closing unit time
-        //all remaining possibilities must have this unit of time equal and can thus be ignored in future comparisons
+void stepBacklightFade(){
+    Kernel::Clock::time_point now = Kernel::Clock::now();
+    if(now - backlightBudgetWindowStart >= 1s){
+        backlightBudgetWindowStart = now;
+        backlightBudgetWindowWrites = 0;
+    }
+    if(backlightBudgetWindowWrites + backlightChannels > backlightWriteBudget){
+        backlightStepsDeferred++;
+        return;
     }
 
-    //times are exactly equal if the for loop has been escaped.  Return false since it has not yet been *crossed*
-    return false;
+    bool reached = true;
+    for(int i = 0; i < backlightChannels; i++){
+        int difference = backlightTarget[i] - backlightColor[i];
+        if(difference > backlightFadeStep) difference = backlightFadeStep;
+        if(difference < -backlightFadeStep) difference = -backlightFadeStep;
+        backlightColor[i] += difference;
+        if(backlightColor[i] != backlightTarget[i]) reached = false;
+    }
+
+    unsigned int writesBefore = lcdObject.backlightWrites();
+    lcdObject.setRGB(backlightColor[0], backlightColor[1], backlightColor[2]);
+    backlightBudgetWindowWrites += lcdObject.backlightWrites() - writesBefore;
+    if(backlightBudgetWindowWrites > backlightPeakWritesPerSecond) backlightPeakWritesPerSecond = backlightBudgetWindowWrites;
+
+    if(reached){
+        if(backlightPulsing){
+            backlightTarget[0] = backlightTarget[0] == 255 ? backlightPulseLow : 255;  //reverse the alarm pulse
+        }else{
+            outputModificationEventQueue.cancel(backlightFadeEventId);
+            backlightFadeEventId = 0;
+        }
+    }
 }
 
 
@@ -1345,6 +2598,29 @@ void alternateBuzzer(){
 }
 
 
+/**
+ * int compensatedBuzzerWait(int partNs, int overheadNs)
+ * non-ISR Function
+ *
+ * Summary of the function:
+ *    This function removes the time that runBuzzer spends outside of wait_ns in a part of the period from the
+ *      length of that part, and scales the rest by the time wait_ns takes per requested ns, so that the part
+ *      lasts partNs on the pin.  The constants are measured by the self-measurement mode of the buzzer test.
+ *
+ * Parameters:
+ *    - partNs     - the length of the part of the period on the pin, in ns: the active or the inactive part
+ *    - overheadNs - the time of each period that runBuzzer spends in that part outside of wait_ns, in ns:
+ *                     buzzerHighOverheadNs for the active part, buzzerLowOverheadNs for the inactive part
+ *
+ * Return value:
+ *    The ns to wait, or 0 if the overhead alone is longer than the part
+ */
+int compensatedBuzzerWait(int partNs, int overheadNs){
+    long long wait = (long long)(partNs - overheadNs) * 1000000 / buzzerWaitScalePpm;
+    return wait > 0 ? (int)wait : 0;
+}
+
+
 /**
  * void runBuzzer()
  * non-ISR Function
@@ -1382,9 +2658,11 @@ void runBuzzer(){
         int period = nanosecondsPerSecond / localFrequnecy;     //(ns) the duration of one cycle period
         int highPeriod = period * localDutyCycle / 100;     //(ns) the portion of the period that the alarm spends in the active state
         int lowPeriod = period - highPeriod;            //(ns) the portion of the period that the alarm spends in the inactive state. ensure that low period + high period time adds to period time by being a derived quantity of the two previously derived quantities 
+        int highWait = compensatedBuzzerWait(highPeriod, buzzerHighOverheadNs);     //(ns) the wait that, with the loop around it, lasts highPeriod
+        int lowWait = compensatedBuzzerWait(lowPeriod, buzzerLowOverheadNs);        //(ns) the wait that, with the loop around it, lasts lowPeriod
         alarm_data_L.write(0);                      //activate the alarm
-        wait_ns(highPeriod);                    //wait the calculated quantity of nanoseconds with the alarm on
+        wait_ns(highWait);                      //wait the calculated quantity of nanoseconds with the alarm on
         alarm_data_L.write(1);              //disable the alarm
-        wait_ns(lowPeriod);             //wait the remaining portion of the time period with the alarm off before proceeding to the next cycle
+        wait_ns(lowWait);               //wait the remaining portion of the time period with the alarm off before proceeding to the next cycle
     }
 }
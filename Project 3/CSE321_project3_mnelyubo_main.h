@@ -0,0 +1,99 @@
+/******************************************************************************
+ *   File Name:      CSE321_project3_mnelyubo_main.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This header declares the constants, globals and functions of the
+ *         Project 3 main program that the host programs in host/ drive and
+ *         observe: the core test, the simulator, the range replay and the
+ *         benchmark.
+ *
+ *       The main program includes it as well, so the compiler checks every
+ *         declaration here against its definition, and a host program can no
+ *         longer declare a global with a type other than its own.
+ ******************************************************************************
+ *   Usage:
+ *       #include "CSE321_project3_mnelyubo_main.h"     in place of 1802.h
+ *
+ *   Constraints:
+ *       1802.h has no include guard, so it is included here and must not be
+ *         included again by a file that includes this header.
+ *       The globals are shared with the threads of the main program: a host
+ *         program accesses them only while those threads are not running, or
+ *         on the thread that serves the queue that owns them.
+ *
+ ******************************************************************************/
+
+#ifndef CSE321_PROJECT3_MAIN_H
+#define CSE321_PROJECT3_MAIN_H
+
+#include "Hal.h"
+#include "1802.h"
+
+//LCD properties
+#define COL 16
+#define ROW 2
+
+//real-world time of day conversion factors
+#define secondsPerMinute 60
+#define secondsPerHour   3600
+#define secondsPerDay    86400
+#define secondsPerWeek   604800
+#define daysPerWeek      7
+#define rtcEpochWeekdayOffset 3     /* the RTC epoch 01/01/1970 was a Thursday, weekday 3 counting from Monday = 0 */
+
+//output stabilization buffer data
+#define stabilizerArrayLen 4
+
+//system state configuration
+#define SetRealTime    0x0
+#define SetClosingTime 0x2
+#define SetMax         0x4
+#define SetMin         0x6
+#define Observer       0x8
+#define StateCount     5    /* number of states, each spaced by two LCD output table lines */
+
+
+//state of the user interface and the container
+extern int  currentState;
+extern int  outputChangesMade;
+extern int  stableDistance;
+extern int  maxDistance;
+extern int  minDistance;
+extern bool alarmArmed;
+extern int  closingTimeSchedule[daysPerWeek];
+extern bool closingScheduleSet;
+extern int  lastRenderedSecond;
+
+//distance filter
+extern int  distanceBuffer[stabilizerArrayLen];
+extern int  distanceBuffIdx;
+extern volatile uint32_t distanceSampleCount;
+extern unsigned long long riseEchoTimestamp;
+extern unsigned long long fallEchoTimestamp;
+
+//event queues and the display
+extern EventQueue distanceSensorEventQueue;
+extern EventQueue outputModificationEventQueue;
+extern EventQueue keyInputEventQueue;
+extern EventQueue matrixOpsEventQueue;
+extern CSE321_LCD<COL, ROW> lcdObject;
+
+void configureSystem();
+void handleInputKey(char charPressed);
+void handleHeldKey(char keyHeld);
+void populateLcdOutput();
+void enqueueOutputRefresh(bool userInput);
+void processDistanceData();
+int  updateStableDistance();
+int  readRealTimeOfWeek();
+int  readRealTimeClock();
+void setRealTimeClock(int weekday, int secondsOfDay);
+int  parseTimeOfDay(const char* timeLine);
+void renderTimeOfDay(char* timeLine, int secondsOfDay);
+void scheduleClosingAlarm();
+void enqueueAlarmScheduling();
+
+#endif
@@ -0,0 +1,285 @@
+/******************************************************************************
+ *   File Name:      CSE321_project3_mnelyubo_bench.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ *   Purpose:        This host program measures the cost per call of the hot functions of the
+ *                     main program against the POSIX HAL and the LCD emulator: the time, the
+ *                     heap allocations and Mutex locks of the call, and the I2C bytes that the
+ *                     display work it causes sends.  The results are compared with the
+ *                     baseline stored next to this file, so that a change of the counts fails
+ *                     the test until the baseline is updated, and the time is shown against
+ *                     the baseline time
+ *
+ *   Functions:      drainOutput, enterObserver, benchHandleInputKey, benchPopulateLcdOutput,
+ *                     benchPopulateLcdOutputUnchanged, benchUpdateStableDistance,
+ *                     benchUpdateStableDistanceChanged, benchReadRealTimeClock,
+ *                     benchScheduleClosingAlarm, readBaseline, writeBaseline, compare
+ *
+ *   Assignment:     Project 3
+ *
+ *   Inputs:         The options:
+ *                     --baseline file      the baseline to compare with, or to write
+ *                     --update             write the results as the new baseline
+ *                     --max-slowdown f     also fail a benchmark that takes f times its baseline time
+ *
+ *   Outputs:        Console report.  The exit status is the number of benchmarks that differ
+ *                     from the baseline
+ *
+ *   Constraints:    Built by host/CMakeLists.txt, not by Mbed Studio.  main() of the project
+ *                     is renamed project3Main() in this build and is not called
+ *                   Time is virtual and does not move, so the RTC and the refresh timers
+ *                     stand still and every run makes the same calls.  The calls posted to
+ *                     the output modification queue are served after every timed call, so that
+ *                     a frame that a call asks for is sent before the next call changes it
+ *                   tickRealTimeClock and closingTimeCrossed no longer exist: the RTC keeps
+ *                     the time, and the closing alarm is scheduled.  Their successors,
+ *                     readRealTimeClock and scheduleClosingAlarm, are measured instead
+ *                   Allocations and locks are those of the host build: an event queue post
+ *                     allocates on the host, but not on the target
+ *                   Times differ between machines and build types, so they fail only with
+ *                     --max-slowdown.  Regenerate the baseline after an intended change with:
+ *                       ./project3_bench --baseline ../bench/CSE321_project3_mnelyubo_bench_baseline.txt --update
+ *
+ ******************************************************************************/
+
+#include "CSE321_project3_mnelyubo_main.h"
+#include "LcdEmulator.h"
+#include "MicroBench.h"
+#include <map>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define countTolerance 0.005    /* counts per call closer than this to the baseline are equal */
+
+LcdEmulator emulator(COL, ROW);
+volatile int sink;              //keeps results that are otherwise unused
+
+
+//runs the output modification calls that are due, as the output refresh thread would, and waits for the LCD writes
+void drainOutput(){
+    halVirtualRunUntil(halTimeUs());
+    lcdObject.flush();
+}
+
+//switches to the Observer state with a 20 to 200 cm range, as the setup keys would
+void enterObserver(){
+    maxDistance = 200;
+    minDistance = 20;
+    currentState = Observer;
+    enqueueOutputRefresh(false);
+    drainOutput();
+}
+
+
+//a key press of the time input of the SetRealTime state: three digits, then C to return the cursor.  C keeps
+//the digits, so the two inputs alternate to have every digit change the display
+void benchHandleInputKey(BenchState& state){
+    const char keys[] = "123c012c";
+    handleInputKey('d');            //back to SetRealTime
+    drainOutput();
+    for(long i = 0; state.keepRunning(); i++){
+        handleInputKey(keys[i % 8]);
+        state.pauseTiming();
+        drainOutput();
+        state.resumeTiming();
+    }
+}
+MICROBENCH("handleInputKey", benchHandleInputKey);
+
+
+//an Observer frame in which the fill level changed
+void benchPopulateLcdOutput(BenchState& state){
+    enterObserver();
+    for(long i = 0; state.keepRunning(); i++){
+        stableDistance = i % 2 ? 100 : 110;
+        outputChangesMade = true;
+        populateLcdOutput();
+        state.pauseTiming();
+        lcdObject.flush();
+        state.resumeTiming();
+    }
+}
+MICROBENCH("populateLcdOutput/changed", benchPopulateLcdOutput);
+
+
+//an Observer frame with nothing new to show, as the periodic refresh draws most seconds
+void benchPopulateLcdOutputUnchanged(BenchState& state){
+    enterObserver();
+    stableDistance = 100;
+    while(state.keepRunning()){
+        outputChangesMade = true;
+        populateLcdOutput();
+        state.pauseTiming();
+        lcdObject.flush();
+        state.resumeTiming();
+    }
+}
+MICROBENCH("populateLcdOutput/unchanged", benchPopulateLcdOutputUnchanged);
+
+
+//a distance sample that leaves the stable distance as it is
+void benchUpdateStableDistance(BenchState& state){
+    enterObserver();
+    for(int i = 0; i < stabilizerArrayLen; i++) distanceBuffer[i] = 100;
+    updateStableDistance();
+    drainOutput();
+    while(state.keepRunning()) sink = updateStableDistance();
+}
+MICROBENCH("updateStableDistance/unchanged", benchUpdateStableDistance);
+
+
+//a distance sample that moves the stable distance, posting a refresh and an alarm update
+void benchUpdateStableDistanceChanged(BenchState& state){
+    enterObserver();
+    for(long i = 0; state.keepRunning(); i++){
+        distanceBuffer[0] = i % 2 ? 100 : 140;
+        sink = updateStableDistance();
+        state.pauseTiming();
+        drainOutput();
+        state.resumeTiming();
+    }
+}
+MICROBENCH("updateStableDistance/changed", benchUpdateStableDistanceChanged);
+
+
+void benchReadRealTimeClock(BenchState& state){
+    while(state.keepRunning()) sink = readRealTimeClock();
+}
+MICROBENCH("readRealTimeClock", benchReadRealTimeClock);
+
+
+//finding the next closing time and re-arming its timeout, then updating the alarm output
+void benchScheduleClosingAlarm(BenchState& state){
+    enterObserver();
+    for(int day = 0; day < daysPerWeek; day++) closingTimeSchedule[day] = 22 * 3600;
+    closingScheduleSet = true;
+    while(state.keepRunning()){
+        scheduleClosingAlarm();
+        state.pauseTiming();
+        drainOutput();
+        state.resumeTiming();
+    }
+}
+MICROBENCH("scheduleClosingAlarm", benchScheduleClosingAlarm);
+
+
+//a line of the baseline: the time and counts per call of a benchmark
+struct BaselineEntry {
+    double ns;
+    std::vector<double> counts;     //allocations, locks, then the registered counters
+};
+
+std::vector<double> countsOf(const BenchResult& result){
+    std::vector<double> counts = {result.allocationsPerCall, result.locksPerCall};
+    counts.insert(counts.end(), result.countersPerCall.begin(), result.countersPerCall.end());
+    return counts;
+}
+
+std::map<std::string, BaselineEntry> readBaseline(const char* path){
+    std::map<std::string, BaselineEntry> baseline;
+    FILE* file = fopen(path, "r");
+    if(!file) return baseline;
+    char line[256];
+    while(fgets(line, sizeof(line), file)){
+        if(line[0] == '#' || line[0] == '\n') continue;
+        char name[128];
+        int used = 0;
+        BaselineEntry entry;
+        if(sscanf(line, "%127s %lf%n", name, &entry.ns, &used) != 2) continue;
+        double count;
+        int more = 0;
+        for(const char* rest = line + used; sscanf(rest, "%lf%n", &count, &more) == 1; rest += more) entry.counts.push_back(count);
+        baseline[name] = entry;
+    }
+    fclose(file);
+    return baseline;
+}
+
+bool writeBaseline(const char* path, const std::vector<BenchResult>& results){
+    FILE* file = fopen(path, "w");
+    if(!file) return false;
+    fprintf(file, "# Baseline of project3_bench, per call.  Written by project3_bench --update\n");
+    fprintf(file, "# benchmark  ns  allocations  locks");
+    for(const std::string& name : benchCounterNames()) fprintf(file, "  %s", name.c_str());
+    fprintf(file, "\n");
+    for(const BenchResult& result : results){
+        fprintf(file, "%s %.1f", result.name.c_str(), result.nsPerCall);
+        for(double count : countsOf(result)) fprintf(file, " %.2f", count);
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
+
+
+//prints every result next to its baseline, and returns the number of benchmarks that differ from it
+int compare(const std::vector<BenchResult>& results, const std::map<std::string, BaselineEntry>& baseline, double maxSlowdown){
+    int failures = 0;
+    printf("%-32s %9s %10s %10s %8s %8s", "benchmark", "calls", "ns", "baseline", "allocs", "locks");
+    for(const std::string& name : benchCounterNames()) printf(" %8s", name.c_str());
+    printf("\n");
+
+    for(const BenchResult& result : results){
+        std::map<std::string, BaselineEntry>::const_iterator found = baseline.find(result.name);
+        printf("%-32s %9ld %10.1f", result.name.c_str(), result.iterations, result.nsPerCall);
+        if(found == baseline.end()) printf(" %10s", "-");
+        else printf(" %10.1f", found->second.ns);
+        std::vector<double> counts = countsOf(result);
+        for(double count : counts) printf(" %8.2f", count);
+        printf("\n");
+
+        if(found == baseline.end()){
+            printf("FAIL %s: no baseline\n", result.name.c_str());
+            failures++;
+            continue;
+        }
+        bool countsDiffer = found->second.counts.size() != counts.size();
+        for(size_t c = 0; !countsDiffer && c < counts.size(); c++){
+            countsDiffer = counts[c] < found->second.counts[c] - countTolerance || counts[c] > found->second.counts[c] + countTolerance;
+        }
+        if(countsDiffer){
+            printf("FAIL %s: counts differ from the baseline:", result.name.c_str());
+            for(double count : found->second.counts) printf(" %.2f", count);
+            printf("\n");
+            failures++;
+        }else if(maxSlowdown > 0 && result.nsPerCall > maxSlowdown * found->second.ns){
+            printf("FAIL %s: %.1fx the baseline time\n", result.name.c_str(), result.nsPerCall / found->second.ns);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+
+int main(int argc, char* argv[]){
+    const char* baselinePath = nullptr;
+    bool update = false;
+    double maxSlowdown = 0;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) baselinePath = argv[++i];
+        else if(strcmp(argv[i], "--update") == 0) update = true;
+        else if(strcmp(argv[i], "--max-slowdown") == 0 && i + 1 < argc) maxSlowdown = atof(argv[++i]);
+    }
+
+    halVirtualTime();
+    emulator.attach();
+    lcdObject.begin();
+    lcdObject.loadBarGlyphs();
+    setRealTimeClock(0, 8 * 3600);
+    registerBenchCounter("i2cBytes", [](){return (double)emulator.total().bytes;});
+
+    std::vector<BenchResult> results = runBenchmarks();
+    int failures = 0;
+    if(update && baselinePath){
+        if(!writeBaseline(baselinePath, results)) failures++;
+        printf("baseline written to %s\n", baselinePath);
+    }
+    failures += compare(results, baselinePath ? readBaseline(baselinePath) : std::map<std::string, BaselineEntry>(), maxSlowdown);
+    if(!emulator.errors().empty()) failures++;
+    printf("%s: %d benchmarks differ from the baseline\n", failures ? "FAILED" : "PASSED", failures);
+
+    //the I2C bus thread is blocked in its queue, and is not joined
+    fflush(stdout);
+    _exit(failures);
+}
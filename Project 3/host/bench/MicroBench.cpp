@@ -0,0 +1,114 @@
+/******************************************************************************
+ *   File Name:      MicroBench.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       Implementation of the microbenchmark harness.  See MicroBench.h.
+ *         The counting operator new and delete are in MicroBenchAllocator.cpp.
+ ******************************************************************************/
+
+#include "MicroBench.h"
+#include "Hal.h"
+
+
+struct RegisteredBenchmark {
+    const char* name;
+    BenchFunction function;
+};
+
+struct RegisteredCounter {
+    std::string name;
+    std::function<double()> read;
+};
+
+//function-local, as benchmarks register during static initialization
+static std::vector<RegisteredBenchmark>& benchmarks(){
+    static std::vector<RegisteredBenchmark> registered;
+    return registered;
+}
+
+static std::vector<RegisteredCounter>& counters(){
+    static std::vector<RegisteredCounter> registered;
+    return registered;
+}
+
+int registerBenchmark(const char* name, BenchFunction function){
+    benchmarks().push_back({name, function});
+    return (int)benchmarks().size();
+}
+
+void registerBenchCounter(const char* name, std::function<double()> read){
+    counters().push_back({name, read});
+}
+
+const std::vector<std::string>& benchCounterNames(){
+    static std::vector<std::string> names;
+    names.clear();
+    for(const RegisteredCounter& counter : counters()) names.push_back(counter.name);
+    return names;
+}
+
+
+BenchState::BenchState(long iterations) : total(iterations) {}
+
+bool BenchState::keepRunning(){
+    if(done == 0 && !running) resumeTiming();
+    if(done == total){
+        pauseTiming();
+        return false;
+    }
+    done++;
+    return true;
+}
+
+void BenchState::pauseTiming(){
+    if(!running) return;
+    timedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    timedAllocations += benchAllocations() - startAllocations;
+    timedLocks += halMutexLocks() - startLocks;
+    running = false;
+}
+
+void BenchState::resumeTiming(){
+    if(running) return;
+    running = true;
+    startAllocations = benchAllocations();
+    startLocks = halMutexLocks();
+    start = std::chrono::steady_clock::now();
+}
+
+
+/**
+ * std::vector<BenchResult> runBenchmarks()
+ *
+ * Summary of the function:
+ *    This function runs each registered benchmark, in the order of registration: once to warm up, then with
+ *      8 times more iterations each run until the timed part lasts benchMinimumTime.  The registered counters
+ *      are read before and after the kept run.
+ */
+std::vector<BenchResult> runBenchmarks(){
+    std::vector<BenchResult> results;
+    for(const RegisteredBenchmark& benchmark : benchmarks()){
+        BenchState warmup(benchWarmupIterations);
+        benchmark.function(warmup);
+
+        for(long iterations = benchFirstIterations; ; iterations *= 8){
+            std::vector<double> countersBefore;
+            for(const RegisteredCounter& counter : counters()) countersBefore.push_back(counter.read());
+            BenchState state(iterations);
+            benchmark.function(state);
+            if(state.seconds() < benchMinimumTime && iterations < benchMaxIterations) continue;
+
+            BenchResult result = {benchmark.name, iterations, state.seconds() * 1e9 / iterations,
+                                  (double)state.allocations() / iterations, (double)state.locks() / iterations, {}};
+            for(size_t c = 0; c < counters().size(); c++){
+                result.countersPerCall.push_back((counters()[c].read() - countersBefore[c]) / iterations);
+            }
+            results.push_back(result);
+            break;
+        }
+    }
+    return results;
+}
@@ -0,0 +1,102 @@
+/******************************************************************************
+ *   File Name:      MicroBench.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       A small microbenchmark harness in the style of Google Benchmark, for
+ *         the host build.  A benchmark is a function that runs its code in a
+ *         while(state.keepRunning()) loop.  The harness runs it with a
+ *         growing number of iterations until the timed part takes
+ *         benchMinimumTime, and reports per call:
+ *           ns             wall time of the timed part
+ *           allocations    operator new calls by the benchmark thread
+ *           locks          Mutex locks by the benchmark thread (halMutexLocks)
+ *         and any counter registered with registerBenchCounter, such as the
+ *         I2C bytes of an emulated device, measured over the whole run.
+ *
+ *       Work that a call leaves behind, such as draining a queue it posted
+ *         to, runs between pauseTiming and resumeTiming: it is left out of
+ *         the time, allocations and locks, but not out of the registered
+ *         counters.
+ ******************************************************************************
+ *   Usage:
+ *       void benchRead(BenchState& state){
+ *           while(state.keepRunning()) readRealTimeClock();
+ *       }
+ *       MICROBENCH("readRealTimeClock", benchRead);
+ *
+ *       std::vector<BenchResult> results = runBenchmarks();
+ *
+ *   Constraints:
+ *       The iteration counts are powers of 8 from 1024, so a benchmark whose
+ *         work repeats with a period that divides 1024 gives the same counts
+ *         on every machine.  Each benchmark is warmed up first.
+ *       Linking this library replaces the global operator new and delete of
+ *         the program, to count the allocations.
+ *
+ ******************************************************************************/
+
+#ifndef MICRO_BENCH_H
+#define MICRO_BENCH_H
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define benchMinimumTime      0.05      /* seconds of timed calls before a result is kept */
+#define benchFirstIterations  1024
+#define benchMaxIterations    (1L << 23)
+#define benchWarmupIterations 64
+
+
+class BenchState {
+public:
+    explicit BenchState(long iterations);
+
+    bool keepRunning();         //true until the iterations are done.  Starts the timing at the first call
+    void pauseTiming();
+    void resumeTiming();
+    long iterations() const {return total;}
+
+    double seconds() const {return timedSeconds;}
+    unsigned long allocations() const {return timedAllocations;}
+    unsigned long locks() const {return timedLocks;}
+
+private:
+    long total;
+    long done = 0;
+    bool running = false;
+    std::chrono::steady_clock::time_point start;
+    unsigned long startAllocations = 0;
+    unsigned long startLocks = 0;
+    double timedSeconds = 0;
+    unsigned long timedAllocations = 0;
+    unsigned long timedLocks = 0;
+};
+
+struct BenchResult {
+    std::string name;
+    long iterations;
+    double nsPerCall;
+    double allocationsPerCall;
+    double locksPerCall;
+    std::vector<double> countersPerCall;    //in the order of benchCounterNames
+};
+
+typedef void (*BenchFunction)(BenchState& state);
+
+int registerBenchmark(const char* name, BenchFunction function);
+void registerBenchCounter(const char* name, std::function<double()> read);     //read returns a running total
+const std::vector<std::string>& benchCounterNames();
+
+std::vector<BenchResult> runBenchmarks();
+unsigned long benchAllocations();           //operator new calls made by the calling thread
+
+#define MICROBENCH_CONCAT(a, b) a##b
+#define MICROBENCH_ID(line) MICROBENCH_CONCAT(microbenchRegistered, line)
+#define MICROBENCH(name, function) static int MICROBENCH_ID(__LINE__) = registerBenchmark(name, function)
+
+#endif
@@ -0,0 +1,47 @@
+/******************************************************************************
+ *   File Name:      MicroBenchAllocator.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       The counting operator new and delete of the microbenchmark harness.
+ *         Every replaceable allocation function of C++14 is replaced here in
+ *         pairs: the plain, array and nothrow forms of new take memory from
+ *         malloc, and every form of delete, sized or not, returns it to free.
+ *
+ *       This file makes no allocation of its own.  In a file that does, the
+ *         compiler inlines the replaced delete into the standard containers
+ *         and warns of a free of memory from the builtin operator new.
+ ******************************************************************************/
+
+#include "MicroBench.h"
+#include <cstdlib>
+#include <new>
+
+//operator new calls of each thread
+static thread_local unsigned long allocationCount = 0;
+
+void* operator new(std::size_t size){
+    allocationCount++;
+    void* memory = std::malloc(size ? size : 1);
+    if(!memory) throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    allocationCount++;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size){return operator new(size);}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {return operator new(size, tag);}
+
+void operator delete(void* memory) noexcept {std::free(memory);}
+void operator delete(void* memory, std::size_t) noexcept {std::free(memory);}
+void operator delete(void* memory, const std::nothrow_t&) noexcept {std::free(memory);}
+void operator delete[](void* memory) noexcept {std::free(memory);}
+void operator delete[](void* memory, std::size_t) noexcept {std::free(memory);}
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {std::free(memory);}
+
+unsigned long benchAllocations(){return allocationCount;}
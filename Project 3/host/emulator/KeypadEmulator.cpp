@@ -0,0 +1,126 @@
+/******************************************************************************
+ *   File Name:      KeypadEmulator.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       Implementation of the host keypad emulator.  See KeypadEmulator.h.
+ ******************************************************************************/
+
+#include "KeypadEmulator.h"
+
+KeypadEmulator::KeypadEmulator(std::vector<PinName> rows, std::vector<PinName> columns, std::vector<std::string> keys)
+    : rowPins(rows), columnPins(columns), keyMap(keys),
+      contacts(columns.size(), std::vector<bool>(rows.size(), false)), columnLevels(columns.size(), 0) {}
+
+void KeypadEmulator::attach(){
+    halGpioWatch(callback(this, &KeypadEmulator::follow));
+}
+
+bool KeypadEmulator::find(char key, int& column, int& row) const {
+    for(column = 0; column < (int)keyMap.size(); column++){
+        for(row = 0; row < (int)keyMap[column].size(); row++){
+            if(keyMap[column][row] == key) return true;
+        }
+    }
+    return false;
+}
+
+bool KeypadEmulator::closed(char key) const {
+    int column, row;
+    return find(key, column, row) && contacts[column][row];
+}
+
+void KeypadEmulator::press(char key, int bounces){
+    int column, row;
+    if(!find(key, column, row)) return;
+    pressCount++;
+    setContact(column, row, true, bounces);
+}
+
+void KeypadEmulator::release(char key, int bounces){
+    int column, row;
+    if(!find(key, column, row)) return;
+    setContact(column, row, false, bounces);
+}
+
+
+/**
+ * void setContact(int column, int row, bool closed, int bounces)
+ *
+ * Summary of the function:
+ *    This function moves a contact to a new position.  Without bounce, the contact settles at once.  With bounce,
+ *      the contact first moves, then toggles back and forth bounces times on the bounce timeout, and is left in the
+ *      new position.  A contact still bouncing from an earlier change is settled first.
+ */
+void KeypadEmulator::setContact(int column, int row, bool closed, int bounces){
+    core_util_critical_section_enter();
+    settle();
+    contacts[column][row] = closed;
+    if(bounces > 0){
+        bounceColumn = column;
+        bounceRow = row;
+        bounceFinal = closed;
+        bouncesLeft = 2 * bounces;      //each bounce opens and closes the contact once more
+        bounceTimeout.attach(callback(this, &KeypadEmulator::toggleBounce), std::chrono::microseconds(KeypadEmulatorBounceIntervalUs));
+    }
+    updateColumns();
+    core_util_critical_section_exit();
+}
+
+//leaves a bouncing contact in its final position
+void KeypadEmulator::settle(){
+    if(bounceColumn < 0) return;
+    bounceTimeout.detach();
+    contacts[bounceColumn][bounceRow] = bounceFinal;
+    bounceColumn = -1;
+    updateColumns();
+}
+
+//the bounce timeout: one toggle of the bouncing contact
+void KeypadEmulator::toggleBounce(){
+    if(bounceColumn < 0) return;
+    bouncesLeft--;
+    contacts[bounceColumn][bounceRow] = !contacts[bounceColumn][bounceRow];
+    if(bouncesLeft > 0){
+        bounceTimeout.attach(callback(this, &KeypadEmulator::toggleBounce), std::chrono::microseconds(KeypadEmulatorBounceIntervalUs));
+    }else{
+        contacts[bounceColumn][bounceRow] = bounceFinal;
+        bounceColumn = -1;
+    }
+    updateColumns();
+}
+
+//the pin model watcher: the rows may have changed
+void KeypadEmulator::follow(int port, uint32_t levels){
+    for(PinName row : rowPins){
+        if((int)STM_PORT(row) == port){
+            updateColumns();
+            return;
+        }
+    }
+}
+
+
+/**
+ * void updateColumns()
+ *
+ * Summary of the function:
+ *    This function drives each column to the level its closed keys connect it to.  A column edge may interrupt a
+ *      driver that switches the rows and so updates the columns again before this call returns, so the rows are
+ *      read again for each column.
+ */
+void KeypadEmulator::updateColumns(){
+    for(int column = 0; column < (int)columnPins.size(); column++){
+        int level = 0;
+        for(int row = 0; row < (int)rowPins.size(); row++){
+            if(contacts[column][row] && halGpioLevel(rowPins[row])) level = 1;
+        }
+        if(level != columnLevels[column]){
+            columnLevels[column] = level;
+            edgeCount++;
+            halGpioDrive(columnPins[column], level);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *   File Name:      KeypadEmulator.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This library emulates a matrix keypad on the host pin model.  A
+ *         closed key connects its row output to its column input, so a
+ *         column reads high while a closed key of that column sits on a row
+ *         that is driven high.  The columns follow every change of the rows,
+ *         as the wires do, so the wake-on-press scan of KeypadMatrix runs
+ *         against the emulator unchanged.
+ *
+ *       A press or release may bounce: the contact toggles a number of
+ *         times, bounceIntervalUs apart, before it settles.  The bounce runs
+ *         on a Timeout, so in virtual time it is part of the simulation.
+ ******************************************************************************
+ *   Usage:
+ *       KeypadEmulator keypad({PE_2, PE_4, PE_5, PE_6}, {PC_0, PC_3, PC_1, PC_4}, {"dcba", "#963", "0852", "*741"});
+ *       keypad.attach();               follow the row outputs
+ *       keypad.press('a', 3);          close the key, bouncing 3 times
+ *       keypad.release('a', 3);
+ *
+ *   Constraints:
+ *       One key bounces at a time.  A press or release while another key
+ *         bounces settles the bouncing key first.
+ *
+ ******************************************************************************/
+
+#ifndef KEYPAD_EMULATOR_H
+#define KEYPAD_EMULATOR_H
+
+#include "Hal.h"
+#include <string>
+#include <vector>
+
+#define KeypadEmulatorBounceIntervalUs 300     /* time between the toggles of a bouncing contact */
+
+
+/**
+ * KeypadEmulator
+ *
+ * A host pin model of a matrix keypad.
+ */
+class KeypadEmulator {
+public:
+    //the row output pins, the column input pins, and the key of each [column][row], as KeypadMatrix takes them
+    KeypadEmulator(std::vector<PinName> rows, std::vector<PinName> columns, std::vector<std::string> keys);
+
+    void attach();                          //follow the row outputs.  Once, as the pin model keeps its watchers
+
+    void press(char key, int bounces = 0);
+    void release(char key, int bounces = 0);
+    bool closed(char key) const;
+
+    unsigned long presses() const {return pressCount;}
+    unsigned long columnEdges() const {return edgeCount;}      //column level changes, bounce and scans included
+
+private:
+    bool find(char key, int& column, int& row) const;
+    void setContact(int column, int row, bool closed, int bounces);
+    void toggleBounce();
+    void settle();
+    void follow(int port, uint32_t levels);
+    void updateColumns();
+
+    std::vector<PinName> rowPins;
+    std::vector<PinName> columnPins;
+    std::vector<std::string> keyMap;
+    std::vector<std::vector<bool>> contacts;    //closed contacts, [column][row]
+    std::vector<int> columnLevels;              //the level driven on each column
+
+    //the contact that is bouncing
+    Timeout bounceTimeout;
+    int bounceColumn = -1;
+    int bounceRow = -1;
+    bool bounceFinal = false;
+    int bouncesLeft = 0;
+
+    unsigned long pressCount = 0;
+    unsigned long edgeCount = 0;
+};
+
+#endif
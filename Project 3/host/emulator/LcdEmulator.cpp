@@ -0,0 +1,234 @@
+/******************************************************************************
+ *   File Name:      LcdEmulator.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       Implementation of the host LCD emulator.  See LcdEmulator.h.
+ ******************************************************************************/
+
+#include "LcdEmulator.h"
+#include <cstdlib>
+
+LcdEmulator::LcdEmulator(int cols, int rows, bool backlight) : cols(cols), rows(rows), hasBacklight(backlight) {
+    memset(lines, ' ', sizeof(lines));
+    memset(cgram, 0, sizeof(cgram));
+}
+
+void LcdEmulator::attach(){
+    HostI2CDevice::attach(LcdEmulatorDisplayAddress);
+    if(hasBacklight) HostI2CDevice::attach(LcdEmulatorBacklightAddress);
+}
+
+void LcdEmulator::detach(){
+    HostI2CDevice::detach(LcdEmulatorDisplayAddress);
+    HostI2CDevice::detach(LcdEmulatorBacklightAddress);
+}
+
+void LcdEmulator::setStrict(bool strictMode){strict = strictMode;}
+
+
+/**
+ * std::string row(int row)
+ *
+ * Summary of the function:
+ *    This function returns the characters in view on a row of the panel.  Rows 0 and 1 are the two DDRAM lines.
+ *      Rows 2 and 3 of a 4 row panel continue lines 0 and 1 after the first cols characters.  The display shift
+ *      moves every row along its line, wrapping at the end of the line.
+ */
+std::string LcdEmulator::row(int row) const {
+    std::string text;
+    int start = row >= 2 ? cols : 0;
+    for(int col = 0; col < cols; col++){
+        text += lines[row & 1][(start + shift + col) % LcdEmulatorLineLength];
+    }
+    return text;
+}
+
+char LcdEmulator::ddram(int line, int column) const {return lines[line][column];}
+const unsigned char* LcdEmulator::glyph(int slot) const {return cgram[slot];}
+
+void LcdEmulator::beginFrame(){frameStart = totalTraffic;}
+
+void LcdEmulator::count(Traffic& traffic, int length){
+    //start, address byte, payload bytes with their acknowledge bits, stop
+    double busTimeUs = (2 + 9.0 * (1 + length)) * 1000000.0 / busFrequency;
+    traffic.transactions++;
+    traffic.bytes += 1 + length;
+    traffic.busTimeUs += busTimeUs;
+    totalTraffic.transactions++;
+    totalTraffic.bytes += 1 + length;
+    totalTraffic.busTimeUs += busTimeUs;
+}
+
+void LcdEmulator::error(const char* message, const char* data, int length){
+    std::string entry = message;
+    entry += " in transfer";
+    char hex[4];
+    for(int i = 0; i < length; i++){
+        snprintf(hex, sizeof(hex), " %02x", (unsigned char)data[i]);
+        entry += hex;
+    }
+    errorLog.push_back(entry);
+    if(strict){
+        fprintf(stderr, "LcdEmulator: %s\n", entry.c_str());
+        abort();
+    }
+}
+
+
+int LcdEmulator::i2cWrite(int deviceAddress, const char* data, int length){
+    if(deviceAddress == LcdEmulatorDisplayAddress){
+        count(displayTraffic, length);
+        displayWrite(data, length);
+        return 0;
+    }
+    if(deviceAddress == LcdEmulatorBacklightAddress && hasBacklight){
+        count(backlightTraffic, length);
+        backlightWrite(data, length);
+        return 0;
+    }
+    return -1;
+}
+
+int LcdEmulator::i2cRead(int deviceAddress, char* data, int length){
+    error("read from a write-only controller", data, 0);
+    return -1;
+}
+
+
+/**
+ * void displayWrite(const char* data, int length)
+ *
+ * Summary of the function:
+ *    This function decodes one transfer to the display controller.  Each control byte has Co in bit 7 and RS in
+ *      bit 6, and no other bits set.  With Co = 1 one byte follows, a command or data by RS, and then another
+ *      control byte.  With Co = 0 every remaining byte of the transfer is a command or data by RS.
+ */
+void LcdEmulator::displayWrite(const char* data, int length){
+    if(length == 0){
+        error("empty display transfer", data, length);
+        return;
+    }
+
+    int i = 0;
+    while(i < length){
+        unsigned char control = data[i++];
+        if(control & 0x3F){
+            error("control byte with reserved bits set", data, length);
+            return;
+        }
+        bool last = !(control & 0x80);
+        bool isData = control & 0x40;
+        if(i == length){
+            error("transfer ends on a control byte", data, length);
+            return;
+        }
+
+        int end = last ? length : i + 1;
+        for(; i < end; i++){
+            if(isData){
+                writeData(data[i], data, length);
+            }else{
+                command(data[i], data, length);
+            }
+        }
+    }
+}
+
+
+void LcdEmulator::command(unsigned char value, const char* data, int length){
+    if(value & 0x80){                   //set DDRAM address
+        int ddramAddress = value & 0x7F;
+        if((ddramAddress & 0x3F) >= LcdEmulatorLineLength){
+            error("DDRAM address off both lines", data, length);
+            return;
+        }
+        addressInCgram = false;
+        address = ddramAddress;
+    }else if(value & 0x40){             //set CGRAM address
+        addressInCgram = true;
+        address = value & 0x3F;
+    }else if(value & 0x20){             //function set
+        functionSet = true;
+        functionBits = value;
+    }else if(!functionSet){
+        error("command before the function set", data, length);
+    }else if(value & 0x10){             //cursor or display shift
+        int direction = (value & 0x04) ? 1 : -1;
+        if(value & 0x08){
+            //moving the display left brings the next column of each line into view
+            shift = (shift - direction + LcdEmulatorLineLength) % LcdEmulatorLineLength;
+        }else{
+            step(direction);
+        }
+    }else if(value & 0x08){             //display on/off control
+        displayControl = value;
+    }else if(value & 0x04){             //entry mode set
+        entryMode = value;
+    }else if(value & 0x02){             //return home
+        addressInCgram = false;
+        address = 0;
+        shift = 0;
+    }else if(value & 0x01){             //clear display
+        memset(lines, ' ', sizeof(lines));
+        addressInCgram = false;
+        address = 0;
+        shift = 0;
+        entryMode |= 0x02;
+    }else{
+        error("no operation command", data, length);
+    }
+}
+
+
+void LcdEmulator::writeData(unsigned char value, const char* data, int length){
+    if(!functionSet){
+        error("data before the function set", data, length);
+        return;
+    }
+    if(addressInCgram){
+        cgram[address / 8][address % 8] = value & 0x1F;
+    }else{
+        lines[address >= 0x40][address & 0x3F] = value;
+    }
+    step((entryMode & 0x02) ? 1 : -1);
+    if(!addressInCgram && (entryMode & 0x01)){
+        shift = (shift + ((entryMode & 0x02) ? 1 : -1) + LcdEmulatorLineLength) % LcdEmulatorLineLength;
+    }
+}
+
+
+//move the address counter by one.  DDRAM runs from the end of one line to the start of the other
+void LcdEmulator::step(int direction){
+    if(addressInCgram){
+        address = (address + direction) & 0x3F;
+        return;
+    }
+    int line = address >= 0x40;
+    int column = (address & 0x3F) + direction;
+    if(column == LcdEmulatorLineLength){
+        line = !line;
+        column = 0;
+    }else if(column < 0){
+        line = !line;
+        column = LcdEmulatorLineLength - 1;
+    }
+    address = (line ? 0x40 : 0) + column;
+}
+
+
+//the backlight controller is written one register at a time: register, value
+void LcdEmulator::backlightWrite(const char* data, int length){
+    if(length != 2){
+        error("backlight transfer is not one register and one value", data, length);
+        return;
+    }
+    unsigned char reg = data[0];
+    if(reg >= LcdEmulatorBacklightRegisters){
+        error("backlight register out of range", data, length);
+        return;
+    }
+    backlightRegs[reg] = data[1];
+}
@@ -0,0 +1,145 @@
+/******************************************************************************
+ *   File Name:      LcdEmulator.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This library emulates the I2C LCD of the project on a Linux host: the
+ *         HD44780-compatible AiP31068 display controller at LCD_ADDRESS_1802,
+ *         and the PCA9633 RGB backlight controller at RGB_ADDRESS.  CSE321_LCD
+ *         is linked against the host I2C bus, and every transaction it sends
+ *         is decoded into the DDRAM, CGRAM, display shift and backlight
+ *         registers of the emulator, which tests can then read back.
+ *
+ *       Every transaction and byte on the bus is counted, including the
+ *         address byte, so the traffic of one display frame can be measured
+ *         without a logic analyser.  Bus time is estimated at the frequency
+ *         last set on the bus, at 9 bit times per byte plus a start and a
+ *         stop condition per transaction.
+ *
+ *       A malformed sequence is an error: a transfer that ends on a control
+ *         byte, a control byte with reserved bits set, a DDRAM address off
+ *         both lines, data before the function set, or a backlight write that
+ *         is not one register and one value.  In strict mode an error prints
+ *         the offending transfer and aborts, so a driver test fails at the
+ *         transfer that broke the protocol.
+ ******************************************************************************
+ *   Usage:
+ *       LcdEmulator lcd(16, 2);
+ *       lcd.attach();                  put the display and backlight on the host I2C bus
+ *       ... drive a CSE321_LCD<16, 2> ...
+ *       lcd.row(0)                     the text in view on row 0
+ *       lcd.beginFrame();              start counting the traffic of a frame
+ *       lcd.frameBytes()               bytes since beginFrame, address bytes included
+ *
+ *   References:
+ *       AiP31068 datasheet:    https://www.seeedstudio.com/Grove-LCD-RGB-Backlight.html
+ *       PCA9633 datasheet:     https://www.nxp.com/docs/en/data-sheet/PCA9633.pdf
+ *
+ ******************************************************************************/
+
+#ifndef LCD_EMULATOR_H
+#define LCD_EMULATOR_H
+
+#include "Hal.h"
+#include <string>
+#include <vector>
+
+#define LcdEmulatorDisplayAddress 0x7c
+#define LcdEmulatorBacklightAddress 0xc4
+#define LcdEmulatorLineLength 40        /* characters of a DDRAM line */
+#define LcdEmulatorBacklightRegisters 9
+
+
+/**
+ * LcdEmulator
+ *
+ * A host I2C device model of the display and backlight controllers.
+ */
+class LcdEmulator : public HostI2CDevice {
+public:
+    //traffic counters of one address, or of the whole device
+    struct Traffic {
+        unsigned long transactions;
+        unsigned long bytes;            //including the address byte of each transaction
+        double busTimeUs;               //estimated at the bus frequency of each transaction
+    };
+
+    LcdEmulator(int cols, int rows, bool backlight = true);
+
+    void attach();                      //attach the display, and the backlight if there is one, to the host I2C bus
+    void detach();
+
+    void setStrict(bool strict);        //abort at the first error.  On by default
+    const std::vector<std::string>& errors() const {return errorLog;}
+    void clearErrors() {errorLog.clear();}
+
+    //display state
+    std::string row(int row) const;                 //the characters in view on a row, CGRAM glyphs as 0x00-0x07
+    char ddram(int line, int column) const;         //a character of a DDRAM line
+    const unsigned char* glyph(int slot) const;     //the 8 rows of 5 dots of a CGRAM glyph
+    int displayShift() const {return shift;}        //columns the display is shifted left, 0 to 39
+    bool initialized() const {return functionSet;}
+    bool displayOn() const {return displayControl & 0x04;}
+    bool twoLine() const {return functionBits & 0x08;}
+    int addressCounter() const {return address;}
+
+    //backlight state
+    unsigned char backlightRegister(int reg) const {return backlightRegs[reg];}
+    unsigned char red() const {return backlightRegs[4];}
+    unsigned char green() const {return backlightRegs[3];}
+    unsigned char blue() const {return backlightRegs[2];}
+
+    //traffic accounting
+    void beginFrame();
+    Traffic total() const {return totalTraffic;}
+    Traffic display() const {return displayTraffic;}
+    Traffic backlight() const {return backlightTraffic;}
+    unsigned long frameTransactions() const {return totalTraffic.transactions - frameStart.transactions;}
+    unsigned long frameBytes() const {return totalTraffic.bytes - frameStart.bytes;}
+    double frameBusTimeUs() const {return totalTraffic.busTimeUs - frameStart.busTimeUs;}
+    int frequency() const {return busFrequency;}
+
+    //HostI2CDevice
+    int i2cWrite(int address, const char* data, int length) override;
+    int i2cRead(int address, char* data, int length) override;
+    void i2cFrequency(int hz) override {busFrequency = hz;}
+
+private:
+    void count(Traffic& traffic, int length);
+    void error(const char* message, const char* data, int length);
+    void displayWrite(const char* data, int length);
+    void command(unsigned char value, const char* data, int length);
+    void writeData(unsigned char value, const char* data, int length);
+    void step(int direction);
+    void backlightWrite(const char* data, int length);
+
+    int cols;
+    int rows;
+    bool hasBacklight;
+    bool strict = true;
+    std::vector<std::string> errorLog;
+
+    //display controller
+    char lines[2][LcdEmulatorLineLength];
+    unsigned char cgram[8][8];
+    bool functionSet = false;
+    unsigned char functionBits = 0;
+    unsigned char displayControl = 0;
+    unsigned char entryMode = 0x02;     //increment, no shift
+    bool addressInCgram = false;
+    int address = 0;                    //DDRAM address (0x00-0x27, 0x40-0x67) or CGRAM address (0-63)
+    int shift = 0;
+
+    //backlight controller
+    unsigned char backlightRegs[LcdEmulatorBacklightRegisters] = {};
+
+    int busFrequency = 100000;
+    Traffic totalTraffic = {};
+    Traffic displayTraffic = {};
+    Traffic backlightTraffic = {};
+    Traffic frameStart = {};
+};
+
+#endif
@@ -0,0 +1,75 @@
+/******************************************************************************
+ *   File Name:      RangeSensorEmulator.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       Implementation of the host range sensor emulator.  See RangeSensorEmulator.h.
+ ******************************************************************************/
+
+#include "RangeSensorEmulator.h"
+
+RangeSensorEmulator::RangeSensorEmulator(PinName trigger, PinName echo) : triggerPin(trigger), echoPin(echo) {}
+
+void RangeSensorEmulator::attach(){
+    halGpioWatch(callback(this, &RangeSensorEmulator::follow));
+}
+
+void RangeSensorEmulator::setJitter(int us, uint32_t seed){
+    jitterUs = us;
+    jitterState = seed ? seed : 1;
+}
+
+//a value from -jitterUs to jitterUs, from a xorshift sequence so that every run is the same
+int RangeSensorEmulator::nextJitterUs(){
+    if(jitterUs == 0) return 0;
+    jitterState ^= jitterState << 13;
+    jitterState ^= jitterState >> 17;
+    jitterState ^= jitterState << 5;
+    return (int)(jitterState % (2 * jitterUs + 1)) - jitterUs;
+}
+
+
+/**
+ * void follow(int port, uint32_t levels)
+ *
+ * Summary of the function:
+ *    This function is the pin model watcher.  It times the trigger pulse, and at its falling edge starts the echo
+ *      of a measurement.
+ */
+void RangeSensorEmulator::follow(int port, uint32_t levels){
+    if(port != (int)STM_PORT(triggerPin)) return;
+    bool high = levels & (1u << STM_PIN(triggerPin));
+    if(high == triggerHigh) return;
+    triggerHigh = high;
+
+    if(high){
+        triggerRiseUs = halTimeUs();
+        return;
+    }
+    if(halTimeUs() - triggerRiseUs < RangeSensorMinTriggerUs){
+        shortTriggerCount++;
+        return;
+    }
+    if(echoBusy){
+        busyTriggerCount++;
+        return;
+    }
+
+    triggerCount++;
+    echoBusy = true;
+    bool inRange = RangeSensorMinCm <= distanceCm && distanceCm <= RangeSensorMaxCm;
+    echoWidthUs = inRange ? distanceCm * RangeSensorUsPerCm + nextJitterUs() : RangeSensorNoEchoUs;
+    echoTimeout.attach(callback(this, &RangeSensorEmulator::echoRise), std::chrono::microseconds(RangeSensorBurstUs));
+}
+
+void RangeSensorEmulator::echoRise(){
+    halGpioDrive(echoPin, 1);
+    echoTimeout.attach(callback(this, &RangeSensorEmulator::echoFall), std::chrono::microseconds(echoWidthUs));
+}
+
+void RangeSensorEmulator::echoFall(){
+    halGpioDrive(echoPin, 0);
+    echoBusy = false;
+}
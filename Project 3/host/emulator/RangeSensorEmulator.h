@@ -0,0 +1,83 @@
+/******************************************************************************
+ *   File Name:      RangeSensorEmulator.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This library emulates the HC-SR04 range detection sensor on the host
+ *         pin model.  A high pulse of at least 10 us on the trigger pin
+ *         starts a measurement.  After the burst time, the echo pin goes high
+ *         for 58 us per cm of the set distance, plus a deterministic jitter,
+ *         or for the no-echo time if the distance is out of range.  The echo
+ *         runs on a Timeout, so in virtual time it is part of the simulation.
+ ******************************************************************************
+ *   Usage:
+ *       RangeSensorEmulator sensor(PC_9, PC_8);
+ *       sensor.attach();               follow the trigger output
+ *       sensor.setDistance(120);       cm
+ *
+ *   Constraints:
+ *       A trigger while an echo is in progress is ignored, as by the sensor.
+ *
+ *   References:
+ *       HC-SR04 distance sensor datasheet:    https://www.digikey.com/htmldatasheets/production/1979760/0/0/1/hc-sr04.html
+ *
+ ******************************************************************************/
+
+#ifndef RANGE_SENSOR_EMULATOR_H
+#define RANGE_SENSOR_EMULATOR_H
+
+#include "Hal.h"
+
+#define RangeSensorMinTriggerUs   10        /* shortest trigger pulse that starts a measurement */
+#define RangeSensorBurstUs        460       /* time from the end of the trigger to the rising edge of the echo */
+#define RangeSensorUsPerCm        58
+#define RangeSensorNoEchoUs       38000     /* echo pulse when nothing is in range */
+#define RangeSensorMinCm          2
+#define RangeSensorMaxCm          400
+
+
+/**
+ * RangeSensorEmulator
+ *
+ * A host pin model of the HC-SR04.
+ */
+class RangeSensorEmulator {
+public:
+    RangeSensorEmulator(PinName trigger, PinName echo);
+
+    void attach();                              //follow the trigger output.  Once, as the pin model keeps its watchers
+
+    void setDistance(int cm){distanceCm = cm;}
+    int distance() const {return distanceCm;}
+    void setJitter(int us, uint32_t seed = 1);  //echo times vary by up to +-us, from a fixed pseudo-random sequence
+
+    unsigned long triggers() const {return triggerCount;}           //measurements started
+    unsigned long shortTriggers() const {return shortTriggerCount;} //trigger pulses shorter than RangeSensorMinTriggerUs
+    unsigned long busyTriggers() const {return busyTriggerCount;}   //triggers ignored during an echo
+
+private:
+    void follow(int port, uint32_t levels);
+    void echoRise();
+    void echoFall();
+    int nextJitterUs();
+
+    PinName triggerPin;
+    PinName echoPin;
+    int distanceCm = RangeSensorMaxCm;
+    int jitterUs = 0;
+    uint32_t jitterState = 1;
+
+    bool triggerHigh = false;
+    long long triggerRiseUs = 0;
+    bool echoBusy = false;
+    Timeout echoTimeout;
+    int echoWidthUs = 0;
+
+    unsigned long triggerCount = 0;
+    unsigned long shortTriggerCount = 0;
+    unsigned long busyTriggerCount = 0;
+};
+
+#endif
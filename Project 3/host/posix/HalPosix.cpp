@@ -0,0 +1,793 @@
+/******************************************************************************
+ *   File Name:      HalPosix.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       POSIX backend of the hardware abstraction layer.  See HalPosix.h.
+ ******************************************************************************/
+
+#include "HalPosix.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//state shared by the models.  Allocated once and never freed, see HalPosix.h
+namespace {
+
+//virtual time: set by halVirtualTime, and moved only by halVirtualRunUntil and the waits
+bool virtualTime = false;
+std::atomic<long long> virtualNowUs{0};
+
+//microseconds since startup, or the virtual time
+long long nowUs(){
+    if(virtualTime) return virtualNowUs.load();
+    static const std::chrono::steady_clock::time_point startup = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startup).count();
+}
+
+//let time pass on the calling thread: a sleep in real time, or a step of the virtual clock
+void passTime(long long us){
+    if(virtualTime) virtualNowUs += us;
+    else std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+std::chrono::steady_clock::time_point steadyTimeOf(long long us){
+    return std::chrono::steady_clock::now() + std::chrono::microseconds(us - nowUs());
+}
+
+
+/**
+ * The interrupt context.  Register model changes, interrupt handlers, Ticker callbacks and critical sections hold
+ *   the interrupt lock.  isrDepth counts the handlers running, and criticalDepth the critical sections entered, on
+ *   the thread holding the lock.  Pending EXTI lines are served when both are 0.
+ */
+struct InterruptContext {
+    std::recursive_mutex lock;
+    int isrDepth = 0;
+    int criticalDepth = 0;
+    InterruptIn* lineHandlers[16] = {};
+    std::vector<mbed::Callback<void(int, uint32_t)>> watchers;
+};
+InterruptContext& interrupts(){static InterruptContext* context = new InterruptContext; return *context;}
+
+GPIO_TypeDef& port(uint32_t index){
+    static GPIO_TypeDef* ports = new GPIO_TypeDef[HAL_GPIO_PORTS];
+    return ports[index];
+}
+
+uint32_t pinBit(PinName pin){return 1u << STM_PIN(pin);}
+GPIO_TypeDef& portOf(PinName pin){return port(STM_PORT(pin));}
+
+//configure a pin as an input or as a general purpose output in MODER
+void setPinMode(PinName pin, bool output){
+    uint32_t shift = 2 * STM_PIN(pin);
+    portOf(pin).MODER = (portOf(pin).MODER & ~(0x3u << shift)) | ((output ? 0x1u : 0x0u) << shift);
+}
+
+
+//serve every pending unmasked EXTI line, lowest line first, unless a handler or a critical section is running
+void servePendingLines(){
+    InterruptContext& context = interrupts();
+    while(context.isrDepth == 0 && context.criticalDepth == 0){
+        uint32_t ready = halExti.PR1.pending & halExti.IMR1;
+        if(!ready) return;
+        int line = __builtin_ctz(ready);
+        halExti.PR1.pending &= ~(1u << line);
+        InterruptIn* handler = context.lineHandlers[line];
+        if(!handler) continue;
+
+        context.isrDepth++;
+        handler->deliverEdge(handler->read());      //as the target HAL, the level of the pin tells the edge
+        context.isrDepth--;
+    }
+}
+
+
+//latch the EXTI lines of the pins of a port whose level changed on an enabled edge, then serve them
+void latchEdges(uint32_t portIndex, uint32_t before){
+    InterruptContext& context = interrupts();
+    uint32_t after = port(portIndex).IDR;
+    uint32_t changed = before ^ after;
+    while(changed){
+        int line = __builtin_ctz(changed);
+        uint32_t bit = 1u << line;
+        changed &= ~bit;
+        InterruptIn* handler = context.lineHandlers[line];
+        bool enabledEdge = (after & bit) ? (halExti.RTSR1 & bit) : (halExti.FTSR1 & bit);
+        if(handler && (halExti.IMR1 & bit) && enabledEdge) halExti.PR1.pending |= bit;
+    }
+    servePendingLines();
+}
+
+
+//apply an output change, let the device models follow it, and latch any edge it caused
+void writeOutputs(GPIO_TypeDef* gpio, uint32_t setBits, uint32_t clearBits){
+    InterruptContext& context = interrupts();
+    std::lock_guard<std::recursive_mutex> guard(context.lock);
+    uint32_t portIndex = gpio - &port(0);
+    uint32_t before = gpio->IDR;
+    gpio->ODR = (gpio->ODR & ~clearBits) | setBits;
+    for(auto& watcher : context.watchers) watcher(portIndex, gpio->ODR);
+    latchEdges(portIndex, before);
+}
+
+
+/**
+ * The interrupt timers behind Ticker, Timeout and the watchdog.  One thread waits for the next deadline and runs
+ *   its handler in interrupt context.
+ */
+struct TimerEntry {
+    long long dueUs;
+    long long periodUs;             //0 for a one-shot entry
+    mbed::Callback<void()> handler;
+};
+
+struct InterruptTimers {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::map<uint32_t, TimerEntry> entries;
+    uint32_t nextId = 1;
+    bool started = false;
+};
+InterruptTimers& timers(){static InterruptTimers* state = new InterruptTimers; return *state;}
+
+//the entry due first, or entries.end()
+std::map<uint32_t, TimerEntry>::iterator earliestTimer(InterruptTimers& state){
+    auto next = state.entries.end();
+    for(auto entry = state.entries.begin(); entry != state.entries.end(); entry++){
+        if(next == state.entries.end() || entry->second.dueUs < next->second.dueUs) next = entry;
+    }
+    return next;
+}
+
+//takes the handler of an entry that is due, re-arming a periodic entry and removing a one-shot entry
+mbed::Callback<void()> takeTimer(InterruptTimers& state, std::map<uint32_t, TimerEntry>::iterator entry){
+    mbed::Callback<void()> handler = entry->second.handler;
+    if(entry->second.periodUs) entry->second.dueUs += entry->second.periodUs;
+    else state.entries.erase(entry);
+    return handler;
+}
+
+//runs a timer handler in interrupt context, then serves the edges it latched
+void runInInterruptContext(mbed::Callback<void()> handler){
+    InterruptContext& context = interrupts();
+    context.lock.lock();
+    context.isrDepth++;
+    handler();
+    context.isrDepth--;
+    servePendingLines();
+    context.lock.unlock();
+}
+
+void runTimers(){
+    InterruptTimers& state = timers();
+    std::unique_lock<std::mutex> guard(state.lock);
+    while(true){
+        auto next = earliestTimer(state);
+        if(next == state.entries.end()){
+            state.changed.wait(guard);
+            continue;
+        }
+        if(next->second.dueUs > nowUs()){
+            state.changed.wait_until(guard, steadyTimeOf(next->second.dueUs));
+            continue;
+        }
+
+        mbed::Callback<void()> handler = takeTimer(state, next);
+        guard.unlock();
+        runInInterruptContext(handler);
+        guard.lock();
+    }
+}
+
+uint32_t addTimer(long long delayUs, long long periodUs, mbed::Callback<void()> handler){
+    InterruptTimers& state = timers();
+    std::lock_guard<std::mutex> guard(state.lock);
+    if(!state.started && !virtualTime){      //in virtual time, halVirtualRunUntil runs the timers
+        state.started = true;
+        std::thread(runTimers).detach();
+    }
+    uint32_t id = state.nextId++;
+    state.entries[id] = {nowUs() + delayUs, periodUs, handler};
+    state.changed.notify_one();
+    return id;
+}
+
+void removeTimer(uint32_t id){
+    InterruptTimers& state = timers();
+    std::lock_guard<std::mutex> guard(state.lock);
+    state.entries.erase(id);
+}
+
+//the RTC: seconds at the last write, and the time of that write
+time_t rtcSeconds = 0;
+long long rtcWrittenUs = 0;
+std::mutex rtcLock;
+
+unsigned int watchdogExpirations = 0;
+
+//every event queue, for halVirtualRunUntil
+std::mutex queuesLock;
+std::vector<events::EventQueue*>& queues(){static std::vector<events::EventQueue*>* registered = new std::vector<events::EventQueue*>; return *registered;}
+
+} //namespace
+
+
+/******************************************************************************
+ *  Register models
+ ******************************************************************************/
+RCC_TypeDef halRcc;
+EXTI_TypeDef halExti;
+
+GPIO_TypeDef* halGpioPort(uint32_t index){return &port(index);}
+
+uint32_t GPIO_TypeDef::outputPins() const {
+    uint32_t pins = 0;
+    for(int pin = 0; pin < 16; pin++){
+        if(((MODER >> (2 * pin)) & 0x3u) == 0x1u) pins |= 1u << pin;
+    }
+    return pins;
+}
+
+HalGpioInputRegister::operator uint32_t() const {
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    uint32_t outputs = port->outputPins();
+    return ((port->ODR & outputs) | (port->inputLevels & ~outputs)) & 0xFFFFu;
+}
+
+HalGpioSetResetRegister& HalGpioSetResetRegister::operator=(uint32_t value){
+    writeOutputs(port, value & 0xFFFFu, (value >> 16) & ~value & 0xFFFFu);    //set wins over reset, as on the target
+    return *this;
+}
+
+HalGpioResetRegister& HalGpioResetRegister::operator=(uint32_t value){
+    writeOutputs(port, 0, value & 0xFFFFu);
+    return *this;
+}
+
+void halGpioDrive(PinName pin, int level){
+    InterruptContext& context = interrupts();
+    std::lock_guard<std::recursive_mutex> guard(context.lock);
+    GPIO_TypeDef& gpio = portOf(pin);
+    uint32_t before = gpio.IDR;
+    if(level) gpio.inputLevels |= pinBit(pin);
+    else gpio.inputLevels &= ~pinBit(pin);
+    latchEdges(STM_PORT(pin), before);
+}
+
+int halGpioLevel(PinName pin){return (portOf(pin).IDR & pinBit(pin)) ? 1 : 0;}
+
+void halGpioWatch(mbed::Callback<void(int port, uint32_t levels)> watcher){
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    interrupts().watchers.push_back(watcher);
+}
+
+
+namespace mbed {
+
+void Timer::start(){
+    if(!running){
+        running = true;
+        startUs = nowUs();
+    }
+}
+
+void Timer::stop(){
+    if(running){
+        accumulatedUs += nowUs() - startUs;
+        running = false;
+    }
+}
+
+void Timer::reset(){
+    accumulatedUs = 0;
+    startUs = nowUs();
+}
+
+std::chrono::microseconds Timer::elapsed_time() const {
+    return std::chrono::microseconds(accumulatedUs + (running ? nowUs() - startUs : 0));
+}
+
+
+Ticker::Ticker() : repeating(true) {}
+Ticker::Ticker(bool repeating) : repeating(repeating) {}
+Ticker::~Ticker(){detach();}
+
+void Ticker::attach(Callback<void()> handler, std::chrono::microseconds period){
+    detach();
+    entry = addTimer(period.count(), repeating ? period.count() : 0, handler);
+}
+
+void Ticker::detach(){
+    if(entry) removeTimer(entry);
+    entry = 0;
+}
+
+
+DigitalOut::DigitalOut(PinName pin, int value) : pin(pin) {
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    write(value);
+    setPinMode(pin, true);
+}
+
+void DigitalOut::write(int value){
+    GPIO_TypeDef& gpio = portOf(pin);
+    writeOutputs(&gpio, value ? pinBit(pin) : 0, value ? 0 : pinBit(pin));
+}
+
+int DigitalOut::read(){
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    return (portOf(pin).ODR & pinBit(pin)) ? 1 : 0;
+}
+
+
+DigitalIn::DigitalIn(PinName pin, PinMode mode) : pin(pin) {
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    setPinMode(pin, false);
+    if(mode == PullUp) portOf(pin).inputLevels |= pinBit(pin);
+}
+
+int DigitalIn::read(){return halGpioLevel(pin);}
+
+
+InterruptIn::InterruptIn(PinName pin, PinMode mode) : pin(pin) {
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    setPinMode(pin, false);
+    if(mode == PullUp) portOf(pin).inputLevels |= pinBit(pin);
+    interrupts().lineHandlers[STM_PIN(pin)] = this;
+}
+
+InterruptIn::~InterruptIn(){
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    if(interrupts().lineHandlers[STM_PIN(pin)] == this) interrupts().lineHandlers[STM_PIN(pin)] = nullptr;
+}
+
+void InterruptIn::rise(Callback<void()> handler){
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    riseHandler = handler;
+    halExti.RTSR1 |= pinBit(pin);
+    halExti.IMR1 |= pinBit(pin);
+}
+
+void InterruptIn::fall(Callback<void()> handler){
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    fallHandler = handler;
+    halExti.FTSR1 |= pinBit(pin);
+    halExti.IMR1 |= pinBit(pin);
+}
+
+void InterruptIn::enable_irq(){
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    halExti.IMR1 |= pinBit(pin);
+}
+
+void InterruptIn::disable_irq(){
+    std::lock_guard<std::recursive_mutex> guard(interrupts().lock);
+    halExti.IMR1 &= ~pinBit(pin);
+}
+
+int InterruptIn::read(){return halGpioLevel(pin);}
+
+void InterruptIn::deliverEdge(bool rising){
+    if(rising && riseHandler) riseHandler();
+    if(!rising && fallHandler) fallHandler();
+}
+
+
+//the devices attached to the host I2C bus, by 8-bit address.  Never freed, see HalPosix.h
+static std::recursive_mutex& busLock(){static std::recursive_mutex* lock = new std::recursive_mutex; return *lock;}
+static std::map<int, HostI2CDevice*>& busDevices(){static std::map<int, HostI2CDevice*>* devices = new std::map<int, HostI2CDevice*>; return *devices;}
+
+void HostI2CDevice::attach(int address){
+    std::lock_guard<std::recursive_mutex> guard(busLock());
+    busDevices()[address & 0xFE] = this;
+}
+
+void HostI2CDevice::detach(int address){
+    std::lock_guard<std::recursive_mutex> guard(busLock());
+    if(busDevices()[address & 0xFE] == this) busDevices().erase(address & 0xFE);
+}
+
+void I2C::frequency(int hz){
+    std::lock_guard<std::recursive_mutex> guard(busLock());
+    HostI2CDevice* last = nullptr;
+    for(auto& device : busDevices()){
+        if(device.second != last) device.second->i2cFrequency(hz);      //once per device, not per address
+        last = device.second;
+    }
+}
+
+int I2C::write(int address, const char* data, int length, bool repeated){
+    std::lock_guard<std::recursive_mutex> guard(busLock());
+    auto device = busDevices().find(address & 0xFE);
+    return device == busDevices().end() ? -1 : device->second->i2cWrite(address & 0xFE, data, length);
+}
+
+int I2C::read(int address, char* data, int length, bool repeated){
+    std::lock_guard<std::recursive_mutex> guard(busLock());
+    auto device = busDevices().find(address & 0xFE);
+    return device == busDevices().end() ? -1 : device->second->i2cRead(address & 0xFE, data, length);
+}
+
+void I2C::lock(){busLock().lock();}
+void I2C::unlock(){busLock().unlock();}
+
+
+Watchdog& Watchdog::get_instance(){
+    static Watchdog* watchdog = new Watchdog;
+    return *watchdog;
+}
+
+//the target resets when the watchdog expires.  The host reports it and carries on
+bool Watchdog::start(uint32_t timeout){
+    stop();
+    timeoutMs = timeout;
+    running = true;
+    kick();
+    return true;
+}
+
+bool Watchdog::stop(){
+    if(entry) removeTimer(entry);
+    entry = 0;
+    running = false;
+    return true;
+}
+
+void Watchdog::kick(){
+    if(!running) return;
+    if(entry) removeTimer(entry);
+    entry = addTimer(timeoutMs * 1000LL, timeoutMs * 1000LL, []{
+        watchdogExpirations++;
+        printf("Watchdog: not kicked for %u ms, the target would reset\n", Watchdog::get_instance().get_timeout());
+    });
+}
+
+} //namespace mbed
+
+unsigned int halWatchdogExpirations(){return watchdogExpirations;}
+
+
+namespace rtos {
+
+//RTOS mutexes may be locked again by the thread that holds them
+struct Mutex::State {
+    std::recursive_mutex mutex;
+};
+
+//locks taken by each thread, for the lock counts of the benchmarks
+thread_local unsigned long mutexLocks = 0;
+
+Mutex::Mutex() : state(new State) {}
+
+void Mutex::lock(){
+    state->mutex.lock();
+    mutexLocks++;
+}
+
+void Mutex::unlock(){state->mutex.unlock();}
+
+bool Mutex::trylock(){
+    bool locked = state->mutex.try_lock();
+    if(locked) mutexLocks++;
+    return locked;
+}
+
+
+struct Semaphore::State {
+    std::mutex mutex;
+    std::condition_variable available;
+    int32_t count;
+    int32_t maxCount;
+};
+
+Semaphore::Semaphore(int32_t count) : Semaphore(count, 0xFFFF) {}
+Semaphore::Semaphore(int32_t count, uint16_t maxCount) : state(new State) {
+    state->count = count;
+    state->maxCount = maxCount;
+}
+
+void Semaphore::acquire(){
+    std::unique_lock<std::mutex> guard(state->mutex);
+    state->available.wait(guard, [this]{return state->count > 0;});
+    state->count--;
+}
+
+bool Semaphore::try_acquire(){
+    std::lock_guard<std::mutex> guard(state->mutex);
+    if(state->count == 0) return false;
+    state->count--;
+    return true;
+}
+
+//the state is read once: a waiter woken by the release may return and destroy a Semaphore on its stack
+//before notify_one, as I2CBus::submit does.  The state itself is never freed
+int Semaphore::release(){
+    State* released = state;
+    {
+        std::lock_guard<std::mutex> guard(released->mutex);
+        if(released->count >= released->maxCount) return -1;    //osErrorResource, as on the target
+        released->count++;
+    }
+    released->available.notify_one();
+    return 0;
+}
+
+
+int Thread::start(mbed::Callback<void()> task){
+    std::thread(task).detach();
+    return 0;
+}
+
+
+constexpr Kernel::Clock::duration_u32 Kernel::wait_for_u32_forever;
+
+Kernel::Clock::time_point Kernel::Clock::now(){return time_point(duration(nowUs() / 1000));}
+uint64_t Kernel::get_ms_count(){return nowUs() / 1000;}
+
+void ThisThread::sleep_for(Kernel::Clock::duration_u32 duration){
+    if(duration == Kernel::wait_for_u32_forever){
+        while(true) std::this_thread::sleep_for(std::chrono::hours(24));
+    }
+    passTime(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+} //namespace rtos
+
+
+namespace events {
+
+struct QueuedEvent {
+    long long dueUs;
+    long long periodUs;             //0 for a call that runs once
+    std::function<void()> call;
+};
+
+struct EventQueue::State {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::map<int, QueuedEvent> events;
+    unsigned capacity;
+    unsigned overflows = 0;
+    int nextId = 1;
+    bool breakRequested = false;
+};
+
+EventQueue::EventQueue(unsigned size) : state(new State) {
+    state->capacity = size / EVENTS_EVENT_SIZE;
+    std::lock_guard<std::mutex> guard(queuesLock);
+    queues().push_back(this);
+}
+
+//the state is not freed, see HalPosix.h.  The queue is only taken off the list served in virtual time
+EventQueue::~EventQueue(){
+    std::lock_guard<std::mutex> guard(queuesLock);
+    queues().erase(std::remove(queues().begin(), queues().end(), this), queues().end());
+}
+
+int EventQueue::post(long long delayMs, long long periodMs, std::function<void()> call){
+    std::lock_guard<std::mutex> guard(state->lock);
+    if(state->events.size() >= state->capacity){
+        state->overflows++;
+        return 0;                   //the queue is full, as a failed call on the target
+    }
+    int id = state->nextId++;
+    if(state->nextId <= 0) state->nextId = 1;
+    state->events[id] = {nowUs() + delayMs * 1000, periodMs * 1000, call};
+    state->changed.notify_all();
+    return id;
+}
+
+bool EventQueue::cancel(int id){
+    std::lock_guard<std::mutex> guard(state->lock);
+    return state->events.erase(id) > 0;
+}
+
+unsigned EventQueue::pending(){
+    std::lock_guard<std::mutex> guard(state->lock);
+    return state->events.size();
+}
+
+unsigned EventQueue::overflows(){
+    std::lock_guard<std::mutex> guard(state->lock);
+    return state->overflows;
+}
+
+//the call due first, and of those the one posted first, or events.end()
+static std::map<int, QueuedEvent>::iterator earliestEvent(std::map<int, QueuedEvent>& events){
+    auto next = events.end();
+    for(auto event = events.begin(); event != events.end(); event++){
+        if(next == events.end() || event->second.dueUs < next->second.dueUs) next = event;
+    }
+    return next;
+}
+
+//takes the call of an event that is due, re-arming a periodic event and removing one that runs once
+static std::function<void()> takeEvent(std::map<int, QueuedEvent>& events, std::map<int, QueuedEvent>::iterator event){
+    std::function<void()> call = event->second.call;
+    if(event->second.periodUs) event->second.dueUs += event->second.periodUs;
+    else events.erase(event);
+    return call;
+}
+
+long long EventQueue::nextDueUs(){
+    std::lock_guard<std::mutex> guard(state->lock);
+    auto next = earliestEvent(state->events);
+    return next == state->events.end() ? -1 : next->second.dueUs;
+}
+
+void EventQueue::runNext(){
+    std::unique_lock<std::mutex> guard(state->lock);
+    auto next = earliestEvent(state->events);
+    if(next == state->events.end()) return;
+    std::function<void()> call = takeEvent(state->events, next);
+    guard.unlock();
+    call();
+}
+
+void EventQueue::dispatch_forever(){dispatch(-1);}
+
+void EventQueue::break_dispatch(){
+    std::lock_guard<std::mutex> guard(state->lock);
+    state->breakRequested = true;
+    state->changed.notify_all();
+}
+
+/**
+ * void dispatch(int ms)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function runs the calls of the queue as they fall due, the earliest first and calls due at the same time
+ *      in the order they were posted.  A periodic call is due again one period after it was due, and stays in the
+ *      queue until it is cancelled.  Calls run with the queue unlocked, so they may post and cancel calls.
+ *
+ * Parameters:
+ *    - ms - the time to dispatch for, -1 to dispatch until break_dispatch, or 0 to run the calls that are due
+ */
+void EventQueue::dispatch(int ms){
+    long long endUs = ms < 0 ? -1 : nowUs() + ms * 1000LL;
+    std::unique_lock<std::mutex> guard(state->lock);
+    while(!state->breakRequested){
+        auto next = earliestEvent(state->events);
+
+        long long now = nowUs();
+        if(next != state->events.end() && next->second.dueUs <= now){
+            std::function<void()> call = takeEvent(state->events, next);
+            guard.unlock();
+            call();
+            guard.lock();
+            continue;
+        }
+
+        if(endUs >= 0 && now >= endUs) break;
+        long long wakeUs = next == state->events.end() ? endUs : (endUs < 0 ? next->second.dueUs : std::min(endUs, next->second.dueUs));
+        if(wakeUs < 0) state->changed.wait(guard);
+        else state->changed.wait_until(guard, steadyTimeOf(wakeUs));
+    }
+    state->breakRequested = false;
+}
+
+} //namespace events
+
+
+void wait_us(int us){passTime(us);}
+void wait_ns(unsigned int ns){
+    if(virtualTime) virtualNowUs += (ns + 999) / 1000;     //the virtual clock counts whole microseconds
+    else std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+}
+void thread_sleep_for(uint32_t ms){passTime(ms * 1000LL);}
+
+void core_util_critical_section_enter(){
+    interrupts().lock.lock();
+    interrupts().criticalDepth++;
+}
+
+void core_util_critical_section_exit(){
+    InterruptContext& context = interrupts();
+    context.criticalDepth--;
+    servePendingLines();
+    context.lock.unlock();
+}
+
+time_t halRtcRead(){
+    std::lock_guard<std::mutex> guard(rtcLock);
+    return rtcSeconds + (nowUs() - rtcWrittenUs) / 1000000;
+}
+
+uint32_t halRtcSubsecondUs(){
+    std::lock_guard<std::mutex> guard(rtcLock);
+    return (uint32_t)((nowUs() - rtcWrittenUs) % 1000000);
+}
+
+void halRtcWrite(time_t seconds){
+    std::lock_guard<std::mutex> guard(rtcLock);
+    rtcSeconds = seconds;
+    rtcWrittenUs = nowUs();
+}
+
+
+void halVirtualTime(){
+    if(timers().started) printf("halVirtualTime: an interrupt timer already runs in real time\n");
+    virtualTime = true;
+    virtualNowUs = 0;
+}
+
+long long halTimeUs(){return nowUs();}
+
+
+uint32_t SystemCoreClock = HAL_CORE_CLOCK_HZ;
+static long long cycleCounterStartUs = 0;
+
+void halCycleCounterStart(){cycleCounterStartUs = nowUs();}
+uint32_t halCycles(){return (uint32_t)((nowUs() - cycleCounterStartUs) * (SystemCoreClock / 1000000));}
+
+unsigned long halMutexLocks(){return rtos::mutexLocks;}
+
+
+/**
+ * void halVirtualRunUntil(long long untilUs)
+ * non-ISR function
+ *
+ * Summary of the function:
+ *    This function is the scheduler of virtual time.  It runs the interrupt timer handlers and the queued calls of
+ *      every event queue that fall due up to untilUs, the earliest first, on the calling thread.  At equal times an
+ *      interrupt timer goes first, as an interrupt preempts a thread.  The virtual clock is moved to the time of
+ *      each one before it runs, and to untilUs at the end.
+ *
+ * Parameters:
+ *    - untilUs - the virtual time to run to, in microseconds
+ *
+ * Return value:
+ *    None
+ *
+ * Shared variables accessed:
+ *    The virtual clock, the interrupt timers and the event queues.  A handler or call may attach timers and post
+ *      calls, which run in this same pass if they fall due by untilUs.
+ */
+void halVirtualRunUntil(long long untilUs){
+    InterruptTimers& state = timers();
+    while(true){
+        long long timerDueUs = -1;
+        {
+            std::lock_guard<std::mutex> guard(state.lock);
+            auto next = earliestTimer(state);
+            if(next != state.entries.end()) timerDueUs = next->second.dueUs;
+        }
+
+        events::EventQueue* queue = nullptr;
+        long long queueDueUs = -1;
+        {
+            std::lock_guard<std::mutex> guard(queuesLock);
+            for(events::EventQueue* candidate : queues()){
+                long long dueUs = candidate->nextDueUs();
+                if(dueUs >= 0 && (queueDueUs < 0 || dueUs < queueDueUs)){
+                    queue = candidate;
+                    queueDueUs = dueUs;
+                }
+            }
+        }
+
+        bool timerFirst = timerDueUs >= 0 && (queueDueUs < 0 || timerDueUs <= queueDueUs);
+        long long dueUs = timerFirst ? timerDueUs : queueDueUs;
+        if(dueUs < 0 || dueUs > untilUs) break;
+        if(dueUs > virtualNowUs) virtualNowUs = dueUs;
+
+        if(timerFirst){
+            std::unique_lock<std::mutex> guard(state.lock);
+            auto next = earliestTimer(state);
+            mbed::Callback<void()> handler = takeTimer(state, next);
+            guard.unlock();
+            runInInterruptContext(handler);
+        }else{
+            queue->runNext();
+        }
+    }
+    if(untilUs > virtualNowUs) virtualNowUs = untilUs;
+}
@@ -0,0 +1,504 @@
+/******************************************************************************
+ *   File Name:      HalPosix.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       POSIX backend of the hardware abstraction layer (Hal.h), used when the
+ *         project is built on a Linux host.  It implements the part of the
+ *         Mbed OS API that the project uses with the C++ standard library and
+ *         POSIX threads: Thread, Mutex, Semaphore, EventQueue, Timer, Ticker,
+ *         Timeout, InterruptIn, DigitalOut, I2C, the Kernel clock, Watchdog
+ *         and the critical section.
+ *
+ *       The GPIO ports, RCC and EXTI are register models.  A store to BSRR
+ *         sets and clears ODR bits, IDR reads outputs from ODR and inputs
+ *         from the levels driven with halGpioDrive, and an edge on the pin
+ *         of an InterruptIn latches the EXTI pending bit of its line when
+ *         the line is unmasked in IMR1.  Writing 1 to a PR1 bit clears it.
+ *
+ *       Interrupt handlers, Ticker and Timeout callbacks run in a simulated
+ *         interrupt context: one at a time, with the interrupt lock held.
+ *         core_util_critical_section_enter takes the same lock, so a thread
+ *         in a critical section is not interrupted.  An edge latched while a
+ *         handler runs is delivered when the handler returns, unless the
+ *         handler clears its pending bit first, as on the target.
+ *
+ *       An I2C transaction is delivered to the HostI2CDevice attached at its
+ *         address, such as the LCD emulator.  A transaction to an address
+ *         with no device is not acknowledged.
+ *
+ *       Time is the steady clock of the host, or, after halVirtualTime, a
+ *         virtual clock that only moves when it is advanced.  In virtual
+ *         time the interrupt timers and the event queues are served by
+ *         halVirtualRunUntil on the calling thread, in time order with the
+ *         interrupt timers first, and the clock jumps from one deadline to
+ *         the next, so a day of 100 ms polls runs in well under a second and
+ *         every run is the same.  wait_us, thread_sleep_for and
+ *         ThisThread::sleep_for move the virtual clock forward without
+ *         running anything else, as a busy wait would.  The cycle counter
+ *         follows the same clock.
+ ******************************************************************************
+ *   Host-only functions:
+ *       halGpioDrive(pin, level)       drive the level of an input pin, raising its edge interrupt
+ *       halGpioLevel(pin)              the level of a pin, as IDR reads it
+ *       halGpioWatch(watcher)          call watcher(port, ODR) after every output change, to model a device on the pins
+ *       halWatchdogExpirations()       watchdog timeouts that would have reset the target
+ *       halVirtualTime()               switch to virtual time, at 0 us
+ *       halVirtualRunUntil(us)         run the interrupt timers and queued calls due until virtual time us
+ *       halTimeUs()                    the current time, in microseconds since startup or in virtual time
+ *       halMutexLocks()                Mutex locks and successful trylocks made by the calling thread
+ *
+ *   Constraints:
+ *       RTOS objects keep their state on the heap and never free it, so a
+ *         thread still blocked in a global object when the program exits
+ *         does not wait on a destroyed mutex.
+ *       Thread priorities and stack sizes are accepted and ignored.
+ *       An EventQueue holds size / EVENTS_EVENT_SIZE events.  On the target,
+ *         an event with arguments takes more than EVENTS_EVENT_SIZE bytes, so
+ *         a target queue may fill sooner.
+ *       halVirtualTime must be called before any timer is attached or call
+ *         is queued.  In virtual time, the queues must not be dispatched by
+ *         threads: only halVirtualRunUntil serves them.  Threads that do not
+ *         dispatch a queue, such as the I2C bus thread, still run in real
+ *         time and see the virtual clock.
+ *
+ *   References:
+ *       MBED OS API:    https://os.mbed.com/docs/mbed-os/v6.15/apis/index.html
+ *       NUCLEO datasheet:  https://www.st.com/resource/en/reference_manual/dm00310109-stm32l4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+ *
+ ******************************************************************************/
+
+#ifndef HAL_POSIX_H
+#define HAL_POSIX_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+
+using namespace std::chrono_literals;
+
+//pin names follow the STM32 layout: (port << 4) | pin
+typedef enum {
+    PA_0 = 0x00, PA_1 = 0x01, PA_2 = 0x02, PA_3 = 0x03, PA_4 = 0x04, PA_5 = 0x05, PA_6 = 0x06, PA_7 = 0x07, PA_8 = 0x08, PA_9 = 0x09, PA_10 = 0x0A, PA_11 = 0x0B, PA_12 = 0x0C, PA_13 = 0x0D, PA_14 = 0x0E, PA_15 = 0x0F,
+    PB_0 = 0x10, PB_1 = 0x11, PB_2 = 0x12, PB_3 = 0x13, PB_4 = 0x14, PB_5 = 0x15, PB_6 = 0x16, PB_7 = 0x17, PB_8 = 0x18, PB_9 = 0x19, PB_10 = 0x1A, PB_11 = 0x1B, PB_12 = 0x1C, PB_13 = 0x1D, PB_14 = 0x1E, PB_15 = 0x1F,
+    PC_0 = 0x20, PC_1 = 0x21, PC_2 = 0x22, PC_3 = 0x23, PC_4 = 0x24, PC_5 = 0x25, PC_6 = 0x26, PC_7 = 0x27, PC_8 = 0x28, PC_9 = 0x29, PC_10 = 0x2A, PC_11 = 0x2B, PC_12 = 0x2C, PC_13 = 0x2D, PC_14 = 0x2E, PC_15 = 0x2F,
+    PD_0 = 0x30, PD_1 = 0x31, PD_2 = 0x32, PD_3 = 0x33, PD_4 = 0x34, PD_5 = 0x35, PD_6 = 0x36, PD_7 = 0x37, PD_8 = 0x38, PD_9 = 0x39, PD_10 = 0x3A, PD_11 = 0x3B, PD_12 = 0x3C, PD_13 = 0x3D, PD_14 = 0x3E, PD_15 = 0x3F,
+    PE_0 = 0x40, PE_1 = 0x41, PE_2 = 0x42, PE_3 = 0x43, PE_4 = 0x44, PE_5 = 0x45, PE_6 = 0x46, PE_7 = 0x47, PE_8 = 0x48, PE_9 = 0x49, PE_10 = 0x4A, PE_11 = 0x4B, PE_12 = 0x4C, PE_13 = 0x4D, PE_14 = 0x4E, PE_15 = 0x4F,
+    PF_0 = 0x50, PF_1 = 0x51, PF_2 = 0x52, PF_3 = 0x53, PF_4 = 0x54, PF_5 = 0x55, PF_6 = 0x56, PF_7 = 0x57, PF_8 = 0x58, PF_9 = 0x59, PF_10 = 0x5A, PF_11 = 0x5B, PF_12 = 0x5C, PF_13 = 0x5D, PF_14 = 0x5E, PF_15 = 0x5F,
+    PG_0 = 0x60, PG_1 = 0x61, PG_2 = 0x62, PG_3 = 0x63, PG_4 = 0x64, PG_5 = 0x65, PG_6 = 0x66, PG_7 = 0x67, PG_8 = 0x68, PG_9 = 0x69, PG_10 = 0x6A, PG_11 = 0x6B, PG_12 = 0x6C, PG_13 = 0x6D, PG_14 = 0x6E, PG_15 = 0x6F,
+    PH_0 = 0x70, PH_1 = 0x71, PH_2 = 0x72, PH_3 = 0x73, PH_4 = 0x74, PH_5 = 0x75, PH_6 = 0x76, PH_7 = 0x77, PH_8 = 0x78, PH_9 = 0x79, PH_10 = 0x7A, PH_11 = 0x7B, PH_12 = 0x7C, PH_13 = 0x7D, PH_14 = 0x7E, PH_15 = 0x7F,
+    PI_0 = 0x80, PI_1 = 0x81, PI_2 = 0x82, PI_3 = 0x83, PI_4 = 0x84, PI_5 = 0x85, PI_6 = 0x86, PI_7 = 0x87, PI_8 = 0x88, PI_9 = 0x89, PI_10 = 0x8A, PI_11 = 0x8B, PI_12 = 0x8C, PI_13 = 0x8D, PI_14 = 0x8E, PI_15 = 0x8F,
+    NC = (int)0xFFFFFFFF
+} PinName;
+
+#define STM_PORT(X) (((uint32_t)(X) >> 4) & 0xF)
+#define STM_PIN(X)  ((uint32_t)(X) & 0xF)
+
+typedef enum {PullNone = 0, PullUp = 1, PullDown = 2} PinMode;
+
+enum osPriority {osPriorityIdle, osPriorityLow, osPriorityBelowNormal, osPriorityNormal, osPriorityAboveNormal, osPriorityHigh, osPriorityRealtime};
+
+#define EVENTS_EVENT_SIZE 64        /* bytes of one event in an EventQueue buffer */
+#define HAL_GPIO_PORTS    9         /* ports A to I */
+#define HAL_CORE_CLOCK_HZ 120000000 /* SystemCoreClock of the NUCLEO-L4R5ZI */
+
+
+/******************************************************************************
+ *  Register models
+ ******************************************************************************/
+struct GPIO_TypeDef;
+
+//IDR: output pins read back ODR, input pins read the level driven with halGpioDrive
+struct HalGpioInputRegister {
+    GPIO_TypeDef* port;
+    operator uint32_t() const;
+};
+
+//BSRR: bits 0-15 set ODR bits, bits 16-31 clear them, in one store
+struct HalGpioSetResetRegister {
+    GPIO_TypeDef* port;
+    HalGpioSetResetRegister& operator=(uint32_t value);
+    operator uint32_t() const {return 0;}      //write-only, reads as 0
+};
+
+//BRR: bits 0-15 clear ODR bits
+struct HalGpioResetRegister {
+    GPIO_TypeDef* port;
+    HalGpioResetRegister& operator=(uint32_t value);
+    operator uint32_t() const {return 0;}
+};
+
+struct GPIO_TypeDef {
+    uint32_t MODER = 0;
+    uint32_t OTYPER = 0;
+    uint32_t OSPEEDR = 0;
+    uint32_t PUPDR = 0;
+    HalGpioInputRegister IDR;
+    uint32_t ODR = 0;
+    HalGpioSetResetRegister BSRR;
+    uint32_t LCKR = 0;
+    uint32_t AFR[2] = {0, 0};
+    HalGpioResetRegister BRR;
+
+    uint32_t inputLevels = 0;       //host only: the levels driven onto the pins from outside
+    uint32_t outputPins() const;    //host only: the pins configured as general purpose outputs in MODER
+
+    GPIO_TypeDef() : IDR{this}, BSRR{this}, BRR{this} {}
+    GPIO_TypeDef(const GPIO_TypeDef&) = delete;
+};
+
+struct RCC_TypeDef {
+    uint32_t AHB1ENR;
+    uint32_t AHB2ENR;
+    uint32_t AHB3ENR;
+    uint32_t APB1ENR1;
+    uint32_t APB1ENR2;
+    uint32_t APB2ENR;
+    uint32_t BDCR;
+    uint32_t CSR;
+};
+
+//PR1: writing 1 to a bit clears the pending edge of the line.  The register structs have no initializers, so that
+//  they are zeroed before any static constructor, such as that of a global InterruptIn, writes them
+struct HalExtiPendingRegister {
+    uint32_t pending;
+    HalExtiPendingRegister& operator=(uint32_t value){pending &= ~value; return *this;}
+    operator uint32_t() const {return pending;}
+};
+
+struct EXTI_TypeDef {
+    uint32_t IMR1;
+    uint32_t EMR1;
+    uint32_t RTSR1;
+    uint32_t FTSR1;
+    uint32_t SWIER1;
+    HalExtiPendingRegister PR1;
+};
+
+extern RCC_TypeDef halRcc;
+extern EXTI_TypeDef halExti;
+#define RCC  (&halRcc)
+#define EXTI (&halExti)
+
+GPIO_TypeDef* halGpioPort(uint32_t index);      //the registers of port index, from port A = 0
+#define GPIOA halGpioPort(0)
+#define GPIOB halGpioPort(1)
+#define GPIOC halGpioPort(2)
+#define GPIOD halGpioPort(3)
+#define GPIOE halGpioPort(4)
+
+
+namespace mbed {
+
+template<typename F> class Callback;
+
+//a callable target.  Wraps std::function, with the member function form of the Mbed Callback
+template<typename R, typename... Args>
+class Callback<R(Args...)> {
+public:
+    Callback() {}
+    template<typename F> Callback(F function) : target(function) {}
+    template<typename T, typename M> Callback(T* object, M method)
+        : target([object, method](Args... args) -> R {return static_cast<R>((object->*method)(args...));}) {}
+
+    R operator()(Args... args) const {return target(args...);}
+    R call(Args... args) const {return target(args...);}
+    explicit operator bool() const {return static_cast<bool>(target);}
+
+private:
+    std::function<R(Args...)> target;
+};
+
+template<typename T, typename R, typename... Args>
+Callback<R(Args...)> callback(T* object, R (T::*method)(Args...)){return Callback<R(Args...)>(object, method);}
+template<typename R, typename... Args>
+Callback<R(Args...)> callback(R (*function)(Args...)){return Callback<R(Args...)>(function);}
+
+
+//measures elapsed time, accumulated over start/stop intervals
+class Timer {
+public:
+    void start();
+    void stop();
+    void reset();
+    std::chrono::microseconds elapsed_time() const;
+
+private:
+    bool running = false;
+    long long startUs = 0;
+    long long accumulatedUs = 0;
+};
+
+
+//calls a callback in interrupt context every period, or once after a delay
+class Ticker {
+public:
+    Ticker();
+    ~Ticker();
+    void attach(Callback<void()> handler, std::chrono::microseconds period);
+    void detach();
+
+protected:
+    Ticker(bool repeating);
+
+private:
+    bool repeating;
+    uint32_t entry = 0;     //id of the pending timer entry, or 0
+};
+
+class Timeout : public Ticker {
+public:
+    Timeout() : Ticker(false) {}
+};
+
+class LowPowerTicker : public Ticker {};
+class LowPowerTimeout : public Timeout {};
+
+
+class DigitalOut {
+public:
+    DigitalOut(PinName pin, int value = 0);
+    void write(int value);
+    int read();
+    DigitalOut& operator=(int value){write(value); return *this;}
+    operator int(){return read();}
+
+private:
+    PinName pin;
+};
+
+class DigitalIn {
+public:
+    DigitalIn(PinName pin, PinMode mode = PullNone);
+    int read();
+    operator int(){return read();}
+
+private:
+    PinName pin;
+};
+
+
+//an edge interrupt on an input pin, served by the EXTI line of the pin number
+class InterruptIn {
+public:
+    InterruptIn(PinName pin, PinMode mode = PullNone);
+    ~InterruptIn();
+    void rise(Callback<void()> handler);
+    void fall(Callback<void()> handler);
+    void enable_irq();
+    void disable_irq();
+    int read();
+    operator int(){return read();}
+
+    void deliverEdge(bool rising);      //host only: run the handler of an edge
+
+private:
+    PinName pin;
+    Callback<void()> riseHandler;
+    Callback<void()> fallHandler;
+};
+
+
+/**
+ * HostI2CDevice
+ *
+ * A device model on the host I2C bus.  Attach it at one or more 8-bit addresses.
+ */
+class HostI2CDevice {
+public:
+    virtual ~HostI2CDevice() {}
+    virtual int i2cWrite(int address, const char* data, int length) = 0;   //returns 0 to acknowledge
+    virtual int i2cRead(int address, char* data, int length) = 0;          //returns 0 to acknowledge
+    virtual void i2cFrequency(int hz) {}
+
+    void attach(int address);
+    void detach(int address);
+};
+
+class I2C {
+public:
+    I2C(PinName sda, PinName scl) {}
+    void frequency(int hz);
+    int write(int address, const char* data, int length, bool repeated = false);
+    int read(int address, char* data, int length, bool repeated = false);
+    void lock();
+    void unlock();
+};
+
+
+class Watchdog {
+public:
+    static Watchdog& get_instance();
+    bool start(uint32_t timeoutMs);
+    bool stop();
+    void kick();
+    bool is_running() const {return running;}
+    uint32_t get_timeout() const {return timeoutMs;}
+
+private:
+    Watchdog() {}
+    bool running = false;
+    uint32_t timeoutMs = 0;
+    uint32_t entry = 0;
+};
+
+typedef enum {RESET_REASON_POWER_ON, RESET_REASON_PIN_RESET, RESET_REASON_SOFTWARE, RESET_REASON_WATCHDOG, RESET_REASON_UNKNOWN} reset_reason_t;
+class ResetReason {
+public:
+    static reset_reason_t get(){return RESET_REASON_POWER_ON;}
+};
+
+} //namespace mbed
+
+
+namespace rtos {
+
+class Mutex {
+public:
+    Mutex();
+    void lock();
+    void unlock();
+    bool trylock();
+
+private:
+    struct State;
+    State* state;
+};
+
+class Semaphore {
+public:
+    Semaphore(int32_t count = 0);
+    Semaphore(int32_t count, uint16_t maxCount);
+    void acquire();
+    bool try_acquire();
+    int release();
+
+private:
+    struct State;
+    State* state;
+};
+
+class Thread {
+public:
+    Thread(osPriority priority = osPriorityNormal, uint32_t stackSize = 0, unsigned char* stackMemory = nullptr, const char* name = nullptr) {}
+    int start(mbed::Callback<void()> task);     //runs the task on a detached POSIX thread.  Returns 0
+};
+
+struct Kernel {
+    //milliseconds since startup
+    struct Clock {
+        typedef std::chrono::milliseconds duration;
+        typedef duration::rep rep;
+        typedef duration::period period;
+        typedef std::chrono::time_point<Clock> time_point;
+        typedef std::chrono::duration<uint32_t, std::milli> duration_u32;
+        static constexpr bool is_steady = true;
+        static time_point now();
+    };
+    static uint64_t get_ms_count();
+    static constexpr Clock::duration_u32 wait_for_u32_forever{0xFFFFFFFFu};
+};
+
+namespace ThisThread {
+    void sleep_for(Kernel::Clock::duration_u32 duration);      //wait_for_u32_forever blocks for good
+}
+
+} //namespace rtos
+
+
+void halVirtualRunUntil(long long untilUs);      //host only, declared here as it serves the event queues
+
+namespace events {
+
+/**
+ * EventQueue
+ *
+ * A queue of calls, dispatched in time order by the thread that runs dispatch_forever.  Calls may be posted from
+ *   any thread and from interrupt context.
+ */
+class EventQueue {
+public:
+    EventQueue(unsigned size = 32 * EVENTS_EVENT_SIZE);
+
+    //post a call to run as soon as possible, after a delay, or every period.  Return the event id, or 0 if the queue is full
+    template<typename F, typename... Args>
+    int call(F function, Args... args){return post(0, 0, std::bind(function, args...));}
+    template<typename T, typename R, typename... MArgs, typename... Args>
+    int call(T* object, R (T::*method)(MArgs...), Args... args){return post(0, 0, std::bind(method, object, args...));}
+
+    template<typename F, typename... Args>
+    int call_in(std::chrono::milliseconds delay, F function, Args... args){return post(delay.count(), 0, std::bind(function, args...));}
+    template<typename T, typename R, typename... MArgs, typename... Args>
+    int call_in(std::chrono::milliseconds delay, T* object, R (T::*method)(MArgs...), Args... args){return post(delay.count(), 0, std::bind(method, object, args...));}
+
+    template<typename F, typename... Args>
+    int call_every(std::chrono::milliseconds period, F function, Args... args){return post(period.count(), period.count(), std::bind(function, args...));}
+    template<typename T, typename R, typename... MArgs, typename... Args>
+    int call_every(std::chrono::milliseconds period, T* object, R (T::*method)(MArgs...), Args... args){return post(period.count(), period.count(), std::bind(method, object, args...));}
+
+    bool cancel(int id);
+    void dispatch_forever();
+    void dispatch(int ms = -1);     //dispatch for ms milliseconds, or forever if -1.  0 runs the calls that are due and returns
+    void break_dispatch();
+
+    unsigned pending();             //host only: the number of calls in the queue
+    unsigned overflows();           //host only: the calls that could not be posted because the queue was full
+
+    ~EventQueue();
+
+private:
+    int post(long long delayMs, long long periodMs, std::function<void()> call);
+    long long nextDueUs();          //the time the earliest call is due, or -1 if the queue is empty
+    void runNext();                 //run the earliest call
+    friend void ::halVirtualRunUntil(long long untilUs);
+
+    struct State;
+    State* state;
+};
+
+} //namespace events
+
+
+using namespace mbed;
+using namespace rtos;
+using namespace events;
+
+void wait_us(int us);
+void wait_ns(unsigned int ns);
+void thread_sleep_for(uint32_t ms);
+
+void core_util_critical_section_enter();
+void core_util_critical_section_exit();
+inline uint32_t core_util_atomic_load_u32(const volatile uint32_t* value){return __atomic_load_n(value, __ATOMIC_SEQ_CST);}
+inline void core_util_atomic_store_u32(volatile uint32_t* value, uint32_t store){__atomic_store_n(value, store, __ATOMIC_SEQ_CST);}
+inline uint32_t core_util_atomic_incr_u32(volatile uint32_t* value, uint32_t delta){return __atomic_add_fetch(value, delta, __ATOMIC_SEQ_CST);}
+
+//the on-chip RTC, in seconds since the epoch.  0 at startup, as the RTC of the target before it is set
+time_t halRtcRead();
+uint32_t halRtcSubsecondUs();            //the time into the current RTC second, in microseconds
+void halRtcWrite(time_t seconds);
+
+//the cycle counter of the core, modelled on the time: SystemCoreClock cycles per second, in steps of a microsecond
+extern uint32_t SystemCoreClock;
+void halCycleCounterStart();
+uint32_t halCycles();
+
+//host only: the pin model
+void halGpioDrive(PinName pin, int level);
+int  halGpioLevel(PinName pin);
+void halGpioWatch(mbed::Callback<void(int port, uint32_t levels)> watcher);
+unsigned int halWatchdogExpirations();
+
+//host only: virtual time
+void halVirtualTime();
+long long halTimeUs();
+
+//host only: the Mutex locks taken by the calling thread
+unsigned long halMutexLocks();
+
+#endif
@@ -0,0 +1,232 @@
+/******************************************************************************
+ *   File Name:      CSE321_project3_mnelyubo_filter_sweep.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ *   Purpose:        This host program evaluates a grid of distance filter configurations
+ *                     over recorded range sensor traces: mean windows, as stabilizerArrayLen
+ *                     of the main program, median windows, EMA weights and Kalman noise
+ *                     terms, each with and without an outlier gate.  The configurations
+ *                     are evaluated in SIMD batches (see FilterSweep.h), spread over every
+ *                     core, and the latency/noise Pareto front is reported, so that the
+ *                     filter of a container is chosen from its own traces
+ *
+ *   Functions:      buildGrid, runSweep, paretoFront, printScore, verifyMedians
+ *
+ *   Assignment:     Project 3
+ *
+ *   Inputs:         One or more trace files of one container, and the options:
+ *                     --threads n      worker threads (default: every core)
+ *                     --all            print every configuration, not only the front
+ *                     --verify         check the median batches against replayTrace
+ *
+ *   Outputs:        Console report.  The exit status is the number of --verify mismatches
+ *
+ *   Constraints:    Built by host/CMakeLists.txt, not by Mbed Studio
+ *                   The scores of all traces are summed, so each trace weighs by its polls
+ *                     and steps.  A configuration that does not settle after every step is
+ *                     left out of the front
+ *
+ ******************************************************************************/
+
+#include "RangeTrace.h"
+#include "RangeReplay.h"
+#include "FilterSweep.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#define currentFilterWindow 4       /* stabilizerArrayLen of the main program */
+
+const int meanWindows[] = {1, 2, 3, 4, 5, 6, 8, 10, 12, 16};
+const int medianWindows[] = {3, 5, 7, 9, 11, 15};
+const float emaWeights[] = {0.05f, 0.1f, 0.15f, 0.2f, 0.25f, 0.3f, 0.4f, 0.5f, 0.6f, 0.7f, 0.8f, 0.9f};
+const float kalmanProcessNoise[] = {0.01f, 0.03f, 0.1f, 0.3f, 1, 3, 10};
+const float kalmanMeasurementNoise[] = {1, 3, 10, 30, 100, 300};
+const float gates[] = {gateOff, 10, 20, 40};
+
+//a batch of configurations of one family, evaluated in the lanes of one pass over a trace
+struct Batch {
+    int first;
+    int count;
+};
+
+struct Entry {
+    FilterConfig config;
+    SweepScore score;
+};
+
+
+//every configuration of the grid, ordered by family so that batches do not mix families
+std::vector<FilterConfig> buildGrid(){
+    std::vector<FilterConfig> grid;
+    for(float gate : gates){
+        for(int window : meanWindows) grid.push_back({FilterMean, (float)window, 0, gate});
+    }
+    for(float gate : gates){
+        for(int window : medianWindows) grid.push_back({FilterMedian, (float)window, 0, gate});
+    }
+    for(float gate : gates){
+        for(float weight : emaWeights) grid.push_back({FilterEma, weight, 0, gate});
+    }
+    for(float gate : gates){
+        for(float q : kalmanProcessNoise){
+            for(float r : kalmanMeasurementNoise) grid.push_back({FilterKalman, q, r, gate});
+        }
+    }
+    return grid;
+}
+
+
+/**
+ * std::vector<SweepSums> runSweep(const std::vector<FilterConfig>& grid, const std::vector<SweepTrace>& traces, int threads)
+ *
+ * Summary of the function:
+ *    This function splits the grid into batches of sweepLanes configurations of one family, and has the worker
+ *      threads take (batch, trace) pairs from a shared counter until none are left.  Each pair writes its own
+ *      slot of sums, and the slots are added up per configuration once the workers are joined, so the workers
+ *      share nothing but the counter.
+ *
+ * Return value:
+ *    The sums of each configuration over every trace
+ */
+std::vector<SweepSums> runSweep(const std::vector<FilterConfig>& grid, const std::vector<SweepTrace>& traces, int threads){
+    std::vector<Batch> batches;
+    for(size_t first = 0; first < grid.size();){
+        int count = 1;
+        while(count < sweepLanes && first + count < grid.size() && grid[first + count].family == grid[first].family) count++;
+        batches.push_back({(int)first, count});
+        first += count;
+    }
+
+    size_t work = batches.size() * traces.size();
+    std::vector<SweepSums> slots(work * sweepLanes, SweepSums());
+    std::atomic<size_t> nextWork(0);
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; t++){
+        workers.emplace_back([&](){
+            for(size_t item = nextWork++; item < work; item = nextWork++){
+                const Batch& batch = batches[item / traces.size()];
+                evaluateBatch(&grid[batch.first], batch.count, traces[item % traces.size()], &slots[item * sweepLanes]);
+            }
+        });
+    }
+    for(std::thread& worker : workers) worker.join();
+
+    std::vector<SweepSums> sums(grid.size(), SweepSums());
+    for(size_t item = 0; item < work; item++){
+        const Batch& batch = batches[item / traces.size()];
+        for(int lane = 0; lane < batch.count; lane++) sums[batch.first + lane].add(slots[item * sweepLanes + lane]);
+    }
+    return sums;
+}
+
+
+//the configurations that no other configuration beats on both latency and noise, by increasing latency
+std::vector<Entry> paretoFront(std::vector<Entry> entries){
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& entry){return entry.score.unsettled > 0;}), entries.end());
+    std::sort(entries.begin(), entries.end(), [](const Entry& first, const Entry& second){
+        return first.score.latencyMs != second.score.latencyMs ? first.score.latencyMs < second.score.latencyMs
+                                                               : first.score.noiseCm < second.score.noiseCm;
+    });
+    std::vector<Entry> front;
+    for(const Entry& entry : entries){
+        if(front.empty() || entry.score.noiseCm < front.back().score.noiseCm) front.push_back(entry);
+    }
+    return front;
+}
+
+
+void printScore(const Entry& entry){
+    printf("%10.0f %9.2f %9.2f %9lu  %s\n", entry.score.latencyMs, entry.score.noiseCm, entry.score.meanAbsErrorCm,
+           entry.score.unsettled, entry.config.describe().c_str());
+}
+
+
+//checks the ungated median lanes against MedianFilter through replayTrace, which scores one poll at a time
+int verifyMedians(const std::vector<FilterConfig>& grid, const std::vector<RangeTrace>& traces, const std::vector<SweepTrace>& prepared){
+    int mismatches = 0;
+    for(const FilterConfig& config : grid){
+        if(config.family != FilterMedian || config.gateCm < gateOff) continue;
+        for(size_t t = 0; t < traces.size(); t++){
+            SweepSums sums = SweepSums();
+            evaluateBatch(&config, 1, prepared[t], &sums);
+            MedianFilter median((int)config.a);
+            FilterScore expected = replayTrace(median, traces[t]);
+            double settle = sums.settledSteps ? sums.settlePolls / sums.settledSteps : 0;
+            double meanError = sums.scored ? sums.absError / sums.scored : 0;
+            if((unsigned long)sums.steps != expected.steps || (unsigned long)sums.unsettled != expected.unsettled ||
+               (unsigned long)sums.scored != expected.scored || std::fabs(settle - expected.meanSettlePolls) > 1e-6 ||
+               std::fabs(meanError - expected.meanAbsErrorCm) > 1e-4){
+                printf("MISMATCH %s on trace %zu: settle %.3f/%.3f, mean error %.4f/%.4f, unsettled %lu/%lu\n",
+                       config.describe().c_str(), t, settle, expected.meanSettlePolls, meanError, expected.meanAbsErrorCm,
+                       (unsigned long)sums.unsettled, expected.unsettled);
+                mismatches++;
+            }
+        }
+    }
+    printf("verify: %d median configurations mismatched replayTrace\n", mismatches);
+    return mismatches;
+}
+
+
+int main(int argc, char* argv[]){
+    int threads = std::thread::hardware_concurrency();
+    bool printAll = false;
+    bool verify = false;
+    std::vector<const char*> paths;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--all") == 0) printAll = true;
+        else if(strcmp(argv[i], "--verify") == 0) verify = true;
+        else paths.push_back(argv[i]);
+    }
+    if(paths.empty()){
+        printf("usage: %s <trace.rtr>... [--threads n] [--all] [--verify]\n", argv[0]);
+        return 2;
+    }
+    if(threads < 1) threads = 1;
+
+    std::vector<RangeTrace> traces(paths.size());
+    std::vector<SweepTrace> prepared;
+    size_t polls = 0;
+    for(size_t t = 0; t < paths.size(); t++){
+        std::string error;
+        if(!readRangeTrace(paths[t], traces[t], error)){
+            printf("%s\n", error.c_str());
+            return 2;
+        }
+        prepared.push_back(prepareSweepTrace(traces[t]));
+        polls += traces[t].samples.size();
+    }
+
+    std::vector<FilterConfig> grid = buildGrid();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<SweepSums> sums = runSweep(grid, prepared, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<Entry> entries;
+    for(size_t c = 0; c < grid.size(); c++) entries.push_back({grid[c], sums[c].score(traces[0].pollPeriodMs)});
+    printf("%zu configurations over %zu traces of %zu polls in %.3f s on %d threads: %.1f M configuration-polls/s\n",
+           grid.size(), traces.size(), polls, seconds, threads, grid.size() * polls / seconds / 1e6);
+    printf("%lu steps of the ground truth\n\n", entries.empty() ? 0 : entries[0].score.steps);
+
+    printf("%10s %9s %9s %9s  %s\n", "latency ms", "noise cm", "mean cm", "unsettled", "filter");
+    if(printAll){
+        for(const Entry& entry : entries) printScore(entry);
+        printf("\nPareto front:\n");
+    }
+    for(const Entry& entry : paretoFront(entries)) printScore(entry);
+
+    printf("\ncurrent filter:\n");
+    for(const Entry& entry : entries){
+        if(entry.config.family == FilterMean && (int)entry.config.a == currentFilterWindow && entry.config.gateCm >= gateOff) printScore(entry);
+    }
+
+    int mismatches = verify ? verifyMedians(grid, traces, prepared) : 0;
+    return mismatches;
+}
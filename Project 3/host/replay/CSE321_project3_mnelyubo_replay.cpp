@@ -0,0 +1,146 @@
+/******************************************************************************
+ *   File Name:      CSE321_project3_mnelyubo_replay.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ *   Purpose:        This host program replays a range sensor trace, captured on the NUCLEO
+ *                     by tests/CSE321_project3_mnelyubo_range_test.cpp, through the distance
+ *                     filter of the main program and through replacement candidates, as fast
+ *                     as possible.  For each filter it reports the samples replayed per
+ *                     second, and the error of the filter output against the ground truth
+ *                     annotated in the trace, so that a filter change is evaluated on real
+ *                     data before it is flashed
+ *
+ *   Functions:      ProjectFilter, printOutputs, printScore
+ *
+ *   Assignment:     Project 3
+ *
+ *   Inputs:         The trace file, and the options:
+ *                     --outputs        print the echo, truth and output of every filter for each poll
+ *                     --max-error cm   fail if the mean error of a filter is larger
+ *
+ *   Outputs:        Console report, and the number of filters over the --max-error bound as
+ *                     the exit status
+ *
+ *   Constraints:    Built by host/CMakeLists.txt, not by Mbed Studio.  main() of the project
+ *                     is renamed project3Main() in this build and is not called
+ *                   The filter of the main program is run by setting the echo timestamps
+ *                     and calling processDistanceData, as distanceEchoFallHandler posts it,
+ *                     only for polls whose falling edge was seen.  The output refresh and
+ *                     alarm calls that updateStableDistance posts are not served: once the
+ *                     output modification queue is full, they fail, and are counted as its
+ *                     overflows
+ *
+ ******************************************************************************/
+
+#include "CSE321_project3_mnelyubo_main.h"
+#include "RangeTrace.h"
+#include "RangeReplay.h"
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/**
+ * ProjectFilter
+ *
+ * The filter of the main program: processDistanceData and updateStableDistance, on the globals of the program.
+ */
+class ProjectFilter : public RangeFilter {
+public:
+    const char* name() const override {return "project";}
+
+    void reset() override {
+        for(int i = 0; i < stabilizerArrayLen; i++) distanceBuffer[i] = 0;
+        distanceBuffIdx = 0;
+        stableDistance = 0;
+    }
+
+    int update(uint16_t riseUs, uint16_t fallUs) override {
+        if(fallUs != RangeTraceNoEdge){
+            riseEchoTimestamp = riseUs == RangeTraceNoEdge ? 0 : riseUs;    //cleared by the previous poll
+            fallEchoTimestamp = fallUs;
+            processDistanceData();
+        }
+        return stableDistance;
+    }
+};
+
+
+//one line for every poll: the echo edges, the distance they measure, the truth, and the output of each filter
+void printOutputs(const RangeTrace& trace, const std::vector<std::unique_ptr<RangeFilter>>& filters){
+    std::vector<std::vector<int>> outputs(filters.size());
+    for(size_t f = 0; f < filters.size(); f++) replayTrace(*filters[f], trace, &outputs[f]);
+
+    printf("%6s %6s %6s %6s %6s", "poll", "rise", "fall", "echo", "truth");
+    for(const std::unique_ptr<RangeFilter>& filter : filters) printf(" %8s", filter->name());
+    printf("\n");
+    for(size_t i = 0; i < trace.samples.size(); i++){
+        const RangeSample& sample = trace.samples[i];
+        printf("%6zu %6d %6d %6d %6d", i, sample.riseUs == RangeTraceNoEdge ? -1 : sample.riseUs,
+               sample.fallUs == RangeTraceNoEdge ? -1 : sample.fallUs, echoDistanceCm(sample.riseUs, sample.fallUs), sample.truthCm);
+        for(size_t f = 0; f < filters.size(); f++) printf(" %8d", outputs[f][i]);
+        printf("\n");
+    }
+}
+
+
+void printScore(RangeFilter& filter, const RangeTrace& trace){
+    FilterScore score = replayTrace(filter, trace);
+    double rate = replayRate(filter, trace);
+    printf("%-10s %12.0f %8.2f %8.2f %6d %6lu %8.1f %9lu %6lu\n", filter.name(), rate, score.meanAbsErrorCm, score.rmsErrorCm,
+           score.maxAbsErrorCm, score.steps, score.meanSettlePolls, score.unsettled, score.silent);
+}
+
+
+int main(int argc, char* argv[]){
+    const char* path = nullptr;
+    bool showOutputs = false;
+    double maxError = -1;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--outputs") == 0) showOutputs = true;
+        else if(strcmp(argv[i], "--max-error") == 0 && i + 1 < argc) maxError = atof(argv[++i]);
+        else path = argv[i];
+    }
+    if(!path){
+        printf("usage: %s <trace.rtr> [--outputs] [--max-error cm]\n", argv[0]);
+        return 2;
+    }
+
+    RangeTrace trace;
+    std::string error;
+    if(!readRangeTrace(path, trace, error)){
+        printf("%s\n", error.c_str());
+        return 2;
+    }
+    unsigned long truths = 0;
+    unsigned long echoes = 0;
+    for(const RangeSample& sample : trace.samples){
+        if(sample.truthCm != RangeTraceNoTruth) truths++;
+        if(echoDistanceCm(sample.riseUs, sample.fallUs) != RangeNoOutput) echoes++;
+    }
+    printf("trace %s: %zu polls %d ms apart, %lu with ground truth, %lu valid echoes\n", path, trace.samples.size(),
+           trace.pollPeriodMs, truths, echoes);
+
+    std::vector<std::unique_ptr<RangeFilter>> filters;
+    filters.emplace_back(new ProjectFilter());
+    filters.emplace_back(new MedianFilter(3));
+    filters.emplace_back(new MedianFilter(5));
+
+    if(showOutputs) printOutputs(trace, filters);
+
+    printf("%-10s %12s %8s %8s %6s %6s %8s %9s %6s\n", "filter", "samples/s", "mean cm", "rms cm", "max", "steps", "settle", "unsettled", "silent");
+    int failures = 0;
+    for(const std::unique_ptr<RangeFilter>& filter : filters){
+        printScore(*filter, trace);
+        if(maxError >= 0 && replayTrace(*filter, trace).meanAbsErrorCm > maxError){
+            printf("FAIL %s: mean error over %.2f cm\n", filter->name(), maxError);
+            failures++;
+        }
+    }
+    printf("output queue overflows %u\n", outputModificationEventQueue.overflows());
+
+    fflush(stdout);
+    _exit(failures);
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+ *   File Name:      CSE321_project3_mnelyubo_trace_synth.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ *   Purpose:        This host program writes a synthetic range sensor trace, annotated with
+ *                     its ground truth, in the format that the capture mode of
+ *                     tests/CSE321_project3_mnelyubo_range_test.cpp streams from the NUCLEO.
+ *                     The container is emptied, filled slowly, opened and closed, and left
+ *                     out of range, and the echoes carry the faults seen on the bench:
+ *                     timing jitter, double bounces, lost echoes and missed edges.
+ *
+ *                   It stands in for a captured trace in the host tests.  Filter changes
+ *                     should be evaluated on captured traces as well
+ *
+ *   Functions:      nextRandom, chance, uniform, clampUs, echoOf
+ *
+ *   Assignment:     Project 3
+ *
+ *   Inputs:         The trace file to write, and optionally the seed of the faults
+ *
+ *   Outputs:        The trace file
+ *
+ *   Constraints:    Built by host/CMakeLists.txt, not by Mbed Studio
+ *                   The same seed writes the same trace
+ *
+ ******************************************************************************/
+
+#include "RangeTrace.h"
+#include "RangeSensorEmulator.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define synthPollPeriodMs   100
+#define outOfRangeCm        600     /* no echo: nothing in front of the sensor */
+
+//echo faults
+#define widthJitterUs       60      /* up to +- this much on every echo width */
+#define riseLatencyUs       20      /* up to this much interrupt latency on the rising edge */
+#define doubleBouncePerMil  20      /* echo returns from a second reflection, at twice the distance */
+#define lostEchoPerMil      10      /* the sensor gives the no-echo pulse */
+#define missedFallPerMil    10      /* the falling edge arrives after the next poll */
+#define missedRisePerMil    5       /* the rising edge interrupt is missed */
+
+//a part of the plan: the distance moves from fromCm to toCm over polls
+struct Segment {
+    int polls;
+    int fromCm;
+    int toCm;
+};
+
+const Segment plan[] = {
+    {150, 180, 180},        //empty container
+    {300, 180, 40},         //filled slowly
+    {150, 40, 40},
+    {100, 120, 120},        //lid held open over the sensor
+    {100, 40, 40},
+    {100, 25, 25},          //topped up
+    {100, outOfRangeCm, outOfRangeCm},     //sensor turned away
+    {150, 250, 250}         //emptied, and the sensor put back
+};
+
+uint32_t randomState = 1;
+
+//xorshift, so that every run with the same seed writes the same trace
+uint32_t nextRandom(){
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+bool chance(int perMil){return (int)(nextRandom() % 1000) < perMil;}
+
+int uniform(int range){return (int)(nextRandom() % (2 * range + 1)) - range;}
+
+uint16_t clampUs(int us){return us > RangeTraceMaxUs ? RangeTraceMaxUs : us;}
+
+
+//the echo edges of a poll at distanceCm, in us after the poll started, with the faults of the sensor and the interrupts
+RangeSample echoOf(int distanceCm){
+    int riseUs = RangeSensorMinTriggerUs + RangeSensorBurstUs + (int)(nextRandom() % (riseLatencyUs + 1));
+    int widthUs;
+    bool inRange = RangeSensorMinCm <= distanceCm && distanceCm <= RangeSensorMaxCm;
+    if(!inRange || chance(lostEchoPerMil)){
+        widthUs = RangeSensorNoEchoUs;
+    }else if(chance(doubleBouncePerMil)){
+        widthUs = 2 * distanceCm * RangeSensorUsPerCm + uniform(widthJitterUs);
+    }else{
+        widthUs = distanceCm * RangeSensorUsPerCm + uniform(widthJitterUs);
+    }
+
+    RangeSample sample;
+    sample.riseUs = clampUs(riseUs);
+    sample.fallUs = clampUs(riseUs + widthUs);
+    if(chance(missedFallPerMil)) sample.fallUs = RangeTraceNoEdge;
+    if(chance(missedRisePerMil)) sample.riseUs = RangeTraceNoEdge;
+    sample.truthCm = inRange ? distanceCm : RangeTraceNoTruth;
+    return sample;
+}
+
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        printf("usage: %s <trace.rtr> [seed]\n", argv[0]);
+        return 2;
+    }
+    randomState = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+    if(randomState == 0) randomState = 1;
+
+    RangeTrace trace;
+    trace.pollPeriodMs = synthPollPeriodMs;
+    for(const Segment& segment : plan){
+        for(int poll = 0; poll < segment.polls; poll++){
+            int distanceCm = segment.fromCm + (segment.toCm - segment.fromCm) * poll / segment.polls;
+            trace.samples.push_back(echoOf(distanceCm));
+        }
+    }
+
+    if(!writeRangeTrace(argv[1], trace)){
+        printf("cannot write %s\n", argv[1]);
+        return 1;
+    }
+    printf("wrote %zu polls to %s\n", trace.samples.size(), argv[1]);
+    return 0;
+}
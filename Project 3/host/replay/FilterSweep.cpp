@@ -0,0 +1,249 @@
+/******************************************************************************
+ *   File Name:      FilterSweep.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       Implementation of the vectorized filter sweep.  See FilterSweep.h.
+ ******************************************************************************/
+
+#include "FilterSweep.h"
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+typedef float  LaneVector __attribute__((vector_size(sweepLanes * sizeof(float))));
+typedef double LaneSum    __attribute__((vector_size(sweepLanes * sizeof(double))));
+
+#define sumFlushPolls 4096      /* polls summed in float lanes before the sums are moved to double lanes */
+
+static LaneVector splat(float value){
+    LaneVector zero = {};
+    return zero + value;
+}
+
+static LaneVector absolute(LaneVector value){return value < 0 ? -value : value;}
+
+
+std::string FilterConfig::describe() const {
+    char text[64];
+    switch(family){
+        case FilterMean:   snprintf(text, sizeof(text), "mean %d", (int)a); break;
+        case FilterMedian: snprintf(text, sizeof(text), "median %d", (int)a); break;
+        case FilterEma:    snprintf(text, sizeof(text), "ema %.2f", a); break;
+        case FilterKalman: snprintf(text, sizeof(text), "kalman q=%g r=%g", a, b); break;
+    }
+    std::string description = text;
+    if(gateCm < gateOff){
+        snprintf(text, sizeof(text), " gate %d", (int)gateCm);
+        description += text;
+    }
+    return description;
+}
+
+
+SweepTrace prepareSweepTrace(const RangeTrace& trace){
+    SweepTrace prepared;
+    prepared.pollPeriodMs = trace.pollPeriodMs;
+    int lastTruth = RangeTraceNoTruth;
+    for(const RangeSample& sample : trace.samples){
+        prepared.echoCm.push_back(echoDistanceCm(sample.riseUs, sample.fallUs));
+        prepared.truthCm.push_back(sample.truthCm);
+        bool step = false;
+        if(sample.truthCm != RangeTraceNoTruth){
+            step = lastTruth != RangeTraceNoTruth && std::abs(sample.truthCm - lastTruth) > settleToleranceCm;
+            lastTruth = sample.truthCm;
+        }
+        prepared.step.push_back(step);
+    }
+    return prepared;
+}
+
+
+void SweepSums::add(const SweepSums& other){
+    settlePolls += other.settlePolls;
+    settledSteps += other.settledSteps;
+    steps += other.steps;
+    unsettled += other.unsettled;
+    steadySquareError += other.steadySquareError;
+    steadyPolls += other.steadyPolls;
+    absError += other.absError;
+    scored += other.scored;
+}
+
+SweepScore SweepSums::score(int pollPeriodMs) const {
+    SweepScore result;
+    result.latencyMs = settledSteps ? settlePolls / settledSteps * pollPeriodMs : 0;
+    result.noiseCm = steadyPolls ? std::sqrt(steadySquareError / steadyPolls) : 0;
+    result.meanAbsErrorCm = scored ? absError / scored : 0;
+    result.steps = (unsigned long)steps;
+    result.unsettled = (unsigned long)unsettled;
+    return result;
+}
+
+
+//the window of a mean or median lane
+struct LaneWindow {
+    std::vector<float> samples;     //circular
+    std::vector<float> sorted;
+    int next = 0;
+    int count = 0;
+    float sum = 0;
+
+    explicit LaneWindow(int length) : samples(length > 0 ? length : 1), sorted(samples.size()) {}
+
+    void clear(){
+        next = 0;
+        count = 0;
+        sum = 0;
+    }
+
+    void push(float sample){
+        if(count == (int)samples.size()) sum -= samples[next];
+        else count++;
+        samples[next] = sample;
+        sum += sample;
+        next = (next + 1) % samples.size();
+    }
+
+    float mean() const {return sum / count;}
+
+    //the upper median, as MedianFilter
+    float median(){
+        std::copy(samples.begin(), samples.begin() + count, sorted.begin());
+        std::nth_element(sorted.begin(), sorted.begin() + count / 2, sorted.begin() + count);
+        return sorted[count / 2];
+    }
+};
+
+
+/**
+ * void evaluateBatch(const FilterConfig* configs, int count, const SweepTrace& trace, SweepSums* sums)
+ *
+ * Summary of the function:
+ *    This function runs up to sweepLanes configurations of one family over the trace together.  Each poll with a
+ *      valid echo is gated and filtered in every lane, and every poll with a known truth is scored in every
+ *      lane.  Branches that differ between lanes are masks: 1 in a lane where the condition holds, 0 elsewhere,
+ *      multiplied into the update, so that every lane runs the same instructions.
+ *    The settle count follows replayTrace: it starts at a step and ends at the first output within
+ *      settleToleranceCm, counting every poll in between.
+ *
+ * Parameters:
+ *    configs - count configurations of the same family
+ *    trace   - the prepared trace
+ *    sums    - count sums, added to
+ */
+void evaluateBatch(const FilterConfig* configs, int count, const SweepTrace& trace, SweepSums* sums){
+    FilterFamily family = configs[0].family;
+
+    //parameters of each lane.  Lanes past count repeat the first configuration, and are not reported
+    LaneVector a, b, gate;
+    std::vector<LaneWindow> windows;
+    for(int lane = 0; lane < sweepLanes; lane++){
+        const FilterConfig& config = configs[lane < count ? lane : 0];
+        a[lane] = config.a;
+        b[lane] = config.b;
+        gate[lane] = config.gateCm;
+        if(family == FilterMean || family == FilterMedian) windows.emplace_back((int)config.a);
+    }
+
+    const LaneVector one = splat(1);
+    const LaneVector zero = splat(0);
+    const LaneVector tolerance = splat(settleToleranceCm);
+    LaneVector output = zero;
+    LaneVector variance = zero;         //Kalman estimate variance
+    LaneVector rejectRun = zero;
+
+    //scoring state, and sums of the current flush interval
+    LaneVector settling = zero;
+    LaneVector stepPolls = zero;
+    LaneVector settlePolls = zero, settledSteps = zero, unsettled = zero, steadySquareError = zero, steadyPolls = zero, absError = zero;
+    LaneSum totalSettlePolls = {}, totalSettledSteps = {}, totalUnsettled = {}, totalSteadySquareError = {}, totalSteadyPolls = {}, totalAbsError = {};
+    double steps = 0;
+    double scored = 0;
+    bool started = false;
+
+    for(size_t i = 0; i < trace.echoCm.size(); i++){
+        float echo = trace.echoCm[i];
+        if(started && family == FilterKalman) variance += a;       //predict: the distance may have moved since the last poll
+
+        if(echo != RangeNoOutput){
+            LaneVector sample = splat(echo);
+            if(!started){
+                started = true;
+                output = sample;
+                variance = b;
+                for(LaneWindow& window : windows) window.push(echo);
+            }else{
+                LaneVector over = absolute(sample - output) > gate ? one : zero;
+                LaneVector force = over * (rejectRun >= gateRejectRun ? one : zero);
+                LaneVector accept = one - over;
+                rejectRun = (rejectRun + one) * over * (one - force);
+
+                switch(family){
+                    case FilterEma:
+                        output += accept * a * (sample - output);
+                        output += force * (sample - output);
+                        break;
+                    case FilterKalman: {
+                        LaneVector gain = variance / (variance + b);
+                        output += accept * gain * (sample - output);
+                        variance -= accept * gain * variance;
+                        output += force * (sample - output);
+                        variance += force * (b - variance);
+                        break;
+                    }
+                    case FilterMean:
+                    case FilterMedian:
+                        for(int lane = 0; lane < sweepLanes; lane++){
+                            if(force[lane] != 0) windows[lane].clear();
+                            if(accept[lane] == 0 && force[lane] == 0) continue;
+                            windows[lane].push(echo);
+                            output[lane] = family == FilterMean ? windows[lane].mean() : windows[lane].median();
+                        }
+                        break;
+                }
+            }
+        }
+
+        if(trace.truthCm[i] != RangeTraceNoTruth){
+            if(trace.step[i]){
+                steps++;
+                unsettled += settling;
+                settling = one;
+                stepPolls = zero;
+            }
+            if(started){
+                LaneVector error = absolute(output - (float)trace.truthCm[i]);
+                LaneVector settled = settling * (error <= tolerance ? one : zero);
+                settlePolls += settled * stepPolls;
+                settledSteps += settled;
+                settling -= settled;
+                LaneVector steady = one - settling;
+                steadySquareError += steady * error * error;
+                steadyPolls += steady;
+                absError += error;
+                scored++;
+            }
+        }
+        stepPolls += one;
+
+        if(i % sumFlushPolls == sumFlushPolls - 1 || i + 1 == trace.echoCm.size()){
+            totalSettlePolls += __builtin_convertvector(settlePolls, LaneSum);
+            totalSettledSteps += __builtin_convertvector(settledSteps, LaneSum);
+            totalUnsettled += __builtin_convertvector(unsettled, LaneSum);
+            totalSteadySquareError += __builtin_convertvector(steadySquareError, LaneSum);
+            totalSteadyPolls += __builtin_convertvector(steadyPolls, LaneSum);
+            totalAbsError += __builtin_convertvector(absError, LaneSum);
+            settlePolls = settledSteps = unsettled = steadySquareError = steadyPolls = absError = zero;
+        }
+    }
+    totalUnsettled += __builtin_convertvector(settling, LaneSum);      //steps still settling at the end of the trace
+
+    for(int lane = 0; lane < count; lane++){
+        SweepSums laneSums = {totalSettlePolls[lane], totalSettledSteps[lane], steps, totalUnsettled[lane],
+                              totalSteadySquareError[lane], totalSteadyPolls[lane], totalAbsError[lane], scored};
+        sums[lane].add(laneSums);
+    }
+}
@@ -0,0 +1,105 @@
+/******************************************************************************
+ *   File Name:      FilterSweep.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This library evaluates many configurations of a distance filter
+ *         family over a range sensor trace at once.  The configurations of a
+ *         batch share the family and are the lanes of SIMD vectors, so one
+ *         pass over the trace updates every lane with the same vector
+ *         instructions, and scores every lane against the ground truth.
+ *
+ *       Families:
+ *         FilterMean    the mean of the last a accepted samples, as the main
+ *                       program with stabilizerArrayLen = a
+ *         FilterMedian  the median of the last a accepted samples
+ *         FilterEma     exponential moving average with weight a
+ *         FilterKalman  constant position Kalman filter, process noise a and
+ *                       measurement noise b, in cm squared per poll
+ *
+ *       Any family may gate outliers: a sample further than gateCm from the
+ *         output is rejected, unless gateRejectRun samples in a row were, in
+ *         which case the distance has moved and the filter restarts from the
+ *         sample.
+ *
+ *       The score of a lane is the latency and noise of its output:
+ *         latency, the polls the output takes to settle within
+ *         settleToleranceCm after a step of the truth, and noise, the RMS
+ *         error over the polls where the output is settled.
+ ******************************************************************************
+ *   Usage:
+ *       SweepTrace prepared = prepareSweepTrace(trace);
+ *       SweepSums sums[sweepLanes] = {};
+ *       evaluateBatch(configs, count, prepared, sums);    count <= sweepLanes, one family
+ *       SweepScore score = sums[0].score(prepared.pollPeriodMs);
+ *
+ *   Constraints:
+ *       The vectors use the GCC vector extension, so the lanes compile to
+ *         the SIMD instructions of the host (SSE, AVX or NEON) without
+ *         intrinsics.  The EMA and Kalman families and the scoring run in
+ *         vectors.  Mean and median keep a window per lane, updated lane by
+ *         lane
+ *
+ ******************************************************************************/
+
+#ifndef FILTER_SWEEP_H
+#define FILTER_SWEEP_H
+
+#include "RangeTrace.h"
+#include "RangeReplay.h"
+#include <string>
+#include <vector>
+
+#define sweepLanes      8       /* configurations evaluated together */
+#define gateRejectRun   3       /* samples rejected in a row before the filter restarts from a sample */
+#define gateOff         1.0e9f
+
+enum FilterFamily {FilterMean, FilterMedian, FilterEma, FilterKalman};
+
+struct FilterConfig {
+    FilterFamily family;
+    float a;                //window, weight or process noise
+    float b;                //measurement noise of FilterKalman
+    float gateCm;           //or gateOff
+    std::string describe() const;
+};
+
+//a trace in the form the lanes read: the echo distance of each poll, its truth, and the steps of the truth
+struct SweepTrace {
+    int pollPeriodMs = 100;
+    std::vector<float> echoCm;          //or RangeNoOutput
+    std::vector<int> truthCm;           //or RangeTraceNoTruth
+    std::vector<unsigned char> step;    //1 at the first poll of a step of the truth larger than settleToleranceCm
+};
+
+SweepTrace prepareSweepTrace(const RangeTrace& trace);
+
+struct SweepScore {
+    double latencyMs;           //mean time to settle after a step
+    double noiseCm;             //RMS error while settled
+    double meanAbsErrorCm;      //over every scored poll
+    unsigned long steps;
+    unsigned long unsettled;    //steps after which the output did not settle before the next step
+};
+
+//the sums of a lane, which add up over traces
+struct SweepSums {
+    double settlePolls;
+    double settledSteps;
+    double steps;
+    double unsettled;
+    double steadySquareError;
+    double steadyPolls;
+    double absError;
+    double scored;
+
+    void add(const SweepSums& other);
+    SweepScore score(int pollPeriodMs) const;
+};
+
+//adds the sums of each configuration over trace to sums[lane]
+void evaluateBatch(const FilterConfig* configs, int count, const SweepTrace& trace, SweepSums* sums);
+
+#endif
@@ -0,0 +1,113 @@
+/******************************************************************************
+ *   File Name:      RangeReplay.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       Implementation of the trace replay and the filter score.  See RangeReplay.h.
+ ******************************************************************************/
+
+#include "RangeReplay.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+MedianFilter::MedianFilter(int window) : filterName("median" + std::to_string(window)), history(window > 0 ? window : 1), sorted(history.size()) {}
+
+void MedianFilter::reset(){
+    next = 0;
+    count = 0;
+    output = RangeNoOutput;
+}
+
+int MedianFilter::update(uint16_t riseUs, uint16_t fallUs){
+    int distance = echoDistanceCm(riseUs, fallUs);
+    if(distance == RangeNoOutput) return output;
+
+    history[next] = distance;
+    next = (next + 1) % history.size();
+    if(count < (int)history.size()) count++;
+
+    std::copy(history.begin(), history.begin() + count, sorted.begin());
+    std::nth_element(sorted.begin(), sorted.begin() + count / 2, sorted.begin() + count);
+    output = sorted[count / 2];
+    return output;
+}
+
+
+/**
+ * FilterScore replayTrace(RangeFilter& filter, const RangeTrace& trace, std::vector<int>* outputs)
+ *
+ * Summary of the function:
+ *    This function resets the filter, passes it every poll of the trace in order, and compares each output with
+ *      the truth of its poll.  A step of the truth starts a settle count, which ends at the first output within
+ *      settleToleranceCm of the new truth, or is counted as unsettled at the next step or the end of the trace.
+ */
+FilterScore replayTrace(RangeFilter& filter, const RangeTrace& trace, std::vector<int>* outputs){
+    FilterScore score;
+    double absSum = 0;
+    double squareSum = 0;
+    unsigned long settleSum = 0;
+    unsigned long settledSteps = 0;
+    int lastTruth = RangeTraceNoTruth;
+    bool settling = false;
+    size_t stepStart = 0;
+
+    if(outputs) outputs->clear();
+    filter.reset();
+    for(size_t i = 0; i < trace.samples.size(); i++){
+        const RangeSample& sample = trace.samples[i];
+        int output = filter.update(sample.riseUs, sample.fallUs);
+        if(outputs) outputs->push_back(output);
+        if(sample.truthCm == RangeTraceNoTruth) continue;
+
+        if(lastTruth != RangeTraceNoTruth && std::abs(sample.truthCm - lastTruth) > settleToleranceCm){
+            score.steps++;
+            if(settling) score.unsettled++;
+            settling = true;
+            stepStart = i;
+        }
+        lastTruth = sample.truthCm;
+
+        if(output == RangeNoOutput){
+            score.silent++;
+            continue;
+        }
+        int error = std::abs(output - sample.truthCm);
+        score.scored++;
+        absSum += error;
+        squareSum += (double)error * error;
+        score.maxAbsErrorCm = std::max(score.maxAbsErrorCm, error);
+        if(settling && error <= settleToleranceCm){
+            settling = false;
+            settleSum += i - stepStart;
+            settledSteps++;
+        }
+    }
+    if(settling) score.unsettled++;
+
+    if(score.scored){
+        score.meanAbsErrorCm = absSum / score.scored;
+        score.rmsErrorCm = std::sqrt(squareSum / score.scored);
+    }
+    if(settledSteps) score.meanSettlePolls = (double)settleSum / settledSteps;
+    return score;
+}
+
+
+double replayRate(RangeFilter& filter, const RangeTrace& trace){
+    if(trace.samples.empty()) return 0;
+    volatile int sink = 0;          //keeps the outputs, so that the replay is not optimized away
+    unsigned long samples = 0;
+    double seconds = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while(seconds < replayMinimumTime){
+        filter.reset();
+        for(const RangeSample& sample : trace.samples) sink = sink + filter.update(sample.riseUs, sample.fallUs);
+        samples += trace.samples.size();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return samples / seconds;
+}
@@ -0,0 +1,105 @@
+/******************************************************************************
+ *   File Name:      RangeReplay.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This library replays a range sensor trace through a distance filter
+ *         and scores the filter output against the annotated ground truth.
+ *         A filter is anything that takes the echo edges of one poll and
+ *         returns the distance it shows, so the filter of the main program
+ *         and a candidate replacement are evaluated on the same data.
+ *
+ *       The score of a filter covers the polls with a known truth:
+ *         the mean, RMS and largest absolute error of the output, and the
+ *         polls the output takes to settle within settleToleranceCm after a
+ *         step of the truth larger than that tolerance.  Polls before the
+ *         filter has any output are counted as silent and not scored.
+ ******************************************************************************
+ *   Usage:
+ *       MedianFilter median(5);
+ *       std::vector<int> outputs;
+ *       FilterScore score = replayTrace(median, trace, &outputs);
+ *       double rate = replayRate(median, trace);      samples/s
+ *
+ ******************************************************************************/
+
+#ifndef RANGE_REPLAY_H
+#define RANGE_REPLAY_H
+
+#include "RangeTrace.h"
+#include <vector>
+
+#define RangeUsPerCm        58      /* echo time per cm of distance, from the sensor datasheet */
+#define RangeMinimumCm      2       /* the main program keeps distances strictly between these */
+#define RangeMaximumCm      400
+#define RangeNoOutput       -1      /* a filter that has not seen a valid sample yet */
+#define settleToleranceCm   2
+#define replayMinimumTime   0.2     /* seconds of replay over which the sample rate is measured */
+
+
+//the distance of the echo of a poll, as processDistanceData computes it, or RangeNoOutput if it is out of range.
+//A rise that was not seen counts from the start of the poll, as the cleared timestamp of the main program
+inline int echoDistanceCm(uint16_t riseUs, uint16_t fallUs){
+    if(fallUs == RangeTraceNoEdge) return RangeNoOutput;
+    int width = fallUs - (riseUs == RangeTraceNoEdge ? 0 : riseUs);
+    int distance = width / RangeUsPerCm;
+    return (RangeMinimumCm < distance && distance < RangeMaximumCm) ? distance : RangeNoOutput;
+}
+
+
+/**
+ * RangeFilter
+ *
+ * A distance filter under evaluation.  update is called once for every poll of a trace, in order.
+ */
+class RangeFilter {
+public:
+    virtual ~RangeFilter() {}
+    virtual const char* name() const = 0;
+    virtual void reset() = 0;                                   //forget every sample, as at startup
+    virtual int update(uint16_t riseUs, uint16_t fallUs) = 0;   //the echo edges of a poll, as in RangeSample.  Returns the distance shown, or RangeNoOutput
+};
+
+
+/**
+ * MedianFilter
+ *
+ * A replacement candidate: the median of the last window valid samples.  Out of range echoes are dropped.
+ */
+class MedianFilter : public RangeFilter {
+public:
+    explicit MedianFilter(int window);
+    const char* name() const override {return filterName.c_str();}
+    void reset() override;
+    int update(uint16_t riseUs, uint16_t fallUs) override;
+
+private:
+    std::string filterName;
+    std::vector<int> history;       //circular, the last window valid samples
+    std::vector<int> sorted;        //a copy of history, partially sorted to find the median
+    int next = 0;
+    int count = 0;
+    int output = RangeNoOutput;
+};
+
+
+struct FilterScore {
+    unsigned long scored = 0;       //polls with a known truth and a filter output
+    unsigned long silent = 0;       //polls with a known truth before the first output
+    double meanAbsErrorCm = 0;
+    double rmsErrorCm = 0;
+    int maxAbsErrorCm = 0;
+    unsigned long steps = 0;        //steps of the truth larger than settleToleranceCm
+    unsigned long unsettled = 0;    //steps after which the output did not settle before the next step
+    double meanSettlePolls = 0;     //over the steps that settled
+};
+
+//resets filter and runs it over every sample of trace.  The output of each poll is stored in outputs if it is given
+FilterScore replayTrace(RangeFilter& filter, const RangeTrace& trace, std::vector<int>* outputs = nullptr);
+
+//replays trace through filter as fast as possible, repeatedly for at least replayMinimumTime, and returns the samples per second
+double replayRate(RangeFilter& filter, const RangeTrace& trace);
+
+#endif
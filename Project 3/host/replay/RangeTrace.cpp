@@ -0,0 +1,91 @@
+/******************************************************************************
+ *   File Name:      RangeTrace.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       Implementation of the range sensor trace format.  See RangeTrace.h.
+ ******************************************************************************/
+
+#include "RangeTrace.h"
+#include <stdio.h>
+
+static const char traceMagic[4] = {'R', 'T', 'R', 'C'};
+
+static uint16_t readU16(const unsigned char* bytes){return bytes[0] | (bytes[1] << 8);}
+
+static void writeU16(unsigned char* bytes, uint16_t value){
+    bytes[0] = value & 0xFF;
+    bytes[1] = value >> 8;
+}
+
+
+/**
+ * bool readRangeTrace(const char* path, RangeTrace& trace, std::string& error)
+ *
+ * Summary of the function:
+ *    This function reads a trace file into trace.  Annotation records are folded into the truth of the samples
+ *      that follow them.  A partial record at the end, as a capture stopped mid-write leaves, is dropped.
+ */
+bool readRangeTrace(const char* path, RangeTrace& trace, std::string& error){
+    FILE* file = fopen(path, "rb");
+    if(!file){
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    unsigned char header[RangeTraceHeaderSize];
+    if(fread(header, 1, sizeof(header), file) != sizeof(header) || header[0] != traceMagic[0] || header[1] != traceMagic[1] ||
+       header[2] != traceMagic[2] || header[3] != traceMagic[3]){
+        fclose(file);
+        error = std::string(path) + " is not a range trace";
+        return false;
+    }
+    if(header[4] != RangeTraceVersion){
+        fclose(file);
+        error = std::string(path) + ": unsupported trace version " + std::to_string(header[4]);
+        return false;
+    }
+    trace.pollPeriodMs = readU16(header + 6);
+    trace.samples.clear();
+
+    int truthCm = RangeTraceNoTruth;
+    unsigned char record[RangeTraceRecordSize];
+    while(fread(record, 1, sizeof(record), file) == sizeof(record)){
+        uint16_t rise = readU16(record);
+        uint16_t fall = readU16(record + 2);
+        if(rise == RangeTraceAnnotation){
+            truthCm = fall == RangeTraceNoEdge ? RangeTraceNoTruth : fall;
+        }else{
+            trace.samples.push_back({rise, fall, truthCm});
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+
+bool writeRangeTrace(const char* path, const RangeTrace& trace){
+    FILE* file = fopen(path, "wb");
+    if(!file) return false;
+
+    unsigned char header[RangeTraceHeaderSize] = {traceMagic[0], traceMagic[1], traceMagic[2], traceMagic[3], RangeTraceVersion, 0};
+    writeU16(header + 6, trace.pollPeriodMs);
+    bool written = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+
+    int truthCm = RangeTraceNoTruth;
+    unsigned char record[RangeTraceRecordSize];
+    for(const RangeSample& sample : trace.samples){
+        if(sample.truthCm != truthCm){
+            truthCm = sample.truthCm;
+            writeU16(record, RangeTraceAnnotation);
+            writeU16(record + 2, truthCm == RangeTraceNoTruth ? RangeTraceNoEdge : truthCm);
+            written = written && fwrite(record, 1, sizeof(record), file) == sizeof(record);
+        }
+        writeU16(record, sample.riseUs);
+        writeU16(record + 2, sample.fallUs);
+        written = written && fwrite(record, 1, sizeof(record), file) == sizeof(record);
+    }
+    return fclose(file) == 0 && written;
+}
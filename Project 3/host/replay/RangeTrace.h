@@ -0,0 +1,70 @@
+/******************************************************************************
+ *   File Name:      RangeTrace.h
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ ******************************************************************************
+ *   Purpose:
+ *       This library reads and writes range sensor traces: the raw echo
+ *         edge timestamps of every distance poll, as the capture mode of
+ *         tests/CSE321_project3_mnelyubo_range_test.cpp streams them from
+ *         the NUCLEO, with the ground truth distance annotated by the user
+ *         during the capture.
+ *
+ *       A trace is little-endian binary:
+ *         header, 8 bytes:  'R' 'T' 'R' 'C', version (1), reserved (0),
+ *                           poll period in ms (uint16)
+ *         record, 4 bytes:  rise (uint16), fall (uint16)
+ *
+ *       A record is one poll.  rise and fall are the times of the echo
+ *         edges in us after the poll started, as riseEchoTimestamp and
+ *         fallEchoTimestamp of the main program, or RangeTraceNoEdge if the
+ *         edge was not seen before the next poll.  Times are clamped to
+ *         RangeTraceMaxUs.
+ *       A record with rise RangeTraceAnnotation is not a poll: its fall is
+ *         the ground truth distance in cm of the polls that follow, or
+ *         RangeTraceNoEdge if the distance is unknown.
+ ******************************************************************************
+ *   Usage:
+ *       RangeTrace trace;
+ *       std::string error;
+ *       if(!readRangeTrace("shelf.rtr", trace, error)) puts(error.c_str());
+ *       for(const RangeSample& sample : trace.samples) ...
+ *
+ ******************************************************************************/
+
+#ifndef RANGE_TRACE_H
+#define RANGE_TRACE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define RangeTraceVersion     1
+#define RangeTraceHeaderSize  8
+#define RangeTraceRecordSize  4
+#define RangeTraceNoEdge      0xFFFF    /* the edge was not seen in the poll, or the truth is unknown */
+#define RangeTraceAnnotation  0xFFFE    /* in the rise field: the record sets the ground truth */
+#define RangeTraceMaxUs       0xFFFD    /* longest edge time that can be recorded */
+#define RangeTraceNoTruth     -1
+
+
+//a poll of a trace, and the ground truth distance at the time of the poll
+struct RangeSample {
+    uint16_t riseUs;        //or RangeTraceNoEdge
+    uint16_t fallUs;        //or RangeTraceNoEdge
+    int truthCm;            //or RangeTraceNoTruth
+};
+
+struct RangeTrace {
+    int pollPeriodMs = 100;
+    std::vector<RangeSample> samples;
+};
+
+//false with a message in error if the file cannot be read or is not a trace
+bool readRangeTrace(const char* path, RangeTrace& trace, std::string& error);
+
+//writes the samples, with an annotation before every change of the truth
+bool writeRangeTrace(const char* path, const RangeTrace& trace);
+
+#endif
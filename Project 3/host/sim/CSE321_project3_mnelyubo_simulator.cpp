@@ -0,0 +1,376 @@
+/******************************************************************************
+ *   File Name:      CSE321_project3_mnelyubo_simulator.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ *   Purpose:        This host program runs the Project 3 main program in virtual time for
+ *                     a number of days, against the LCD, keypad and range sensor emulators.
+ *                     The keypad is scripted through the setup states, and a fill and empty
+ *                     plan for each day of the week moves the synthetic echo, so that the
+ *                     closing time alarm, clock rollover at midnight and the week are
+ *                     exercised without waiting next to the hardware.
+ *
+ *                   It reports the distance polls missed, the event queue overflows, the
+ *                     seconds the Observer clock skipped (missed ticks), and the time of
+ *                     every alarm change against the time the plan expects it
+ *
+ *   Functions:      runUntil, runFor, checkTicks, typeKeys, syncToRtc, virtualTimeAt, closingTimeOf,
+ *                     planWeek, expectAlarm, runSetup, compareAlarm, report
+ *
+ *   Assignment:     Project 3
+ *
+ *   Inputs:         Optional: the number of days to simulate (default 7)
+ *
+ *   Outputs:        Console report, and the number of failed checks as the exit status
+ *
+ *   Constraints:    Built by host/CMakeLists.txt, not by Mbed Studio.  main() of the project
+ *                     is renamed project3Main() in this build and is not called: the
+ *                     simulator calls configureSystem, and serves every event queue itself
+ *                     with halVirtualRunUntil in place of the threads of startThreads
+ *                   The buzzer threads are not run.  The alarm is observed on its enable
+ *                     output, PB_10
+ *                   The keypad is not scanned periodically: a press raises a column
+ *                     interrupt.  The keypad script presses each key with contact bounce
+ *                     instead, at 10 ms resolution of the plan
+ *                   The closing alarm is re-evaluated by a timeout in whole RTC seconds, so
+ *                     an alarm change may be up to a second late.  It counts as a timing
+ *                     error when it is later than alarmToleranceUs or early
+ *
+ ******************************************************************************/
+
+#include "CSE321_project3_mnelyubo_main.h"
+#include "LcdEmulator.h"
+#include "KeypadEmulator.h"
+#include "RangeSensorEmulator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+//time
+#define usPerSecond      1000000LL
+#define usPerMs          1000LL
+#define startOfSimulation (8 * secondsPerHour)     /* Monday 08:00:00, as the script sets the clock */
+
+//simulation
+#define defaultDays         7
+#define stepUs              (100 * usPerMs)     /* the Observer clock is checked every step: faster than its 1 s frames */
+#define pollPeriodUs        (100 * usPerMs)     /* distance sensor poll period of the main program */
+#define keyHoldUs           (80 * usPerMs)
+#define keyGapUs            (150 * usPerMs)
+#define keyBounces          3
+#define echoJitterUs        20
+#define alarmToleranceUs    (1500 * usPerMs)    /* a whole RTC second of timeout rounding, and the four sample distance filter */
+
+//distances of the container, cm
+#define emptyDistance       200
+#define fullDistance        20
+
+//closing times, seconds since midnight
+#define weekdayClosing      (22 * secondsPerHour)
+#define weekendClosing      (18 * secondsPerHour)
+
+int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+void check(bool passed, const char* condition, int line){
+    if(!passed){
+        printf("FAIL line %d: %s\n", line, condition);
+        failures++;
+    }
+}
+
+LcdEmulator lcd(COL, ROW);
+KeypadEmulator keypadEmulator({PE_2, PE_4, PE_5, PE_6}, {PC_0, PC_3, PC_1, PC_4}, {"dcba", "#963", "0852", "*741"});
+RangeSensorEmulator rangeSensor(PC_9, PC_8);
+
+//a change of the alarm enable output, PB_10
+struct AlarmChange {
+    long long timeUs;
+    int level;
+};
+std::vector<AlarmChange> alarmChanges;
+int alarmLevel = 0;
+
+//an action of the plan, at a time of the simulation in seconds since Monday 00:00:00 of the first week
+struct PlanAction {
+    long long second;
+    int distanceCm;         //the distance to set, or -1
+    const char* keys;       //the keys to type, or nullptr
+};
+
+//the Observer clock
+int lastSeenSecond = -1;
+unsigned long missedTicks = 0;
+unsigned long observerSeconds = 0;
+
+//the RTC, as synchronized by syncToRtc: the virtual time at which the RTC counted simulation second rtcSecond
+long long rtcSyncUs = 0;
+long long rtcSecond = 0;
+
+
+//the pin model watcher: records the changes of the alarm enable output
+void watchAlarm(int port, uint32_t levels){
+    if(port != (int)STM_PORT(PB_10)) return;
+    int level = (levels >> STM_PIN(PB_10)) & 1;
+    if(level == alarmLevel) return;
+    alarmLevel = level;
+    alarmChanges.push_back({halTimeUs(), level});
+}
+
+
+//counts the seconds the Observer clock skipped since the last check
+void checkTicks(){
+    if(currentState != Observer){
+        lastSeenSecond = -1;
+        return;
+    }
+    if(lastRenderedSecond == lastSeenSecond) return;
+    if(lastSeenSecond >= 0){
+        int advance = (lastRenderedSecond - lastSeenSecond + secondsPerDay) % secondsPerDay;
+        if(advance > 1) missedTicks += advance - 1;
+    }
+    observerSeconds++;
+    lastSeenSecond = lastRenderedSecond;
+}
+
+
+//runs the simulation to a virtual time, checking the Observer clock at every step
+void runUntil(long long untilUs){
+    while(halTimeUs() < untilUs){
+        halVirtualRunUntil(std::min(untilUs, halTimeUs() + stepUs));
+        checkTicks();
+    }
+}
+
+void runFor(long long us){runUntil(halTimeUs() + us);}
+
+
+//types keys on the keypad, each pressed and released with contact bounce
+void typeKeys(const char* keys){
+    for(const char* key = keys; *key; key++){
+        keypadEmulator.press(*key, keyBounces);
+        runFor(keyHoldUs);
+        keypadEmulator.release(*key, keyBounces);
+        runFor(keyGapUs);
+    }
+}
+
+
+//finds the virtual time at which the RTC counts a new second, so that plan times can be converted to virtual time
+void syncToRtc(){
+    time_t start = halRtcRead();
+    while(halRtcRead() == start) runFor(usPerMs);
+    rtcSyncUs = halTimeUs();
+    rtcSecond = readRealTimeOfWeek();       //the simulation starts on Monday, so the first week is the time of week
+}
+
+long long virtualTimeAt(long long second){return rtcSyncUs + (second - rtcSecond) * usPerSecond;}
+
+
+//the closing time of a day of the simulation
+int closingTimeOf(int day){return day % daysPerWeek < 5 ? weekdayClosing : weekendClosing;}
+
+
+/**
+ * std::vector<PlanAction> planWeek(int days)
+ *
+ * Summary of the function:
+ *    This function builds the fill and empty plan of the simulation.  The container fills through each day.  On
+ *      Monday, Wednesday and Friday it is emptied before closing time.  On Tuesday and Saturday it is left until
+ *      the next morning, so the alarm sounds until midnight.  On Thursday it is emptied an hour after closing,
+ *      which stops the alarm.  On Sunday the alarm is disarmed before closing and armed again the next morning.
+ */
+std::vector<PlanAction> planWeek(int days){
+    std::vector<PlanAction> plan;
+    for(int day = 0; day < days; day++){
+        long long midnight = (long long)day * secondsPerDay;
+        plan.push_back({midnight +  9 * secondsPerHour, 150, nullptr});
+        plan.push_back({midnight + 13 * secondsPerHour,  90, nullptr});
+        plan.push_back({midnight + 17 * secondsPerHour,  60, nullptr});
+        switch(day % daysPerWeek){
+        case 0: case 4:
+            plan.push_back({midnight + 21 * secondsPerHour, emptyDistance, nullptr});
+            break;
+        case 2:
+            plan.push_back({midnight + 21 * secondsPerHour + 1800, emptyDistance, nullptr});
+            break;
+        case 3:
+            plan.push_back({midnight + 23 * secondsPerHour, emptyDistance, nullptr});
+            break;
+        case 6:
+            plan.push_back({midnight + 16 * secondsPerHour, -1, "#"});                          //disarm
+            plan.push_back({midnight + secondsPerDay + 7 * secondsPerHour + 1800, -1, "#"});    //arm again on Monday morning
+            //fall through: emptied on Monday morning
+        case 1: case 5:
+            plan.push_back({midnight + secondsPerDay + 7 * secondsPerHour, emptyDistance, nullptr});
+            break;
+        }
+    }
+    std::stable_sort(plan.begin(), plan.end(), [](const PlanAction& a, const PlanAction& b){return a.second < b.second;});
+    return plan;
+}
+
+
+/**
+ * std::vector<AlarmChange> expectAlarm(const std::vector<PlanAction>& plan, long long endSecond)
+ *
+ * Summary of the function:
+ *    This function works out the alarm changes the plan should cause, from the rule of the main program: the
+ *      alarm sounds while it is armed, the time of day is past the closing time of the day, and the container is
+ *      not empty.  The rule is evaluated at every action of the plan, every closing time and every midnight.
+ */
+std::vector<AlarmChange> expectAlarm(const std::vector<PlanAction>& plan, long long endSecond){
+    std::vector<long long> moments;
+    for(const PlanAction& action : plan) moments.push_back(action.second);
+    for(long long midnight = 0; midnight <= endSecond; midnight += secondsPerDay){
+        moments.push_back(midnight);
+        moments.push_back(midnight + closingTimeOf(midnight / secondsPerDay) + 1);
+    }
+    std::sort(moments.begin(), moments.end());
+
+    std::vector<AlarmChange> expected;
+    int distance = emptyDistance;
+    bool armed = true;
+    int level = 0;
+    size_t next = 0;
+    for(long long moment : moments){
+        if(moment < startOfSimulation || moment >= endSecond) continue;
+        for(; next < plan.size() && plan[next].second <= moment; next++){
+            if(plan[next].distanceCm >= 0) distance = plan[next].distanceCm;
+            if(plan[next].keys) armed = !armed;
+        }
+        bool passed = moment % secondsPerDay > closingTimeOf(moment / secondsPerDay);
+        int alarm = armed && passed && distance < emptyDistance;
+        if(alarm != level){
+            level = alarm;
+            expected.push_back({virtualTimeAt(moment), level});
+        }
+    }
+    return expected;
+}
+
+
+//goes through the setup states with the keypad: Monday 08:00:00, a closing time for each day, then empty and full
+void runSetup(){
+    rangeSensor.setDistance(emptyDistance);
+    runFor(usPerSecond);                    //startup and the first frame
+
+    typeKeys("080000a");                    //SetRealTime: Monday is shown first
+    syncToRtc();
+
+    for(int day = 0; day < daysPerWeek; day++){
+        typeKeys("c");
+        typeKeys(closingTimeOf(day) == weekdayClosing ? "2200" : "1800");
+        typeKeys(day < daysPerWeek - 1 ? "b" : "a");    //[B] stores the shown day and shows the next, [A] stores Sunday and confirms
+    }
+
+    runFor(usPerSecond);
+    typeKeys("a");                          //SetMax at the empty distance
+    rangeSensor.setDistance(fullDistance);
+    runFor(usPerSecond);
+    typeKeys("a");                          //SetMin at the full distance, arming the alarm
+    rangeSensor.setDistance(emptyDistance);
+    runFor(usPerSecond);
+
+    CHECK(currentState == Observer);
+    CHECK(alarmArmed);
+    for(int day = 0; day < daysPerWeek; day++) CHECK(closingTimeSchedule[day] == closingTimeOf(day));
+}
+
+
+//compares the alarm changes seen to those expected, and prints them
+void compareAlarm(const std::vector<AlarmChange>& expected){
+    unsigned long timingErrors = 0;
+    long long maxLateUs = 0;
+    long long totalLateUs = 0;
+    size_t compared = std::min(expected.size(), alarmChanges.size());
+    for(size_t i = 0; i < compared; i++){
+        long long lateUs = alarmChanges[i].timeUs - expected[i].timeUs;
+        bool wrong = alarmChanges[i].level != expected[i].level || lateUs < 0 || lateUs > alarmToleranceUs;
+        if(wrong){
+            timingErrors++;
+            printf("alarm change %zu: %s expected at %.3f s, seen %s at %.3f s\n", i,
+                   expected[i].level ? "on" : "off", expected[i].timeUs / 1e6, alarmChanges[i].level ? "on" : "off", alarmChanges[i].timeUs / 1e6);
+        }
+        maxLateUs = std::max(maxLateUs, lateUs);
+        totalLateUs += lateUs;
+    }
+
+    printf("alarm changes         expected %zu, seen %zu\n", expected.size(), alarmChanges.size());
+    printf("alarm lateness        max %.3f s, mean %.3f s, tolerance %.3f s\n",
+           maxLateUs / 1e6, compared ? totalLateUs / 1e6 / compared : 0.0, alarmToleranceUs / 1e6);
+    printf("alarm timing errors   %lu\n", timingErrors);
+    CHECK(expected.size() == alarmChanges.size());
+    CHECK(timingErrors == 0);
+}
+
+
+//prints the report of the run and checks it
+void report(int days, double wallSeconds, long long pollStartUs, const std::vector<AlarmChange>& expected){
+    long long simulatedUs = halTimeUs() - pollStartUs;
+    unsigned long pollsExpected = simulatedUs / pollPeriodUs;
+    unsigned long missedPolls = pollsExpected > rangeSensor.triggers() ? pollsExpected - rangeSensor.triggers() : 0;
+    unsigned long overflows = distanceSensorEventQueue.overflows() + outputModificationEventQueue.overflows() +
+                              keyInputEventQueue.overflows() + matrixOpsEventQueue.overflows();
+
+    printf("\n=== Simulation of %d days: %.1f s of virtual time in %.1f s ===\n", days, halTimeUs() / 1e6, wallSeconds);
+    printf("distance polls        expected %lu, triggered %lu, short %lu, during echo %lu, missed %lu\n", pollsExpected,
+           rangeSensor.triggers(), rangeSensor.shortTriggers(), rangeSensor.busyTriggers(), missedPolls);
+    printf("distance samples      %lu\n", (unsigned long)distanceSampleCount);
+    printf("queue overflows       distance %u, output %u, key input %u, matrix %u\n", distanceSensorEventQueue.overflows(),
+           outputModificationEventQueue.overflows(), keyInputEventQueue.overflows(), matrixOpsEventQueue.overflows());
+    printf("Observer seconds      %lu, missed ticks %lu\n", observerSeconds, missedTicks);
+    printf("key presses           %lu, column edges %lu\n", keypadEmulator.presses(), keypadEmulator.columnEdges());
+    printf("watchdog expirations  %u\n", halWatchdogExpirations());
+    printf("LCD emulator errors   %zu\n", lcd.errors().size());
+    compareAlarm(expected);
+
+    CHECK(missedPolls <= 1);            //the poll in progress at the end
+    CHECK(rangeSensor.shortTriggers() == 0);
+    CHECK(overflows == 0);
+    CHECK(missedTicks == 0);
+    CHECK(halWatchdogExpirations() == 0);
+    CHECK(lcd.errors().empty());
+}
+
+
+int main(int argc, char* argv[]){
+    int days = argc > 1 ? atoi(argv[1]) : defaultDays;
+    if(days < 1) days = defaultDays;
+
+    halVirtualTime();
+    lcd.attach();
+    keypadEmulator.attach();
+    rangeSensor.attach();
+    rangeSensor.setJitter(echoJitterUs);
+    halGpioWatch(callback(watchAlarm));
+
+    std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+    configureSystem();
+    long long pollStartUs = halTimeUs();
+    runSetup();
+
+    long long endSecond = startOfSimulation + (long long)days * secondsPerDay;
+    std::vector<PlanAction> plan = planWeek(days + 1);
+    std::vector<AlarmChange> expected = expectAlarm(plan, endSecond);
+    for(const PlanAction& action : plan){
+        if(action.second < startOfSimulation) continue;
+        if(action.second >= endSecond) break;
+        runUntil(virtualTimeAt(action.second));
+        if(action.distanceCm >= 0) rangeSensor.setDistance(action.distanceCm);
+        if(action.keys) typeKeys(action.keys);
+    }
+    runUntil(virtualTimeAt(endSecond));
+    lcdObject.flush();
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    report(days, wallSeconds, pollStartUs, expected);
+    printf("%s: %d failed checks\n", failures ? "FAILED" : "PASSED", failures);
+
+    //the I2C bus thread is blocked in its queue, and is not joined
+    fflush(stdout);
+    _exit(failures ? 1 : 0);
+}
@@ -0,0 +1,290 @@
+/******************************************************************************
+ *   File Name:      CSE321_project3_mnelyubo_core_test.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ *   Purpose:        This host program links the Project 3 main program through the POSIX
+ *                     backend of the HAL, without starting its threads, and checks the GPIO
+ *                     register model, the clock conversions, the distance filter, and the
+ *                     user interface state machine from the first key press to the alarm,
+ *                     as the LCD emulator shows it, and the buckets of the latency histograms
+ *
+ *   Functions:      checkGpio, checkClock, checkStableDistance, checkSetup, checkObserver,
+ *                     checkAlarm, checkLatencyHistogram
+ *
+ *   Assignment:     Project 3
+ *
+ *   Inputs:         None
+ *
+ *   Outputs:        Console printout, and the number of failed checks as the exit status
+ *
+ *   Constraints:    Built by host/CMakeLists.txt, not by Mbed Studio.  main() of the project
+ *                     is renamed project3Main() in this build and is not called
+ *                   Key presses are passed to handleInputKey on the main thread, and the
+ *                     calls they post to the output modification queue are dispatched on the
+ *                     main thread by drainOutput, in place of the output refresh thread
+ *                   The RTC runs in real time, so the seconds of a rendered time are not checked
+ *
+ ******************************************************************************/
+
+#include "CSE321_project3_mnelyubo_main.h"
+#include "GpioPin.h"
+#include "LatencyProbe.h"
+#include "LcdEmulator.h"
+#include <string>
+#include <unistd.h>
+
+#define coalescedFrameWaitMs 40     /* longer than the 20 ms coalescing interval of SetMax and SetMin */
+
+int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+#define CHECK_ROW(display, line, text) checkText((display).row(line), (text), __LINE__)
+#define CHECK_PREFIX(display, line, text) checkText((display).row(line).substr(0, sizeof(text) - 1), (text), __LINE__)
+
+void check(bool passed, const char* condition, int line){
+    if(!passed){
+        printf("FAIL line %d: %s\n", line, condition);
+        failures++;
+    }
+}
+
+void checkText(const std::string& shown, const char* expected, int line){
+    if(shown != expected){
+        printf("FAIL line %d: shown \"%s\", expected \"%s\"\n", line, shown.c_str(), expected);
+        failures++;
+    }
+}
+
+LcdEmulator emulator(COL, ROW);
+LatencyProbe testProbe("test");
+
+
+//runs the output modification calls that are due, as the output refresh thread would, and waits for the LCD writes
+void drainOutput(){
+    outputModificationEventQueue.dispatch(0);
+    lcdObject.flush();
+}
+
+//presses each key of keys in turn
+void pressKeys(const char* keys){
+    for(const char* key = keys; *key; key++){
+        handleInputKey(*key);
+        drainOutput();
+    }
+}
+
+//sends count long press and repeat events of a held key
+void holdKey(char key, int count){
+    for(int i = 0; i < count; i++){
+        handleHeldKey(key);
+        drainOutput();
+    }
+}
+
+//fills the distance filter with distance, as a run of equal samples would, and waits for a coalesced frame to be drawn
+void measureDistance(int distance){
+    for(int i = 0; i < stabilizerArrayLen; i++) distanceBuffer[i] = distance;
+    updateStableDistance();
+    outputModificationEventQueue.dispatch(coalescedFrameWaitMs);
+    lcdObject.flush();
+}
+
+
+//the register model: BSRR sets and resets ODR, and IDR reads output pins back
+void checkGpio(){
+    typedef Pin<PortC, 9> RangeTrigger;
+    RangeTrigger::configureOutput();
+    CHECK(RCC->AHB2ENR & 0x04);
+    CHECK(((GPIOC->MODER >> 18) & 0x3) == 0x1);
+
+    RangeTrigger::set();
+    CHECK(halGpioLevel(PC_9) == 1);
+    CHECK(GPIOC->ODR & (1 << 9));
+    RangeTrigger::clear();
+    CHECK(halGpioLevel(PC_9) == 0);
+
+    typedef PinGroup<Pin<PortE, 2>, Pin<PortE, 4>, Pin<PortE, 5>, Pin<PortE, 6>> Rows;
+    Rows::configureOutputs();
+    Rows::write(Rows::mask());
+    CHECK((GPIOE->ODR & 0x74) == 0x74);
+    Rows::select(1);
+    CHECK((GPIOE->ODR & 0x74) == 0x10);
+    Rows::write(0);
+    CHECK((GPIOE->ODR & 0x74) == 0);
+}
+
+
+//the RTC keeps the day of the week and the time of day, through the time input line format
+void checkClock(){
+    char timeLine[] = "(24hr)  13:07:58";
+    CHECK(parseTimeOfDay(timeLine) == 13 * 3600 + 7 * 60 + 58);
+    renderTimeOfDay(timeLine, 23 * 3600 + 59 * 60 + 59);
+    checkText(timeLine, "(24hr)  23:59:59", __LINE__);
+
+    for(int weekday = 0; weekday < 7; weekday++){
+        setRealTimeClock(weekday, 3600);
+        CHECK(readRealTimeOfWeek() / secondsPerDay == weekday);
+        CHECK(readRealTimeClock() - 3600 <= 1);
+    }
+}
+
+
+//the stable distance is the average of the filter, and a change requests a frame
+void checkStableDistance(){
+    int samples[stabilizerArrayLen] = {100, 102, 98, 104};
+    for(int i = 0; i < stabilizerArrayLen; i++) distanceBuffer[i] = samples[i];
+    CHECK(updateStableDistance() == 101);
+    CHECK(stableDistance == 101);
+    CHECK(outputModificationEventQueue.pending() > 0);
+    drainOutput();
+}
+
+
+//SetRealTime, SetClosingTime, SetMax and SetMin, as a user goes through them with the keypad
+void checkSetup(){
+    CHECK(currentState == SetRealTime);
+    CHECK_ROW(emulator, 0, "Set current: Mon");
+    CHECK_ROW(emulator, 1, "(24hr)  hh:mm:ss");
+
+    pressKeys("13");
+    CHECK_ROW(emulator, 1, "(24hr)  13:mm:ss");
+    holdKey('3', 6);                                //holding a digit scrolls the digit it entered
+    CHECK_ROW(emulator, 1, "(24hr)  19:mm:ss");
+    holdKey('3', 1);
+    CHECK_ROW(emulator, 1, "(24hr)  10:mm:ss");
+    holdKey('3', 3);
+    CHECK_ROW(emulator, 1, "(24hr)  13:mm:ss");
+    pressKeys("9");                                 //minutes cannot exceed 59
+    CHECK_ROW(emulator, 1, "(24hr)  13:mm:ss");
+    holdKey('9', 1);                                //a rejected digit scrolls nothing
+    CHECK_ROW(emulator, 1, "(24hr)  13:mm:ss");
+    pressKeys("0758bb");
+    CHECK_ROW(emulator, 0, "Set current: Wed");
+    CHECK_ROW(emulator, 1, "(24hr)  13:07:58");
+
+    pressKeys("a");
+    CHECK(currentState == SetClosingTime);
+    CHECK(readRealTimeOfWeek() / secondsPerDay == 2);
+    CHECK(readRealTimeClock() - (13 * 3600 + 7 * 60 + 58) <= 2);
+    CHECK_ROW(emulator, 0, "Set closing: Wed");
+
+    pressKeys("22");
+    holdKey('2', 2);                                //hours cannot exceed 23, so the digit wraps past 3
+    CHECK_ROW(emulator, 1, "(24hr)  20:mm:ss");
+    holdKey('2', 2);
+    CHECK_ROW(emulator, 1, "(24hr)  22:mm:ss");
+    pressKeys("a");                                 //unset digits are taken as 0
+    CHECK(currentState == SetMax);
+    CHECK(closingScheduleSet);
+    for(int day = 0; day < 7; day++) CHECK(closingTimeSchedule[day] == 22 * 3600);
+
+    measureDistance(200);
+    CHECK_ROW(emulator, 1, "Set empty: 200cm");
+    pressKeys("a");
+    CHECK(maxDistance == 200);
+    CHECK(currentState == SetMin);
+
+    measureDistance(50);
+    CHECK_ROW(emulator, 1, "Set full:  050cm");
+    pressKeys("a");
+    CHECK(minDistance == 50);
+    CHECK(alarmArmed);
+    CHECK(currentState == Observer);
+}
+
+
+//the Observer output shows the fill level, the alarm indicator and the time of day
+void checkObserver(){
+    CHECK_PREFIX(emulator, 0, "Space ");
+    CHECK_PREFIX(emulator, 1, "100%   #13:0");
+
+    measureDistance(125);
+    pressKeys("#");                                 //a key press draws a frame at once
+    CHECK_PREFIX(emulator, 1, "050%    13:0");
+    CHECK(!alarmArmed);
+    pressKeys("#");
+    CHECK_PREFIX(emulator, 1, "050%   #13:0");
+}
+
+
+//the alarm sounds after closing time while the container is used, and stops when it is disarmed
+void checkAlarm(){
+    DigitalOut& alarmEnable = *new DigitalOut(PB_10);     //reads back the alarm enable output of the main program
+    CHECK(alarmEnable.read() == 0);
+
+    setRealTimeClock(2, 22 * 3600 + 5);
+    enqueueAlarmScheduling();
+    drainOutput();
+    CHECK(alarmEnable.read() == 1);
+
+    pressKeys("#");
+    CHECK(alarmEnable.read() == 0);
+
+    pressKeys("d");
+    CHECK(currentState == SetRealTime);
+    CHECK(!alarmArmed);
+    CHECK_ROW(emulator, 0, "Set current: Wed");
+    CHECK_PREFIX(emulator, 1, "(24hr)  22:00:0");
+}
+
+
+//the buckets of a latency histogram cover every 32-bit value without gaps, each within 1/8 of its values
+void checkLatencyHistogram(){
+    for(int bucket = 0; bucket < latencyBucketCount - 1; bucket++){
+        CHECK(LatencyHistogram::bucketHigh(bucket) + 1 == LatencyHistogram::bucketLow(bucket + 1));
+        CHECK(LatencyHistogram::bucketOf(LatencyHistogram::bucketLow(bucket)) == bucket);
+        CHECK(LatencyHistogram::bucketOf(LatencyHistogram::bucketHigh(bucket)) == bucket);
+        CHECK((LatencyHistogram::bucketHigh(bucket) - LatencyHistogram::bucketLow(bucket)) * 8 <= LatencyHistogram::bucketLow(bucket));
+    }
+    CHECK(LatencyHistogram::bucketOf(0xFFFFFFFF) == latencyBucketCount - 1);
+    CHECK(LatencyHistogram::bucketHigh(latencyBucketCount - 1) == 0xFFFFFFFF);
+
+    LatencyHistogram histogram;
+    for(uint32_t cycles = 1; cycles <= 1000; cycles++) histogram.record(cycles);
+    CHECK(histogram.count() == 1000);
+    CHECK(histogram.minimum() == 1 && histogram.maximum() == 1000 && histogram.mean() == 500);
+    CHECK(histogram.percentile(500) >= 500 && histogram.percentile(500) <= 500 + 500 / 8);
+    CHECK(histogram.percentile(990) >= 990 && histogram.percentile(990) <= 1000);
+    CHECK(histogram.percentile(1000) == 1000);
+    histogram.reset();
+    histogram.record(7);
+    CHECK(histogram.count() == 1 && histogram.minimum() == 7 && histogram.maximum() == 7 && histogram.percentile(999) == 7);
+
+    //a stop without a start is not recorded.  Without CSE321_LATENCY_PROBES every stamp is 0
+    testProbe.stop();
+    CHECK(testProbe.values().count() == 0);
+    testProbe.start();
+    wait_us(1000);
+    testProbe.stop();
+    CHECK(testProbe.values().count() == 1);
+#if CSE321_LATENCY_PROBES
+    CHECK(testProbe.values().maximum() >= SystemCoreClock / 1000);
+#else
+    CHECK(testProbe.values().maximum() == 0);
+#endif
+}
+
+
+int main(){
+    emulator.attach();
+    lcdObject.begin();
+    lcdObject.loadBarGlyphs();
+    handleInputKey('x');                            //no action: draws the first frame, as startup does
+    drainOutput();
+
+    checkGpio();
+    checkClock();
+    checkStableDistance();
+    checkSetup();
+    checkObserver();
+    checkAlarm();
+    checkLatencyHistogram();
+
+    CHECK(emulator.errors().empty());
+    printf("%s: %d failed checks\n", failures ? "FAILED" : "PASSED", failures);
+
+    //the bus threads are blocked in their queues, and are not joined
+    fflush(stdout);
+    _exit(failures ? 1 : 0);
+}
@@ -0,0 +1,433 @@
+/******************************************************************************
+ *   File Name:      CSE321_project3_mnelyubo_lcd_emulator_test.cpp
+ *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+ *   Date Created:   10/19/2026
+ *   Last Modified:  10/19/2026
+ *   Purpose:        This host program drives CSE321_LCD against the LCD emulator, checks
+ *                     the text, glyphs and backlight color the emulator decodes, and pins
+ *                     the I2C traffic of the Observer display refreshes.  It also checks
+ *                     the transaction and free slot counts of the bus manager when posted
+ *                     writes are merged while a transaction runs
+ *
+ *   Functions:      checkStartup, checkText, checkPages, checkGlyphs, checkBacklight,
+ *                     checkObserverTraffic, checkFourRows, checkMalformed, checkBusMergeWhileBusy
+ *
+ *   Assignment:     Project 3
+ *
+ *   Inputs:         None
+ *
+ *   Outputs:        Console printout, and the number of failed checks as the exit status
+ *
+ *   Constraints:    Built by host/CMakeLists.txt, not by Mbed Studio
+ *                   The traffic pins count the writes CSE321_LCD queues, which do not depend
+ *                     on timing.  The bus manager merges adjacent character writes when the
+ *                     bus thread falls behind, so the traffic on the emulated bus is only
+ *                     bounded by them.  A change of a pin is a change of the display cost
+ *                     of the project, and should be deliberate
+ *
+ *   References:
+ *       AiP31068 datasheet:    https://www.seeedstudio.com/Grove-LCD-RGB-Backlight.html
+ *
+ ******************************************************************************/
+
+#include "Hal.h"
+#include "1802.h"
+#include "LcdEmulator.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#define COL 16
+#define ROW 2
+
+//I2C traffic of the Observer display, in writes queued by CSE321_LCD and bytes including the address bytes
+#define OBSERVER_FIRST_FRAME_WRITES    19      //both rows of both pages on a blank display: 10 runs of text, and 9 cursor moves
+#define OBSERVER_FIRST_FRAME_BYTES     95
+#define OBSERVER_NEW_SECOND_WRITES     2       //one cursor move and one character
+#define OBSERVER_NEW_SECOND_BYTES      6
+#define OBSERVER_NEW_MINUTE_WRITES     4       //the runs "8" and "00", each after a cursor move
+#define OBSERVER_NEW_MINUTE_BYTES      13
+#define OBSERVER_SAME_FRAME_WRITES     0
+#define PAGE_SWITCH_WRITES             1       //16 display shift commands in one transfer
+#define PAGE_SWITCH_BYTES              33
+#define PAGE_RETURN_WRITES             1       //return home
+#define PAGE_RETURN_BYTES              3
+
+#define BUSY_DEVICE_ADDRESS            0xA0    //a device model that holds the bus in each write until it is let go
+#define MERGE_POSTERS                  4       //threads that post mergeable writes at once
+#define MERGE_ROUNDS                   2000    //writes posted by each of them
+
+int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+#define CHECK_ROW(display, line, text) checkText((display).row(line), (text), __LINE__)
+
+void check(bool passed, const char* condition, int line){
+    if(!passed){
+        printf("FAIL line %d: %s\n", line, condition);
+        failures++;
+    }
+}
+
+void checkText(const std::string& shown, const char* expected, int line){
+    if(shown != expected){
+        printf("FAIL line %d: shown \"%s\", expected \"%s\"\n", line, shown.c_str(), expected);
+        failures++;
+    }
+}
+
+I2CBus i2cBus(PB_9, PB_8);
+LcdEmulator emulator(COL, ROW);
+CSE321_LCD<COL, ROW> lcdObject(i2cBus, LCD_5x8DOTS, LCD_I2C_FAST);
+
+
+//the LCD starts at the requested frequency, two lines, display on, blank, with the backlight LEDs under PWM control
+void checkStartup(){
+    lcdObject.begin();
+    lcdObject.flush();
+
+    CHECK(emulator.initialized());
+    CHECK(emulator.twoLine());
+    CHECK(emulator.displayOn());
+    CHECK(emulator.frequency() == LCD_I2C_FAST);
+    CHECK(lcdObject.frequency() == LCD_I2C_FAST);
+    CHECK(emulator.backlightRegister(RGB_REG_MODE1) == 0);
+    CHECK(emulator.backlightRegister(RGB_REG_LEDOUT) == RGB_LEDOUT_PWM);
+    CHECK_ROW(emulator, 0, "                ");
+    CHECK_ROW(emulator, 1, "                ");
+}
+
+
+//text lands where the cursor was set, and updateRow only rewrites what changed
+void checkText(){
+    lcdObject.clear();
+    lcdObject.setCursor(0, 0);
+    lcdObject.print("Hello");
+    lcdObject.setCursor(11, 1);
+    lcdObject.print("World");
+    lcdObject.flush();
+    CHECK_ROW(emulator, 0, "Hello           ");
+    CHECK_ROW(emulator, 1, "           World");
+
+    lcdObject.clear();
+    lcdObject.updateRow(0, "Space       Time");
+    lcdObject.updateRow(1, "042%    13:07:59");
+    lcdObject.flush();
+    CHECK_ROW(emulator, 0, "Space       Time");
+    CHECK_ROW(emulator, 1, "042%    13:07:59");
+
+    CHECK(lcdObject.updateRow(1, "042%    13:08:00") == 3);
+    lcdObject.flush();
+    CHECK_ROW(emulator, 1, "042%    13:08:00");
+}
+
+
+//a hidden page is written without being seen, and a display shift brings it into view
+void checkPages(){
+    lcdObject.clear();
+    lcdObject.updatePage(0, 0, "Page zero row 0 ");
+    lcdObject.updatePage(1, 0, "Page one row 0  ");
+    lcdObject.updatePage(1, 1, "Page one row 1  ");
+    lcdObject.flush();
+    CHECK_ROW(emulator, 0, "Page zero row 0 ");
+
+    lcdObject.showPage(1);
+    lcdObject.flush();
+    CHECK(emulator.displayShift() == COL);
+    CHECK_ROW(emulator, 0, "Page one row 0  ");
+    CHECK_ROW(emulator, 1, "Page one row 1  ");
+
+    lcdObject.showPage(0);
+    lcdObject.flush();
+    CHECK(emulator.displayShift() == 0);
+    CHECK_ROW(emulator, 0, "Page zero row 0 ");
+}
+
+
+//the bar glyphs are uploaded to CGRAM once, and printed through their character codes
+void checkGlyphs(){
+    lcdObject.clear();
+    lcdObject.loadBarGlyphs();
+    char bar[COL + 1] = {};
+    CSE321_LCDController::renderBar(bar, COL, 42, 100);
+    lcdObject.updateRow(0, bar);
+    lcdObject.flush();
+
+    for(int dots = 1; dots < LCD_BAR_STEPS; dots++){
+        const unsigned char* glyph = emulator.glyph(LCD_BAR_FIRST_SLOT + dots - 1);
+        for(int line = 0; line < LCD_GLYPH_ROWS; line++){
+            CHECK(glyph[line] == ((0x1F << (LCD_BAR_STEPS - dots)) & 0x1F));
+        }
+    }
+    CHECK(emulator.row(0) == std::string(bar));
+
+    unsigned int writes = lcdObject.transactions();
+    lcdObject.loadBarGlyphs();
+    CHECK(lcdObject.transactions() == writes);          //the glyphs are cached
+}
+
+
+//the backlight color reaches the PWM registers, and a repeated color costs nothing
+void checkBacklight(){
+    lcdObject.setRGB(10, 20, 30);
+    lcdObject.flush();
+    CHECK(emulator.red() == 10);
+    CHECK(emulator.green() == 20);
+    CHECK(emulator.blue() == 30);
+
+    unsigned long writes = emulator.backlight().transactions;
+    lcdObject.setRGB(10, 20, 30);
+    lcdObject.flush();
+    CHECK(emulator.backlight().transactions == writes);
+}
+
+
+/**
+ * void checkTraffic(const char* step, unsigned int writes, unsigned int bytes, unsigned int expectedWrites, unsigned int expectedBytes, int line)
+ *
+ * Summary of the function:
+ *    This function checks the writes and bytes CSE321_LCD queued since the start of a frame against the pinned
+ *      cost, checks that the emulated bus carried no more, and prints both.
+ */
+void checkTraffic(const char* step, unsigned int writes, unsigned int bytes, unsigned int expectedWrites, unsigned int expectedBytes, int line){
+    lcdObject.flush();
+    printf("%-22s queued %2u writes %3u bytes, bus %2lu transactions %3lu bytes %6.1f us\n",
+           step, writes, bytes, emulator.frameTransactions(), emulator.frameBytes(), emulator.frameBusTimeUs());
+    if(writes != expectedWrites || bytes != expectedBytes){
+        printf("FAIL line %d: %s cost %u writes %u bytes, pinned at %u writes %u bytes\n", line, step, writes, bytes, expectedWrites, expectedBytes);
+        failures++;
+    }
+    CHECK(emulator.frameTransactions() <= writes);
+    CHECK(emulator.frameBytes() <= bytes);
+}
+
+#define FRAME(step, expectedWrites, expectedBytes, ...) do{                                     \
+        lcdObject.flush();                                                                      \
+        emulator.beginFrame();                                                                  \
+        unsigned int writes = lcdObject.transactions();                                         \
+        unsigned int bytes = lcdObject.busBytes();                                              \
+        __VA_ARGS__;                                                                            \
+        checkTraffic(step, lcdObject.transactions() - writes, lcdObject.busBytes() - bytes,     \
+                     expectedWrites, expectedBytes, __LINE__);                                  \
+    }while(0)
+
+
+//the display refreshes of the Observer state, as populateLcdOutput sends them
+void checkObserverTraffic(){
+    lcdObject.clear();
+
+    FRAME("first Observer frame", OBSERVER_FIRST_FRAME_WRITES, OBSERVER_FIRST_FRAME_BYTES,
+          lcdObject.updatePage(0, 0, "Space       Time");
+          lcdObject.updatePage(0, 1, "042%    13:07:58");
+          lcdObject.updatePage(1, 0, "Poll 09/s Fill =");
+          lcdObject.updatePage(1, 1, "Closes  22:00:00"));
+    CHECK_ROW(emulator, 1, "042%    13:07:58");
+
+    FRAME("new second", OBSERVER_NEW_SECOND_WRITES, OBSERVER_NEW_SECOND_BYTES,
+          lcdObject.updatePage(0, 0, "Space       Time");
+          lcdObject.updatePage(0, 1, "042%    13:07:59");
+          lcdObject.updatePage(1, 0, "Poll 09/s Fill =");
+          lcdObject.updatePage(1, 1, "Closes  22:00:00"));
+
+    FRAME("new minute", OBSERVER_NEW_MINUTE_WRITES, OBSERVER_NEW_MINUTE_BYTES,
+          lcdObject.updatePage(0, 1, "042%    13:08:00"));
+    CHECK_ROW(emulator, 1, "042%    13:08:00");
+
+    FRAME("unchanged frame", OBSERVER_SAME_FRAME_WRITES, 0,
+          lcdObject.updatePage(0, 0, "Space       Time");
+          lcdObject.updatePage(0, 1, "042%    13:08:00"));
+
+    FRAME("switch to details", PAGE_SWITCH_WRITES, PAGE_SWITCH_BYTES,
+          lcdObject.showPage(1));
+    CHECK_ROW(emulator, 0, "Poll 09/s Fill =");
+    CHECK_ROW(emulator, 1, "Closes  22:00:00");
+
+    FRAME("switch back", PAGE_RETURN_WRITES, PAGE_RETURN_BYTES,
+          lcdObject.showPage(0));
+    CHECK_ROW(emulator, 0, "Space       Time");
+}
+
+
+//rows 2 and 3 of a 20x4 panel continue DDRAM lines 0 and 1
+void checkFourRows(){
+    emulator.detach();
+    I2CBus* bus = new I2CBus(PB_9, PB_8);       //never freed, as its thread runs until exit
+    LcdEmulator fourRows(20, 4);
+    fourRows.attach();
+    CSE321_LCD<20, 4> panel(*bus, LCD_5x8DOTS, LCD_I2C_FAST);
+    panel.begin();
+    panel.updateRow(0, "Row zero            ");
+    panel.updateRow(1, "Row one             ");
+    panel.updateRow(2, "Row two             ");
+    panel.updateRow(3, "Row three           ");
+    panel.flush();
+
+    CHECK_ROW(fourRows, 0, "Row zero            ");
+    CHECK_ROW(fourRows, 1, "Row one             ");
+    CHECK_ROW(fourRows, 2, "Row two             ");
+    CHECK_ROW(fourRows, 3, "Row three           ");
+    CHECK(fourRows.errors().empty());
+    fourRows.detach();
+    emulator.attach();
+}
+
+
+//every malformed transfer is reported instead of being decoded
+void checkMalformed(){
+    emulator.detach();
+    LcdEmulator lenient(COL, ROW);
+    lenient.setStrict(false);
+    lenient.attach();
+    I2C raw(PB_9, PB_8);
+
+    const char dataFirst[] = {0x40, 'A'};
+    raw.write(LCD_ADDRESS_1802, dataFirst, sizeof(dataFirst));
+    CHECK(lenient.errors().size() == 1);                //data before the function set
+
+    const char functionSet[] = {(char)0x80, LCD_FUNCTIONSET | LCD_2LINE};
+    raw.write(LCD_ADDRESS_1802, functionSet, sizeof(functionSet));
+    CHECK(lenient.errors().size() == 1);
+
+    const char endsOnControl[] = {(char)0x80, LCD_RETURNHOME, (char)0x80};
+    raw.write(LCD_ADDRESS_1802, endsOnControl, sizeof(endsOnControl));
+    CHECK(lenient.errors().size() == 2);
+
+    const char reservedBits[] = {0x41, 'A'};
+    raw.write(LCD_ADDRESS_1802, reservedBits, sizeof(reservedBits));
+    CHECK(lenient.errors().size() == 3);
+
+    const char offTheLine[] = {(char)0x80, (char)(LCD_SETDDRAMADDR | 0x28)};
+    raw.write(LCD_ADDRESS_1802, offTheLine, sizeof(offTheLine));
+    CHECK(lenient.errors().size() == 4);
+
+    const char rgbTooLong[] = {RED_REG, 1, 2};
+    raw.write(RGB_ADDRESS, rgbTooLong, sizeof(rgbTooLong));
+    CHECK(lenient.errors().size() == 5);
+
+    const char rgbRegister[] = {0x09, 1};
+    raw.write(RGB_ADDRESS, rgbRegister, sizeof(rgbRegister));
+    CHECK(lenient.errors().size() == 6);
+
+    //a well formed transfer after the errors still decodes
+    const char wellFormed[] = {(char)0x80, LCD_SETDDRAMADDR | 0x40, 0x40, 'O', 'K'};
+    raw.write(LCD_ADDRESS_1802, wellFormed, sizeof(wellFormed));
+    CHECK(lenient.errors().size() == 6);
+    CHECK(lenient.ddram(1, 0) == 'O' && lenient.ddram(1, 1) == 'K');
+
+    for(const std::string& error : lenient.errors()) printf("reported: %s\n", error.c_str());
+    lenient.detach();
+    emulator.attach();
+}
+
+
+//a device model whose writes do not return until the test lets them, to queue requests while a transaction runs
+class BusyDevice : public HostI2CDevice {
+public:
+    int i2cWrite(int address, const char* data, int length) override {
+        writes++;
+        bytes += length;
+        if(heldWrites > 0){
+            heldWrites--;
+            entered.release();
+            proceed.acquire();
+        }
+        return 0;
+    }
+    int i2cRead(int address, char* data, int length) override {return 0;}
+
+    std::atomic<int> writes{0};
+    std::atomic<int> bytes{0};
+    std::atomic<int> heldWrites{0}; //the next writes to hold
+    Semaphore entered{0};           //released as a held write starts
+    Semaphore proceed{0};           //lets a held write return
+};
+
+
+//posted writes queued while a transaction runs are merged into one transaction, every merged request frees its
+//slot once, and the bus thread is not woken with nothing to run by the tokens of merged requests
+void checkBusMergeWhileBusy(){
+    BusyDevice device;
+    device.attach(BUSY_DEVICE_ADDRESS);
+    int client = i2cBus.addClient("busy test", I2CBus::DisplayPriority);
+    const char first[] = {0x40, '0'};
+
+    //eight writes of one prefix, queued behind a held write, are one transaction
+    device.heldWrites = 1;
+    i2cBus.post(client, BUSY_DEVICE_ADDRESS, first, sizeof(first), 1);
+    device.entered.acquire();
+    for(int i = 0; i < 8; i++){
+        const char next[] = {0x40, (char)('1' + i)};
+        i2cBus.post(client, BUSY_DEVICE_ADDRESS, next, sizeof(next), 1);
+    }
+    device.proceed.release();
+    i2cBus.flush(client);
+    CHECK(device.writes == 2);
+    CHECK(device.bytes == 2 + 1 + 8);
+    CHECK(i2cBus.statistics(client).batched == 7);
+
+    //mergeable writes posted by several threads as fast as the bus thread takes them: every byte arrives once
+    std::thread posters[MERGE_POSTERS];
+    for(std::thread& poster : posters){
+        poster = std::thread([client](){
+            for(int round = 0; round < MERGE_ROUNDS; round++){
+                const char next[] = {0x40, (char)('a' + round % 26)};
+                i2cBus.post(client, BUSY_DEVICE_ADDRESS, next, sizeof(next), 1);
+                if(round % 4 == 0) std::this_thread::yield();
+            }
+        });
+    }
+    for(std::thread& poster : posters) poster.join();
+    i2cBus.flush(client);
+    I2CBus::ClientStatistics statistics = i2cBus.statistics(client);
+    CHECK(device.bytes == 2 + 1 + 8 + MERGE_POSTERS * MERGE_ROUNDS + (device.writes - 2));
+    CHECK(device.writes - 2 + (int)statistics.batched - 7 == MERGE_POSTERS * MERGE_ROUNDS);
+
+    //every slot is free again: a held write and I2CBusQueueDepth - 1 posts fill the queue without waiting, and one
+    //more post is queued once the held write completes.  A lost slot blocks one of the first posts, and the test
+    //runs into its timeout
+    device.writes = 0;
+    device.heldWrites = 1;
+    std::atomic<int> posted{0};
+    Semaphore queueFilled{0};           //released when the first I2CBusQueueDepth posts have returned
+    std::thread poster([&](){
+        for(int i = 0; i < I2CBusQueueDepth + 1; i++){
+            if(i == I2CBusQueueDepth) queueFilled.release();
+            const char separate[] = {0x00, (char)i};
+            i2cBus.post(client, BUSY_DEVICE_ADDRESS, separate, sizeof(separate));
+            posted++;
+        }
+    });
+    device.entered.acquire();
+    queueFilled.acquire();
+    CHECK(posted == I2CBusQueueDepth);
+    CHECK(device.writes == 1);          //the queue was filled behind the held write
+    device.proceed.release();
+    poster.join();
+    i2cBus.flush(client);
+    CHECK(posted == I2CBusQueueDepth + 1);
+    CHECK(device.writes == I2CBusQueueDepth + 1);
+    device.detach(BUSY_DEVICE_ADDRESS);
+}
+
+
+int main(){
+    emulator.attach();
+
+    checkStartup();
+    checkText();
+    checkPages();
+    checkGlyphs();
+    checkBacklight();
+    checkObserverTraffic();
+    checkFourRows();
+    checkMalformed();
+    checkBusMergeWhileBusy();
+
+    CHECK(emulator.errors().empty());
+    printf("%s: %d failed checks\n", failures ? "FAILED" : "PASSED", failures);
+
+    //the bus threads are blocked in their queues, and are not joined
+    fflush(stdout);
+    _exit(failures ? 1 : 0);
+}
@@ -2,33 +2,71 @@
 // *   File Name:      CSE321_project3_mnelyubo_buzzer_test.cpp                  *
 // *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)                     *
 // *   Date Created:   12/01/2021                                                *
-// *   Last Modified:  12/01/2021                                                *
+// *   Last Modified:  10/19/2026                                                *
 // *   Purpose:        This file tests the effect of various frequency inputs    *
 // *                     on the buzzer output.                                   *
 // *                   WARNING: Unpleasant sounds produced.                      *
-// *   Functions:                                                                *
+// *                   With SELF_MEASURE set to 1, it measures the square wave   *
+// *                     on PB_11 with a timer capture input instead, for every  *
+// *                     note of outputSoundTable, and reports the achieved      *
+// *                     frequency and duty cycle against the requested ones.    *
+// *                     A calibration of the software oscillator is fitted to   *
+// *                     the measurements, applied, and the notes are measured   *
+// *                     again with it.                                          *
+// *   Functions:      runBuzzer, configureCapture, captureIsr, measureNote,     *
+// *                     measureNotes, fitCalibration                            *
 // *                                                                             *
 // *   Assignment:     Project 3                                                 *
 // *                                                                             *
-// *   Inputs:         None                                                      *
+// *   Inputs:         None, or with SELF_MEASURE: PB_11 on PA_0                 *
 // *                                                                             *
-// *   Outputs:        Buzzer                                                    *
+// *   Outputs:        Buzzer, or with SELF_MEASURE: Serial printout             *
 // *                                                                             *
 // *   Constraints:                                                              *
 // *       The buzzer must be connected to the system with the following pins:   *
 // *                       GND - GND                                             *
 // *                       I/O - PB_11                                           *
 // *                       VCC - PB_10                                           *
+// *       With SELF_MEASURE, a jumper wire must also connect the following pins:
+// *                       PB_11 (buzzer output) - PA_0 (TIM5_CH1 capture input) *
+// *         and the buzzer is left unpowered, so the test is silent.            *
+// *       TIM5 runs from the 120 MHz timer clock, so the capture resolves       *
+// *         8.3 ns.  TIM2 is the microsecond ticker of Mbed OS on the STM32L4   *
+// *         and is not used.                                                    *
+// *       The oscillator loop below is the runBuzzer() of the main              *
+// *         implementation, with the same Mutex locks, so its calibration       *
+// *         applies to the main implementation.  To apply it:                   *
+// *           1. comment out the main implementation, uncomment this file and   *
+// *              set SELF_MEASURE to 1                                          *
+// *           2. run it, and check that the calibrated table passes             *
+// *           3. copy the three printed #define lines over the lines of the     *
+// *              same names under "//buzzer configuration" of the main          *
+// *              implementation, then comment this file out again               *
+// *         (see "Calibrating the Buzzer" in the README)                        *
 // *                                                                             *
 // *   References:                                                               *
 // *       Buzzer datasheet:                                                     *
 // *         https://www.mouser.com/datasheet/2/400/ef532_ps-13444.pdf           *
+// *       NUCLEO datasheet:                                                     *
+// *         https://www.st.com/resource/en/reference_manual/dm00310109-stm32l4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+// *         (TIM2/TIM3/TIM4/TIM5: PWM input mode)                               *
 // *                                                                             *
 // ******************************************************************************/
 
 // #include <mbed.h>
 
-// #define nanosecondsPerSecond 1000*1000*1000 
+// #ifndef SELF_MEASURE
+// #define SELF_MEASURE 0      //1: measure the oscillator on the capture input instead of playing the tune
+// #endif
+
+// #define nanosecondsPerSecond 1000*1000*1000
+
+// //self-measurement timing
+// #define noteSettleTime      20          /* ms after a note change before its periods are counted */
+// #define measureWindow       1000        /* ms of periods counted for each note */
+// #define minimumPeriods      4           /* periods counted for each note, at least, for the slowest notes */
+// #define measureTimeout      6000        /* ms after which a note without minimumPeriods is reported as it is */
+// #define frequencyTolerance  5           /* tenths of a percent of frequency error accepted after calibration */
 
 // Thread buzzerThread;
 // Thread alternatorThread;
@@ -122,25 +160,96 @@
 
 
 // int DUTY_CYCLE = 0;             //integer between 0 and 100 indicating what percent of the time the signal should be high
-
+// Mutex dutyCycleRW;              //mutex order: (8), as in the main implementation
 
 // DigitalOut alarm_Enable(PB_10);    //starts off with 0V. power to alarm disabled until the alarm state has been set to inactive
 // DigitalOut alarm_data_L(PB_11);      //starts off with 0V. active low component that produces a noise when active
 
 
 // int OSCILLATION_FREQ;      //frequency of digital signal oscillation in Hertz
+// Mutex oscillationFrequencyRW;   //mutex order: (9), as in the main implementation
+
+// //compensation of the software oscillator, as buzzerWaitScalePpm, buzzerHighOverheadNs and buzzerLowOverheadNs of
+// //the main implementation.  No compensation until fitCalibration sets them.  Read under oscillationFrequencyRW
+// int waitScalePpm = 1000000;     //ns that wait_ns takes per requested ns, in parts per million
+// int highOverheadNs = 0;         //ns of each period with the buzzer on beyond its wait_ns
+// int lowOverheadNs = 0;          //ns of each period with the buzzer off beyond its wait_ns
+
+// #if SELF_MEASURE
+// //the measured square wave of one note
+// struct NoteMeasurement {
+//     int frequency;              //requested (Hz)
+//     int dutyCycle;              //requested (%)
+//     int highWait;               //wait_ns of the active part of the period, after compensation (ns)
+//     int lowWait;                //wait_ns of the inactive part of the period, after compensation (ns)
+//     uint32_t periods;           //periods captured
+//     double periodNs;            //mean period
+//     double activeNs;            //mean time of each period with PB_11 low, the buzzer on
+//     uint32_t shortestTicks;     //shortest and longest period in timer ticks
+//     uint32_t longestTicks;
+// };
+
+// //sums of the periods captured since the last reset, written by captureIsr
+// volatile uint32_t capturedPeriods = 0;
+// volatile unsigned long long capturedPeriodTicks = 0;
+// volatile unsigned long long capturedActiveTicks = 0;
+// volatile uint32_t shortestPeriodTicks = 0;
+// volatile uint32_t longestPeriodTicks = 0;
+// volatile bool discardCapture = true;    //the first capture after a reset spans the change of note
+
+// NoteMeasurement uncalibrated[frequencyTableLength];
+// NoteMeasurement calibrated[frequencyTableLength];
+
+// void configureCapture();
+// void captureIsr();
+// NoteMeasurement measureNote(int frequency, int dutyCycle);
+// int measureNotes(NoteMeasurement* results);
+// void fitCalibration(const NoteMeasurement* results, int noteCount);
+// void printNotes(const char* title, const NoteMeasurement* results, int noteCount);
+// #endif
+
+// //the ns to wait_ns for a part of the period, after the compensation of the loop and of wait_ns itself
+// int compensatedWait(int partNs, int overheadNs, int scalePpm){
+//     long long wait = (long long)(partNs - overheadNs) * 1000000 / scalePpm;
+//     return wait > 0 ? (int)wait : 0;
+// }
 
 // int main() {
 //     alarm_data_L.write(1);   //start the alarm in a disabled state (active low -> 1 disables)
+
+// #if SELF_MEASURE
+//     printf("\n\n=== Buzzer Self-Measurement (PB_11 -> PA_0) ===\n");
+//     OSCILLATION_FREQ = outputSoundTable[tableOffsetFreq];   //the buzzer stays unpowered
+//     configureCapture();
+//     buzzerThread.start(runBuzzer);
+
+//     int noteCount = measureNotes(uncalibrated);
+//     printNotes("uncalibrated", uncalibrated, noteCount);
+//     fitCalibration(uncalibrated, noteCount);
+//     printf("\nCalibration of the software oscillator.  Copy these lines over the lines of the same names\n");
+//     printf("under \"//buzzer configuration\" of the main implementation once the calibrated notes pass:\n");
+//     printf("    #define buzzerWaitScalePpm    %d\n", waitScalePpm);
+//     printf("    #define buzzerHighOverheadNs  %d\n", highOverheadNs);
+//     printf("    #define buzzerLowOverheadNs   %d\n", lowOverheadNs);
+
+//     measureNotes(calibrated);
+//     printNotes("calibrated", calibrated, noteCount);
+//     printf("=== Done ===\n");
+//     while(true){thread_sleep_for(1000);}
+// #else
 //     alarm_Enable.write(1); //supply power to alarm
-    
+
 //     buzzerThread.start(runBuzzer);      //set the buzzer execution thread to oscillate I/O at the variable oscillation frequency
 
 //     int currentNoteIndex = 0;
 //     int waitTime = 0;       //time (ms) to wait before switching to the next note
 //     while(1) {
+//         oscillationFrequencyRW.lock();  //(9)
 //         OSCILLATION_FREQ = outputSoundTable[frequencyTableFields * currentNoteIndex + tableOffsetFreq];     //switch the frequency to the next table value
+//         oscillationFrequencyRW.unlock();    //(9)
+//         dutyCycleRW.lock();     //(8)
 //         DUTY_CYCLE = outputSoundTable[frequencyTableFields * currentNoteIndex + tableOffsetDutyCycle];      //switch the duty cycle to the next table value
+//         dutyCycleRW.unlock();   //(8)
 //         waitTime = outputSoundTable[frequencyTableFields * currentNoteIndex + tableOffsetDuration];         //switch the duration to the next table value
 
 //         // printf("New operating frequency: %d Hz\n",OSCILLATION_FREQ);
@@ -148,18 +257,232 @@
 //         thread_sleep_for(waitTime);                                         //idle for the designated note duration before proceeding
 //         currentNoteIndex = (currentNoteIndex + 1) % frequencyTableLength;                                   //proceed to next table value in next cycle of while loop
 //     }
+// #endif
 
 //   return 0;
 // }
 
+// //the runBuzzer() of the main implementation, with the compensation read from variables so that it can be fitted
 // void runBuzzer(){
 //     while(1) {
-//         int Period = nanosecondsPerSecond / (OSCILLATION_FREQ);
-//         int highPeriod = Period * DUTY_CYCLE / 100;
-//         int lowPeriod = Period - highPeriod;        //ensure that low period + high period time adds to period time 
+//         dutyCycleRW.lock();                 //(8)
+//         oscillationFrequencyRW.lock();      //(9)
+//         int localDutyCycle = DUTY_CYCLE;
+//         int localFrequency = OSCILLATION_FREQ;
+//         int localScalePpm = waitScalePpm;
+//         int localHighOverhead = highOverheadNs;
+//         int localLowOverhead = lowOverheadNs;
+//         oscillationFrequencyRW.unlock();    //(9)
+//         dutyCycleRW.unlock();               //(8)
+
+//         int Period = nanosecondsPerSecond / localFrequency;
+//         int highPeriod = Period * localDutyCycle / 100;
+//         int lowPeriod = Period - highPeriod;        //ensure that low period + high period time adds to period time
+//         int highWait = compensatedWait(highPeriod, localHighOverhead, localScalePpm);
+//         int lowWait = compensatedWait(lowPeriod, localLowOverhead, localScalePpm);
 //         alarm_data_L.write(0);
-//         wait_ns(highPeriod);
+//         wait_ns(highWait);
 //         alarm_data_L.write(1);
-//         wait_ns(lowPeriod);
+//         wait_ns(lowWait);
+//     }
+// }
+
+// #if SELF_MEASURE
+// /**
+//  * void configureCapture()
+//  * non-ISR function
+//  *
+//  * Summary of the function:
+//  *    This function sets TIM5 up in PWM input mode on PA_0: both capture channels take the input, the falling
+//  *      edge that switches the buzzer on captures the period into CCR1 and resets the counter, and the rising
+//  *      edge that switches it off captures the active time into CCR2.  Each period interrupts captureIsr.
+//  */
+// void configureCapture(){
+//     RCC->AHB2ENR |= RCC_AHB2ENR_GPIOAEN;
+//     RCC->APB1ENR1 |= RCC_APB1ENR1_TIM5EN;
+//     GPIOA->MODER = (GPIOA->MODER & ~0x3u) | 0x2u;          //PA_0 alternate function
+//     GPIOA->AFR[0] = (GPIOA->AFR[0] & ~0xFu) | 0x2u;        //AF2: TIM5_CH1
+
+//     TIM5->PSC = 0;                                          //count the 120 MHz timer clock
+//     TIM5->ARR = 0xFFFFFFFF;                                 //32 bits: 35 s before a period overflows
+//     TIM5->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_CC2S_1;     //IC1 on TI1, IC2 on TI1
+//     TIM5->CCER = TIM_CCER_CC1P | TIM_CCER_CC1E | TIM_CCER_CC2E;    //IC1 on the falling edge, IC2 on the rising edge
+//     TIM5->SMCR = TIM_SMCR_TS_2 | TIM_SMCR_TS_0 | TIM_SMCR_SMS_2;   //reset the counter on TI1FP1, the falling edge
+//     TIM5->EGR = TIM_EGR_UG;
+//     TIM5->DIER = TIM_DIER_CC1IE;
+//     NVIC_SetVector(TIM5_IRQn, (uint32_t)&captureIsr);
+//     NVIC_EnableIRQ(TIM5_IRQn);
+//     TIM5->CR1 = TIM_CR1_CEN;
+// }
+
+// //adds each captured period to the sums
+// void captureIsr(){
+//     if(!(TIM5->SR & TIM_SR_CC1IF)) return;
+//     uint32_t period = TIM5->CCR1;           //reading CCR1 clears CC1IF
+//     uint32_t active = TIM5->CCR2;           //the rising edge of the period that just ended
+//     if(discardCapture){
+//         discardCapture = false;
+//         return;
+//     }
+//     if(capturedPeriods == 0 || period < shortestPeriodTicks) shortestPeriodTicks = period;
+//     if(period > longestPeriodTicks) longestPeriodTicks = period;
+//     capturedPeriodTicks += period;
+//     capturedActiveTicks += active;
+//     capturedPeriods++;
+// }
+
+
+// /**
+//  * NoteMeasurement measureNote(int frequency, int dutyCycle)
+//  * non-ISR function
+//  *
+//  * Summary of the function:
+//  *    This function switches the oscillator to the note, lets it settle, and counts its periods on the capture
+//  *      input for measureWindow, or longer for the slowest notes until minimumPeriods are counted.
+//  *
+//  * Return value:
+//  *    The means of the counted periods, in ns
+//  */
+// NoteMeasurement measureNote(int frequency, int dutyCycle){
+//     dutyCycleRW.lock();                 //(8)
+//     oscillationFrequencyRW.lock();      //(9)
+//     DUTY_CYCLE = dutyCycle;
+//     OSCILLATION_FREQ = frequency;
+//     int period = nanosecondsPerSecond / frequency;
+//     int highPeriod = period * dutyCycle / 100;
+//     NoteMeasurement note = {frequency, dutyCycle, compensatedWait(highPeriod, highOverheadNs, waitScalePpm),
+//                             compensatedWait(period - highPeriod, lowOverheadNs, waitScalePpm), 0, 0, 0, 0, 0};
+//     oscillationFrequencyRW.unlock();    //(9)
+//     dutyCycleRW.unlock();               //(8)
+//     thread_sleep_for(noteSettleTime);
+
+//     core_util_critical_section_enter();
+//     capturedPeriods = 0;
+//     capturedPeriodTicks = 0;
+//     capturedActiveTicks = 0;
+//     shortestPeriodTicks = 0;
+//     longestPeriodTicks = 0;
+//     discardCapture = true;
+//     core_util_critical_section_exit();
+//     thread_sleep_for(measureWindow);
+//     for(int waited = measureWindow; capturedPeriods < minimumPeriods && waited < measureTimeout; waited += 10) thread_sleep_for(10);
+
+//     core_util_critical_section_enter();
+//     double nsPerTick = 1e9 / SystemCoreClock;
+//     note.periods = capturedPeriods;
+//     if(capturedPeriods > 0){
+//         note.periodNs = capturedPeriodTicks * nsPerTick / capturedPeriods;
+//         note.activeNs = capturedActiveTicks * nsPerTick / capturedPeriods;
+//     }
+//     note.shortestTicks = shortestPeriodTicks;
+//     note.longestTicks = longestPeriodTicks;
+//     core_util_critical_section_exit();
+//     return note;
+// }
+
+
+// //measures each distinct note of outputSoundTable once, in the order of the table, and returns the number of notes
+// int measureNotes(NoteMeasurement* results){
+//     int noteCount = 0;
+//     for(int index = 0; index < frequencyTableLength; index++){
+//         int frequency = outputSoundTable[frequencyTableFields * index + tableOffsetFreq];
+//         int dutyCycle = outputSoundTable[frequencyTableFields * index + tableOffsetDutyCycle];
+//         bool measured = false;
+//         for(int note = 0; note < noteCount; note++){
+//             if(results[note].frequency == frequency && results[note].dutyCycle == dutyCycle) measured = true;
+//         }
+//         if(!measured) results[noteCount++] = measureNote(frequency, dutyCycle);
+//     }
+//     return noteCount;
+// }
+
+
+// /**
+//  * void fitCalibration(const NoteMeasurement* results, int noteCount)
+//  * non-ISR function
+//  *
+//  * Summary of the function:
+//  *    This function fits the uncalibrated measurements to the model of the oscillator: a period takes
+//  *      scale * (high wait + low wait) + high overhead + low overhead, and its active part takes
+//  *      scale * high wait + high overhead.  The scale and the sum of the overheads are the least squares line
+//  *      of the measured against the requested period, and the high overhead is the mean active time beyond the
+//  *      scaled high wait.  The fit is written to the compensation variables that runBuzzer reads.
+//  */
+// void fitCalibration(const NoteMeasurement* results, int noteCount){
+//     double n = 0, sumRequested = 0, sumMeasured = 0, sumRequestedSquared = 0, sumProduct = 0;
+//     for(int note = 0; note < noteCount; note++){
+//         if(results[note].periods == 0) continue;
+//         double requested = results[note].highWait + results[note].lowWait;
+//         n++;
+//         sumRequested += requested;
+//         sumMeasured += results[note].periodNs;
+//         sumRequestedSquared += requested * requested;
+//         sumProduct += requested * results[note].periodNs;
+//     }
+//     double spread = n * sumRequestedSquared - sumRequested * sumRequested;
+//     if(n < 2 || spread <= 0){
+//         printf("FAIL: too few notes were captured to calibrate.  Is PB_11 connected to PA_0?\n");
+//         return;
+//     }
+//     double scale = (n * sumProduct - sumRequested * sumMeasured) / spread;
+//     double overhead = (sumMeasured - scale * sumRequested) / n;
+
+//     double highOverhead = 0;
+//     for(int note = 0; note < noteCount; note++){
+//         if(results[note].periods > 0) highOverhead += results[note].activeNs - scale * results[note].highWait;
+//     }
+//     highOverhead /= n;
+
+//     oscillationFrequencyRW.lock();      //(9)
+//     waitScalePpm = (int)(scale * 1000000 + 0.5);
+//     highOverheadNs = (int)(highOverhead + 0.5);
+//     lowOverheadNs = (int)(overhead - highOverhead + 0.5);
+//     oscillationFrequencyRW.unlock();    //(9)
+// }
+
+
+// //prints a value in hundredths with two decimals, such as a frequency in Hz or an error in percent
+// void printHundredths(long long hundredths){
+//     const char* sign = hundredths < 0 ? "-" : "";
+//     if(hundredths < 0) hundredths = -hundredths;
+//     printf("%s%ld.%02ld", sign, (long)(hundredths / 100), (long)(hundredths % 100));
+// }
+
+
+// /**
+//  * void printNotes(const char* title, const NoteMeasurement* results, int noteCount)
+//  * non-ISR function
+//  *
+//  * Summary of the function:
+//  *    This function prints, for each note, the requested frequency and duty cycle, the wait_ns of the two parts
+//  *      of the period, and the achieved frequency, frequency error, duty cycle and period jitter (longest less
+//  *      shortest period).  A note passes if its frequency is within frequencyTolerance of the request.  The duty
+//  *      cycle of a 0% note is the overhead of the loop, and is not compensated.
+//  */
+// void printNotes(const char* title, const NoteMeasurement* results, int noteCount){
+//     printf("\n--- %s ---\n", title);
+//     printf("Hz\tduty %%\thigh ns\tlow ns\tperiods\tachieved Hz\terror %%\tduty %%\tjitter us\tresult\n");
+//     int passed = 0;
+//     for(int note = 0; note < noteCount; note++){
+//         const NoteMeasurement& result = results[note];
+//         printf("%d\t%d\t%d\t%d\t%lu\t", result.frequency, result.dutyCycle, result.highWait, result.lowWait, (unsigned long)result.periods);
+//         if(result.periods == 0){
+//             printf("-\t\t-\t-\t-\t\tFAIL\n");
+//             continue;
+//         }
+//         double achievedHz = 1e9 / result.periodNs;
+//         double errorPercent = (achievedHz - result.frequency) * 100 / result.frequency;
+//         printHundredths((long long)(achievedHz * 100 + 0.5));
+//         printf("\t\t");
+//         printHundredths((long long)(errorPercent * 100 + (errorPercent < 0 ? -0.5 : 0.5)));
+//         printf("\t");
+//         printHundredths((long long)(result.activeNs * 10000 / result.periodNs + 0.5));
+//         printf("\t");
+//         printHundredths((long long)(result.longestTicks - result.shortestTicks) * 100 / (SystemCoreClock / 1000000));
+//         bool correct = errorPercent * 10 <= frequencyTolerance && errorPercent * 10 >= -frequencyTolerance;
+//         printf("\t\t%s\n", correct ? "PASS" : "FAIL");
+//         if(correct) passed++;
 //     }
+//     printf("%d of %d notes within %d.%d%% of their frequency\n", passed, noteCount, frequencyTolerance / 10, frequencyTolerance % 10);
 // }
+// #endif
@@ -0,0 +1,169 @@
+// /******************************************************************************
+// *   File Name:      CSE321_project3_mnelyubo_keypad_rate_test.cpp
+// *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+// *   Date Created:   10/19/2026
+// *   Last Modified:  10/19/2026
+// *   Purpose:        This program benchmarks the maximum sustained rate of key
+// *                     presses that the timestamp-based keypad debounce accepts
+// *                     without dropping or duplicating a press, and how many
+// *                     bounce edges the ISR-level column mask suppresses before
+// *                     they reach the event queue.
+// *
+// *   Functions:
+// *
+// *   Assignment:     Project 3
+// *
+// *   Inputs:         Simulated key on PC_0, driven by PC_10
+// *
+// *   Outputs:        Serial printout
+// *
+// *   Constraints:    The keypad must be disconnected from PC_0 and a jumper wire
+// *                     connected between the following pins:
+// *                       PC_10 (simulated key output) - PC_0 (keypad column input)
+// *                   Every simulated press and release is followed by a burst
+// *                     of contact bounce edges.
+// *
+// *   References:
+// *       NUCLEO datasheet:                  https://www.st.com/resource/en/reference_manual/dm00310109-stm32l4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+// *       MBED OS API: Kernel                https://os.mbed.com/docs/mbed-os/v6.15/apis/kernel-interface-functions.html
+// *
+// ******************************************************************************/
+
+// #include "mbed.h"
+// #include <chrono>
+
+// //keypad bounce window (ms) under test, as in the main implementation
+// #define bounceTimeoutWindow 30
+
+// //EXTI line of PC_0 and the time it stays masked after an edge, as in the main implementation
+// #define columnExtiLine 0x01
+// #define columnEdgeMaskTime 2ms
+
+// //simulated key timing
+// #define pressesPerRate      50      /* presses generated at each tested rate */
+// #define pressDutyCycle      50      /* percent of each key period that the key is held down */
+// #define bounceEdges         6       /* number of extra edges after every press and release */
+// #define bounceEdgeSpacingUs 150     /* time between bounce edges (us) */
+// #define firstRate           5       /* keys per second */
+// #define lastRate            40      /* keys per second */
+// #define rateStep            1       /* keys per second */
+
+// Thread matrixThread;                                    //thread to execute the debounce in the same way as the main implementation
+// EventQueue matrixOpsEventQueue(32 * EVENTS_EVENT_SIZE);
+
+// InterruptIn column(PC_0, PullDown);     //keypad column input under test
+// DigitalOut simulatedKey(PC_10);         //drives the keypad column input through a jumper wire
+
+// char charPressed = '\0';                        //the character that is currently pressed
+// Kernel::Clock::time_point lastKeyEdgeTime;      //the time of the last accepted press or release of the simulated key
+// int acceptedPresses = 0;                        //the number of presses accepted by the debounce at the current rate
+// int edgesReceived = 0;                          //the number of interrupts received at the current rate
+// int eventsEnqueued = 0;                         //the number of edge events enqueued at the current rate
+// int columnReportedLevel = 0;                    //the level of the column after the last enqueued edge
+// Timeout columnMaskTimeout;                      //re-enables the EXTI line of the column after an edge
+// int keysPerSecond = 0;                          //the rate at which the simulated key is currently pressed
+
+// void handleMatrixButtonEvent(bool isRisingEdgeInterrupt, Kernel::Clock::time_point edgeTime);
+// void confirmKeyRelease();
+// void generateKeyPresses();
+// void bounceKey(int finalLevel);
+
+// //same masking as reportColumnEdge and unmaskColumnEdges in the main implementation
+// void unmaskColumnEdges();
+// void reportColumnEdge(bool isRisingEdgeInterrupt){
+//     core_util_critical_section_enter();
+//     EXTI->IMR1 &= ~columnExtiLine;
+//     core_util_critical_section_exit();
+//     columnMaskTimeout.attach(&unmaskColumnEdges, columnEdgeMaskTime);
+//     columnReportedLevel = isRisingEdgeInterrupt;
+//     if(matrixOpsEventQueue.call(handleMatrixButtonEvent, isRisingEdgeInterrupt, Kernel::Clock::now())) eventsEnqueued++;
+// }
+
+// void unmaskColumnEdges(){
+//     core_util_critical_section_enter();
+//     EXTI->PR1 = columnExtiLine;
+//     EXTI->IMR1 |= columnExtiLine;
+//     core_util_critical_section_exit();
+//     if(column.read() != columnReportedLevel) reportColumnEdge(column.read());
+// }
+
+// void rising_isr(){edgesReceived++; reportColumnEdge(true);}
+// void falling_isr(){edgesReceived++; reportColumnEdge(false);}
+
+// int main(){
+//     printf("\n\n=== Keypad Rate Test (bounce window %d ms) ===\n", bounceTimeoutWindow);
+//     matrixThread.start(callback(&matrixOpsEventQueue, &EventQueue::dispatch_forever));
+//     column.rise(&rising_isr);
+//     column.fall(&falling_isr);
+
+//     int maximumCorrectRate = 0;
+//     printf("keys/s\texpected\taccepted\tedges\tenqueued\tresult\n");
+//     for(int rate = firstRate; rate <= lastRate; rate += rateStep){
+//         acceptedPresses = 0;
+//         edgesReceived = 0;
+//         eventsEnqueued = 0;
+//         keysPerSecond = rate;
+//         Thread generatorThread(osPriorityRealtime);     //thread that toggles the simulated key.  Threads cannot be restarted, so one is created per rate
+//         generatorThread.start(&generateKeyPresses);
+//         generatorThread.join();
+//         thread_sleep_for(2 * bounceTimeoutWindow);  //let the last release settle
+
+//         bool correct = acceptedPresses == pressesPerRate;
+//         printf("%d\t%d\t\t%d\t\t%d\t%d\t\t%s\n", rate, pressesPerRate, acceptedPresses, edgesReceived, eventsEnqueued, correct ? "PASS" : "FAIL");
+//         if(correct && maximumCorrectRate == rate - rateStep) maximumCorrectRate = rate;   //sustained: every slower rate also passed
+//     }
+//     printf("Maximum sustained correct rate: %d keys/s\n", maximumCorrectRate);
+
+//     while(true){thread_sleep_for(1000);}
+//     return 0;
+// }
+
+// //generates pressesPerRate simulated key presses at the given rate, with bounce on each edge
+// void generateKeyPresses(){
+//     int periodUs = 1000000 / keysPerSecond;
+//     int holdUs = periodUs * pressDutyCycle / 100;
+//     for(int i = 0; i < pressesPerRate; i++){
+//         bounceKey(1);
+//         wait_us(holdUs - bounceEdges * bounceEdgeSpacingUs);
+//         bounceKey(0);
+//         wait_us(periodUs - holdUs - bounceEdges * bounceEdgeSpacingUs);
+//     }
+// }
+
+// //switches the simulated key to the final level with contact bounce
+// void bounceKey(int finalLevel){
+//     for(int i = 0; i < bounceEdges; i++){
+//         simulatedKey.write(i % 2 == 0 ? finalLevel : !finalLevel);
+//         wait_us(bounceEdgeSpacingUs);
+//     }
+//     simulatedKey.write(finalLevel);
+// }
+
+// //same filtering as handleMatrixButtonEvent in the main implementation, counting accepted presses instead of handling keys
+// void handleMatrixButtonEvent(bool isRisingEdgeInterrupt, Kernel::Clock::time_point edgeTime){
+//     std::chrono::milliseconds bounceWindow(bounceTimeoutWindow);
+//     bool withinBounceWindow = edgeTime - lastKeyEdgeTime < bounceWindow;
+//     if(isRisingEdgeInterrupt){
+//         if(!charPressed && !withinBounceWindow){
+//             lastKeyEdgeTime = edgeTime;
+//             charPressed = '1';
+//             acceptedPresses++;
+//         }
+//     }else if(charPressed){
+//         if(!withinBounceWindow){
+//             lastKeyEdgeTime = edgeTime;
+//             charPressed = '\0';
+//         }else{
+//             std::chrono::milliseconds recheckDelay = bounceWindow - (Kernel::Clock::now() - lastKeyEdgeTime);
+//             if(recheckDelay < 0ms) recheckDelay = 0ms;
+//             matrixOpsEventQueue.call_in(recheckDelay, confirmKeyRelease);
+//         }
+//     }
+// }
+
+// void confirmKeyRelease(){
+//     if(charPressed && column.read() == 0){
+//         lastKeyEdgeTime = Kernel::Clock::now();
+//         charPressed = '\0';
+//     }
+// }
@@ -0,0 +1,157 @@
+// /******************************************************************************
+// *   File Name:      CSE321_project3_mnelyubo_keypad_wake_test.cpp
+// *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
+// *   Date Created:   10/19/2026
+// *   Last Modified:  10/19/2026
+// *   Purpose:        This program measures the latency from a keypad key press
+// *                     to the call of handleInputKey and the idle CPU time of
+// *                     the wake-on-press keypad scan used in the main
+// *                     implementation.
+// *
+// *   Functions:
+// *
+// *   Assignment:     Project 3
+// *
+// *   Inputs:         4x4 Matrix Keypad
+// *
+// *   Outputs:        Serial printout
+// *
+// *   Constraints:    The keypad must be connected as in the main implementation.
+// *                   CPU statistics must be enabled in mbed_app.json with
+// *                     "platform.cpu-stats-enabled": true
+// *                   Keys are pressed by hand.  Every press prints its latency,
+// *                     and every statisticsPeriod the idle, sleep and deep
+// *                     sleep share of CPU time is printed.
+// *
+// *   References:
+// *       NUCLEO datasheet:                  https://www.st.com/resource/en/reference_manual/dm00310109-stm32l4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
+// *       MBED OS API: Platform statistics   https://os.mbed.com/docs/mbed-os/v6.15/apis/mbed-statistics.html
+// *
+// ******************************************************************************/
+
+// #include "mbed.h"
+// #include <chrono>
+
+// #define MatrixDim 4
+// #define keypadAllRows -1
+// #define keypadRowsMask 0x74
+// #define keypadScanSettleTimeUs 5
+// #define keypadColumnExtiLines 0x1B
+// #define statisticsPeriod 10s
+
+// Thread matrixThread;
+// EventQueue matrixOpsEventQueue(32 * EVENTS_EVENT_SIZE);
+
+// InterruptIn colLL(PC_0,PullDown);
+// InterruptIn colCL(PC_3,PullDown);
+// InterruptIn colCR(PC_1,PullDown);
+// InterruptIn colRR(PC_4,PullDown);
+// InterruptIn* matrixColumns[MatrixDim] = {&colLL, &colCL, &colCR, &colRR};
+
+// char keyValues[][MatrixDim + 1] = {"dcba","#963","0852","*741"};
+// int keypadRowMasks[MatrixDim] = {0x04, 0x10, 0x20, 0x40};
+// int keypadVccRow = keypadAllRows;
+// char charPressed = '\0';
+
+// Timer latencyTimer;                 //free running timer used to timestamp edges and handler calls (us)
+// Ticker statisticsTicker;            //periodically enqueues a printout of the CPU statistics
+
+// void handleInputKey(char key, long long edgeTimeUs);
+// void handleRelease();
+// void printCpuStatistics();
+// void enqueueCpuStatistics(){matrixOpsEventQueue.call(printCpuStatistics);}
+
+// //same scan as resolvePressedKeyRow in the main implementation
+// int resolvePressedKeyRow(int column){
+//     int pressedRow = keypadAllRows;
+//     for(int row = 0; row < MatrixDim && pressedRow == keypadAllRows; row++){
+//         GPIOE->BSRR = ((keypadRowsMask & ~keypadRowMasks[row]) << 16) | keypadRowMasks[row];
+//         wait_us(keypadScanSettleTimeUs);
+//         if(matrixColumns[column]->read()) pressedRow = row;
+//     }
+//     if(pressedRow == keypadAllRows) GPIOE->BSRR = keypadRowsMask;
+//     EXTI->PR1 = keypadColumnExtiLines;
+//     return pressedRow;
+// }
+
+// void handleColumnRise(int column){
+//     long long edgeTimeUs = latencyTimer.elapsed_time().count();
+//     if(keypadVccRow != keypadAllRows) return;       //a key is already pressed
+//     int pressedRow = resolvePressedKeyRow(column);
+//     if(pressedRow == keypadAllRows) return;
+//     keypadVccRow = pressedRow;
+//     matrixOpsEventQueue.call(handleInputKey, keyValues[column][pressedRow], edgeTimeUs);
+// }
+
+// void handleColumnFall(int column){
+//     if(keypadVccRow != keypadAllRows) matrixOpsEventQueue.call_in(30ms, handleRelease);     //wait out release bounce before driving every row again
+// }
+
+// void rising_isr_abc() {handleColumnRise(0);}
+// void rising_isr_369() {handleColumnRise(1);}
+// void rising_isr_258() {handleColumnRise(2);}
+// void rising_isr_147() {handleColumnRise(3);}
+// void falling_isr_abc(){handleColumnFall(0);}
+// void falling_isr_369(){handleColumnFall(1);}
+// void falling_isr_258(){handleColumnFall(2);}
+// void falling_isr_147(){handleColumnFall(3);}
+
+// int main(){
+//     printf("\n\n=== Keypad Wake Test ===\n");
+
+//     //enable port C and E, configure PE2, PE4, PE5, PE6 as outputs
+//     RCC->AHB2ENR |= 0x14;
+//     GPIOE->MODER |= 0x01510;
+//     GPIOE->MODER &= ~(0x02A20);
+//     GPIOE->BSRR = keypadRowsMask;   //wait for a key press on every row
+
+//     colLL.rise(&rising_isr_abc);
+//     colCL.rise(&rising_isr_369);
+//     colCR.rise(&rising_isr_258);
+//     colRR.rise(&rising_isr_147);
+//     colLL.fall(&falling_isr_abc);
+//     colCL.fall(&falling_isr_369);
+//     colCR.fall(&falling_isr_258);
+//     colRR.fall(&falling_isr_147);
+
+//     latencyTimer.start();
+//     matrixThread.start(callback(&matrixOpsEventQueue, &EventQueue::dispatch_forever));
+//     statisticsTicker.attach(&enqueueCpuStatistics, statisticsPeriod);
+
+//     while(true){ThisThread::sleep_for(Kernel::wait_for_u32_forever);}
+//     return 0;
+// }
+
+// //stands in for handleInputKey of the main implementation and prints the press latency
+// void handleInputKey(char key, long long edgeTimeUs){
+//     long long latencyUs = latencyTimer.elapsed_time().count() - edgeTimeUs;
+//     charPressed = key;
+//     printf("key %c\tpress to handleInputKey latency: %lld us\n", key, latencyUs);
+// }
+
+// void handleRelease(){
+//     core_util_critical_section_enter();
+//     bool columnHigh = false;
+//     for(int column = 0; column < MatrixDim; column++){
+//         if(matrixColumns[column]->read()) columnHigh = true;
+//     }
+//     if(!columnHigh){
+//         keypadVccRow = keypadAllRows;
+//         GPIOE->BSRR = keypadRowsMask;
+//         charPressed = '\0';
+//     }
+//     core_util_critical_section_exit();
+// }
+
+// //prints the share of CPU time spent idle since the last printout
+// void printCpuStatistics(){
+//     static mbed_stats_cpu_t previous = {0};
+//     mbed_stats_cpu_t current;
+//     mbed_stats_cpu_get(&current);
+//     unsigned long long uptime = current.uptime - previous.uptime;
+//     unsigned long long idle = current.idle_time - previous.idle_time;
+//     unsigned long long sleep = current.sleep_time - previous.sleep_time;
+//     unsigned long long deepSleep = current.deep_sleep_time - previous.deep_sleep_time;
+//     printf("CPU idle: %llu%%\tsleep: %llu%%\tdeep sleep: %llu%%\n", 100 * idle / uptime, 100 * sleep / uptime, 100 * deepSleep / uptime);
+//     previous = current;
+// }
@@ -2,27 +2,46 @@
 // *   File Name:      CSE321_project3_mnelyubo_range_test.cpp
 // *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
 // *   Date Created:   11/20/2021
-// *   Last Modified:  11/20/2021
+// *   Last Modified:  10/19/2026
 // *   Purpose:        This program tests the operation of the range detection sensor
 // *
-// *   Functions:      
+// *                   With CAPTURE_TRACE set to 1, it streams the raw echo edge timestamps
+// *                     of every poll to the serial port as a binary range trace instead,
+// *                     so that a recording of the sensor can be replayed through distance
+// *                     filters on the host (host/replay).  A ground truth distance typed
+// *                     on the serial port, followed by Enter, is annotated in the trace
+// *                     for the polls that follow it.  '?' and Enter marks the truth unknown
+// *
+// *   Functions:      riseHandler, fallHandler, getTimeSinceStart, getStableDistance,
+// *                     writeTraceRecord, readAnnotation
 // *
 // *   Assignment:     Project 3
 // *
 // *   Inputs:         Range Detection Sensor
+// *                   Capture mode: the ground truth distance in cm, typed on the serial port
 // *
 // *   Outputs:        Serial printout
+// *                   Capture mode: a binary range trace on the serial port, in the format of
+// *                     host/replay/RangeTrace.h.  Nothing else is printed, so the port can be
+// *                     recorded to a file as it is, for example:
+// *                       stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 > shelf.rtr
+// *                     with the truth typed from a second terminal:
+// *                       echo 120 > /dev/ttyACM0
 // *
 // *   Constraints:    Range Detection Sensor must be connected to the Nucleo with the following pins:
 // *                     Vcc  - 5V
 // *                     Trig - PC_9
 // *                     Echo - PC_8
 // *                     Gnd  - GND
+// *                   Capture mode writes the port through BufferedSerial, not printf, so
+// *                     that no newline conversion of the console alters the binary records
+// *                   The recording must start before the NUCLEO is reset, to keep the header
 // *
 // *   References:
 // *       HC-SR04 audio sensor datasheet:    https://www.digikey.com/htmldatasheets/production/1979760/0/0/1/hc-sr04.html
 // *       NUCLEO datasheet:                  https://www.st.com/resource/en/reference_manual/dm00310109-stm32l4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
 // *       MBED OS API: timer                 https://os.mbed.com/docs/mbed-os/v6.15/apis/timer.html
+// *       MBED OS API: BufferedSerial        https://os.mbed.com/docs/mbed-os/v6.15/apis/serial-uart-apis.html
 // *
 // ******************************************************************************/
 
@@ -41,12 +60,24 @@
 // #define stabilizerArrayLen 40
 // #define DISTANCE_MAXIMUM 400  /* sensor max range is stated to be 4m */
 
+// //trace capture, as host/replay/RangeTrace.h reads it
+// #define CAPTURE_TRACE        0          /* 1: stream a binary range trace instead of printing */
+// #define captureBaudRate      115200
+// #define traceVersion         1
+// #define traceNoEdge          0xFFFF     /* the edge was not seen in the poll, or the truth is unknown */
+// #define traceAnnotation      0xFFFE     /* in the rise field: the record sets the ground truth */
+// #define traceMaxUs           0xFFFD     /* longest edge time that can be recorded */
+// #define annotationMaxDigits  3
+
 // void riseHandler();
 // void fallHandler();
 
 // ull getTimeSinceStart();
 // int getStableDistance();
 
+// void writeTraceRecord(uint16_t first, uint16_t second);
+// void readAnnotation();
+
 // int stableDistance[stabilizerArrayLen];
 // int stableDistIdx = 0;
 
@@ -55,6 +86,13 @@
 // ull riseDetected = 0;
 // ull fallDetected = 0;
 
+// #if CAPTURE_TRACE
+// BufferedSerial captureSerial(USBTX, USBRX, captureBaudRate);   //the trace output and the annotation input.  Replaces the console
+// int annotationValue = 0;        //the digits of the ground truth typed so far
+// int annotationDigits = 0;
+// bool annotationUnknown = false;
+// #endif
+
 // // DigitalOut trig(PC_8);
 // InterruptIn echo(PC_8);
 
@@ -74,6 +112,16 @@
 //     //configure pin C8 as an input
 //     GPIOC->MODER &= ~(0x30000);
 
+// #if CAPTURE_TRACE
+//     //trace header: magic, version, reserved, poll period in ms
+//     captureSerial.set_blocking(false);      //annotations are read without waiting.  Writes still wait for room in the buffer
+//     const uint8_t header[8] = {'R', 'T', 'R', 'C', traceVersion, 0, POLLING_CYCLE_TIME_MS & 0xFF, POLLING_CYCLE_TIME_MS >> 8};
+//     for(size_t sent = 0; sent < sizeof(header);){
+//         ssize_t written = captureSerial.write(header + sent, sizeof(header) - sent);
+//         if(written > 0) sent += written;
+//     }
+// #endif
+
 //     while(true){
 //         timer.start();
 
@@ -84,7 +132,19 @@
 
 //         thread_sleep_for(60);   //sensor documentation states wait for 60ms before measuring upper limit
 
+// #if CAPTURE_TRACE
+//         //the edges may arrive until the next poll, as in the main implementation.  They are recorded once the cycle ends
+//         thread_sleep_for(POLLING_CYCLE_TIME_MS - 60);
+//         while(getTimeSinceStart() < POLLING_CYCLE_TIME_MS * 1000);
 
+//         core_util_critical_section_enter();
+//         ull rise = riseDetected;
+//         ull fall = fallDetected;
+//         core_util_critical_section_exit();
+//         writeTraceRecord(rise ? (rise > traceMaxUs ? traceMaxUs : rise) : traceNoEdge,
+//                          fall ? (fall > traceMaxUs ? traceMaxUs : fall) : traceNoEdge);
+//         readAnnotation();
+// #else
 //         while(getTimeSinceStart() < POLLING_CYCLE_TIME_MS * 1000){
 //             if(riseDetected && fallDetected){
 //                 ull deltaTime = fallDetected - riseDetected;
@@ -99,7 +159,8 @@
 //                 fallDetected=false;
 //             }
 //         }
-        
+// #endif
+
 //         //prevent half-returns from cascading into the next data point
 //         riseDetected=false;
 //         fallDetected=false;
@@ -133,3 +194,82 @@
 //     using namespace std::chrono;
 //     return duration_cast<microseconds>(timer.elapsed_time()).count();
 // }
+
+
+// #if CAPTURE_TRACE
+// /**
+//  * void writeTraceRecord(uint16_t first, uint16_t second)
+//  * non-ISR function
+//  *
+//  * Summary of the function:
+//  *    This function writes one 4 byte record of the trace, little-endian: the rise and fall times of a poll, or an
+//  *      annotation and its distance.  At 115200 baud a record takes 0.35 ms of the 100 ms poll cycle
+//  *
+//  * Parameters:
+//  *    first  - the rise time in us, traceNoEdge, or traceAnnotation
+//  *    second - the fall time in us, or the annotated distance in cm, or traceNoEdge
+//  *
+//  * Return value:
+//  *    None
+//  *
+//  * Outputs:
+//  *    4 bytes are written to the serial port
+//  *
+//  * Shared variables accessed:
+//  *    None
+//  */
+// void writeTraceRecord(uint16_t first, uint16_t second){
+//     const uint8_t record[4] = {(uint8_t)(first & 0xFF), (uint8_t)(first >> 8), (uint8_t)(second & 0xFF), (uint8_t)(second >> 8)};
+//     for(size_t sent = 0; sent < sizeof(record);){
+//         ssize_t written = captureSerial.write(record + sent, sizeof(record) - sent);
+//         if(written > 0) sent += written;
+//     }
+// }
+
+
+// /**
+//  * void readAnnotation()
+//  * non-ISR function
+//  *
+//  * Summary of the function:
+//  *    This function reads the characters typed on the serial port since the last poll.  Digits build up a
+//  *      distance in cm and '?' marks it unknown.  At Enter, an annotation record is written, so that the distance
+//  *      applies to the polls recorded after it.  Any other character discards the input.
+//  *
+//  * Parameters:
+//  *    None
+//  *
+//  * Return value:
+//  *    None
+//  *
+//  * Outputs:
+//  *    An annotation record may be written to the serial port
+//  *
+//  * Shared variables accessed:
+//  *    annotationValue, annotationDigits and annotationUnknown, only accessed by the main thread
+//  */
+// void readAnnotation(){
+//     char typed;
+//     while(captureSerial.readable() && captureSerial.read(&typed, 1) == 1){
+//         if(typed >= '0' && typed <= '9' && annotationDigits < annotationMaxDigits){
+//             annotationValue = annotationValue * 10 + (typed - '0');
+//             annotationDigits++;
+//         }else if(typed == '?'){
+//             annotationUnknown = true;
+//         }else if(typed == '\r' || typed == '\n'){
+//             if(annotationUnknown){
+//                 writeTraceRecord(traceAnnotation, traceNoEdge);
+//             }else if(annotationDigits){
+//                 writeTraceRecord(traceAnnotation, annotationValue);
+//             }
+//             annotationValue = 0;
+//             annotationDigits = 0;
+//             annotationUnknown = false;
+//         }else{
+//             annotationValue = 0;
+//             annotationDigits = 0;
+//             annotationUnknown = false;
+//         }
+//     }
+// }
+// #endif
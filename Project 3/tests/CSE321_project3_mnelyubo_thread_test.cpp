@@ -1,83 +1,253 @@
 // /******************************************************************************
-// *   File Name:      CSE321_project3_mnelyubo_range_test.cpp
+// *   File Name:      CSE321_project3_mnelyubo_thread_test.cpp
 // *   Author:         Misha Nelyubov (mnelyubo@buffalo.edu)
 // *   Date Created:   11/22/2021
-// *   Last Modified:  11/22/2021
-// *   Purpose:        This test code verifies the expected behavior of threads, 
-// *                     event queues, and mutexes.  These scheduling utilities
-// *                     will be used in the main project implementation.
+// *   Last Modified:  10/19/2026
+// *   Purpose:        This program benchmarks the Ticker -> EventQueue -> Thread
+// *                     dispatch that the main implementation is built on.  Each
+// *                     ticker ISR stamps the cycle counter and posts an event to
+// *                     its queue, and the event measures its dispatch latency, the
+// *                     cycles from the ISR to the start of the event, and its
+// *                     jitter, how far the time since the previous event of its
+// *                     queue is from the ticker period.  The scenarios vary the
+// *                     number of queues, the priority of their threads, the time
+// *                     each event holds a Mutex that all events share, and a
+// *                     background thread that busy-waits as runBuzzer() does.
 // *
-// *   Functions:      N/A
+// *   Functions:      runScenario, printScenario, tickQueue, handleTick, runBuzzerLoad
 // *
 // *   Assignment:     Project 3
 // *
 // *   Inputs:         None
 // *
-// *   Outputs:        Serial printout
+// *   Outputs:        Serial printout: a table of percentiles for each scenario,
+// *                     in microseconds, followed by the same values in cycles as
+// *                     lines of comma separated values that start with "csv,",
+// *                     for parsing on a computer:
+// *                       csv,scenario,queue,priority,holdUs,buzzer,metric,count,min,p50,p90,p99,p99.9,max,dropped
+// *                     where metric is latency or jitter
 // *
-// *   Constraints:    N/A
+// *   Constraints:    The buzzer load toggles PB_11, so the buzzer may be left
+// *                     connected to hear it.
+// *                   Requires Hal.h and LatencyProbe.h from Project 2 to be copied
+// *                     next to this file.
+// *                   The percentiles are the largest values of their histogram
+// *                     buckets, so they may read up to 1/8 high.
+// *                   A tick whose event cannot be posted is counted as dropped.
 // *
 // *   References:
 // *       NUCLEO datasheet:                  https://www.st.com/resource/en/reference_manual/dm00310109-stm32l4-series-advanced-armbased-32bit-mcus-stmicroelectronics.pdf
 // *       MBED OS API: Mutex                 https://os.mbed.com/docs/mbed-os/v6.15/apis/mutex.html
+// *       MBED OS API: EventQueue            https://os.mbed.com/docs/mbed-os/v6.15/apis/eventqueue.html
+// *       MBED OS API: Thread                https://os.mbed.com/docs/mbed-os/v6.15/apis/thread.html
 // *
 // ******************************************************************************/
 
-// #include "mbed.h"
+// #include "Hal.h"
+// #include "LatencyProbe.h"
 // #include <chrono>
+// #include <cstdlib>
 
-// Thread t1;
-// Thread t2;
-// Thread t3;
+// //benchmark timing
+// #define maxQueues           3           /* queues, threads and tickers available to a scenario */
+// #define tickPeriod          2ms         /* period of every ticker */
+// #define tickPeriodUs        2000
+// #define scenarioDuration    4000ms      /* run time of each scenario: 2000 ticks per queue */
+// #define eventWorkUs         50          /* busy time of each event outside of the shared Mutex */
+// #define drainTime           100ms       /* time for the last events to finish after the tickers stop */
 
-// Mutex printer;  //create mutex for controlling access to serial output printing
+// //buzzer load, as runBuzzer() plays the 200 Hz, 20% notes of outputSoundTable
+// #define buzzerFrequency     200
+// #define buzzerDutyCycle     20
+// #define nanosecondsPerSecond 1000000000
 
-// //the amount of times that each output function has been called
-// int beat[3] = {0,0,0};
+// //a load on the scheduler: the queues that tick, the priority of their threads, the time each event holds the
+// //shared Mutex and whether the buzzer thread busy-waits in the background
+// struct Scenario {
+//     const char* name;
+//     int queues;
+//     osPriority priorities[maxQueues];
+//     int holdUs;
+//     bool buzzer;
+// };
 
-// Ticker tick1;
-// Ticker tick2;
-// Ticker tick3;
+// const Scenario scenarios[] = {
+//     /*name,                     queues, thread priorities,                                                  hold(us), buzzer*/
+//     {"one queue",               1,      {osPriorityNormal, osPriorityNormal, osPriorityNormal},             0,        false},
+//     {"three queues",            3,      {osPriorityNormal, osPriorityNormal, osPriorityNormal},             0,        false},
+//     {"three queues, mutex",     3,      {osPriorityNormal, osPriorityNormal, osPriorityNormal},             300,      false},
+//     {"ranked priorities, mutex", 3,     {osPriorityHigh, osPriorityAboveNormal, osPriorityNormal},          300,      false},
+//     {"one queue, buzzer",       1,      {osPriorityNormal, osPriorityNormal, osPriorityNormal},             0,        true},
+//     {"three queues, buzzer",    3,      {osPriorityNormal, osPriorityNormal, osPriorityNormal},             300,      true},
+//     {"above buzzer, buzzer",    3,      {osPriorityAboveNormal, osPriorityAboveNormal, osPriorityAboveNormal}, 300,   true},
+// };
+// #define scenarioCount (int)(sizeof(scenarios) / sizeof(scenarios[0]))
 
-// void outputInit1();
-// void outputInit2();
-// void outputInit3();
-// void output(int beatThread);
+// //the measurements of one queue in the current scenario
+// struct QueueResults {
+//     LatencyHistogram latency;           //cycles from the ticker ISR to the start of the event
+//     LatencyHistogram jitter;            //cycles between the start of an event and the period after the previous one
+//     volatile uint32_t lastStartCycles;
+//     volatile int handled;
+//     volatile int dropped;
+// };
 
-// EventQueue eq1(32 * EVENTS_EVENT_SIZE);
-// EventQueue eq2(32 * EVENTS_EVENT_SIZE);
-// EventQueue eq3(32 * EVENTS_EVENT_SIZE);
+// Thread queueThreads[maxQueues];
+// EventQueue queues[maxQueues];          //32 * EVENTS_EVENT_SIZE each, the default size
+// Ticker tickers[maxQueues];
+// QueueResults results[maxQueues];
 
-// int main(){
-//     printf("== Beginning execution ==\n");
-//     t1.start(callback(&eq1, &EventQueue::dispatch_forever));    //start thread 1 to process event queue 1
-//     t2.start(callback(&eq2, &EventQueue::dispatch_forever));    //start thread 2 to process event queue 2
-//     t3.start(callback(&eq3, &EventQueue::dispatch_forever));    //start thread 3 to process event queue 3
+// Mutex sharedState;                      //held by every event for holdUs, as the main implementation shares its state variables
+// Mutex buzzerSettingsRW;                 //read by the buzzer load every period, as dutyCycleRW and oscillationFrequencyRW
+// Thread buzzerDataThread;                //busy-waits as runBuzzer() does while buzzerLoad is set
+// DigitalOut alarm_data_L(PB_11);
+// volatile bool buzzerLoad = false;
+// volatile int holdUs = 0;
+// uint32_t periodCycles = 0;              //the ticker period in cycles
+
+// void tickQueue(int queue);
+// void tickQueue0(){tickQueue(0);}
+// void tickQueue1(){tickQueue(1);}
+// void tickQueue2(){tickQueue(2);}
+// void (*const tickIsrs[maxQueues])() = {tickQueue0, tickQueue1, tickQueue2};
 
-//     tick1.attach(&outputInit1, 1s);       //set ticker 1 to run the output initializer once every second for thread 1
-//     tick2.attach(&outputInit2, 1s);       //set ticker 2 to run the output initializer once every second for thread 2
-//     tick3.attach(&outputInit3, 1s);       //set ticker 3 to run the output initializer once every second for thread 3
+// void handleTick(int queue, uint32_t tickCycles);
+// void runBuzzerLoad();
+// void runScenario(const Scenario& scenario);
+// void printScenario(int index, const Scenario& scenario);
 
-//     while(true){}                       //run indefinitely
+// int main(){
+//     printf("\n\n=== Scheduling Jitter Benchmark ===\n");
+//     halCycleCounterStart();
+//     periodCycles = (uint32_t)((unsigned long long)SystemCoreClock * tickPeriodUs / 1000000);
+//     for(int queue = 0; queue < maxQueues; queue++) queueThreads[queue].start(callback(&queues[queue], &EventQueue::dispatch_forever));
+//     buzzerDataThread.start(runBuzzerLoad);
 
+//     for(int index = 0; index < scenarioCount; index++){
+//         runScenario(scenarios[index]);
+//         printScenario(index, scenarios[index]);
+//     }
+//     printf("=== Done ===\n");
+
+//     while(true){thread_sleep_for(1000);}
 //     return 0;
 // }
 
-// //these ISR functions adds the time-costly thread functions to the event queue
-// void outputInit1(){eq1.call(output, 1);}
-// void outputInit2(){eq2.call(output, 2);}
-// void outputInit3(){eq3.call(output, 3);}
-
-// //this EventQueue-called function executes lengthier calls
-// void output(int beatThread){
-//     printer.lock();
-//     printf("thread %d rise %d\n", beatThread, ++beat[beatThread]);
-//     printer.unlock();
-    
-//     thread_sleep_for(500);
-
-//     printer.lock();
-//     printf("thread %d fall %d\n", beatThread, beat[beatThread]);
-//     printer.unlock();
+
+// /**
+//  * void runScenario(const Scenario& scenario)
+//  * non-ISR function
+//  *
+//  * Summary of the function:
+//  *    This function sets the thread priorities, Mutex hold time and buzzer load of the scenario, clears the
+//  *      results, and runs the tickers of its queues for scenarioDuration.  The tickers are stopped and the
+//  *      queues drained before it returns, so the results no longer change.
+//  */
+// void runScenario(const Scenario& scenario){
+//     for(int queue = 0; queue < maxQueues; queue++){
+//         queueThreads[queue].set_priority(scenario.priorities[queue]);
+//         results[queue].latency.reset();
+//         results[queue].jitter.reset();
+//         results[queue].handled = 0;
+//         results[queue].dropped = 0;
+//     }
+//     holdUs = scenario.holdUs;
+//     buzzerLoad = scenario.buzzer;
+
+//     for(int queue = 0; queue < scenario.queues; queue++) tickers[queue].attach(tickIsrs[queue], tickPeriod);
+//     ThisThread::sleep_for(scenarioDuration);
+//     for(int queue = 0; queue < scenario.queues; queue++) tickers[queue].detach();
+
+//     buzzerLoad = false;
+//     ThisThread::sleep_for(drainTime);
+// }
+
+
+// //the ISR of each ticker: stamps the tick and posts its event
+// void tickQueue(int queue){
+//     uint32_t tickCycles = halCycles();
+//     if(!queues[queue].call(handleTick, queue, tickCycles)) results[queue].dropped++;
 // }
 
+
+// //the event of each tick: records its latency and jitter, then works as a short event of the main implementation does
+// void handleTick(int queue, uint32_t tickCycles){
+//     uint32_t startCycles = halCycles();
+//     QueueResults& result = results[queue];
+//     result.latency.record(startCycles - tickCycles);
+//     if(result.handled > 0) result.jitter.record(abs((int32_t)(startCycles - result.lastStartCycles - periodCycles)));
+//     result.lastStartCycles = startCycles;
+//     result.handled++;
+
+//     wait_us(eventWorkUs);
+//     if(holdUs > 0){
+//         sharedState.lock();
+//         wait_us(holdUs);
+//         sharedState.unlock();
+//     }
+// }
+
+
+// /**
+//  * void runBuzzerLoad()
+//  * non-ISR function
+//  *
+//  * Summary of the function:
+//  *    This function runs on buzzerDataThread.  While buzzerLoad is set, it plays a square wave on PB_11 in the
+//  *      same way as runBuzzer() in the main implementation: the settings are read under a Mutex and the two
+//  *      halves of each period are busy-waited, so the thread never blocks.  Otherwise it sleeps.
+//  */
+// void runBuzzerLoad(){
+//     while(1){
+//         if(!buzzerLoad){
+//             thread_sleep_for(10);
+//             continue;
+//         }
+//         buzzerSettingsRW.lock();
+//         int period = nanosecondsPerSecond / buzzerFrequency;
+//         int highPeriod = period * buzzerDutyCycle / 100;
+//         int lowPeriod = period - highPeriod;
+//         buzzerSettingsRW.unlock();
+//         alarm_data_L.write(0);
+//         wait_ns(highPeriod);
+//         alarm_data_L.write(1);
+//         wait_ns(lowPeriod);
+//     }
+// }
+
+
+// /**
+//  * void printScenario(int index, const Scenario& scenario)
+//  * non-ISR function
+//  *
+//  * Summary of the function:
+//  *    This function prints the latency and jitter percentiles of each queue of the scenario as a table in
+//  *      microseconds, to two decimals, then as csv lines in cycles.
+//  */
+// void printScenario(int index, const Scenario& scenario){
+//     uint32_t cyclesPerUs = SystemCoreClock / 1000000;
+//     printf("\n--- Scenario %d: %s (%d queues, Mutex held %d us, buzzer %s) ---\n", index, scenario.name, scenario.queues,
+//            scenario.holdUs, scenario.buzzer ? "on" : "off");
+//     printf("queue\tpriority\tmetric\tcount\tmin\tp50\tp90\tp99\tp99.9\tmax\tdropped\n");
+//     for(int pass = 0; pass < 2; pass++){                    //the table, then the csv lines
+//         for(int queue = 0; queue < scenario.queues; queue++){
+//             const LatencyHistogram* metrics[] = {&results[queue].latency, &results[queue].jitter};
+//             const char* metricNames[] = {"latency", "jitter"};
+//             for(int metric = 0; metric < 2; metric++){
+//                 const LatencyHistogram& values = *metrics[metric];
+//                 uint32_t shown[] = {values.minimum(), values.percentile(500), values.percentile(900), values.percentile(990),
+//                                     values.percentile(999), values.maximum()};
+//                 if(pass == 0) printf("%d\t%d\t\t%s\t%lu", queue, (int)scenario.priorities[queue], metricNames[metric], (unsigned long)values.count());
+//                 else printf("csv,%d,%d,%d,%d,%d,%s,%lu", index, queue, (int)scenario.priorities[queue], scenario.holdUs, scenario.buzzer,
+//                             metricNames[metric], (unsigned long)values.count());
+//                 for(uint32_t cycles : shown){
+//                     unsigned long long hundredths = (unsigned long long)cycles * 100 / cyclesPerUs;
+//                     if(pass == 0) printf("\t%lu.%02lu", (unsigned long)(hundredths / 100), (unsigned long)(hundredths % 100));
+//                     else printf(",%lu", (unsigned long)cycles);
+//                 }
+//                 if(pass == 0) printf("\t%d\n", results[queue].dropped);
+//                 else printf(",%d\n", results[queue].dropped);
+//             }
+//         }
+//     }
+// }